@@ -12,12 +12,24 @@ C:\VulkanSDK\1.3.296.0\Bin\glslc.exe ssao_generation.frag -o ssao_generation_fra
 C:\VulkanSDK\1.3.296.0\Bin\glslc.exe shader_raytracing.vert -o shader_raytracing_vertex.spv
 C:\VulkanSDK\1.3.296.0\Bin\glslc.exe shader_raytracing.frag -o shader_raytracing_frag.spv
 C:\VulkanSDK\1.3.296.0\Bin\glslc.exe surfel_generation.comp -o surfel_generation.spv
+C:\VulkanSDK\1.3.296.0\Bin\glslc.exe surfel_grid_count.comp -o surfel_grid_count.spv
+C:\VulkanSDK\1.3.296.0\Bin\glslc.exe surfel_grid_offset.comp -o surfel_grid_offset.spv
+C:\VulkanSDK\1.3.296.0\Bin\glslc.exe surfel_grid_binning.comp -o surfel_grid_binning.spv
+C:\VulkanSDK\1.3.296.0\Bin\glslc.exe surfel_indirect_args.comp -o surfel_indirect_args.spv
 C:\VulkanSDK\1.3.296.0\Bin\glslc.exe surfel_visualization.vert -o surfel_visualization_vert.spv
 C:\VulkanSDK\1.3.296.0\Bin\glslc.exe surfel_visualization.frag -o surfel_visualization_frag.spv
 C:\VulkanSDK\1.3.296.0\Bin\glslc.exe -fshader-stage=geometry surfel_visualization.geom.glsl -o surfel_visualization_geom.spv
 C:\VulkanSDK\1.3.296.0\Bin\glslc.exe surfel_radiance_calculation.comp -o surfel_radiance_calculation.spv
-C:\VulkanSDK\1.3.296.0\Bin\glslc.exe indirect_diffuse_shading.frag -o indirect_diffuse_shading.spv
+C:\VulkanSDK\1.3.296.0\Bin\glslc.exe surfel_irradiance_volume.comp -o surfel_irradiance_volume.spv
+C:\VulkanSDK\1.3.296.0\Bin\glslc.exe indirect_diffuse_tiled.comp -o indirect_diffuse_tiled.spv
+C:\VulkanSDK\1.3.296.0\Bin\glslc.exe indirect_diffuse_volume.frag -o indirect_diffuse_volume.spv
 C:\VulkanSDK\1.3.296.0\Bin\glslc.exe surfels_composition.frag -o surfels_composition_frag.spv
 C:\VulkanSDK\1.3.296.0\Bin\glslc.exe surfels_composition_visualization.frag -o surfels_composition_visualization_frag.spv
 C:\VulkanSDK\1.3.296.0\Bin\glslc.exe surfel_radiance_visualization.vert -o surfel_radiance_visualization_vert.spv
+C:\VulkanSDK\1.3.296.0\Bin\glslc.exe scene_culling.comp -o scene_culling.spv
+C:\VulkanSDK\1.3.296.0\Bin\glslc.exe hiz_downsample.comp -o hiz_downsample.spv
+C:\VulkanSDK\1.3.296.0\Bin\glslc.exe surfel_lifecycle.comp -o surfel_lifecycle.spv
+C:\VulkanSDK\1.3.296.0\Bin\glslc.exe surfel_ray_priority.comp -o surfel_ray_priority.spv
+C:\VulkanSDK\1.3.296.0\Bin\glslc.exe surfel_ray_budget.comp -o surfel_ray_budget.spv
+C:\VulkanSDK\1.3.296.0\Bin\glslc.exe surfel_ray_enqueue.comp -o surfel_ray_enqueue.spv
 pause
\ No newline at end of file
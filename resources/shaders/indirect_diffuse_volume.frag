@@ -0,0 +1,71 @@
+#version 450
+#extension GL_EXT_scalar_block_layout : enable
+#extension GL_EXT_nonuniform_qualifier : enable
+#include "surfelsData.glsl"
+
+layout(push_constant) uniform PushConstants {
+    float width;
+    float height;
+} windowSize;
+
+// Desplazamiento de la consulta a lo largo de la normal, en celdas, para que el filtrado no mezcle tanto las celdas
+// del otro lado de las paredes finas
+const float NORMAL_OFFSET = 0.25;
+const float MIN_OCCUPANCY = 1e-3;
+
+layout (binding = 4) uniform sampler2D positionTexture;
+layout (binding = 5) uniform sampler2D normalTexture;
+layout (binding = 6) uniform CameraBuffer {
+    mat4 view;
+    mat4 projection;
+    vec2 nearFarPlanes;
+    vec2 padding0;
+    uvec4 frame;
+    vec3 position;
+    float padding1;
+} cameraData;
+// Volumen de irradiancia de cada nivel del clipmap (surfel_irradiance_volume.comp). El sampler repite la textura, por
+// lo que el direccionamiento toroidal del grid sale directamente de las coordenadas de mundo
+layout (binding = 7) uniform sampler3D irradianceVolume[SURFEL_CLIPMAP_LEVELS];
+layout (binding = 8) uniform sampler3D directionVolume[SURFEL_CLIPMAP_LEVELS];
+
+layout (location = 0) in vec2 inUV;
+
+layout (location = 0) out vec4 outColor;
+
+void main()
+{
+    // Se recuperan los parámetros del G-Buffer. La imagen es de resolución reducida, y cada píxel toma el superior
+    // izquierdo de su bloque, que es el que usa la composición como guía al reescalarla
+    ivec2 gBufferPixel = ivec2(gl_FragCoord.xy) * int(INDIRECT_DIFFUSE_DOWNSCALE);
+    vec3 fragPositionCamera = texelFetch(positionTexture, gBufferPixel, 0).xyz;
+    vec3 fragNormalCamera = normalize(texelFetch(normalTexture, gBufferPixel, 0).xyz * 2.0 - 1.0);
+    // Se pasan a espacio global
+    vec3 fragWorldPosition = (inverse(cameraData.view) * vec4(fragPositionCamera, 1.0)).xyz;
+    vec3 fragWorldNormal = normalize((inverse(cameraData.view) * vec4(fragNormalCamera, 0.0)).xyz);
+
+    // Fuera del clipmap no hay surfels. El nivel deja una celda de margen, así que las ocho celdas del filtrado
+    // trilineal están dentro de su ventana
+    uint level = surfel_clipmapLevel(fragWorldPosition, cameraData.position);
+    if (level >= SURFEL_CLIPMAP_LEVELS) {
+        outColor = vec4(0.0);
+        return;
+    }
+
+    // El centro del texel i del volumen coincide con el centro de la celda i del nivel
+    float cellSize = surfel_cellLength(level);
+    vec3 samplePosition = fragWorldPosition + fragWorldNormal * (NORMAL_OFFSET * cellSize);
+    vec3 uvw = samplePosition / (cellSize * vec3(SURFEL_GRID_DIMENSIONS));
+
+    // Las celdas vacías valen cero en todos los canales, así que se normaliza por la ocupación filtrada
+    vec4 irradiance = texture(irradianceVolume[nonuniformEXT(level)], uvw);
+    if (irradiance.a < MIN_OCCUPANCY) {
+        outColor = vec4(0.0);
+        return;
+    }
+    vec4 direction = texture(directionVolume[nonuniformEXT(level)], uvw) / irradiance.a;
+
+    float directionalFactor = max(direction.w + dot(direction.xyz, fragWorldNormal), 0.0);
+    vec3 finalColor = irradiance.rgb / irradiance.a * directionalFactor;
+    outColor = vec4(finalColor, 1.0);
+}
\ No newline at end of file
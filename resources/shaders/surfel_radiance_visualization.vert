@@ -1,10 +1,8 @@
 #version 450
 
-// Atributos
-layout(location = 0) in vec3 inPos;
-layout(location = 1) in vec3 inNormal;
-layout(location = 2) in float inRadius;
-layout(location = 3) in vec3 inColor;
+#extension GL_EXT_scalar_block_layout : enable
+
+#include "surfelsData.glsl"
 
 // Variables que se pasan al Geometry Shader
 layout(location = 0) out VS_OUT {
@@ -20,18 +18,25 @@ layout (binding = 0) uniform CameraBuffer {
     	mat4 projection;
     	vec2 nearFarPlanes;
         vec2 padding0;
-    	vec4 frame;
+    	uvec4 frame;
         vec3 position;
         float padding1;
 } cameraData;
 
+// Los surfels se leen directamente del buffer generado en GPU, un vértice por surfel
+layout (binding = 1) readonly buffer SurfelBuffer {
+	Surfel surfelInBuffer[];
+} surfels;
+
 void main() {
 	
-    vs_out.pos = inPos;
-    vs_out.normal = normalize(inNormal);
-    vs_out.radius = inRadius * 0.7;
-    vs_out.color = inColor;
+    Surfel surfel = surfels.surfelInBuffer[gl_VertexIndex];
+
+    vs_out.pos = surfel.position;
+    vs_out.normal = normalize(surfel.normal);
+    vs_out.radius = surfel.radius * 0.7;
+    vs_out.color = surfel_irradiance(surfel);
 
     // Se proyecta la posición del surfel
-    gl_Position   = cameraData.projection * cameraData.view * vec4(inPos, 1.0);
+    gl_Position   = cameraData.projection * cameraData.view * vec4(surfel.position, 1.0);
 }
\ No newline at end of file
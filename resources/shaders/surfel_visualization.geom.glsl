@@ -21,7 +21,7 @@ layout (binding = 0) uniform CameraBuffer {
     	mat4 projection;
     	vec2 nearFarPlanes;
         vec2 padding0;
-    	vec4 frame;
+    	uvec4 frame;
         vec3 position;
         float padding1;
 } cameraData;
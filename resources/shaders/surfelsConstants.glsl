@@ -0,0 +1,95 @@
+// Constantes de los surfels compartidas con la aplicación: el mismo fichero se incluye desde los shaders y desde la
+// implementación de referencia en CPU (src/Surfels/SurfelData.h), por lo que sólo puede usar la sintaxis común a GLSL y
+// C++: declaraciones const con tipos escalares, uvec3 y vec3, y comentarios de línea
+
+// El grid es un clipmap centrado en la cámara: SURFEL_CLIPMAP_LEVELS niveles de SURFEL_GRID_DIMENSIONS celdas, en los que
+// el lado de las celdas y el radio máximo de los surfels se doblan de un nivel al siguiente. Las dimensiones tienen que
+// ser potencias de dos, porque las celdas se direccionan de forma toroidal con una máscara
+const uvec3 SURFEL_GRID_DIMENSIONS = uvec3(128, 64, 128);
+const uint SURFEL_CLIPMAP_LEVELS = 4;
+const uint SURFEL_LEVEL_TABLE_SIZE = SURFEL_GRID_DIMENSIONS.x * SURFEL_GRID_DIMENSIONS.y * SURFEL_GRID_DIMENSIONS.z;
+const uint SURFEL_TABLE_SIZE = SURFEL_LEVEL_TABLE_SIZE * SURFEL_CLIPMAP_LEVELS;
+// Radio máximo de los surfels y lado de las celdas del nivel más fino
+const float SURFEL_MAX_RADIUS = 12.5;
+const float CELL_LENGTH = 30;
+const uint SURFEL_CAPACITY = 100000;
+const float SURFEL_TARGET_COVERAGE = 0.2;
+const uint MAX_RAYS_PER_SURFEL = 2500;
+const uint NUM_RAYS = 50;
+const uint RAYS_LENGTH = 1500;
+const float INDIRECT_DIFFUSE_ILLUMINATION_WEIGHT = 1.0;
+const float ANGULAR_INDIRECT_DIFFUSE_MIN_FACTOR = 0.025;
+// Muestreo adaptativo: un surfel con al menos SURFEL_MIN_SAMPLES muestras cuyo error relativo (desviación típica de la
+// media entre la media) está por debajo de SURFEL_CONVERGED_ERROR se considera convergido y deja de lanzar rayos
+const uint SURFEL_MIN_SAMPLES = 100;
+const float SURFEL_CONVERGED_ERROR = 0.02;
+const vec3 SURFEL_LUMINANCE_WEIGHTS = vec3(0.2126, 0.7152, 0.0722);
+// Rebotes múltiples: en el punto de choque de cada rayo se consulta la radiancia ya acumulada en los surfels de su celda
+// y se suma como luz rebotada. En las celdas con más de SURFEL_BOUNCE_MAX_SURFELS surfels se toma uno de cada tramo de
+// la celda, con un desplazamiento distinto en cada rayo, para no depender del orden en el que se insertaron. La parte indirecta de cada surfel se mezcla con
+// un peso mínimo de SURFEL_BOUNCE_MIN_BLEND para que siga a la caché a medida que los vecinos acumulan rebotes
+const float SURFEL_BOUNCE_WEIGHT = 1.0;
+const uint SURFEL_BOUNCE_MAX_SURFELS = 16;
+const float SURFEL_BOUNCE_MIN_BLEND = 0.05;
+// Los rebotes siguen cambiando después de que converja la radiancia directa, a medida que los vecinos acumulan luz. Cada
+// surfel guarda la media móvil (con peso SURFEL_BOUNCE_TREND_BLEND) de la diferencia con signo entre los rebotes de cada
+// lote y los acumulados, relativa a su irradiancia total, y sigue recibiendo rayos mientras supere en valor absoluto
+// SURFEL_BOUNCE_CONVERGED_CHANGE, aunque la parte directa haya convergido o haya alcanzado MAX_RAYS_PER_SURFEL. Al ir con
+// signo, el ruido de los lotes se compensa y sólo queda la tendencia de la caché
+const float SURFEL_BOUNCE_TREND_BLEND = 0.1;
+const float SURFEL_BOUNCE_CONVERGED_CHANGE = 0.02;
+// Volumen de irradiancia: cada celda ocupada guarda la irradiancia media de los surfels que la solapan y un término
+// lineal con la normal ajustado por mínimos cuadrados, para que el sombreado indirecto haga una sola consulta filtrada
+// por píxel. Los surfels se ponderan con una gaussiana de SURFEL_VOLUME_SIGMA celdas alrededor del centro de la celda,
+// y SURFEL_VOLUME_REGULARIZATION estabiliza el ajuste cuando las normales de la celda apenas varían
+const float SURFEL_VOLUME_SIGMA = 0.75;
+const float SURFEL_VOLUME_REGULARIZATION = 0.1;
+// La iluminación difusa indirecta se calcula a 1/INDIRECT_DIFFUSE_DOWNSCALE de la resolución en cada eje (1, 2 o 4), con
+// el píxel superior izquierdo de cada bloque, y la composición la reescala guiándose por la profundidad y las normales
+const uint INDIRECT_DIFFUSE_DOWNSCALE = 2;
+
+// Número máximo de referencias surfel-celda en la lista compactada (cada surfel puede solapar hasta 27 celdas)
+const uint SURFEL_CELL_BUFFER_SIZE = SURFEL_CAPACITY * 27;
+// Número de celdas que procesa cada grupo en el cálculo de offsets del grid
+const uint SURFEL_GRID_SCAN_BLOCK_SIZE = 1024;
+
+// Ciclo de vida de los surfels: frames sin cubrir ningún píxel visible tras los que se recicla un surfel, edad mínima
+// para considerarlo redundante, y distancia (relativa a su radio) a la que otro surfel más antiguo lo hace redundante
+const uint SURFEL_MAX_UNSEEN_FRAMES = 600;
+const uint SURFEL_MIN_RECYCLE_AGE = 30;
+const float SURFEL_REDUNDANT_DISTANCE_FACTOR = 0.25;
+// Bits de flags de cada surfel. Los de un bake offline cubren toda la escena y no se reciclan por no verse
+const uint SURFEL_FLAG_BAKED = 1;
+
+// Posiciones del buffer de estadísticas
+const uint SURFEL_STATS_COUNT = 0;
+const uint SURFEL_STATS_CELL_ALLOCATOR = 1;
+const uint SURFEL_STATS_FREE_COUNT = 2;
+// Argumentos de dibujado indirecto (VkDrawIndirectCommand) de la visualización de surfels
+const uint SURFEL_STATS_DRAW_ARGS = 4;
+// Argumentos del dispatch indirecto (VkDispatchIndirectCommand) de las pasadas con un hilo por surfel
+const uint SURFEL_STATS_DISPATCH_ARGS = 8;
+const uint SURFEL_STATS_SIZE = 12;
+// Hilos por grupo de las pasadas con un hilo por surfel que se lanzan con dispatch indirecto
+const uint SURFEL_GROUP_SIZE = 64;
+
+// Planificación de rayos: los surfels que necesitan rayos se reparten en cubos según su prioridad, y el presupuesto
+// de rayos del frame se asigna empezando por los cubos más prioritarios. La prioridad combina lo nuevo que es el
+// surfel, la varianza de su radiancia, la distancia a la cámara y lo reciente que ha sido visto
+const uint SURFEL_PRIORITY_BUCKETS = 64;
+const float SURFEL_PRIORITY_WEIGHT_NEW = 0.3;
+const float SURFEL_PRIORITY_WEIGHT_VARIANCE = 0.3;
+const float SURFEL_PRIORITY_WEIGHT_DISTANCE = 0.2;
+const float SURFEL_PRIORITY_WEIGHT_SEEN = 0.2;
+const float SURFEL_PRIORITY_DISTANCE_SCALE = 1000.0;
+const float SURFEL_PRIORITY_SEEN_SCALE = 30.0;
+
+// Cabecera de la cola de surfels que trazan rayos en el frame, seguida del histograma de prioridades y de la cola
+const uint SURFEL_RAY_QUEUE_COUNT = 0;
+const uint SURFEL_RAY_QUEUE_HIGH_PRIORITY_COUNT = 1;
+const uint SURFEL_RAY_QUEUE_THRESHOLD_BUCKET = 2;
+const uint SURFEL_RAY_QUEUE_HIGH_PRIORITY_CURSOR = 3;
+const uint SURFEL_RAY_QUEUE_THRESHOLD_CURSOR = 4;
+// Argumentos del dispatch indirecto (VkDispatchIndirectCommand) del cálculo de radiancia
+const uint SURFEL_RAY_QUEUE_DISPATCH_ARGS = 5;
+const uint SURFEL_RAY_QUEUE_HEADER_SIZE = 8;
\ No newline at end of file
@@ -1,19 +1,14 @@
-const uvec3 SURFEL_GRID_DIMENSIONS = uvec3(256, 128, 128);
-const uint SURFEL_TABLE_SIZE = SURFEL_GRID_DIMENSIONS.x * SURFEL_GRID_DIMENSIONS.y * SURFEL_GRID_DIMENSIONS.z; 
-const float SURFEL_MAX_RADIUS = 12.5;
-const float CELL_LENGTH = 30;
-const uint SURFEL_CAPACITY = 100000;
-const float SURFEL_TARGET_COVERAGE = 0.2;
-const uint MAX_RAYS_PER_SURFEL = 2500;
-const uint NUM_RAYS = 50;
-const uint RAYS_LENGTH = 1500;
-const float INDIRECT_DIFFUSE_ILLUMINATION_WEIGHT = 1.0;
-const float ANGULAR_INDIRECT_DIFFUSE_MIN_FACTOR = 0.025;
+#include "surfelsConstants.glsl"
 
 #define PI 3.14159265358979323846
 #define SQRT_PI 1.772453851
 
-const uint SURFEL_CELL_LIMIT = 30;
+// Cada celda del grid guarda cuántos surfels la solapan y dónde empieza su lista en el buffer compactado
+struct SurfelGridCell
+{
+	uint count;
+	uint offset;
+};
 
 struct Surfel
 {
@@ -22,25 +17,81 @@ struct Surfel
 	vec3 normal;
     	int generatedRays;
 	vec3 color;
-	float pad1;
+	uint lastSeenFrame;
 	vec3 direct_radiance;
-    	float padding2;
+    	uint age;
     	vec3 indirect_radiance;
-    	float padding3;
+    	float luminanceMoment2;
+    	float indirectTrend;
+    	uint flags;
+    	uint padding[2];
 };
 
-ivec3 surfel_cell(vec3 position){
-	return ivec3(floor((position) / CELL_LENGTH) + SURFEL_GRID_DIMENSIONS / 2);
+// Los surfels reciclados (o nunca generados) no tienen rayos, y el resto empieza con uno al generarse
+bool surfel_isAlive(Surfel surfel)
+{
+	return surfel.generatedRays > 0;
 }
 
-bool surfel_cellValid(ivec3 cell){
-	if (cell.x < 0 || cell.x >= SURFEL_GRID_DIMENSIONS.x)
-		return false;
-	if (cell.y < 0 || cell.y >= SURFEL_GRID_DIMENSIONS.y)
-		return false;
-	if (cell.z < 0 || cell.z >= SURFEL_GRID_DIMENSIONS.z)
+// El contador de rayos empieza en uno al generar el surfel para distinguirlo de los libres, así que las muestras
+// acumuladas en la media de radiancia son una menos
+uint surfel_sampleCount(Surfel surfel)
+{
+	return uint(max(surfel.generatedRays - 1, 0));
+}
+
+// Radiancia total que llega al surfel: la directa desde el primer choque y la de los rebotes leídos de la caché
+vec3 surfel_irradiance(Surfel surfel)
+{
+	return surfel.direct_radiance + surfel.indirect_radiance;
+}
+
+// Error relativo de la media de radiancia del surfel, a partir de la varianza de la luminancia de sus muestras.
+// Sin muestras el error es máximo
+float surfel_relativeError(Surfel surfel)
+{
+	uint samples = surfel_sampleCount(surfel);
+	if (samples == 0)
+	{
+		return 1.0;
+	}
+
+	float meanLuminance = dot(surfel.direct_radiance, SURFEL_LUMINANCE_WEIGHTS);
+	float variance = max(surfel.luminanceMoment2 - meanLuminance * meanLuminance, 0.0);
+	return sqrt(variance / float(samples)) / max(meanLuminance, 1e-4);
+}
+
+// La radiancia directa acumula muestras mientras no haya alcanzado el máximo ni haya convergido
+bool surfel_needsDirectRays(Surfel surfel)
+{
+	if (!surfel_isAlive(surfel) || surfel.generatedRays >= MAX_RAYS_PER_SURFEL)
+	{
 		return false;
-	return true;
+	}
+	return surfel_sampleCount(surfel) < SURFEL_MIN_SAMPLES || surfel_relativeError(surfel) >= SURFEL_CONVERGED_ERROR;
+}
+
+// Un surfel necesita rayos mientras lo necesite su radiancia directa o mientras los rebotes que le llegan de la caché
+// sigan cambiando
+bool surfel_needsRays(Surfel surfel)
+{
+	return surfel_needsDirectRays(surfel) || (surfel_isAlive(surfel) && abs(surfel.indirectTrend) >= SURFEL_BOUNCE_CONVERGED_CHANGE);
+}
+
+// Cubo de prioridad del surfel en la planificación de rayos. Los más altos reciben rayos antes
+uint surfel_rayPriorityBucket(Surfel surfel, vec3 cameraPosition, uint frame)
+{
+	// Hasta reunir el mínimo de muestras la varianza no es fiable, así que se prioriza a los surfels que aún no lo tienen
+	float newness = 1.0 - min(float(surfel_sampleCount(surfel)) / float(SURFEL_MIN_SAMPLES), 1.0);
+	// La varianza de la radiancia directa sólo cuenta mientras siga acumulando muestras; después queda la de los rebotes
+	float directError = surfel_needsDirectRays(surfel) ? surfel_relativeError(surfel) : 0.0;
+	float variance = clamp(max(directError, abs(surfel.indirectTrend)), 0.0, 1.0);
+	float proximity = 1.0 / (1.0 + distance(surfel.position, cameraPosition) / SURFEL_PRIORITY_DISTANCE_SCALE);
+	float seen = 1.0 / (1.0 + float(frame - surfel.lastSeenFrame) / SURFEL_PRIORITY_SEEN_SCALE);
+
+	float priority = SURFEL_PRIORITY_WEIGHT_NEW * newness + SURFEL_PRIORITY_WEIGHT_VARIANCE * variance +
+					 SURFEL_PRIORITY_WEIGHT_DISTANCE * proximity + SURFEL_PRIORITY_WEIGHT_SEEN * seen;
+	return min(uint(priority * float(SURFEL_PRIORITY_BUCKETS)), SURFEL_PRIORITY_BUCKETS - 1);
 }
 
 uint flatten3D(uvec3 coord, uvec3 dim)
@@ -48,9 +99,57 @@ uint flatten3D(uvec3 coord, uvec3 dim)
 	return (coord.z * dim.x * dim.y) + (coord.y * dim.x) + coord.x;
 }
 
-uint surfel_cellIndex(ivec3 cell)
+// Lado de las celdas de un nivel del clipmap
+float surfel_cellLength(uint level)
+{
+	return CELL_LENGTH * float(1u << level);
+}
+
+// Radio máximo de los surfels de un nivel, para que cada uno solape como mucho las 27 celdas vecinas de la suya
+float surfel_levelMaxRadius(uint level)
+{
+	return SURFEL_MAX_RADIUS * float(1u << level);
+}
+
+// Las celdas se identifican por sus coordenadas de mundo en el nivel, que no cambian al moverse la cámara
+ivec3 surfel_cell(vec3 position, uint level){
+	return ivec3(floor(position / surfel_cellLength(level)));
+}
+
+// Primera celda de la ventana del nivel, centrada en la celda de la cámara
+ivec3 surfel_levelOrigin(uint level, vec3 cameraPosition)
+{
+	return surfel_cell(cameraPosition, level) - ivec3(SURFEL_GRID_DIMENSIONS / 2);
+}
+
+bool surfel_cellValid(ivec3 cell, uint level, vec3 cameraPosition){
+	ivec3 local = cell - surfel_levelOrigin(level, cameraPosition);
+	return all(greaterThanEqual(local, ivec3(0))) && all(lessThan(local, ivec3(SURFEL_GRID_DIMENSIONS)));
+}
+
+// Nivel más fino en cuya ventana está la posición con todas sus celdas vecinas. Fuera del clipmap devuelve
+// SURFEL_CLIPMAP_LEVELS
+uint surfel_clipmapLevel(vec3 position, vec3 cameraPosition)
+{
+	for (uint level = 0; level < SURFEL_CLIPMAP_LEVELS; ++level)
+	{
+		ivec3 local = surfel_cell(position, level) - surfel_levelOrigin(level, cameraPosition);
+		if (all(greaterThanEqual(local, ivec3(1))) && all(lessThan(local, ivec3(SURFEL_GRID_DIMENSIONS) - 1)))
+		{
+			return level;
+		}
+	}
+	return SURFEL_CLIPMAP_LEVELS;
+}
+
+// Direccionamiento toroidal: la celda ocupa la posición de sus coordenadas de mundo módulo las dimensiones del nivel.
+// Al desplazarse la ventana, las celdas que siguen dentro conservan su posición y las que entran ocupan la de las que
+// salen. Quien lea el grid de un frame anterior puede encontrar en esas celdas surfels de la celda que salió, pero
+// todas las consultas filtran los surfels por su distancia o por su celda
+uint surfel_cellIndex(ivec3 cell, uint level)
 {
-	return flatten3D(uvec3(cell), SURFEL_GRID_DIMENSIONS);
+	uvec3 wrapped = uvec3(cell & ivec3(SURFEL_GRID_DIMENSIONS - 1u));
+	return level * SURFEL_LEVEL_TABLE_SIZE + flatten3D(wrapped, SURFEL_GRID_DIMENSIONS);
 }
 
 const vec3 surfel_neighbour_offsets[27] = {
@@ -98,23 +197,24 @@ float distanceSquared(vec3 a, vec3 b) {
     return dot(d, d);
 }
 
-bool surfel_cellIntersects(Surfel surfel, ivec3 cell)
+bool surfel_cellIntersects(Surfel surfel, ivec3 cell, uint level, vec3 cameraPosition)
 {
-    if (!surfel_cellValid(cell)) {
+    if (!surfel_cellValid(cell, level, cameraPosition)) {
         return false;
     }
 
-    const float cellSize = CELL_LENGTH;
+    float cellSize = surfel_cellLength(level);
     // Reconstruimos el AABB en espacio mundo desde la celda
-    vec3 cellMin = (vec3(cell) - vec3(SURFEL_GRID_DIMENSIONS) / 2.0) * cellSize;
+    vec3 cellMin = vec3(cell) * cellSize;
     vec3 cellMax = cellMin + vec3(cellSize);
 
     // Punto más cercano de la celda al surfel
     vec3 closestPoint = clamp(surfel.position, cellMin, cellMax);
 
-    // Si está a menos de un radio, hay intersección
+    // Si está a menos del radio máximo del nivel, hay intersección
+    float maxRadius = surfel_levelMaxRadius(level);
     float distSquared = dot(surfel.position - closestPoint, surfel.position - closestPoint);
-    return distSquared < (SURFEL_MAX_RADIUS * SURFEL_MAX_RADIUS);
+    return distSquared < (maxRadius * maxRadius);
 }
 
 uint hash_uint(uint x) {
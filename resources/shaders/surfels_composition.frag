@@ -122,19 +122,55 @@ vec3 shadeMainLight() {
 
 }
 
-vec3 sampleIndirectDiffuse(vec2 uv) {
-    vec2 texelSize = 1.0 / vec2(textureSize(indirectDiffuseMap, 0));
-    vec3 result = vec3(0.0);
-    int count = 0;
+// Reescalado bilateral conjunto de la iluminación indirecta, que se calcula a resolución reducida. Los cuatro píxeles
+// más cercanos de la imagen reducida se ponderan con el filtro bilineal, y cada uno pierde peso según se alejan su
+// profundidad y su normal de las del píxel. Su guía es el píxel del G-Buffer con el que se calcularon (el superior
+// izquierdo de su bloque), para que la iluminación no cruce los bordes de la geometría
+const float UPSAMPLE_DEPTH_SIGMA = 0.05;    // Relativa a la profundidad del píxel
+const float UPSAMPLE_NORMAL_POWER = 16.0;
+const float UPSAMPLE_MIN_WEIGHT = 1e-3;
+
+vec3 sampleIndirectDiffuse() {
+    ivec2 lowResSize = textureSize(indirectDiffuseMap, 0);
+    ivec2 gBufferSize = textureSize(samplerPosition, 0);
+    vec3 N = normalize(fragNormal);
 
-    for (int x = -1; x <= 1; ++x) {
-        for (int y = -1; y <= 1; ++y) {
-            vec2 offset = vec2(x, y) * texelSize;
-            result += texture(indirectDiffuseMap, uv + offset).rgb;
-            count++;
+    // El píxel i de la imagen reducida está en el píxel i * INDIRECT_DIFFUSE_DOWNSCALE de la pantalla
+    vec2 lowResCoord = floor(gl_FragCoord.xy) / float(INDIRECT_DIFFUSE_DOWNSCALE);
+    ivec2 basePixel = ivec2(lowResCoord);
+    vec2 f = lowResCoord - vec2(basePixel);
+
+    vec3 result = vec3(0.0);
+    float totalWeight = 0.0;
+    vec3 closestSample = vec3(0.0);
+    float closestDepthDifference = 1e30;
+
+    for (int y = 0; y <= 1; ++y) {
+        for (int x = 0; x <= 1; ++x) {
+            ivec2 samplePixel = min(basePixel + ivec2(x, y), lowResSize - 1);
+            ivec2 guidePixel = min(samplePixel * int(INDIRECT_DIFFUSE_DOWNSCALE), gBufferSize - 1);
+            vec3 guidePosition = texelFetch(samplerPosition, guidePixel, 0).xyz;
+            vec3 guideNormal = normalize(texelFetch(samplerNormal, guidePixel, 0).xyz * 2.0 - 1.0);
+            vec3 indirect = texelFetch(indirectDiffuseMap, samplePixel, 0).rgb;
+
+            float bilinear = (x == 1 ? f.x : 1.0 - f.x) * (y == 1 ? f.y : 1.0 - f.y);
+            float depthDifference = abs(guidePosition.z - fragPos.z);
+            float depthWeight = exp(-depthDifference / (UPSAMPLE_DEPTH_SIGMA * abs(fragPos.z) + 1e-4));
+            float normalWeight = pow(max(dot(guideNormal, N), 0.0), UPSAMPLE_NORMAL_POWER);
+
+            float weight = bilinear * depthWeight * normalWeight;
+            result += indirect * weight;
+            totalWeight += weight;
+
+            if (depthDifference < closestDepthDifference) {
+                closestDepthDifference = depthDifference;
+                closestSample = indirect;
+            }
         }
     }
-    return result / float(count);
+
+    // Si ninguno se parece al píxel (geometría más fina que un bloque) se toma el de profundidad más cercana
+    return totalWeight > UPSAMPLE_MIN_WEIGHT ? result / totalWeight : closestSample;
 }
 
 
@@ -143,7 +179,7 @@ void main()
 	fragPos = texture(samplerPosition, inUV).rgb;
 	fragNormal = normalize(texture(samplerNormal, inUV).rgb * 2.0 - 1.0);
 	albedo = texture(samplerAlbedo, inUV);
-	indirectDiffuse = sampleIndirectDiffuse(inUV);
+	indirectDiffuse = sampleIndirectDiffuse();
 	specular = texture(samplerSpecular, inUV); 
 	ssao = texture(samplerSSAOBlur, inUV).r;
 
@@ -0,0 +1,402 @@
+#include "SurfelBakeJob.h"
+
+#include "Buffers/SurfelCacheFile.h"
+#include "Tools/MappedFile.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstring>
+
+using namespace SurfelShader;
+
+namespace
+{
+    // Borde que cada región hornea fuera de sí misma, y a lo largo del cual el merge pasa de una región a otra
+    const float BRICK_BORDER = 2.0f * CELL_LENGTH;
+    const char *JOB_FILE_NAME = "bake.job";
+    // Intervalo con el que se comprueba si han llegado los parciales, y con el que se informa de los pendientes
+    const auto PARTIALS_POLL_INTERVAL = std::chrono::seconds(1);
+    const uint32_t PARTIALS_REPORT_POLLS = 30;
+    // Los workers actualizan la fecha de su directorio de reclamación mientras hornean la región. Una reclamación sin
+    // actualizar durante CLAIM_STALE_TIMEOUT es de un worker que ha fallado. El margen es amplio para tolerar la
+    // diferencia de reloj entre nodos que comparten el directorio
+    const auto CLAIM_HEARTBEAT_INTERVAL = std::chrono::seconds(10);
+    const auto CLAIM_STALE_TIMEOUT = std::chrono::seconds(120);
+
+    // Mantiene viva una reclamación desde un hilo propio mientras exista el objeto
+    class ClaimHeartbeat
+    {
+    public:
+        explicit ClaimHeartbeat(const std::string &claimPath) : heartbeatThread([this, claimPath]()
+                                                                                 { refresh(claimPath); }) {}
+
+        ~ClaimHeartbeat()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopped = true;
+            }
+            stopCondition.notify_one();
+            heartbeatThread.join();
+        }
+
+    private:
+        std::mutex mutex;
+        std::condition_variable stopCondition;
+        bool stopped = false;
+        std::thread heartbeatThread;
+
+        void refresh(const std::string &claimPath)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!stopCondition.wait_for(lock, CLAIM_HEARTBEAT_INTERVAL, [this]()
+                                           { return stopped; }))
+            {
+                std::error_code errorCode;
+                std::filesystem::last_write_time(claimPath, std::filesystem::file_time_type::clock::now(), errorCode);
+            }
+        }
+    };
+}
+
+void SurfelBakeJob::prepare(const std::string &jobDirectory, uint32_t brickCount)
+{
+    std::filesystem::create_directories(jobDirectory);
+    for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(jobDirectory))
+    {
+        std::string extension = entry.path().extension().string();
+        if (extension == ".claim" || extension == ".partial" || extension == ".tmp")
+        {
+            std::filesystem::remove_all(entry.path());
+        }
+    }
+
+    std::ofstream jobFile((std::filesystem::path(jobDirectory) / JOB_FILE_NAME).string(), std::ios::trunc);
+    if (!jobFile)
+    {
+        throw std::runtime_error("failed to write surfel bake job file!");
+    }
+    jobFile << brickCount << std::endl;
+}
+
+void SurfelBakeJob::runLocalWorkers(const std::string &executablePath, const std::string &jobDirectory, uint32_t workerCount)
+{
+    uint32_t threadsPerWorker = std::max(1u, std::thread::hardware_concurrency() / std::max(workerCount, 1u));
+    std::vector<std::thread> workers;
+    for (uint32_t i = 0; i < workerCount; i++)
+    {
+        std::string command = "\"" + executablePath + "\" --worker \"" + jobDirectory + "\" " + std::to_string(threadsPerWorker);
+#ifdef _WIN32
+        // cmd.exe quita las comillas exteriores cuando la orden empieza por comillas
+        command = "\"" + command + "\"";
+#endif
+        workers.emplace_back([command, i]()
+                             {
+            if (std::system(command.c_str()) != 0)
+            {
+                std::cerr << "El worker local " << i << " del bake ha terminado con error" << std::endl;
+            } });
+    }
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+uint32_t SurfelBakeJob::runWorker(const std::string &jobDirectory, ThreadPool &threadPool)
+{
+    uint32_t brickCount = readBrickCount(jobDirectory);
+
+    // La escena se carga al reclamar la primera región, para no hacerlo si ya no queda ninguna libre
+    SurfelBaker baker(threadPool);
+    std::vector<SurfelBakeBrick> bricks;
+    uint32_t bakedBricks = 0;
+
+    for (uint32_t brick = 0; brick < brickCount; brick++)
+    {
+        std::error_code errorCode;
+        std::string claimPath = getClaimPath(jobDirectory, brick);
+        if (std::filesystem::exists(getPartialPath(jobDirectory, brick)) || !std::filesystem::create_directory(claimPath, errorCode))
+        {
+            continue;
+        }
+
+        // Si el bake de la región falla se libera la reclamación, para que otro worker o el coordinador la repitan
+        try
+        {
+            ClaimHeartbeat heartbeat(claimPath);
+
+            if (bricks.empty())
+            {
+                baker.loadScene();
+                baker.placeSurfels();
+                bricks = baker.computeBricks(brickCount);
+            }
+
+            std::cout << "Region " << brick << "/" << brickCount << std::endl;
+            baker.restrictToBrick(bricks[brick], BRICK_BORDER);
+            baker.integrate();
+
+            std::vector<uint32_t> indices;
+            std::vector<Surfel> surfels;
+            baker.getActiveSurfels(&indices, &surfels);
+
+            SurfelBakePartialHeader header{};
+            memcpy(header.magic, SURFEL_BAKE_PARTIAL_MAGIC, sizeof(header.magic));
+            header.version = SURFEL_BAKE_PARTIAL_VERSION;
+            header.sceneHash = baker.getSceneHash();
+            header.brick = brick;
+            header.brickCount = brickCount;
+            header.surfelCount = baker.getSurfelCount();
+            header.entryCount = static_cast<uint32_t>(indices.size());
+            header.surfelStride = sizeof(Surfel);
+            header.frameCounter = baker.getFrameCounter();
+            for (int axis = 0; axis < 3; axis++)
+            {
+                header.brickMin[axis] = bricks[brick].min[axis];
+                header.brickMax[axis] = bricks[brick].max[axis];
+            }
+            header.border = BRICK_BORDER;
+            if (!writePartial(getPartialPath(jobDirectory, brick), header, indices, surfels))
+            {
+                throw std::runtime_error("failed to write surfel bake partial!");
+            }
+        }
+        catch (...)
+        {
+            std::filesystem::remove_all(claimPath, errorCode);
+            throw;
+        }
+        bakedBricks++;
+    }
+    return bakedBricks;
+}
+
+void SurfelBakeJob::waitForPartials(const std::string &jobDirectory, ThreadPool &threadPool)
+{
+    uint32_t brickCount = readBrickCount(jobDirectory);
+    for (uint32_t poll = 0;; poll++)
+    {
+        std::vector<uint32_t> pending;
+        bool freeBricks = false;
+        for (uint32_t brick = 0; brick < brickCount; brick++)
+        {
+            if (std::filesystem::exists(getPartialPath(jobDirectory, brick)))
+            {
+                continue;
+            }
+            pending.push_back(brick);
+
+            // Una reclamación que no se actualiza es de un worker que ha fallado sin liberarla, así que se borra
+            std::error_code errorCode;
+            std::string claimPath = getClaimPath(jobDirectory, brick);
+            std::filesystem::file_time_type claimTime = std::filesystem::last_write_time(claimPath, errorCode);
+            if (errorCode)
+            {
+                freeBricks = true;
+            }
+            else if (std::filesystem::file_time_type::clock::now() - claimTime > CLAIM_STALE_TIMEOUT)
+            {
+                std::cout << "La reclamación de la región " << brick << " no se actualiza; se vuelve a hornear" << std::endl;
+                std::filesystem::remove_all(claimPath, errorCode);
+                freeBricks = true;
+            }
+        }
+        if (pending.empty())
+        {
+            return;
+        }
+
+        // Las regiones libres, porque ningún worker las ha cogido o porque el suyo ha fallado, las hornea el propio
+        // coordinador. Si su bake falla también aquí, la excepción termina el trabajo en lugar de esperar para siempre
+        if (freeBricks)
+        {
+            uint32_t bakedBricks = runWorker(jobDirectory, threadPool);
+            std::cout << "Regiones horneadas por el coordinador: " << bakedBricks << std::endl;
+            continue;
+        }
+
+        // El resto las están horneando workers de otros nodos
+        if (poll % PARTIALS_REPORT_POLLS == 0)
+        {
+            std::cout << "Regiones pendientes:";
+            for (uint32_t brick : pending)
+            {
+                std::cout << " " << brick;
+            }
+            std::cout << std::endl;
+        }
+        std::this_thread::sleep_for(PARTIALS_POLL_INTERVAL);
+    }
+}
+
+bool SurfelBakeJob::merge(const std::string &jobDirectory, ThreadPool &threadPool, const std::string &cachePath)
+{
+    uint32_t brickCount = readBrickCount(jobDirectory);
+
+    SurfelReference merged(threadPool);
+    uint64_t sceneHash = 0;
+    std::vector<float> weights;
+    std::vector<glm::vec3> directRadiance;
+    std::vector<glm::vec3> indirectRadiance;
+    std::vector<float> luminanceMoment2;
+    std::vector<float> indirectTrend;
+
+    for (uint32_t brick = 0; brick < brickCount; brick++)
+    {
+        MappedFile partialFile;
+        if (!partialFile.open(getPartialPath(jobDirectory, brick)) || partialFile.getSize() < sizeof(SurfelBakePartialHeader))
+        {
+            throw std::runtime_error("failed to open surfel bake partial!");
+        }
+        const uint8_t *data = partialFile.getData();
+        const SurfelBakePartialHeader *header = reinterpret_cast<const SurfelBakePartialHeader *>(data);
+        uint64_t indicesSize = static_cast<uint64_t>(header->entryCount) * sizeof(uint32_t);
+        uint64_t surfelsSize = static_cast<uint64_t>(header->entryCount) * sizeof(Surfel);
+        if (memcmp(header->magic, SURFEL_BAKE_PARTIAL_MAGIC, sizeof(header->magic)) != 0 || header->version != SURFEL_BAKE_PARTIAL_VERSION ||
+            header->surfelStride != sizeof(Surfel) || header->brick != brick || header->brickCount != brickCount || header->surfelCount > SURFEL_CAPACITY ||
+            header->indicesOffset > partialFile.getSize() || indicesSize > partialFile.getSize() - header->indicesOffset ||
+            header->surfelsOffset > partialFile.getSize() || surfelsSize > partialFile.getSize() - header->surfelsOffset)
+        {
+            throw std::runtime_error("failed to merge surfel bake: invalid partial!");
+        }
+
+        // Todas las regiones tienen que venir de la misma escena y del mismo reparto
+        if (brick == 0)
+        {
+            sceneHash = header->sceneHash;
+            merged.surfelCount = header->surfelCount;
+            weights.assign(merged.surfelCount, 0.0f);
+            directRadiance.assign(merged.surfelCount, glm::vec3(0.0f));
+            indirectRadiance.assign(merged.surfelCount, glm::vec3(0.0f));
+            luminanceMoment2.assign(merged.surfelCount, 0.0f);
+            indirectTrend.assign(merged.surfelCount, 0.0f);
+        }
+        else if (header->sceneHash != sceneHash || header->surfelCount != merged.surfelCount)
+        {
+            throw std::runtime_error("failed to merge surfel bake: partials come from different scenes!");
+        }
+        merged.frame = std::max(merged.frame, header->frameCounter);
+
+        SurfelBakeBrick brickBounds{glm::vec3(header->brickMin[0], header->brickMin[1], header->brickMin[2]),
+                                    glm::vec3(header->brickMax[0], header->brickMax[1], header->brickMax[2])};
+        const uint32_t *indices = reinterpret_cast<const uint32_t *>(data + header->indicesOffset);
+        const Surfel *surfels = reinterpret_cast<const Surfel *>(data + header->surfelsOffset);
+        for (uint32_t i = 0; i < header->entryCount; i++)
+        {
+            uint32_t surfelIndex = indices[i];
+            if (surfelIndex >= merged.surfelCount)
+            {
+                throw std::runtime_error("failed to merge surfel bake: invalid partial!");
+            }
+            const Surfel &surfel = surfels[i];
+            float weight = brickWeight(brickBounds, header->border, surfel.position);
+            if (weight <= 0.0f)
+            {
+                continue;
+            }
+
+            // La geometría es la misma en todas las regiones; de las muestras y la edad se toma la mayor
+            Surfel &result = merged.surfels[surfelIndex];
+            if (weights[surfelIndex] == 0.0f)
+            {
+                result = surfel;
+            }
+            result.generatedRays = std::max(result.generatedRays, surfel.generatedRays);
+            result.age = std::max(result.age, surfel.age);
+
+            weights[surfelIndex] += weight;
+            directRadiance[surfelIndex] += weight * surfel.direct_radiance;
+            indirectRadiance[surfelIndex] += weight * surfel.indirect_radiance;
+            luminanceMoment2[surfelIndex] += weight * surfel.luminanceMoment2;
+            indirectTrend[surfelIndex] += weight * surfel.indirectTrend;
+        }
+    }
+
+    for (uint32_t i = 0; i < merged.surfelCount; i++)
+    {
+        if (weights[i] == 0.0f)
+        {
+            throw std::runtime_error("failed to merge surfel bake: a surfel is not covered by any partial!");
+        }
+        merged.surfels[i].direct_radiance = directRadiance[i] / weights[i];
+        merged.surfels[i].indirect_radiance = indirectRadiance[i] / weights[i];
+        merged.surfels[i].luminanceMoment2 = luminanceMoment2[i] / weights[i];
+        merged.surfels[i].indirectTrend = indirectTrend[i] / weights[i];
+    }
+
+    merged.buildGrid();
+    return SurfelBaker::writeCache(cachePath.empty() ? SurfelCacheFile::getCachePath(sceneHash) : cachePath, sceneHash, merged);
+}
+
+uint32_t SurfelBakeJob::readBrickCount(const std::string &jobDirectory)
+{
+    std::ifstream jobFile((std::filesystem::path(jobDirectory) / JOB_FILE_NAME).string());
+    uint32_t brickCount = 0;
+    if (!(jobFile >> brickCount) || brickCount == 0)
+    {
+        throw std::runtime_error("failed to read surfel bake job file!");
+    }
+    return brickCount;
+}
+
+std::string SurfelBakeJob::getClaimPath(const std::string &jobDirectory, uint32_t brick)
+{
+    return (std::filesystem::path(jobDirectory) / ("brick_" + std::to_string(brick) + ".claim")).string();
+}
+
+std::string SurfelBakeJob::getPartialPath(const std::string &jobDirectory, uint32_t brick)
+{
+    return (std::filesystem::path(jobDirectory) / ("brick_" + std::to_string(brick) + ".partial")).string();
+}
+
+bool SurfelBakeJob::writePartial(const std::string &partialPath, const SurfelBakePartialHeader &header, const std::vector<uint32_t> &indices,
+                                 const std::vector<Surfel> &surfels)
+{
+    SurfelBakePartialHeader partialHeader = header;
+    partialHeader.indicesOffset = alignPartialOffset(sizeof(SurfelBakePartialHeader));
+    partialHeader.surfelsOffset = alignPartialOffset(partialHeader.indicesOffset + indices.size() * sizeof(uint32_t));
+
+    // Como en la caché, se escribe en un fichero temporal y se renombra al terminar, de modo que el coordinador nunca
+    // ve un parcial a medias
+    std::string temporaryPath = partialPath + ".tmp";
+    std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        return false;
+    }
+    const char padding[SURFEL_BAKE_PARTIAL_ALIGNMENT] = {};
+    file.write(reinterpret_cast<const char *>(&partialHeader), sizeof(partialHeader));
+    file.write(padding, partialHeader.indicesOffset - static_cast<uint64_t>(file.tellp()));
+    file.write(reinterpret_cast<const char *>(indices.data()), indices.size() * sizeof(uint32_t));
+    file.write(padding, partialHeader.surfelsOffset - static_cast<uint64_t>(file.tellp()));
+    file.write(reinterpret_cast<const char *>(surfels.data()), surfels.size() * sizeof(Surfel));
+    file.close();
+
+    std::error_code errorCode;
+    std::filesystem::rename(temporaryPath, partialPath, errorCode);
+    if (errorCode)
+    {
+        std::filesystem::remove(temporaryPath, errorCode);
+        return false;
+    }
+    return true;
+}
+
+uint64_t SurfelBakeJob::alignPartialOffset(uint64_t offset)
+{
+    return (offset + SURFEL_BAKE_PARTIAL_ALIGNMENT - 1) & ~static_cast<uint64_t>(SURFEL_BAKE_PARTIAL_ALIGNMENT - 1);
+}
+
+float SurfelBakeJob::brickWeight(const SurfelBakeBrick &brick, float border, const glm::vec3 &position)
+{
+    return glm::clamp((brick.insideDistance(position) + border) / (2.0f * border), 0.0f, 1.0f);
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "SurfelBaker.h"
+#include "Surfels/SurfelData.h"
+#include "Tools/ThreadPool.h"
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+// Resultado parcial de una región del bake distribuido: cabecera y, a continuación, el índice de cada surfel horneado
+// en el reparto completo y el propio surfel
+struct SurfelBakePartialHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t sceneHash;
+    uint32_t brick;
+    uint32_t brickCount;
+    uint32_t surfelCount; // Surfels del reparto completo, igual en todas las regiones
+    uint32_t entryCount;  // Surfels horneados en esta región, incluidos los de su borde
+    uint32_t surfelStride;
+    uint32_t frameCounter;
+    float brickMin[3];
+    float brickMax[3];
+    float border;
+    uint32_t _pad;
+    uint64_t indicesOffset; // Offsets desde el principio del fichero
+    uint64_t surfelsOffset;
+};
+
+// Bake distribuido por regiones del grid a través de un directorio compartido. El coordinador prepara el directorio
+// y lanza workers locales; cualquier otro proceso con acceso al mismo directorio (por ejemplo, en otro nodo con un
+// sistema de ficheros compartido) puede unirse como worker. Cada worker reclama regiones libres creando su directorio
+// de reclamación, que es una operación atómica incluso en sistemas de ficheros en red, hornea la región con su borde
+// y escribe su resultado parcial. Con todos los parciales, el merge mezcla los surfels de los bordes, que se hornean
+// en las dos regiones, con un peso que pasa de una a otra a lo largo del borde
+class SurfelBakeJob
+{
+public:
+    static constexpr const char *SURFEL_BAKE_PARTIAL_MAGIC = "SRFP";
+    static const uint32_t SURFEL_BAKE_PARTIAL_VERSION = 3;
+    static const uint32_t SURFEL_BAKE_PARTIAL_ALIGNMENT = 16;
+
+    // Prepara el directorio del trabajo: borra los resultados de un bake anterior y anota el número de regiones
+    static void prepare(const std::string &jobDirectory, uint32_t brickCount);
+    // Lanza workerCount procesos locales de este mismo ejecutable y espera a que terminen. Los hilos de la máquina
+    // se reparten entre ellos
+    static void runLocalWorkers(const std::string &executablePath, const std::string &jobDirectory, uint32_t workerCount);
+    // Reclama regiones libres del trabajo y las hornea hasta que no queda ninguna. Devuelve las regiones horneadas
+    static uint32_t runWorker(const std::string &jobDirectory, ThreadPool &threadPool);
+    // Espera a que todas las regiones tengan su resultado parcial, incluidas las reclamadas por workers de otros nodos.
+    // Se llama con los workers locales terminados, así que las regiones sin reclamar o cuya reclamación ha dejado de
+    // actualizarse (su worker ha fallado) las hornea el propio coordinador
+    static void waitForPartials(const std::string &jobDirectory, ThreadPool &threadPool);
+    // Mezcla los resultados parciales en una caché de surfels. Con una ruta vacía se escribe en la caché de la escena
+    static bool merge(const std::string &jobDirectory, ThreadPool &threadPool, const std::string &cachePath);
+
+private:
+    static uint32_t readBrickCount(const std::string &jobDirectory);
+    static std::string getClaimPath(const std::string &jobDirectory, uint32_t brick);
+    static std::string getPartialPath(const std::string &jobDirectory, uint32_t brick);
+    static bool writePartial(const std::string &partialPath, const SurfelBakePartialHeader &header, const std::vector<uint32_t> &indices,
+                             const std::vector<Surfel> &surfels);
+    static uint64_t alignPartialOffset(uint64_t offset);
+    // Peso de un surfel horneado en una región: 1 a partir de border dentro de ella, 0.5 en su límite y 0 a border fuera
+    static float brickWeight(const SurfelBakeBrick &brick, float border, const glm::vec3 &position);
+};
\ No newline at end of file
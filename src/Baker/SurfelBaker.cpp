@@ -0,0 +1,443 @@
+#include "SurfelBaker.h"
+
+#include "Config.h"
+#include "Buffers/SurfelCacheFile.h"
+#include "Scene/SceneAssets.h"
+#include "Scene/SponzaResources.h"
+#include "Scene/Illumination/LightsData.h"
+#include "Tools/SamplingSequences.h"
+
+#include <stb_image.h>
+
+#include <unordered_map>
+#include <future>
+#include <random>
+#include <algorithm>
+#include <iostream>
+#include <cmath>
+
+using namespace SurfelShader;
+
+namespace
+{
+    // Candidatos por unidad de área (relativa a la separación al cuadrado) del reparto por dart throwing
+    const float CANDIDATES_PER_AREA = 4.0f;
+    // Surfels que acepta el dart throwing por unidad de área con esa densidad de candidatos, para estimar la separación
+    const float ACCEPTED_PER_AREA = 0.6f;
+    // Dos surfels más cerca que la separación sólo son duplicados si sus normales forman menos de 60 grados, de modo
+    // que las dos caras de una pared fina o los dos lados de una esquina tienen sus propios surfels
+    const float DUPLICATE_NORMAL_COS = 0.5f;
+    // Intentos de reparto, aumentando la separación, si los surfels no caben en el buffer
+    const uint32_t MAX_PLACEMENT_ATTEMPTS = 4;
+    const uint32_t PLACEMENT_SEED = 7919;
+    // Radio de los surfels respecto a la separación del reparto. Ningún punto queda a más de la separación de un surfel,
+    // y con este radio los vecinos se solapan
+    const float RADIUS_PER_SPACING = 0.75f;
+    // Cada pasada da como mucho NUM_RAYS rayos a cada surfel, así que con estas pasadas todos agotan su presupuesto. Los
+    // rebotes que sigan cambiando después se cortan en la última pasada
+    const uint32_t MAX_INTEGRATION_PASSES = MAX_RAYS_PER_SURFEL / NUM_RAYS + 1;
+
+    // Clave de la tabla hash de celdas de la separación mínima con la que se buscan los surfels cercanos
+    uint64_t placementKey(const glm::ivec3 &cell)
+    {
+        return (static_cast<uint64_t>(cell.x & 0x1FFFFF) << 42) | (static_cast<uint64_t>(cell.y & 0x1FFFFF) << 21) | static_cast<uint64_t>(cell.z & 0x1FFFFF);
+    }
+
+    float srgbToLinear(float value)
+    {
+        return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+}
+
+float SurfelBakeBrick::insideDistance(const glm::vec3 &position) const
+{
+    glm::vec3 distances = glm::min(position - min, max - position);
+    return std::min(distances.x, std::min(distances.y, distances.z));
+}
+
+SurfelBaker::SurfelBaker(ThreadPool &threadPool) : threadPool(threadPool), reference(threadPool) {}
+
+void SurfelBaker::loadScene()
+{
+    // Las texturas difusas se decodifican mientras se importan los modelos
+    std::vector<std::future<ImportedModel>> importedModels = SceneAssets::importModels(threadPool);
+    std::vector<std::future<glm::vec3>> materialColors;
+    materialColors.reserve(diffuseTexturesPath.size());
+    for (const char *texturePath : diffuseTexturesPath)
+    {
+        materialColors.push_back(threadPool.enqueue([texturePath]()
+                                                    { return averageTextureColor(texturePath); }));
+    }
+
+    // Mismo orden que SceneManager, para que los materiales y el hash de la escena coincidan con los de la aplicación
+    uint32_t materialIndex = 0;
+    sceneHash = SceneAssets::SCENE_HASH_SEED;
+    for (uint32_t i = 0; i < meshesPaths.size(); i++)
+    {
+        ImportedModel importedModel = importedModels[i].get();
+        SceneAssets::hashSceneData(&sceneHash, &importedModel.sourceHash, sizeof(importedModel.sourceHash));
+        MeshLoader::assignMaterials(&importedModel, &materialIndex);
+
+        for (size_t mesh = 0; mesh < importedModel.vertices.size(); mesh++)
+        {
+            const std::vector<Vertex> &vertices = importedModel.vertices[mesh];
+            if (vertices.empty())
+            {
+                continue;
+            }
+            std::vector<glm::vec3> positions(vertices.size());
+            std::vector<glm::vec3> normals(vertices.size());
+            for (size_t v = 0; v < vertices.size(); v++)
+            {
+                positions[v] = vertices[v].pos;
+                normals[v] = vertices[v].normal;
+            }
+            scene.addMesh(positions, normals, importedModel.indices[mesh], static_cast<uint32_t>(vertices[0].idMaterial));
+        }
+    }
+
+    LightsData sceneLights(lightsPositions, lightsIntensities, lightsColors);
+    SceneAssets::hashMainLight(&sceneHash, sceneLights.mainLight);
+    lightPosition = sceneLights.mainLight.position;
+    lightIntensity = sceneLights.mainLight.intensity;
+
+    std::vector<glm::vec3> materialAlbedos;
+    materialAlbedos.reserve(materialColors.size());
+    for (std::future<glm::vec3> &materialColor : materialColors)
+    {
+        materialAlbedos.push_back(materialColor.get());
+    }
+    scene.setMaterialAlbedos(materialAlbedos);
+    scene.build(threadPool);
+
+    std::cout << "Escena cargada: " << scene.getTriangles().size() << " triángulos, " << materialAlbedos.size() << " materiales" << std::endl;
+}
+
+void SurfelBaker::placeSurfels()
+{
+    const std::vector<glm::vec3> &positions = scene.getPositions();
+    const std::vector<glm::uvec3> &triangles = scene.getTriangles();
+
+    std::vector<float> triangleAreas(triangles.size());
+    double totalArea = 0.0;
+    for (size_t i = 0; i < triangles.size(); i++)
+    {
+        const glm::uvec3 &triangle = triangles[i];
+        triangleAreas[i] = 0.5f * glm::length(glm::cross(positions[triangle.y] - positions[triangle.x], positions[triangle.z] - positions[triangle.x]));
+        totalArea += triangleAreas[i];
+    }
+
+    // La separación parte del radio máximo de los surfels, y se aumenta si con ella no caben en el buffer
+    float spacing = std::max(SURFEL_MAX_RADIUS, static_cast<float>(std::sqrt(ACCEPTED_PER_AREA * totalArea / SURFEL_CAPACITY)));
+    uint32_t accepted = 0;
+    for (uint32_t attempt = 0; attempt < MAX_PLACEMENT_ATTEMPTS; attempt++)
+    {
+        accepted = throwSurfels(spacing, triangleAreas);
+        if (accepted <= SURFEL_CAPACITY)
+        {
+            break;
+        }
+        spacing *= 1.05f * std::sqrt(static_cast<float>(accepted) / SURFEL_CAPACITY);
+    }
+
+    std::cout << "Surfels repartidos: " << reference.surfelCount << " sobre " << totalArea << " unidades^2, separacion " << spacing << std::endl;
+    // El radio se limita al máximo del nivel del clipmap, y con la separación por encima del doble los surfels del nivel
+    // más fino ya no se tocan
+    if (spacing > 2.0f * SURFEL_MAX_RADIUS)
+    {
+        std::cerr << "La separacion " << spacing << " supera el doble del radio maximo del nivel mas fino (" << SURFEL_MAX_RADIUS
+                  << "): quedan huecos entre sus surfels" << std::endl;
+    }
+    if (accepted > SURFEL_CAPACITY)
+    {
+        std::cerr << "La escena necesita " << accepted << " surfels y sólo caben " << SURFEL_CAPACITY << ": el resto de superficies queda sin cubrir" << std::endl;
+    }
+}
+
+uint32_t SurfelBaker::throwSurfels(float spacing, const std::vector<float> &triangleAreas)
+{
+    const std::vector<glm::vec3> &positions = scene.getPositions();
+    const std::vector<glm::vec3> &normals = scene.getNormals();
+    const std::vector<glm::uvec3> &triangles = scene.getTriangles();
+
+    // El reparto es secuencial y con una semilla fija, de modo que el mismo bake produce siempre los mismos surfels
+    std::mt19937 rng(PLACEMENT_SEED);
+    std::uniform_real_distribution<float> unitDistribution(0.0f, 1.0f);
+    std::unordered_map<uint64_t, std::vector<uint32_t>> placedCells;
+    std::vector<Surfel> placed;
+
+    const float candidateDensity = CANDIDATES_PER_AREA / (spacing * spacing);
+    const float spacing2 = spacing * spacing;
+
+    for (size_t i = 0; i < triangles.size(); i++)
+    {
+        // Número de candidatos proporcional al área, con redondeo aleatorio para no perder los triángulos pequeños
+        float expectedCandidates = triangleAreas[i] * candidateDensity;
+        uint32_t numCandidates = static_cast<uint32_t>(expectedCandidates);
+        numCandidates += unitDistribution(rng) < expectedCandidates - static_cast<float>(numCandidates) ? 1 : 0;
+        if (numCandidates == 0)
+        {
+            continue;
+        }
+
+        const glm::uvec3 &triangle = triangles[i];
+        const glm::vec3 &v0 = positions[triangle.x];
+        const glm::vec3 &v1 = positions[triangle.y];
+        const glm::vec3 &v2 = positions[triangle.z];
+        glm::vec3 faceNormal = glm::normalize(glm::cross(v1 - v0, v2 - v0));
+        glm::vec3 albedo = scene.getTriangleAlbedo(static_cast<uint32_t>(i));
+
+        for (uint32_t c = 0; c < numCandidates; c++)
+        {
+            float b1 = unitDistribution(rng);
+            float b2 = unitDistribution(rng);
+            if (b1 + b2 > 1.0f)
+            {
+                b1 = 1.0f - b1;
+                b2 = 1.0f - b2;
+            }
+            glm::vec3 position = v0 + b1 * (v1 - v0) + b2 * (v2 - v0);
+            if (SurfelReference::clipmapLevel(position, reference.cameraPosition) >= SURFEL_CLIPMAP_LEVELS)
+            {
+                continue;
+            }
+
+            // Normal interpolada como la del G-buffer, o la de la cara si los vértices no tienen una válida
+            glm::vec3 normal = (1.0f - b1 - b2) * normals[triangle.x] + b1 * normals[triangle.y] + b2 * normals[triangle.z];
+            normal = glm::dot(normal, normal) > 1e-12f ? glm::normalize(normal) : faceNormal;
+
+            glm::ivec3 placementCell = glm::ivec3(glm::floor(position / spacing));
+            bool duplicate = false;
+            for (int dx = -1; dx <= 1 && !duplicate; dx++)
+            {
+                for (int dy = -1; dy <= 1 && !duplicate; dy++)
+                {
+                    for (int dz = -1; dz <= 1 && !duplicate; dz++)
+                    {
+                        auto neighbours = placedCells.find(placementKey(placementCell + glm::ivec3(dx, dy, dz)));
+                        if (neighbours == placedCells.end())
+                        {
+                            continue;
+                        }
+                        for (uint32_t other : neighbours->second)
+                        {
+                            glm::vec3 offset = placed[other].position - position;
+                            if (glm::dot(offset, offset) < spacing2 && glm::dot(placed[other].normal, normal) > DUPLICATE_NORMAL_COS)
+                            {
+                                duplicate = true;
+                                break;
+                            }
+                        }
+                    }
+                }
+            }
+            if (duplicate)
+            {
+                continue;
+            }
+
+            // Mismo estado inicial que un surfel recién generado, con el radio derivado de la separación y limitado al
+            // máximo de su nivel del clipmap
+            Surfel surfel{};
+            surfel.position = position;
+            surfel.radius = std::min(RADIUS_PER_SPACING * spacing, SurfelReference::levelMaxRadius(SurfelReference::clipmapLevel(position, reference.cameraPosition)));
+            surfel.normal = normal;
+            surfel.generatedRays = 1;
+            surfel.color = albedo;
+            surfel.lastSeenFrame = reference.frame;
+            surfel.age = 0;
+            // Se marca como horneado para que la aplicación no lo recicle por no verlo
+            surfel.flags = SURFEL_FLAG_BAKED;
+            placedCells[placementKey(placementCell)].push_back(static_cast<uint32_t>(placed.size()));
+            placed.push_back(surfel);
+        }
+    }
+
+    reference.surfelCount = std::min(static_cast<uint32_t>(placed.size()), SURFEL_CAPACITY);
+    std::copy(placed.begin(), placed.begin() + reference.surfelCount, reference.surfels.begin());
+    placedSurfels.assign(placed.begin(), placed.begin() + reference.surfelCount);
+    placedFrame = reference.frame;
+    return static_cast<uint32_t>(placed.size());
+}
+
+uint64_t SurfelBaker::integrate()
+{
+    // Las mismas direcciones que la textura de ruido de la aplicación
+    std::vector<glm::vec2> raySamples = SamplingSequences::generate(raySamplingSequence, NUM_RAYS * NUM_RAYS, raySamplingSeed);
+
+    uint64_t totalRays = 0;
+    for (uint32_t pass = 0; pass < MAX_INTEGRATION_PASSES; pass++)
+    {
+        // El grid se reconstruye en cada pasada, ya que los rebotes se leen de los surfels de la celda del choque
+        reference.buildGrid();
+        uint64_t passRays = reference.integrateRadiance(scene, lightPosition, lightIntensity, raySamples);
+        reference.frame++;
+        if (passRays == 0)
+        {
+            break;
+        }
+        totalRays += passRays;
+
+        uint32_t pending = 0;
+        for (uint32_t i = 0; i < reference.surfelCount; i++)
+        {
+            pending += SurfelReference::needsRays(reference.surfels[i]) ? 1 : 0;
+        }
+        std::cout << "Pasada " << pass + 1 << ": " << passRays << " rayos, " << pending << " surfels sin converger" << std::endl;
+    }
+
+    // Grid final con la radiancia convergida, que es el que se guarda
+    reference.buildGrid();
+    return totalRays;
+}
+
+bool SurfelBaker::save(const std::string &cachePath) const
+{
+    return writeCache(cachePath, sceneHash, reference);
+}
+
+std::vector<SurfelBakeBrick> SurfelBaker::computeBricks(uint32_t brickCount) const
+{
+    // Se parte del nivel más grueso del clipmap, de modo que las regiones lo cubren entero aunque haya zonas sin surfels
+    const uint32_t outerLevel = SURFEL_CLIPMAP_LEVELS - 1;
+    glm::vec3 gridMin = glm::vec3(SurfelReference::levelOrigin(outerLevel, reference.cameraPosition)) * SurfelReference::cellLength(outerLevel);
+    glm::vec3 gridMax = gridMin + glm::vec3(SURFEL_GRID_DIMENSIONS) * SurfelReference::cellLength(outerLevel);
+    std::vector<SurfelBakeBrick> bricks;
+    std::vector<glm::vec3> positions(placedSurfels.size());
+    for (size_t i = 0; i < placedSurfels.size(); i++)
+    {
+        positions[i] = placedSurfels[i].position;
+    }
+    splitBrick(SurfelBakeBrick{gridMin, gridMax}, std::max(brickCount, 1u), positions.data(), positions.size(), &bricks);
+    return bricks;
+}
+
+void SurfelBaker::splitBrick(const SurfelBakeBrick &brick, uint32_t brickCount, glm::vec3 *positions, size_t count, std::vector<SurfelBakeBrick> *bricks)
+{
+    if (brickCount == 1)
+    {
+        bricks->push_back(brick);
+        return;
+    }
+
+    // Eje más largo de los surfels de la región, o de la propia región si está vacía
+    glm::vec3 boundsMin = brick.max;
+    glm::vec3 boundsMax = brick.min;
+    for (size_t i = 0; i < count; i++)
+    {
+        boundsMin = glm::min(boundsMin, positions[i]);
+        boundsMax = glm::max(boundsMax, positions[i]);
+    }
+    glm::vec3 extent = count > 0 ? boundsMax - boundsMin : brick.max - brick.min;
+    int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+    // Cada mitad recibe una parte de los surfels proporcional a sus regiones, con el corte en un borde de celda
+    uint32_t lowerCount = brickCount / 2;
+    size_t lowerSurfels = count * lowerCount / brickCount;
+    float split = 0.5f * (brick.min[axis] + brick.max[axis]);
+    if (count > 0)
+    {
+        std::nth_element(positions, positions + lowerSurfels, positions + count, [axis](const glm::vec3 &a, const glm::vec3 &b)
+                         { return a[axis] < b[axis]; });
+        split = positions[std::min(lowerSurfels, count - 1)][axis];
+    }
+    split = glm::clamp(std::round(split / CELL_LENGTH) * CELL_LENGTH, brick.min[axis], brick.max[axis]);
+
+    glm::vec3 *upper = std::partition(positions, positions + count, [axis, split](const glm::vec3 &position)
+                                      { return position[axis] < split; });
+    SurfelBakeBrick lower = brick;
+    lower.max[axis] = split;
+    SurfelBakeBrick higher = brick;
+    higher.min[axis] = split;
+    splitBrick(lower, lowerCount, positions, static_cast<size_t>(upper - positions), bricks);
+    splitBrick(higher, brickCount - lowerCount, upper, count - static_cast<size_t>(upper - positions), bricks);
+}
+
+void SurfelBaker::restrictToBrick(const SurfelBakeBrick &brick, float border)
+{
+    // Sin rayos generados los surfels cuentan como libres, así que ni se integran ni entran en el grid
+    std::copy(placedSurfels.begin(), placedSurfels.end(), reference.surfels.begin());
+    reference.frame = placedFrame;
+    for (uint32_t i = 0; i < reference.surfelCount; i++)
+    {
+        if (brick.insideDistance(reference.surfels[i].position) <= -border)
+        {
+            reference.surfels[i].generatedRays = 0;
+        }
+    }
+}
+
+void SurfelBaker::getActiveSurfels(std::vector<uint32_t> *indices, std::vector<Surfel> *surfels) const
+{
+    indices->clear();
+    surfels->clear();
+    for (uint32_t i = 0; i < reference.surfelCount; i++)
+    {
+        if (SurfelReference::isAlive(reference.surfels[i]))
+        {
+            indices->push_back(i);
+            surfels->push_back(reference.surfels[i]);
+        }
+    }
+}
+
+bool SurfelBaker::writeCache(const std::string &cachePath, uint64_t sceneHash, const SurfelReference &reference)
+{
+    std::vector<uint32_t> stats(SURFEL_STATS_SIZE, 0);
+    stats[SURFEL_STATS_COUNT] = reference.surfelCount;
+    stats[SURFEL_STATS_CELL_ALLOCATOR] = static_cast<uint32_t>(reference.cells.size());
+    stats[SURFEL_STATS_FREE_COUNT] = static_cast<uint32_t>(reference.freeList.size());
+
+    SurfelCacheContents contents{};
+    contents.surfels = reference.surfels.data();
+    contents.stats = stats.data();
+    contents.grid = reference.grid.data();
+    contents.cells = reference.cells.data();
+    contents.freeList = reference.freeList.data();
+    contents.frameCounter = reference.frame;
+    contents.flags = SURFEL_CACHE_FLAG_BAKED;
+    return SurfelCacheFile::write(cachePath, sceneHash, contents);
+}
+
+uint64_t SurfelBaker::getSceneHash() const
+{
+    return sceneHash;
+}
+
+uint32_t SurfelBaker::getSurfelCount() const
+{
+    return reference.surfelCount;
+}
+
+uint32_t SurfelBaker::getFrameCounter() const
+{
+    return reference.frame;
+}
+
+glm::vec3 SurfelBaker::averageTextureColor(const char *texturePath)
+{
+    int width, height, channels;
+    unsigned char *pixels = stbi_load(texturePath, &width, &height, &channels, STBI_rgb);
+    // Sólo hace falta un albedo aproximado, así que una textura que falta no impide el bake: se usa un gris medio
+    if (!pixels)
+    {
+        std::cerr << "No se ha podido cargar la textura " << texturePath << ", se usa albedo gris" << std::endl;
+        return glm::vec3(0.5f);
+    }
+
+    // Tabla de conversión de sRGB a lineal, ya que la aplicación muestrea las texturas como imágenes sRGB
+    float toLinear[256];
+    for (int i = 0; i < 256; i++)
+    {
+        toLinear[i] = srgbToLinear(static_cast<float>(i) / 255.0f);
+    }
+
+    glm::dvec3 sum(0.0);
+    const size_t numPixels = static_cast<size_t>(width) * static_cast<size_t>(height);
+    for (size_t i = 0; i < numPixels; i++)
+    {
+        sum += glm::dvec3(toLinear[pixels[3 * i]], toLinear[pixels[3 * i + 1]], toLinear[pixels[3 * i + 2]]);
+    }
+    stbi_image_free(pixels);
+    return numPixels > 0 ? glm::vec3(sum / static_cast<double>(numPixels)) : glm::vec3(0.5f);
+}
\ No newline at end of file
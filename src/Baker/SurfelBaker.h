@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Surfels/SurfelBvhScene.h"
+#include "Surfels/SurfelReference.h"
+#include "Tools/ThreadPool.h"
+
+#define GLM_FORCE_RADIANS
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Región del grid que hornea un worker del bake distribuido. Las regiones cubren el grid sin solaparse, pero cada
+// worker hornea también los surfels cercanos a su borde, que el merge mezcla con los de la región vecina
+struct SurfelBakeBrick
+{
+    glm::vec3 min;
+    glm::vec3 max;
+
+    // Distancia de la posición al borde de la región: positiva dentro y negativa fuera
+    float insideDistance(const glm::vec3 &position) const;
+};
+
+// Bake offline de los surfels de la escena. Sin ventana ni dispositivo Vulkan: carga los modelos por el mismo camino
+// que SceneManager, reparte surfels sobre todas las superficies (no sólo las visibles desde una cámara), integra su
+// radiancia con la BVH de CPU en todos los hilos y guarda el resultado en el formato de la caché de surfels, que la
+// aplicación carga al arrancar en lugar de converger en tiempo real
+class SurfelBaker
+{
+public:
+    explicit SurfelBaker(ThreadPool &threadPool);
+
+    // Importa los modelos, calcula el albedo medio de cada material y construye la BVH de la escena
+    void loadScene();
+    // Reparte los surfels sobre todos los triángulos de la escena dentro del clipmap, centrado en el origen. Todos tienen
+    // el radio del nivel más fino, para que la caché sirva con la cámara en cualquier punto de la escena
+    void placeSurfels();
+    // Traza rayos hasta que todos los surfels convergen o agotan sus rayos. Devuelve el número de rayos trazados
+    uint64_t integrate();
+    // Escribe los surfels, el grid y las estadísticas en el formato de la caché de surfels
+    bool save(const std::string &cachePath) const;
+
+    // Divide el grid en brickCount regiones con un número parecido de surfels, partiendo cada región por la mitad de
+    // sus surfels en su eje más largo. Sólo depende del reparto, que es determinista, así que todos los workers
+    // obtienen las mismas regiones sin comunicarse
+    std::vector<SurfelBakeBrick> computeBricks(uint32_t brickCount) const;
+    // Limita el bake a los surfels a menos de border fuera de la región. El resto se desactiva, por lo que tampoco
+    // aporta rebotes. Cada llamada parte del reparto original, para hornear varias regiones con el mismo reparto
+    void restrictToBrick(const SurfelBakeBrick &brick, float border);
+    // Surfels activos tras el bake, con su índice en el reparto completo
+    void getActiveSurfels(std::vector<uint32_t> *indices, std::vector<Surfel> *surfels) const;
+
+    // Escribe los surfels, el grid y las estadísticas de la implementación de referencia en la caché de surfels
+    static bool writeCache(const std::string &cachePath, uint64_t sceneHash, const SurfelReference &reference);
+
+    uint64_t getSceneHash() const;
+    uint32_t getSurfelCount() const;
+    uint32_t getFrameCounter() const;
+
+private:
+    ThreadPool &threadPool;
+    SurfelBvhScene scene;
+    SurfelReference reference;
+    // Luz principal de la escena, que es la que ilumina los surfels
+    glm::vec3 lightPosition = glm::vec3(0.0f);
+    float lightIntensity = 0.0f;
+    uint64_t sceneHash = 0;
+    // Surfels tal y como quedan tras el reparto, de los que parte cada región del bake distribuido
+    std::vector<Surfel> placedSurfels;
+    uint32_t placedFrame = 0;
+
+    // Color medio de la textura difusa, en espacio lineal como lo devuelve el muestreo de una imagen sRGB
+    static glm::vec3 averageTextureColor(const char *texturePath);
+    // Dart throwing sobre los triángulos en orden, con una separación mínima entre surfels. Devuelve cuántos se aceptan,
+    // aunque sólo se guardan los que caben en el buffer
+    uint32_t throwSurfels(float spacing, const std::vector<float> &triangleAreas);
+    // Divide la región en brickCount regiones, repartiendo entre ellas las posiciones de sus surfels
+    static void splitBrick(const SurfelBakeBrick &brick, uint32_t brickCount, glm::vec3 *positions, size_t count, std::vector<SurfelBakeBrick> *bricks);
+};
\ No newline at end of file
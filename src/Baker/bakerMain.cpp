@@ -0,0 +1,90 @@
+#include "SurfelBaker.h"
+#include "SurfelBakeJob.h"
+
+#include "Buffers/SurfelCacheFile.h"
+#include "Tools/ThreadPool.h"
+
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+
+namespace
+{
+    // Bake en un solo proceso con todos los hilos de la máquina
+    int bakeLocal(ThreadPool &threadPool, const std::string &outputPath)
+    {
+        SurfelBaker baker(threadPool);
+        baker.loadScene();
+        baker.placeSurfels();
+        uint64_t tracedRays = baker.integrate();
+
+        std::string cachePath = !outputPath.empty() ? outputPath : SurfelCacheFile::getCachePath(baker.getSceneHash());
+        if (!baker.save(cachePath))
+        {
+            return EXIT_FAILURE;
+        }
+        std::cout << baker.getSurfelCount() << " surfels, " << tracedRays << " rayos" << std::endl;
+        return EXIT_SUCCESS;
+    }
+}
+
+// Bake offline de los surfels. Por defecto se escribe en la caché de surfels de la escena, que la aplicación carga al
+// arrancar si persistSurfelCache está activado
+//   SurfelBaker [fichero de salida]
+//   SurfelBaker --coordinator <regiones> <workers locales> <directorio> [fichero de salida]
+//   SurfelBaker --worker <directorio> [hilos]
+//   SurfelBaker --merge <directorio> [fichero de salida]
+// El coordinador reparte el grid en regiones y lanza los workers locales; desde otros nodos que vean el mismo
+// directorio se pueden lanzar más workers mientras el coordinador espera los resultados parciales
+int main(int argc, char **argv)
+{
+    try
+    {
+        std::string mode = argc > 1 && strncmp(argv[1], "--", 2) == 0 ? argv[1] : "";
+        uint32_t threadCount = mode == "--worker" && argc > 3 ? static_cast<uint32_t>(std::stoul(argv[3])) : 0;
+        ThreadPool threadPool(threadCount);
+        std::cout << "Hilos del bake: " << threadPool.getNumThreads() << std::endl;
+        auto bakeStart = std::chrono::high_resolution_clock::now();
+
+        int result = EXIT_SUCCESS;
+        if (mode.empty())
+        {
+            result = bakeLocal(threadPool, argc > 1 ? argv[1] : "");
+        }
+        else if (mode == "--coordinator" && argc > 4)
+        {
+            std::string jobDirectory = argv[4];
+            SurfelBakeJob::prepare(jobDirectory, static_cast<uint32_t>(std::stoul(argv[2])));
+            SurfelBakeJob::runLocalWorkers(argv[0], jobDirectory, static_cast<uint32_t>(std::stoul(argv[3])));
+            SurfelBakeJob::waitForPartials(jobDirectory, threadPool);
+            result = SurfelBakeJob::merge(jobDirectory, threadPool, argc > 5 ? argv[5] : "") ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        else if (mode == "--worker" && argc > 2)
+        {
+            uint32_t bakedBricks = SurfelBakeJob::runWorker(argv[2], threadPool);
+            std::cout << "Regiones horneadas por este worker: " << bakedBricks << std::endl;
+        }
+        else if (mode == "--merge" && argc > 2)
+        {
+            result = SurfelBakeJob::merge(argv[2], threadPool, argc > 3 ? argv[3] : "") ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        else
+        {
+            std::cerr << "Uso: SurfelBaker [fichero de salida] | --coordinator <regiones> <workers locales> <directorio> [fichero de salida] | "
+                         "--worker <directorio> [hilos] | --merge <directorio> [fichero de salida]"
+                      << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        float bakeTime = std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - bakeStart).count();
+        std::cout << "Bake terminado en " << bakeTime << " s" << std::endl;
+        return result;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,345 @@
+#include "SceneCullingBufferManager.h"
+
+#include "Images/ImageCreator.h"
+#include "Tools/BufferCreator.h"
+#include "Tools/CommandBufferManager.h"
+#include "Camera/Camera.h"
+
+#define VK_USE_PLATFORM_WIN32_KHR
+#define GLFW_INCLUDE_VULKAN
+#define GLFW_EXPOSE_NATIVE_WIN32
+#define GLM_FORCE_RADIANS
+
+#include <GLFW/glfw3.h>
+#include <GLFW/glfw3native.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <vma/vk_mem_alloc.h>
+
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+
+void SceneCullingBufferManager::createCullingResources(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t MAX_FRAMES_IN_FLIGHT, uint32_t width, uint32_t height,
+                                                       uint32_t sceneDrawCount, Camera *camera, VkCommandPool commandPool, VkQueue graphicsQueue)
+{
+    drawCount = sceneDrawCount;
+
+    // La lista compactada tiene, como mucho, todos los objetos de la escena
+    BufferCreator::createBufferVMA(
+        sizeof(VkDrawIndexedIndirectCommand) * std::max(drawCount, 1u),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+        VMA_MEMORY_USAGE_GPU_ONLY,
+        culledCommandBuffer,
+        culledCommandBufferAllocation);
+    BufferCreator::createBufferVMA(
+        sizeof(SceneCullingStats),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VMA_MEMORY_USAGE_GPU_ONLY,
+        cullingStatsBuffer,
+        cullingStatsBufferAllocation);
+
+    uniformCullingBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+    uniformCullingBuffersMemory.resize(MAX_FRAMES_IN_FLIGHT);
+    uniformCullingBuffersMapped.resize(MAX_FRAMES_IN_FLIGHT);
+    statsReadbackBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+    statsReadbackBuffersMemory.resize(MAX_FRAMES_IN_FLIGHT);
+    statsReadbackBuffersMapped.resize(MAX_FRAMES_IN_FLIGHT);
+
+    // Hasta que se genere la primera pirámide sólo se aplica el test contra el frustum
+    createHiZPyramid(device, physicalDevice, width, height, commandPool, graphicsQueue);
+    createHiZSampler(device);
+
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        BufferCreator::createBuffer(device, physicalDevice, sizeof(SceneCullingUniformBuffer), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, uniformCullingBuffers[i], uniformCullingBuffersMemory[i]);
+        vkMapMemory(device, uniformCullingBuffersMemory[i], 0, sizeof(SceneCullingUniformBuffer), 0, &uniformCullingBuffersMapped[i]);
+
+        BufferCreator::createBuffer(device, physicalDevice, sizeof(SceneCullingStats), VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, statsReadbackBuffers[i], statsReadbackBuffersMemory[i]);
+        vkMapMemory(device, statsReadbackBuffersMemory[i], 0, sizeof(SceneCullingStats), 0, &statsReadbackBuffersMapped[i]);
+        memset(statsReadbackBuffersMapped[i], 0, sizeof(SceneCullingStats));
+    }
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        updateUniformBuffers(i, width, height, camera);
+    }
+    // Ninguno de estos frames ha generado todavía la pirámide
+    hiZPyramidBuilt = false;
+}
+
+void SceneCullingBufferManager::createHiZPyramid(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t width, uint32_t height, VkCommandPool commandPool, VkQueue graphicsQueue)
+{
+    // El nivel 0 es la potencia de dos anterior al tamaño de la ventana, de modo que cada nivel es exactamente la mitad del anterior.
+    // Las coordenadas normalizadas de pantalla se corresponden directamente con las de la pirámide
+    hiZExtent.width = 1;
+    while (hiZExtent.width * 2 <= width)
+    {
+        hiZExtent.width *= 2;
+    }
+    hiZExtent.height = 1;
+    while (hiZExtent.height * 2 <= height)
+    {
+        hiZExtent.height *= 2;
+    }
+    hiZLevels = 1;
+    while (hiZLevels < HIZ_MAX_LEVELS && (std::max(hiZExtent.width, hiZExtent.height) >> hiZLevels) > 0)
+    {
+        hiZLevels++;
+    }
+
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.extent.width = hiZExtent.width;
+    imageInfo.extent.height = hiZExtent.height;
+    imageInfo.extent.depth = 1;
+    imageInfo.mipLevels = hiZLevels;
+    imageInfo.arrayLayers = 1;
+    imageInfo.format = VK_FORMAT_R32_SFLOAT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateImage(device, &imageInfo, nullptr, &hiZImage) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create depth pyramid image!");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(device, hiZImage, &memRequirements);
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memRequirements.size;
+    allocInfo.memoryTypeIndex = BufferCreator::findMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, physicalDevice);
+
+    if (vkAllocateMemory(device, &allocInfo, nullptr, &hiZImageMemory) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to allocate depth pyramid memory!");
+    }
+    vkBindImageMemory(device, hiZImage, hiZImageMemory, 0);
+
+    // Una vista con todos los niveles para el culling, y otra por nivel para escribirlo durante la reducción
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = hiZImage;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = VK_FORMAT_R32_SFLOAT;
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.baseMipLevel = 0;
+    viewInfo.subresourceRange.levelCount = hiZLevels;
+    viewInfo.subresourceRange.baseArrayLayer = 0;
+    viewInfo.subresourceRange.layerCount = 1;
+
+    if (vkCreateImageView(device, &viewInfo, nullptr, &hiZImageView) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create depth pyramid image view!");
+    }
+
+    hiZLevelViews.resize(hiZLevels);
+    for (uint32_t level = 0; level < hiZLevels; level++)
+    {
+        viewInfo.subresourceRange.baseMipLevel = level;
+        viewInfo.subresourceRange.levelCount = 1;
+        if (vkCreateImageView(device, &viewInfo, nullptr, &hiZLevelViews[level]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create depth pyramid image view!");
+        }
+    }
+
+    // La pirámide se queda siempre en layout general: se escribe como imagen de almacenamiento y se lee con un sampler
+    VkCommandBuffer commandBuffer = CommandBufferManager::beginSingleTimeCommands(commandPool, device);
+
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = hiZImage;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = hiZLevels;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    CommandBufferManager::endSingleTimeCommands(commandBuffer, graphicsQueue, device, commandPool);
+
+    hiZPyramidBuilt = false;
+}
+
+void SceneCullingBufferManager::createHiZSampler(VkDevice device)
+{
+    // Muestreo sin filtrar: el culling elige un nivel en el que la caja ocupa como mucho 2x2 texels y lee los cuatro
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_NEAREST;
+    samplerInfo.minFilter = VK_FILTER_NEAREST;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.anisotropyEnable = VK_FALSE;
+    samplerInfo.maxAnisotropy = 1.0f;
+    samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+    samplerInfo.unnormalizedCoordinates = VK_FALSE;
+    samplerInfo.compareEnable = VK_FALSE;
+    samplerInfo.minLod = 0.0f;
+    samplerInfo.maxLod = static_cast<float>(HIZ_MAX_LEVELS);
+
+    if (vkCreateSampler(device, &samplerInfo, nullptr, &hiZSampler) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create depth pyramid sampler!");
+    }
+}
+
+void SceneCullingBufferManager::updateUniformBuffers(uint32_t currentImage, uint32_t width, uint32_t height, Camera *camera)
+{
+    SceneCullingUniformBuffer ubo{};
+
+    // Misma proyección que la del G-Buffer, para que la profundidad de la pirámide sea comparable
+    float zNear = 0.1f;
+    float zFar = 8000.0f;
+
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), (float)width / (float)height, zNear, zFar);
+    projection[1][1] *= -1;
+
+    ubo.viewProjection = projection * camera->getViewMatrix();
+    ubo.previousViewProjection = previousViewProjection;
+    extractFrustumPlanes(ubo.viewProjection, ubo.frustumPlanes);
+    ubo.pyramidSize = glm::vec2(hiZExtent.width, hiZExtent.height);
+    ubo.pyramidLevels = hiZLevels;
+    ubo.drawCount = drawCount;
+    // La pirámide que se lee es la que generó el frame anterior, con su propia cámara
+    ubo.occlusionEnabled = hiZPyramidBuilt ? 1 : 0;
+
+    memcpy(uniformCullingBuffersMapped[currentImage], &ubo, sizeof(ubo));
+
+    // Este frame genera la pirámide que leerá el siguiente
+    previousViewProjection = ubo.viewProjection;
+    hiZPyramidBuilt = true;
+}
+
+void SceneCullingBufferManager::extractFrustumPlanes(const glm::mat4 &viewProjection, glm::vec4 planes[6])
+{
+    // Planos del frustum a partir de las filas de la matriz (la profundidad de Vulkan está en [0, w])
+    glm::vec4 row0 = glm::vec4(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+    glm::vec4 row1 = glm::vec4(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+    glm::vec4 row2 = glm::vec4(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+    glm::vec4 row3 = glm::vec4(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+    planes[0] = row3 + row0; // Izquierdo
+    planes[1] = row3 - row0; // Derecho
+    planes[2] = row3 + row1; // Inferior
+    planes[3] = row3 - row1; // Superior
+    planes[4] = row2;        // Cercano
+    planes[5] = row3 - row2; // Lejano
+
+    for (int i = 0; i < 6; i++)
+    {
+        planes[i] /= glm::length(glm::vec3(planes[i]));
+    }
+}
+
+void SceneCullingBufferManager::readStats(uint32_t currentImage)
+{
+    memcpy(&lastStats, statsReadbackBuffersMapped[currentImage], sizeof(SceneCullingStats));
+}
+
+VkBuffer SceneCullingBufferManager::getCulledCommandBuffer() const
+{
+    return culledCommandBuffer;
+}
+
+VkBuffer SceneCullingBufferManager::getCullingStatsBuffer() const
+{
+    return cullingStatsBuffer;
+}
+
+std::vector<VkBuffer> SceneCullingBufferManager::getUniformCullingBuffers() const
+{
+    return uniformCullingBuffers;
+}
+
+VkBuffer SceneCullingBufferManager::getStatsReadbackBuffer(uint32_t currentImage) const
+{
+    return statsReadbackBuffers[currentImage];
+}
+
+VkImage SceneCullingBufferManager::getHiZImage() const
+{
+    return hiZImage;
+}
+
+VkImageView SceneCullingBufferManager::getHiZImageView() const
+{
+    return hiZImageView;
+}
+
+std::vector<VkImageView> SceneCullingBufferManager::getHiZLevelViews() const
+{
+    return hiZLevelViews;
+}
+
+VkSampler SceneCullingBufferManager::getHiZSampler() const
+{
+    return hiZSampler;
+}
+
+VkExtent2D SceneCullingBufferManager::getHiZExtent() const
+{
+    return hiZExtent;
+}
+
+uint32_t SceneCullingBufferManager::getHiZLevels() const
+{
+    return hiZLevels;
+}
+
+uint32_t SceneCullingBufferManager::getDrawCount() const
+{
+    return drawCount;
+}
+
+SceneCullingStats SceneCullingBufferManager::getStats() const
+{
+    return lastStats;
+}
+
+void SceneCullingBufferManager::cleanupHiZPyramid(VkDevice device)
+{
+    for (auto &levelView : hiZLevelViews)
+    {
+        vkDestroyImageView(device, levelView, nullptr);
+    }
+    hiZLevelViews.clear();
+    vkDestroyImageView(device, hiZImageView, nullptr);
+    vkDestroyImage(device, hiZImage, nullptr);
+    vkFreeMemory(device, hiZImageMemory, nullptr);
+}
+
+void SceneCullingBufferManager::cleanup(VkDevice device)
+{
+    vmaDestroyBuffer(BufferCreator::allocator, culledCommandBuffer, culledCommandBufferAllocation);
+    vmaDestroyBuffer(BufferCreator::allocator, cullingStatsBuffer, cullingStatsBufferAllocation);
+
+    for (size_t i = 0; i < uniformCullingBuffers.size(); i++)
+    {
+        vkDestroyBuffer(device, uniformCullingBuffers[i], nullptr);
+        vkFreeMemory(device, uniformCullingBuffersMemory[i], nullptr);
+        vkDestroyBuffer(device, statsReadbackBuffers[i], nullptr);
+        vkFreeMemory(device, statsReadbackBuffersMemory[i], nullptr);
+    }
+
+    cleanupHiZPyramid(device);
+    vkDestroySampler(device, hiZSampler, nullptr);
+}
\ No newline at end of file
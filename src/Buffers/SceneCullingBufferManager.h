@@ -0,0 +1,114 @@
+#pragma once
+
+#include "Camera/Camera.h"
+
+#define VK_USE_PLATFORM_WIN32_KHR
+#define GLFW_INCLUDE_VULKAN
+#define GLFW_EXPOSE_NATIVE_WIN32
+#define GLM_FORCE_RADIANS
+
+#include <GLFW/glfw3.h>
+#include <GLFW/glfw3native.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <vma/vk_mem_alloc.h>
+
+#include <vector>
+#include <array>
+
+// Variables uniformes del culling de la escena
+struct SceneCullingUniformBuffer
+{
+    glm::mat4 viewProjection;         // Cámara del frame actual, para el test contra el frustum
+    glm::mat4 previousViewProjection; // Cámara con la que se generó la pirámide de profundidad (frame anterior)
+    glm::vec4 frustumPlanes[6];
+    glm::vec2 pyramidSize; // Tamaño del nivel 0 de la pirámide
+    uint32_t pyramidLevels;
+    uint32_t drawCount;
+    uint32_t occlusionEnabled; // La pirámide no es válida en el primer frame ni tras redimensionar la ventana
+    uint32_t padding[3];
+};
+
+// Estadísticas del culling, en el mismo orden que en el buffer de GPU
+struct SceneCullingStats
+{
+    uint32_t visibleDraws; // También es el número de comandos de la lista compactada
+    uint32_t frustumCulledDraws;
+    uint32_t occlusionCulledDraws;
+    uint32_t testedDraws;
+};
+
+// Tamaños de origen y destino de cada paso de la reducción de la pirámide de profundidad
+struct HiZPushConstants
+{
+    glm::ivec2 sourceSize;
+    glm::ivec2 targetSize;
+};
+
+static const unsigned int SCENE_CULLING_GROUP_SIZE = 64; // Objetos evaluados por cada grupo del compute shader
+static const unsigned int HIZ_GROUP_SIZE = 8;            // Lado del grupo de la reducción de la pirámide
+static const unsigned int HIZ_MAX_LEVELS = 16;
+
+// Recursos del culling de la escena: la lista compactada de comandos que consume el G-Buffer, sus estadísticas
+// y la pirámide de profundidad (Hi-Z) con la que se descartan los objetos ocultos en el frame anterior
+class SceneCullingBufferManager
+{
+private:
+    // Comandos visibles, compactados, y contadores del culling (el primero es el número de comandos de la lista)
+    VkBuffer culledCommandBuffer;
+    VmaAllocation culledCommandBufferAllocation;
+    VkBuffer cullingStatsBuffer;
+    VmaAllocation cullingStatsBufferAllocation;
+
+    // Buffers de variables uniformes (uno por cada frame en vuelo)
+    std::vector<VkBuffer> uniformCullingBuffers;
+    std::vector<VkDeviceMemory> uniformCullingBuffersMemory;
+    std::vector<void *> uniformCullingBuffersMapped;
+
+    // Copia de las estadísticas visible desde CPU, una por frame en vuelo para no leer la que está escribiendo la GPU
+    std::vector<VkBuffer> statsReadbackBuffers;
+    std::vector<VkDeviceMemory> statsReadbackBuffersMemory;
+    std::vector<void *> statsReadbackBuffersMapped;
+
+    // Pirámide de profundidad: cada nivel guarda la profundidad máxima (la más lejana) de los texels que cubre
+    VkImage hiZImage;
+    VkDeviceMemory hiZImageMemory;
+    VkImageView hiZImageView;
+    std::vector<VkImageView> hiZLevelViews;
+    VkSampler hiZSampler;
+    VkExtent2D hiZExtent;
+    uint32_t hiZLevels = 0;
+    bool hiZPyramidBuilt = false;
+
+    uint32_t drawCount = 0;
+    glm::mat4 previousViewProjection = glm::mat4(1.0f);
+    SceneCullingStats lastStats{};
+
+    void createHiZSampler(VkDevice device);
+    static void extractFrustumPlanes(const glm::mat4 &viewProjection, glm::vec4 planes[6]);
+
+public:
+    void createCullingResources(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t MAX_FRAMES_IN_FLIGHT, uint32_t width, uint32_t height, uint32_t sceneDrawCount,
+                                Camera *camera, VkCommandPool commandPool, VkQueue graphicsQueue);
+    // La pirámide depende del tamaño de la ventana, por lo que se vuelve a crear junto a los framebuffers
+    void createHiZPyramid(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t width, uint32_t height, VkCommandPool commandPool, VkQueue graphicsQueue);
+    void cleanupHiZPyramid(VkDevice device);
+    void updateUniformBuffers(uint32_t currentImage, uint32_t width, uint32_t height, Camera *camera);
+    // Se llama una vez terminado el frame que usó por última vez este índice
+    void readStats(uint32_t currentImage);
+
+    VkBuffer getCulledCommandBuffer() const;
+    VkBuffer getCullingStatsBuffer() const;
+    std::vector<VkBuffer> getUniformCullingBuffers() const;
+    VkBuffer getStatsReadbackBuffer(uint32_t currentImage) const;
+    VkImage getHiZImage() const;
+    VkImageView getHiZImageView() const;
+    std::vector<VkImageView> getHiZLevelViews() const;
+    VkSampler getHiZSampler() const;
+    VkExtent2D getHiZExtent() const;
+    uint32_t getHiZLevels() const;
+    uint32_t getDrawCount() const;
+    SceneCullingStats getStats() const;
+
+    void cleanup(VkDevice device);
+};
\ No newline at end of file
@@ -0,0 +1,106 @@
+#include "SurfelCache.h"
+
+#include "SurfelsBufferManager.h"
+#include "Tools/BufferCreator.h"
+#include "Tools/CommandBufferManager.h"
+#include "Tools/MappedFile.h"
+
+#define VK_USE_PLATFORM_WIN32_KHR
+#define GLFW_INCLUDE_VULKAN
+#define GLFW_EXPOSE_NATIVE_WIN32
+
+#include <GLFW/glfw3.h>
+#include <GLFW/glfw3native.h>
+
+#include <vector>
+#include <algorithm>
+#include <cstring>
+
+bool SurfelCache::load(UploadBatcher &uploadBatcher, uint64_t sceneHash, const SurfelCacheBuffers &buffers, uint32_t *frameCounter, uint32_t *flags)
+{
+    // El fichero se proyecta en memoria y cada sección se copia directamente al anillo de staging
+    MappedFile cacheFile;
+    if (!cacheFile.open(SurfelCacheFile::getCachePath(sceneHash)) || cacheFile.getSize() < sizeof(SurfelCacheHeader))
+    {
+        return false;
+    }
+    const uint8_t *data = cacheFile.getData();
+    const SurfelCacheHeader *header = reinterpret_cast<const SurfelCacheHeader *>(data);
+    if (!SurfelCacheFile::isCompatible(*header, sceneHash, cacheFile.getSize()))
+    {
+        return false;
+    }
+
+    // Buffer de destino y offset dentro de él de cada sección
+    VkBuffer dstBuffers[SURFEL_CACHE_SECTION_COUNT] = {buffers.surfels, buffers.stats, buffers.grid, buffers.cells, buffers.freeList};
+    uint64_t dstOffsets[SURFEL_CACHE_SECTION_COUNT] = {0, 0, static_cast<uint64_t>(header->gridFirstCell) * sizeof(SurfelGridCell), 0, 0};
+
+    for (uint32_t i = 0; i < SURFEL_CACHE_SECTION_COUNT; i++)
+    {
+        const SurfelCacheSection &section = header->sections[i];
+        if (section.size == 0)
+        {
+            continue;
+        }
+        uploadBatcher.copyToBuffer(data + section.offset, section.size, dstBuffers[i], dstOffsets[i]);
+    }
+
+    *frameCounter = header->frameCounter;
+    *flags = header->flags;
+    return true;
+}
+
+void SurfelCache::save(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue, uint64_t sceneHash,
+                       const SurfelCacheBuffers &buffers, uint32_t frameCounter)
+{
+    // Se leen los buffers completos, ya que la parte ocupada sólo se conoce tras leer las estadísticas
+    const uint64_t fullSizes[SURFEL_CACHE_SECTION_COUNT] = {
+        sizeof(Surfel) * SURFEL_CAPACITY,
+        sizeof(unsigned int) * SURFEL_STATS_SIZE,
+        sizeof(SurfelGridCell) * SURFEL_TABLE_SIZE,
+        sizeof(unsigned int) * SURFEL_CELL_BUFFER_SIZE,
+        sizeof(unsigned int) * SURFEL_CAPACITY};
+    VkBuffer srcBuffers[SURFEL_CACHE_SECTION_COUNT] = {buffers.surfels, buffers.stats, buffers.grid, buffers.cells, buffers.freeList};
+
+    uint64_t readbackOffsets[SURFEL_CACHE_SECTION_COUNT];
+    uint64_t readbackSize = 0;
+    for (uint32_t i = 0; i < SURFEL_CACHE_SECTION_COUNT; i++)
+    {
+        readbackOffsets[i] = readbackSize;
+        readbackSize += fullSizes[i];
+    }
+
+    VkBuffer readbackBuffer;
+    VkDeviceMemory readbackBufferMemory;
+    BufferCreator::createBuffer(device, physicalDevice, readbackSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, readbackBuffer, readbackBufferMemory);
+
+    VkCommandBuffer readbackCommandBuffer = CommandBufferManager::beginSingleTimeCommands(commandPool, device);
+    for (uint32_t i = 0; i < SURFEL_CACHE_SECTION_COUNT; i++)
+    {
+        VkBufferCopy copyRegion{};
+        copyRegion.srcOffset = 0;
+        copyRegion.dstOffset = readbackOffsets[i];
+        copyRegion.size = fullSizes[i];
+        vkCmdCopyBuffer(readbackCommandBuffer, srcBuffers[i], readbackBuffer, 1, &copyRegion);
+    }
+    CommandBufferManager::endSingleTimeCommands(readbackCommandBuffer, graphicsQueue, device, commandPool);
+
+    void *mappedData;
+    vkMapMemory(device, readbackBufferMemory, 0, VK_WHOLE_SIZE, 0, &mappedData);
+    const uint8_t *readback = static_cast<const uint8_t *>(mappedData);
+
+    SurfelCacheContents contents{};
+    contents.surfels = reinterpret_cast<const Surfel *>(readback + readbackOffsets[SURFEL_CACHE_SECTION_SURFELS]);
+    contents.stats = reinterpret_cast<const uint32_t *>(readback + readbackOffsets[SURFEL_CACHE_SECTION_STATS]);
+    contents.grid = reinterpret_cast<const SurfelGridCell *>(readback + readbackOffsets[SURFEL_CACHE_SECTION_GRID]);
+    contents.cells = reinterpret_cast<const uint32_t *>(readback + readbackOffsets[SURFEL_CACHE_SECTION_CELLS]);
+    contents.freeList = reinterpret_cast<const uint32_t *>(readback + readbackOffsets[SURFEL_CACHE_SECTION_FREE_LIST]);
+    contents.frameCounter = frameCounter;
+    contents.flags = 0;
+    SurfelCacheFile::write(SurfelCacheFile::getCachePath(sceneHash), sceneHash, contents);
+
+    vkUnmapMemory(device, readbackBufferMemory);
+    vkDestroyBuffer(device, readbackBuffer, nullptr);
+    vkFreeMemory(device, readbackBufferMemory, nullptr);
+}
\ No newline at end of file
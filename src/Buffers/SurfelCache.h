@@ -0,0 +1,35 @@
+#pragma once
+
+#include "SurfelCacheFile.h"
+#include "Buffers/Tools/UploadBatcher.h"
+
+#define VK_USE_PLATFORM_WIN32_KHR
+#define GLFW_INCLUDE_VULKAN
+#define GLFW_EXPOSE_NATIVE_WIN32
+
+#include <GLFW/glfw3.h>
+#include <GLFW/glfw3native.h>
+
+#include <string>
+#include <cstdint>
+
+// Buffers de GPU que forman la caché de surfels
+struct SurfelCacheBuffers
+{
+    VkBuffer surfels;
+    VkBuffer stats;
+    VkBuffer grid;
+    VkBuffer cells;
+    VkBuffer freeList;
+};
+
+class SurfelCache
+{
+public:
+    // Graba en el lote actual la subida a los buffers del contenido de la caché de la escena. Devuelve false si no existe
+    // o se generó con otra escena, otro formato u otros parámetros del grid, en cuyo caso los buffers no se modifican
+    static bool load(UploadBatcher &uploadBatcher, uint64_t sceneHash, const SurfelCacheBuffers &buffers, uint32_t *frameCounter, uint32_t *flags);
+    // Lee los buffers de la GPU y los guarda en la caché de la escena. La GPU no debe estar usándolos
+    static void save(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue, uint64_t sceneHash,
+                     const SurfelCacheBuffers &buffers, uint32_t frameCounter);
+};
\ No newline at end of file
@@ -0,0 +1,146 @@
+#include "SurfelCacheFile.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+
+using namespace SurfelShader;
+
+bool SurfelCacheFile::write(const std::string &cachePath, uint64_t sceneHash, const SurfelCacheContents &contents)
+{
+    // La parte ocupada de cada buffer se deduce de las estadísticas
+    uint32_t surfelCount = std::min(contents.stats[SURFEL_STATS_COUNT], SURFEL_CAPACITY);
+    uint32_t cellReferences = std::min(contents.stats[SURFEL_STATS_CELL_ALLOCATOR], SURFEL_CELL_BUFFER_SIZE);
+    uint32_t freeCount = std::min(contents.stats[SURFEL_STATS_FREE_COUNT], SURFEL_CAPACITY);
+
+    // Del grid, casi vacío, se guarda el rango entre la primera y la última celda con surfels
+    uint32_t gridFirstCell = 0;
+    uint32_t gridEndCell = 0;
+    for (uint32_t i = 0; i < SURFEL_TABLE_SIZE; i++)
+    {
+        if (contents.grid[i].count != 0)
+        {
+            if (gridEndCell == 0)
+            {
+                gridFirstCell = i;
+            }
+            gridEndCell = i + 1;
+        }
+    }
+
+    SurfelCacheHeader header{};
+    memcpy(header.magic, SURFEL_CACHE_MAGIC, sizeof(header.magic));
+    header.version = SURFEL_CACHE_VERSION;
+    header.sceneHash = sceneHash;
+    header.gridDimensions[0] = SURFEL_GRID_DIMENSIONS.x;
+    header.gridDimensions[1] = SURFEL_GRID_DIMENSIONS.y;
+    header.gridDimensions[2] = SURFEL_GRID_DIMENSIONS.z;
+    header.clipmapLevels = SURFEL_CLIPMAP_LEVELS;
+    header.cellLength = CELL_LENGTH;
+    header.maxRadius = SURFEL_MAX_RADIUS;
+    header.surfelCapacity = SURFEL_CAPACITY;
+    header.cellBufferSize = SURFEL_CELL_BUFFER_SIZE;
+    header.surfelStride = sizeof(Surfel);
+    header.statsSize = SURFEL_STATS_SIZE;
+    header.frameCounter = contents.frameCounter;
+    header.gridFirstCell = gridFirstCell;
+    header.flags = contents.flags;
+
+    const uint64_t sectionSizes[SURFEL_CACHE_SECTION_COUNT] = {
+        static_cast<uint64_t>(surfelCount) * sizeof(Surfel),
+        sizeof(unsigned int) * SURFEL_STATS_SIZE,
+        static_cast<uint64_t>(gridEndCell - gridFirstCell) * sizeof(SurfelGridCell),
+        static_cast<uint64_t>(cellReferences) * sizeof(unsigned int),
+        static_cast<uint64_t>(freeCount) * sizeof(unsigned int)};
+    const char *sectionData[SURFEL_CACHE_SECTION_COUNT] = {
+        reinterpret_cast<const char *>(contents.surfels),
+        reinterpret_cast<const char *>(contents.stats),
+        reinterpret_cast<const char *>(contents.grid + gridFirstCell),
+        reinterpret_cast<const char *>(contents.cells),
+        reinterpret_cast<const char *>(contents.freeList)};
+
+    // Cada sección empieza alineada, para poder leerla directamente desde el fichero proyectado
+    uint64_t offset = alignCacheOffset(sizeof(SurfelCacheHeader));
+    for (uint32_t i = 0; i < SURFEL_CACHE_SECTION_COUNT; i++)
+    {
+        header.sections[i].offset = offset;
+        header.sections[i].size = sectionSizes[i];
+        offset = alignCacheOffset(offset + sectionSizes[i]);
+    }
+
+    // Se escribe en un fichero temporal y se renombra al terminar, para no dejar nunca un fichero a medias
+    std::error_code errorCode;
+    std::filesystem::create_directories(std::filesystem::path(cachePath).parent_path(), errorCode);
+    std::string temporaryPath = cachePath + ".tmp";
+    std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        std::cerr << "No se ha podido escribir la cache de surfels: " << cachePath << std::endl;
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    const char padding[SURFEL_CACHE_ALIGNMENT] = {};
+    for (uint32_t i = 0; i < SURFEL_CACHE_SECTION_COUNT; i++)
+    {
+        file.write(padding, header.sections[i].offset - static_cast<uint64_t>(file.tellp()));
+        file.write(sectionData[i], sectionSizes[i]);
+    }
+    file.close();
+
+    std::filesystem::rename(temporaryPath, cachePath, errorCode);
+    if (errorCode)
+    {
+        std::filesystem::remove(temporaryPath, errorCode);
+        std::cerr << "No se ha podido escribir la cache de surfels: " << cachePath << std::endl;
+        return false;
+    }
+    std::cout << "Cache de surfels guardada: " << surfelCount << " surfels en " << cachePath << std::endl;
+    return true;
+}
+
+std::string SurfelCacheFile::getCachePath(uint64_t sceneHash)
+{
+    // Cada escena tiene su propio fichero, nombrado con su hash
+    std::ostringstream fileName;
+    fileName << std::hex << std::setw(16) << std::setfill('0') << sceneHash << ".surfels";
+    return (std::filesystem::path(SURFEL_CACHE_PATH) / fileName.str()).string();
+}
+
+bool SurfelCacheFile::isCompatible(const SurfelCacheHeader &header, uint64_t sceneHash, size_t fileSize)
+{
+    // Cualquier cambio en el formato, en la escena o en los parámetros del grid invalida la caché
+    if (memcmp(header.magic, SURFEL_CACHE_MAGIC, sizeof(header.magic)) != 0 || header.version != SURFEL_CACHE_VERSION || header.sceneHash != sceneHash ||
+        header.gridDimensions[0] != SURFEL_GRID_DIMENSIONS.x || header.gridDimensions[1] != SURFEL_GRID_DIMENSIONS.y || header.gridDimensions[2] != SURFEL_GRID_DIMENSIONS.z ||
+        header.clipmapLevels != SURFEL_CLIPMAP_LEVELS || header.cellLength != CELL_LENGTH || header.maxRadius != SURFEL_MAX_RADIUS || header.surfelCapacity != SURFEL_CAPACITY ||
+        header.cellBufferSize != SURFEL_CELL_BUFFER_SIZE || header.surfelStride != sizeof(Surfel) || header.statsSize != SURFEL_STATS_SIZE)
+    {
+        return false;
+    }
+
+    // Las secciones tienen que caber en el fichero y en sus buffers de destino
+    const uint64_t maxSizes[SURFEL_CACHE_SECTION_COUNT] = {
+        sizeof(Surfel) * SURFEL_CAPACITY,
+        sizeof(unsigned int) * SURFEL_STATS_SIZE,
+        sizeof(SurfelGridCell) * (SURFEL_TABLE_SIZE - std::min(header.gridFirstCell, SURFEL_TABLE_SIZE)),
+        sizeof(unsigned int) * SURFEL_CELL_BUFFER_SIZE,
+        sizeof(unsigned int) * SURFEL_CAPACITY};
+    for (uint32_t i = 0; i < SURFEL_CACHE_SECTION_COUNT; i++)
+    {
+        const SurfelCacheSection &section = header.sections[i];
+        if (section.size > maxSizes[i] || section.offset > fileSize || section.size > fileSize - section.offset)
+        {
+            return false;
+        }
+    }
+    return header.sections[SURFEL_CACHE_SECTION_STATS].size == sizeof(unsigned int) * SURFEL_STATS_SIZE;
+}
+
+uint64_t SurfelCacheFile::alignCacheOffset(uint64_t offset)
+{
+    return (offset + SURFEL_CACHE_ALIGNMENT - 1) & ~static_cast<uint64_t>(SURFEL_CACHE_ALIGNMENT - 1);
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Surfels/SurfelData.h"
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Secciones de la caché, una por cada buffer de los surfels
+static const uint32_t SURFEL_CACHE_SECTION_SURFELS = 0;
+static const uint32_t SURFEL_CACHE_SECTION_STATS = 1;
+static const uint32_t SURFEL_CACHE_SECTION_GRID = 2;
+static const uint32_t SURFEL_CACHE_SECTION_CELLS = 3;
+static const uint32_t SURFEL_CACHE_SECTION_FREE_LIST = 4;
+static const uint32_t SURFEL_CACHE_SECTION_COUNT = 5;
+
+// Los surfels de la caché proceden de un bake offline y cubren toda la escena, por lo que no se reciclan por no verse
+static const uint32_t SURFEL_CACHE_FLAG_BAKED = 1;
+
+struct SurfelCacheSection
+{
+    uint64_t offset; // Offset desde el principio del fichero
+    uint64_t size;
+};
+
+// Formato de la caché de surfels: cabecera con la tabla de secciones y, a continuación, el contenido de cada buffer tal
+// y como está en la GPU, para subirlo sin transformarlo. Sólo se guarda la parte ocupada de cada buffer
+struct SurfelCacheHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t sceneHash; // Hash de los modelos y de la iluminación de la escena
+    // Parámetros del grid y de los surfels con los que se generó
+    uint32_t gridDimensions[3]; // De cada nivel del clipmap
+    uint32_t clipmapLevels;
+    float cellLength;
+    float maxRadius;
+    uint32_t surfelCapacity;
+    uint32_t cellBufferSize;
+    uint32_t surfelStride;
+    uint32_t statsSize;
+    uint32_t frameCounter;  // Frame en el que se guardó, para que los surfels no se reciclen por no haberse visto al recargarlos
+    uint32_t gridFirstCell; // Del grid sólo se guardan las celdas entre la primera y la última ocupadas
+    uint32_t flags;         // SURFEL_CACHE_FLAG_*
+    uint32_t _pad;
+    SurfelCacheSection sections[SURFEL_CACHE_SECTION_COUNT];
+};
+
+// Contenido completo de los buffers de los surfels en memoria de CPU, ya sea leído de la GPU o generado en un bake
+struct SurfelCacheContents
+{
+    const Surfel *surfels;      // SURFEL_CAPACITY surfels
+    const uint32_t *stats;      // SURFEL_STATS_SIZE contadores, de los que se deduce la parte ocupada de cada buffer
+    const SurfelGridCell *grid; // SURFEL_TABLE_SIZE celdas
+    const uint32_t *cells;
+    const uint32_t *freeList;
+    uint32_t frameCounter;
+    uint32_t flags;
+};
+
+// Lectura y escritura del fichero de la caché de surfels, sin depender de Vulkan para poder generarlo fuera de la aplicación
+class SurfelCacheFile
+{
+public:
+    static constexpr const char *SURFEL_CACHE_MAGIC = "SURF";
+    static const uint32_t SURFEL_CACHE_VERSION = 4;
+    static const uint32_t SURFEL_CACHE_ALIGNMENT = 16;
+    static constexpr const char *SURFEL_CACHE_PATH = RESOURCES_PATH "cache/surfels";
+
+    // Ruta de la caché de la escena, que es la que carga la aplicación al arrancar
+    static std::string getCachePath(uint64_t sceneHash);
+    // Escribe la parte ocupada de los buffers. Devuelve false si no se ha podido escribir el fichero
+    static bool write(const std::string &cachePath, uint64_t sceneHash, const SurfelCacheContents &contents);
+    // Si la cabecera corresponde a la escena, al formato y a los parámetros actuales del grid, y sus secciones caben en
+    // el fichero y en los buffers de destino
+    static bool isCompatible(const SurfelCacheHeader &header, uint64_t sceneHash, size_t fileSize);
+
+private:
+    static uint64_t alignCacheOffset(uint64_t offset);
+};
\ No newline at end of file
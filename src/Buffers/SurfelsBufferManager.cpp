@@ -2,6 +2,8 @@
 
 #include "Images/ImageCreator.h"
 #include "Tools/BufferCreator.h"
+#include "Tools/SamplingSequences.h"
+#include "SurfelCache.h"
 #include "Camera/Camera.h"
 #include "Config.h"
 #include "Scene/SponzaResources.h"
@@ -18,11 +20,19 @@
 #include <vma/vk_mem_alloc.h>
 
 #include <vector>
-#include <random>
+#include <iostream>
 
-void SurfelsBufferManager::createSurfelsResources(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t width, uint32_t height, Camera *camera, VkCommandPool commandPool,
-                                                  VkQueue graphicsQueue, std::vector<MeshContainer> sceneMeshes)
+namespace
 {
+    // Media precisión basta para la irradiancia, y el formato se puede filtrar y escribir desde los shaders en cualquier GPU
+    const VkFormat IRRADIANCE_VOLUME_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+}
+
+void SurfelsBufferManager::createSurfelsResources(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t MAX_FRAMES_IN_FLIGHT, uint32_t width, uint32_t height, Camera *camera, VkCommandPool commandPool,
+                                                  VkQueue graphicsQueue, UploadBatcher &uploadBatcher, uint64_t sceneHash)
+{
+    this->sceneHash = sceneHash;
+
     // Creación de los buffer de escritura de los surfels
     BufferCreator::createBufferVMA(
         width / 16 * height / 16 * sizeof(glm::vec2),
@@ -37,87 +47,73 @@ void SurfelsBufferManager::createSurfelsResources(VkDevice device, VkPhysicalDev
         surfelBuffer,
         surfelBufferAllocation);
     BufferCreator::createBufferVMA(
-        sizeof(unsigned int) * 8,
-        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+        sizeof(unsigned int) * SURFEL_STATS_SIZE,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
         VMA_MEMORY_USAGE_GPU_ONLY,
         surfelStatsBuffer,
         surfelStatsBufferAllocation);
+    // El grid guarda, por celda, el número de surfels que la solapan y el inicio de su lista en el buffer compactado
     BufferCreator::createBufferVMA(
-        sizeof(unsigned int) * SURFEL_TABLE_SIZE,
-        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        sizeof(SurfelGridCell) * SURFEL_TABLE_SIZE,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
         VMA_MEMORY_USAGE_GPU_ONLY,
         surfelGridBuffer,
         surfelGridBufferAllocation);
+    // Las listas de todas las celdas se guardan seguidas, por lo que el tamaño depende del número de surfels y no del grid
     BufferCreator::createBufferVMA(
-        sizeof(unsigned int) * SURFEL_TABLE_SIZE * SURFEL_CELL_LIMIT,
-        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        sizeof(unsigned int) * SURFEL_CELL_BUFFER_SIZE,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
         VMA_MEMORY_USAGE_GPU_ONLY,
         surfelCellBuffer,
         surfelCellBufferAllocation);
-
-    // Se crean y se rellenan los buffers con la información de la geometría, para poder extraerla desde los shaders
-    for (auto &mesh : sceneMeshes)
+    // Como mucho pueden estar reciclados todos los surfels a la vez
+    BufferCreator::createBufferVMA(
+        sizeof(unsigned int) * SURFEL_CAPACITY,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VMA_MEMORY_USAGE_GPU_ONLY,
+        surfelFreeListBuffer,
+        surfelFreeListBufferAllocation);
+    // Como mucho pueden entrar todos los surfels en la cola. Se limpia en cada frame antes de la planificación
+    BufferCreator::createBufferVMA(
+        sizeof(unsigned int) * (SURFEL_RAY_QUEUE_HEADER_SIZE + SURFEL_PRIORITY_BUCKETS + SURFEL_CAPACITY),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VMA_MEMORY_USAGE_GPU_ONLY,
+        surfelRayQueueBuffer,
+        surfelRayQueueBufferAllocation);
+
+    // Se inicializan a cero las estadísticas y el grid antes del primer frame. Los surfels también, ya que un surfel
+    // sin rayos generados se considera libre
+    VkCommandBuffer clearCommandBuffer = CommandBufferManager::beginSingleTimeCommands(commandPool, device);
+    vkCmdFillBuffer(clearCommandBuffer, surfelBuffer, 0, VK_WHOLE_SIZE, 0);
+    vkCmdFillBuffer(clearCommandBuffer, surfelStatsBuffer, 0, VK_WHOLE_SIZE, 0);
+    vkCmdFillBuffer(clearCommandBuffer, surfelGridBuffer, 0, VK_WHOLE_SIZE, 0);
+    CommandBufferManager::endSingleTimeCommands(clearCommandBuffer, graphicsQueue, device, commandPool);
+
+    // En una escena estática, los surfels del arranque anterior siguen siendo válidos: si hay una caché de la misma escena
+    // y con los mismos parámetros, se sube tal cual y la iluminación global parte ya convergida. La subida va en el lote
+    // del anillo de staging, que se envía después de limpiar los buffers
+    uint32_t surfelCacheFlags = 0;
+    if (persistSurfelCache && SurfelCache::load(uploadBatcher, sceneHash, getSurfelCacheBuffers(), &frameCounter, &surfelCacheFlags))
     {
-        for (int i = 0; i < mesh.vertexMeshesData.vertices.size(); i++)
-        {
-
-            size_t vertexBufferSize = mesh.vertexMeshesData.vertices[i].size() * sizeof(SimpleVertex);
-            size_t indexBufferSize = mesh.vertexMeshesData.indices[i].size() * sizeof(uint16_t);
-
-            VkBuffer vertexBuffer;
-            VkBuffer indexBuffer;
-            VmaAllocation vertexBufferAllocation;
-            VmaAllocation indexBufferAllocation;
-
-            BufferCreator::createBufferVMA(
-                indexBufferSize,
-                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-                VMA_MEMORY_USAGE_CPU_TO_GPU,
-                indexBuffer,
-                indexBufferAllocation);
-
-            void *indexMappedData;
-            vmaMapMemory(BufferCreator::allocator, indexBufferAllocation, &indexMappedData);
-            memcpy(indexMappedData, mesh.vertexMeshesData.indices[i].data(), indexBufferSize);
-            vmaUnmapMemory(BufferCreator::allocator, indexBufferAllocation);
-
-            BufferCreator::createBufferVMA(
-                vertexBufferSize,
-                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-                VMA_MEMORY_USAGE_CPU_TO_GPU,
-                vertexBuffer,
-                vertexBufferAllocation);
-
-            // Se simplifica la información de los vértices
-            std::vector<SimpleVertex> vertexList;
-            for(int j = 0; j < mesh.vertexMeshesData.vertices[i].size(); j++) {
-                SimpleVertex vertex;
-                vertex.normal = mesh.vertexMeshesData.vertices[i][j].normal;
-                vertex.idMaterial = mesh.vertexMeshesData.vertices[i][j].idMaterial;
-                vertex.uv = mesh.vertexMeshesData.vertices[i][j].texCoord;
-                vertexList.push_back(vertex);
-            }
-
-            void *vertexMappedData;
-            vmaMapMemory(BufferCreator::allocator, vertexBufferAllocation, &vertexMappedData);
-            memcpy(vertexMappedData, vertexList.data(), vertexBufferSize);
-            vmaUnmapMemory(BufferCreator::allocator, vertexBufferAllocation);
-
-            vertexBufferList.push_back(vertexBuffer);
-            vertexBufferAllocationList.push_back(vertexBufferAllocation);
-            vertexBufferSizeList.push_back(vertexBufferSize);
-            indexBufferList.push_back(indexBuffer);
-            indexBufferAllocationList.push_back(indexBufferAllocation);
-            indexBufferSizeList.push_back(indexBufferSize);
-        }
+        bakedSurfelCache = (surfelCacheFlags & SURFEL_CACHE_FLAG_BAKED) != 0;
+        std::cout << "Cache de surfels cargada (frame " << frameCounter << (bakedSurfelCache ? ", bake offline" : "") << ")" << std::endl;
     }
 
-    // Creación del buffer de variables uniformes
+    // Creación de los buffers de variables uniformes de la cámara
+    // Cada frame en vuelo tiene el suyo, para no sobrescribir los datos que está leyendo la GPU en el frame anterior
     VkDeviceSize bufferSize = sizeof(CameraUniformBuffer);
-    BufferCreator::createBuffer(device, physicalDevice, bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                uniformCameraBuffer, uniformCameraBufferMemory);
-    vkMapMemory(device, uniformCameraBufferMemory, 0, bufferSize, 0, &uniformCameraBufferMapped);
-    updateUniformBuffers(width, height, camera);
+
+    uniformCameraBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+    uniformCameraBuffersMemory.resize(MAX_FRAMES_IN_FLIGHT);
+    uniformCameraBuffersMapped.resize(MAX_FRAMES_IN_FLIGHT);
+
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        BufferCreator::createBuffer(device, physicalDevice, bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                    uniformCameraBuffers[i], uniformCameraBuffersMemory[i]);
+        vkMapMemory(device, uniformCameraBuffersMemory[i], 0, bufferSize, 0, &uniformCameraBuffersMapped[i]);
+        updateUniformBuffers(i, width, height, camera);
+    }
 
     bufferSize = sizeof(bool) * translucentMaterials.size();
     BufferCreator::createBuffer(device, physicalDevice, bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
@@ -132,9 +128,94 @@ void SurfelsBufferManager::createSurfelsResources(VkDevice device, VkPhysicalDev
     blueNoiseImage.createTextureImage(device, physicalDevice, commandPool, graphicsQueue, blueNoisePath);
     blueNoiseImage.createTextureImageView(device);
     blueNoiseImage.createTextureSampler(device, physicalDevice);
+
+    createIrradianceVolume(device, physicalDevice, commandPool, graphicsQueue);
+}
+
+void SurfelsBufferManager::createIrradianceVolume(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue)
+{
+    // Las imágenes se quedan en layout general: la construcción del volumen las escribe y el sombreado indirecto las
+    // muestrea en cada frame. Empiezan a cero, que es lo que la construcción espera de las celdas vacías
+    VkCommandBuffer commandBuffer = CommandBufferManager::beginSingleTimeCommands(commandPool, device);
+    for (uint32_t level = 0; level < SURFEL_CLIPMAP_LEVELS; level++)
+    {
+        createVolumeImage(device, physicalDevice, commandBuffer, irradianceVolume[level]);
+        createVolumeImage(device, physicalDevice, commandBuffer, directionVolume[level]);
+    }
+    CommandBufferManager::endSingleTimeCommands(commandBuffer, graphicsQueue, device, commandPool);
 }
 
-void SurfelsBufferManager::updateUniformBuffers(uint32_t width, uint32_t height, Camera *camera)
+void SurfelsBufferManager::createVolumeImage(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandBuffer commandBuffer, SurfelVolumeImage &volume)
+{
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_3D;
+    imageInfo.extent.width = SURFEL_GRID_DIMENSIONS.x;
+    imageInfo.extent.height = SURFEL_GRID_DIMENSIONS.y;
+    imageInfo.extent.depth = SURFEL_GRID_DIMENSIONS.z;
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.format = IRRADIANCE_VOLUME_FORMAT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateImage(device, &imageInfo, nullptr, &volume.image) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create irradiance volume image!");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(device, volume.image, &memRequirements);
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memRequirements.size;
+    allocInfo.memoryTypeIndex = BufferCreator::findMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, physicalDevice);
+
+    if (vkAllocateMemory(device, &allocInfo, nullptr, &volume.memory) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to allocate irradiance volume memory!");
+    }
+    vkBindImageMemory(device, volume.image, volume.memory, 0);
+
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = volume.image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_3D;
+    viewInfo.format = IRRADIANCE_VOLUME_FORMAT;
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.baseMipLevel = 0;
+    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.baseArrayLayer = 0;
+    viewInfo.subresourceRange.layerCount = 1;
+
+    if (vkCreateImageView(device, &viewInfo, nullptr, &volume.view) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create irradiance volume image view!");
+    }
+
+    VkImageSubresourceRange range = viewInfo.subresourceRange;
+
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = volume.image;
+    barrier.subresourceRange = range;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    VkClearColorValue clearColor = {{0.0f, 0.0f, 0.0f, 0.0f}};
+    vkCmdClearColorImage(commandBuffer, volume.image, VK_IMAGE_LAYOUT_GENERAL, &clearColor, 1, &range);
+}
+
+void SurfelsBufferManager::updateUniformBuffers(uint32_t currentImage, uint32_t width, uint32_t height, Camera *camera)
 {
     CameraUniformBuffer ubo{};
 
@@ -152,108 +233,21 @@ void SurfelsBufferManager::updateUniformBuffers(uint32_t width, uint32_t height,
 
     ubo.cameraPosition = camera->getPosition();
 
-    memcpy(uniformCameraBufferMapped, &ubo, sizeof(ubo));
-}
-
-void SurfelsBufferManager::mapSurfelsVisualizationData(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue,
-                                                       VkBuffer surfelsGeneratedData, VkBuffer &outVertexBuffer, VmaAllocation &outVertexAlloc, bool radianceVisualization)
-{
-    VkDeviceSize surfelsGeneratedBufferSize = sizeof(Surfel) * SURFEL_CAPACITY;
-
-    // Se crea un stagging buffer para leer la información del buffer de surfels generados
-    VkBuffer stagingReadBuf;
-    VmaAllocation stagingReadAlloc;
-    BufferCreator::createBufferVMA(
-        surfelsGeneratedBufferSize,
-        VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-        VMA_MEMORY_USAGE_CPU_ONLY,
-        stagingReadBuf,
-        stagingReadAlloc);
-
-    // Se copia del buffer original al creado
-    VkCommandBuffer cmd = CommandBufferManager::beginSingleTimeCommands(commandPool, device);
-    VkBufferCopy copyRegion{0, 0, surfelsGeneratedBufferSize};
-    vkCmdCopyBuffer(cmd, surfelsGeneratedData, stagingReadBuf, 1, &copyRegion);
-    CommandBufferManager::endSingleTimeCommands(cmd, graphicsQueue, device, commandPool);
-
-    // Se extraen los datos del buffer
-    Surfel *mappedSurfels = nullptr;
-    vmaMapMemory(BufferCreator::allocator, stagingReadAlloc, (void **)&mappedSurfels);
-
-    // Se rellena un vector con los datos de los surfels generados previamente, y se guarda la información indispensable para visualizarlos
-    std::vector<SimpleSurfel> verts;
-    verts.reserve(SURFEL_CAPACITY);
-    for (size_t i = 0; i < SURFEL_CAPACITY; ++i)
-    {
-        SimpleSurfel v;
-        v.position = mappedSurfels[i].position;
-        v.radius = mappedSurfels[i].radius;
-        if (renderConfig == RenderMode::SURFELS_RADIANCE_VISUALIZATION)
-        {
-            v.color = mappedSurfels[i].direct_radiance;
-        }
-        else
-        {
-            v.color = mappedSurfels[i].color;
-        }
-        v.normal = mappedSurfels[i].normal;
-        v.padding0 = 0.0f;
-        v.padding1 = 0.0f;
-        verts.push_back(v);
-    }
-
-    vmaUnmapMemory(BufferCreator::allocator, stagingReadAlloc);
-
-    // Se crea el buffer de vértices que se va a utilizar en GPU para pintar los surfels
-    VkDeviceSize vbSize = sizeof(SimpleSurfel) * verts.size();
-    BufferCreator::createBufferVMA(
-        vbSize,
-        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-        VMA_MEMORY_USAGE_GPU_ONLY,
-        outVertexBuffer,
-        outVertexAlloc);
+    // El número de frame va como entero: se conserva entre sesiones con la cache de surfels y en un float dejaría de
+    // avanzar de uno en uno pasados 2^24 frames
+    ubo.frame = glm::uvec4(frameCounter++, 0u, 0u, 0u);
 
-    // Se crea el stagging buffer intermedio para subir la información reservada al buffer creado
-    VkBuffer stagingWriteBuf;
-    VmaAllocation stagingWriteAlloc;
-    BufferCreator::createBufferVMA(
-        vbSize,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VMA_MEMORY_USAGE_CPU_ONLY,
-        stagingWriteBuf,
-        stagingWriteAlloc);
-
-    // Se copian los datos al stagging buffer
-    void *dst = nullptr;
-    vmaMapMemory(BufferCreator::allocator, stagingWriteAlloc, &dst);
-    memcpy(dst, verts.data(), (size_t)vbSize);
-    vmaUnmapMemory(BufferCreator::allocator, stagingWriteAlloc);
-
-    // Por último, se copian los datos del stagging buffer al buffer de salida
-    VkCommandBuffer cmdFinal = CommandBufferManager::beginSingleTimeCommands(commandPool, device);
-    VkBufferCopy copyRegionFinal{0, 0, vbSize};
-    vkCmdCopyBuffer(cmdFinal, stagingWriteBuf, outVertexBuffer, 1, &copyRegionFinal);
-    CommandBufferManager::endSingleTimeCommands(cmdFinal, graphicsQueue, device, commandPool);
-
-    // Se eliminan los stagging buffers auxiliares
-    vmaDestroyBuffer(BufferCreator::allocator, stagingReadBuf, stagingReadAlloc);
-    vmaDestroyBuffer(BufferCreator::allocator, stagingWriteBuf, stagingWriteAlloc);
+    memcpy(uniformCameraBuffersMapped[currentImage], &ubo, sizeof(ubo));
 }
 
 void SurfelsBufferManager::createRaytracingNoiseTexture(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue)
 {
-    // Generación aleatoria de pares entre [0,1]
-    std::vector<glm::vec2> *noiseTexture = new std::vector<glm::vec2>();
+    // Puntos en [0,1)^2 con la secuencia configurada. El cálculo de radiancia recorre la textura en orden, así que cada
+    // surfel consume prefijos consecutivos de la secuencia
+    const uint32_t numSamples = NUM_RAYS * NUM_RAYS;
+    const uint32_t seed = raySamplingSeed;
+    std::vector<glm::vec2> *noiseTexture = new std::vector<glm::vec2>(SamplingSequences::generate(raySamplingSequence, numSamples, seed));
 
-    std::mt19937 rng(1337);
-    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
-
-    for (uint32_t i = 0; i < NUM_RAYS * NUM_RAYS; i++)
-    {
-        float u1 = dist(rng);
-        float u2 = dist(rng);
-        noiseTexture->push_back(glm::vec2(u1, u2));
-    }
     noiseImage.createRaysNoiseTextureImage(device, physicalDevice, commandPool, graphicsQueue, noiseTexture, NUM_RAYS, NUM_RAYS);
 }
 
@@ -282,9 +276,19 @@ VkBuffer SurfelsBufferManager::getSurfelCellBuffer()
     return surfelCellBuffer;
 }
 
-VkBuffer SurfelsBufferManager::getCameraSurfelBuffer()
+VkBuffer SurfelsBufferManager::getSurfelFreeListBuffer()
 {
-    return uniformCameraBuffer;
+    return surfelFreeListBuffer;
+}
+
+VkBuffer SurfelsBufferManager::getSurfelRayQueueBuffer()
+{
+    return surfelRayQueueBuffer;
+}
+
+std::vector<VkBuffer> SurfelsBufferManager::getCameraSurfelBuffers()
+{
+    return uniformCameraBuffers;
 }
 
 VkBuffer SurfelsBufferManager::getTranslucentMaterialsBuffer()
@@ -292,34 +296,54 @@ VkBuffer SurfelsBufferManager::getTranslucentMaterialsBuffer()
     return translucentMaterialsBuffer;
 }
 
-std::vector<VkBuffer> SurfelsBufferManager::getIndexBufferList()
+ImageCreator SurfelsBufferManager::getRaysNoiseImage()
 {
-    return indexBufferList;
+    return noiseImage;
 }
 
-std::vector<VkBuffer> SurfelsBufferManager::getVertexBufferList()
+ImageCreator SurfelsBufferManager::getBlueNoiseImage()
 {
-    return vertexBufferList;
+    return blueNoiseImage;
 }
 
-std::vector<size_t> SurfelsBufferManager::getIndexBufferSizeList()
+std::vector<VkImageView> SurfelsBufferManager::getIrradianceVolumeViews()
 {
-    return indexBufferSizeList;
+    std::vector<VkImageView> views;
+    for (const SurfelVolumeImage &volume : irradianceVolume)
+    {
+        views.push_back(volume.view);
+    }
+    return views;
 }
 
-std::vector<size_t> SurfelsBufferManager::getVertexBufferSizeList()
+std::vector<VkImageView> SurfelsBufferManager::getDirectionVolumeViews()
 {
-    return vertexBufferSizeList;
+    std::vector<VkImageView> views;
+    for (const SurfelVolumeImage &volume : directionVolume)
+    {
+        views.push_back(volume.view);
+    }
+    return views;
 }
 
-ImageCreator SurfelsBufferManager::getRaysNoiseImage()
+void SurfelsBufferManager::saveSurfelCache(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue)
 {
-    return noiseImage;
+    // Un bake cubre toda la escena y no se sustituye por lo que se haya acumulado desde una sola cámara
+    if (persistSurfelCache && !bakedSurfelCache)
+    {
+        SurfelCache::save(device, physicalDevice, commandPool, graphicsQueue, sceneHash, getSurfelCacheBuffers(), frameCounter);
+    }
 }
 
-ImageCreator SurfelsBufferManager::getBlueNoiseImage()
+SurfelCacheBuffers SurfelsBufferManager::getSurfelCacheBuffers()
 {
-    return blueNoiseImage;
+    SurfelCacheBuffers buffers{};
+    buffers.surfels = surfelBuffer;
+    buffers.stats = surfelStatsBuffer;
+    buffers.grid = surfelGridBuffer;
+    buffers.cells = surfelCellBuffer;
+    buffers.freeList = surfelFreeListBuffer;
+    return buffers;
 }
 
 void SurfelsBufferManager::cleanup(VkDevice device)
@@ -329,18 +353,27 @@ void SurfelsBufferManager::cleanup(VkDevice device)
     vmaDestroyBuffer(BufferCreator::allocator, surfelStatsBuffer, surfelStatsBufferAllocation);
     vmaDestroyBuffer(BufferCreator::allocator, surfelGridBuffer, surfelGridBufferAllocation);
     vmaDestroyBuffer(BufferCreator::allocator, surfelCellBuffer, surfelCellBufferAllocation);
+    vmaDestroyBuffer(BufferCreator::allocator, surfelFreeListBuffer, surfelFreeListBufferAllocation);
+    vmaDestroyBuffer(BufferCreator::allocator, surfelRayQueueBuffer, surfelRayQueueBufferAllocation);
 
-    for (int i = 0; i < vertexBufferList.size(); i++)
+    for (size_t i = 0; i < uniformCameraBuffers.size(); i++)
     {
-        vmaDestroyBuffer(BufferCreator::allocator, indexBufferList[i], indexBufferAllocationList[i]);
-        vmaDestroyBuffer(BufferCreator::allocator, vertexBufferList[i], vertexBufferAllocationList[i]);
+        vkDestroyBuffer(device, uniformCameraBuffers[i], nullptr);
+        vkFreeMemory(device, uniformCameraBuffersMemory[i], nullptr);
     }
-
-    vkDestroyBuffer(device, uniformCameraBuffer, nullptr);
-    vkFreeMemory(device, uniformCameraBufferMemory, nullptr);
     vkDestroyBuffer(device, translucentMaterialsBuffer, nullptr);
     vkFreeMemory(device, translucentMaterialsBufferMemory, nullptr);
 
     noiseImage.cleanup(device);
     blueNoiseImage.cleanup(device);
+
+    for (uint32_t level = 0; level < SURFEL_CLIPMAP_LEVELS; level++)
+    {
+        for (SurfelVolumeImage *volume : {&irradianceVolume[level], &directionVolume[level]})
+        {
+            vkDestroyImageView(device, volume->view, nullptr);
+            vkDestroyImage(device, volume->image, nullptr);
+            vkFreeMemory(device, volume->memory, nullptr);
+        }
+    }
 }
@@ -4,6 +4,8 @@
 #include "Camera/Camera.h"
 #include "Raytracing/RaytracingManager.h"
 #include "Scene/SceneManager.h"
+#include "SurfelCache.h"
+#include "Surfels/SurfelData.h"
 
 #define VK_USE_PLATFORM_WIN32_KHR
 #define GLFW_INCLUDE_VULKAN
@@ -20,45 +22,13 @@
 #include <vector>
 #include <array>
 
-struct SimpleVertex
-{
-    glm::vec3 normal;
-    int idMaterial;
-    glm::vec2 uv;
-    glm::vec2 pad;
-};
-
-struct Surfel
-{
-    glm::vec3 position;
-    float radius;
-    glm::vec3 normal;
-    int generatedRays;
-    glm::vec3 color;
-    float padding1;
-    glm::vec3 direct_radiance;
-    float padding2;
-    glm::vec3 indirect_radiance;
-    float padding3;
-};
-
-struct SimpleSurfel
-{
-    glm::vec3 position;
-    float radius;
-    glm::vec3 color;
-    float padding0;
-    glm::vec3 normal;
-    float padding1;
-};
-
 struct CameraUniformBuffer
 {
     glm::mat4 view;
     glm::mat4 projection;
     glm::vec2 nearFarPlanes;
     glm::vec2 padding0;
-    glm::vec4 frame;
+    glm::uvec4 frame; // x: número de frame
     glm::vec3 cameraPosition;
     float padding1;
 };
@@ -69,15 +39,44 @@ struct PushConstants
     float height;
 };
 
-static const glm::uvec3 SURFEL_GRID_DIMENSIONS = glm::uvec3(256, 128, 128);                                                    // Dimensiones del mallado en el que se va a dividir la escena, para situar los surfels
-static const unsigned int SURFEL_TABLE_SIZE = SURFEL_GRID_DIMENSIONS.x * SURFEL_GRID_DIMENSIONS.y * SURFEL_GRID_DIMENSIONS.z; // Tamaño del grid
-static const unsigned int SURFEL_CAPACITY = 100000;
-static const unsigned int SURFEL_CELL_LIMIT = 100;
-static const unsigned int NUM_RAYS = 50;
+// Rayos que se reparten entre los surfels en cada frame
+struct SurfelRayBudgetPushConstants
+{
+    uint32_t raysPerFrame;
+};
+
+// Constantes compartidas con los shaders (surfelsConstants.glsl), con los nombres que usa la aplicación
+static const glm::uvec3 SURFEL_GRID_DIMENSIONS = SurfelShader::SURFEL_GRID_DIMENSIONS;                                       // Dimensiones de cada nivel del clipmap en el que se sitúan los surfels alrededor de la cámara
+static const unsigned int SURFEL_CLIPMAP_LEVELS = SurfelShader::SURFEL_CLIPMAP_LEVELS;                                       // Niveles del clipmap, con celdas el doble de grandes en cada uno
+static const unsigned int SURFEL_TABLE_SIZE = SurfelShader::SURFEL_TABLE_SIZE;                                               // Tamaño del grid, con todos los niveles
+static const unsigned int SURFEL_CAPACITY = SurfelShader::SURFEL_CAPACITY;
+static const float SURFEL_CELL_LENGTH = SurfelShader::CELL_LENGTH;                                                           // Lado de cada celda del nivel más fino del grid
+static const float SURFEL_MAX_RADIUS = SurfelShader::SURFEL_MAX_RADIUS;                                                      // Radio máximo de un surfel del nivel más fino
+static const unsigned int SURFEL_CELL_BUFFER_SIZE = SurfelShader::SURFEL_CELL_BUFFER_SIZE;                                   // Referencias surfel-celda de la lista compactada (cada surfel solapa como mucho 27 celdas)
+static const unsigned int SURFEL_GRID_SCAN_BLOCK_SIZE = SurfelShader::SURFEL_GRID_SCAN_BLOCK_SIZE;                           // Celdas procesadas por cada grupo al calcular los offsets del grid
+static const unsigned int SURFEL_STATS_COUNT = SurfelShader::SURFEL_STATS_COUNT;                                             // Posiciones del buffer de estadísticas
+static const unsigned int SURFEL_STATS_CELL_ALLOCATOR = SurfelShader::SURFEL_STATS_CELL_ALLOCATOR;
+static const unsigned int SURFEL_STATS_FREE_COUNT = SurfelShader::SURFEL_STATS_FREE_COUNT;                                   // Número de índices en la pila de surfels reciclados
+static const unsigned int SURFEL_STATS_DRAW_ARGS = SurfelShader::SURFEL_STATS_DRAW_ARGS;                                     // VkDrawIndirectCommand de la visualización de surfels
+static const unsigned int SURFEL_STATS_DISPATCH_ARGS = SurfelShader::SURFEL_STATS_DISPATCH_ARGS;                             // VkDispatchIndirectCommand de las pasadas con un hilo por surfel
+static const unsigned int SURFEL_STATS_SIZE = SurfelShader::SURFEL_STATS_SIZE;                                               // Número de contadores del buffer de estadísticas
+static const unsigned int SURFEL_GROUP_SIZE = SurfelShader::SURFEL_GROUP_SIZE;                                               // Hilos por grupo de las pasadas con un hilo por surfel
+static const unsigned int SURFEL_PRIORITY_BUCKETS = SurfelShader::SURFEL_PRIORITY_BUCKETS;                                   // Cubos del histograma de prioridades de la planificación de rayos
+static const unsigned int SURFEL_RAY_QUEUE_DISPATCH_ARGS = SurfelShader::SURFEL_RAY_QUEUE_DISPATCH_ARGS;                     // VkDispatchIndirectCommand del cálculo de radiancia, en la cabecera de la cola
+static const unsigned int SURFEL_RAY_QUEUE_HEADER_SIZE = SurfelShader::SURFEL_RAY_QUEUE_HEADER_SIZE;
+static const unsigned int NUM_RAYS = SurfelShader::NUM_RAYS;
 
 class SurfelsBufferManager
 {
 private:
+    // Imagen 3D de un nivel del volumen de irradiancia, con las mismas dimensiones que el nivel del grid
+    struct SurfelVolumeImage
+    {
+        VkImage image;
+        VkDeviceMemory memory;
+        VkImageView view;
+    };
+
     // Buffers para almacenar los surfels creados, sus localizaciones en la escena...
     VkBuffer surfelPositionBuffer;
     VmaAllocation surfelPositionBufferAllocation;
@@ -89,19 +88,29 @@ private:
     VmaAllocation surfelGridBufferAllocation;
     VkBuffer surfelCellBuffer;
     VmaAllocation surfelCellBufferAllocation;
-
-    // Listas de buffers de vértices y de índices de la escena
-    std::vector<VkBuffer> vertexBufferList;
-    std::vector<VmaAllocation> vertexBufferAllocationList;
-    std::vector<size_t> vertexBufferSizeList;
-    std::vector<VkBuffer> indexBufferList;
-    std::vector<VmaAllocation> indexBufferAllocationList;
-    std::vector<size_t> indexBufferSizeList;
-
-    // Buffer de variables uniformes de la cámara
-    VkBuffer uniformCameraBuffer;
-    VkDeviceMemory uniformCameraBufferMemory;
-    void *uniformCameraBufferMapped;
+    // Pila con los índices de los surfels reciclados, disponibles para la generación
+    VkBuffer surfelFreeListBuffer;
+    VmaAllocation surfelFreeListBufferAllocation;
+    // Cola compactada con los surfels que lanzan rayos en el frame, precedida de su cabecera y del histograma de prioridades
+    VkBuffer surfelRayQueueBuffer;
+    VmaAllocation surfelRayQueueBufferAllocation;
+
+    // Volumen de irradiancia de cada nivel del clipmap: irradiancia media de los surfels de cada celda y ocupación, y
+    // factor con el que la escala la normal del píxel
+    std::array<SurfelVolumeImage, SURFEL_CLIPMAP_LEVELS> irradianceVolume;
+    std::array<SurfelVolumeImage, SURFEL_CLIPMAP_LEVELS> directionVolume;
+
+    // Número de frame que se pasa a los shaders para saber cuándo se vio cada surfel por última vez
+    uint32_t frameCounter = 0;
+    // Hash de la escena, con el que se identifica su caché de surfels
+    uint64_t sceneHash = 0;
+    // La caché cargada procede de un bake offline: cubre toda la escena y no se sobrescribe al salir
+    bool bakedSurfelCache = false;
+
+    // Buffers de variables uniformes de la cámara (uno por cada frame en vuelo)
+    std::vector<VkBuffer> uniformCameraBuffers;
+    std::vector<VkDeviceMemory> uniformCameraBuffersMemory;
+    std::vector<void *> uniformCameraBuffersMapped;
 
     // Buffer con la información de los materiales translúcidos
     VkBuffer translucentMaterialsBuffer;
@@ -116,30 +125,33 @@ private:
     const char *blueNoisePath = RESOURCES_PATH "textures/Blue_Noise.png";
 
     void createRaytracingNoiseTexture(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue);
+    void createIrradianceVolume(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue);
+    static void createVolumeImage(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandBuffer commandBuffer, SurfelVolumeImage &volume);
+    SurfelCacheBuffers getSurfelCacheBuffers();
 
 public:
-    void createSurfelsResources(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t width, uint32_t height, Camera *camera, VkCommandPool commandPool,
-                                VkQueue graphicsQueue, std::vector<MeshContainer> sceneMeshes);
-    void updateUniformBuffers(uint32_t width, uint32_t height, Camera *camera);
+    void createSurfelsResources(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t MAX_FRAMES_IN_FLIGHT, uint32_t width, uint32_t height, Camera *camera, VkCommandPool commandPool,
+                                VkQueue graphicsQueue, UploadBatcher &uploadBatcher, uint64_t sceneHash);
+    void updateUniformBuffers(uint32_t currentImage, uint32_t width, uint32_t height, Camera *camera);
 
-    static void mapSurfelsVisualizationData(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue,
-                                            VkBuffer surfelsGeneratedData, VkBuffer &outVertexBuffer, VmaAllocation &outVertexAlloc, bool radianceVisualization);
 
     VkBuffer getSurfelPositionBuffer();
     VkBuffer getSurfelBuffer();
     VkBuffer getSurfelStatsBuffer();
     VkBuffer getSurfelGridBuffer();
     VkBuffer getSurfelCellBuffer();
-    VkBuffer getCameraSurfelBuffer();
+    VkBuffer getSurfelFreeListBuffer();
+    VkBuffer getSurfelRayQueueBuffer();
+    std::vector<VkBuffer> getCameraSurfelBuffers();
     VkBuffer getTranslucentMaterialsBuffer();
 
-    std::vector<VkBuffer> getIndexBufferList();
-    std::vector<VkBuffer> getVertexBufferList();
-    std::vector<size_t> getIndexBufferSizeList();
-    std::vector<size_t> getVertexBufferSizeList();
-
     ImageCreator getRaysNoiseImage();
     ImageCreator getBlueNoiseImage();
+    std::vector<VkImageView> getIrradianceVolumeViews();
+    std::vector<VkImageView> getDirectionVolumeViews();
+
+    // Guarda el estado de los surfels en la caché de la escena, para cargarlo en el siguiente arranque
+    void saveSurfelCache(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue);
 
     void cleanup(VkDevice device);
 };
\ No newline at end of file
@@ -0,0 +1,230 @@
+#include "UploadBatcher.h"
+
+#include "BufferCreator.h"
+
+#include <GLFW/glfw3.h>
+#include <GLFW/glfw3native.h>
+#include <glm/glm.hpp>
+#include <vma/vk_mem_alloc.h>
+
+#include <vector>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+#define VK_USE_PLATFORM_WIN32_KHR
+#define GLFW_INCLUDE_VULKAN
+#define GLFW_EXPOSE_NATIVE_WIN32
+
+void UploadBatcher::init(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue)
+{
+    this->device = device;
+    this->physicalDevice = physicalDevice;
+    this->commandPool = commandPool;
+    this->graphicsQueue = graphicsQueue;
+
+    // El anillo se crea y se mapea una única vez, en lugar de crear un staging buffer por cada subida
+    BufferCreator::createBuffer(device, physicalDevice, STAGING_RING_SIZE, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingRingBuffer, stagingRingBufferMemory);
+    void *data;
+    vkMapMemory(device, stagingRingBufferMemory, 0, STAGING_RING_SIZE, 0, &data);
+    stagingRingMapped = static_cast<uint8_t *>(data);
+    // Cada lote escribe en su propio segmento, para que la CPU pueda rellenar uno mientras la GPU consume el otro
+    segmentSize = STAGING_RING_SIZE / UPLOAD_BATCHES;
+    segmentHead = 0;
+
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandPool = commandPool;
+    allocInfo.commandBufferCount = 1;
+
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    for (auto &batch : batches)
+    {
+        if (vkAllocateCommandBuffers(device, &allocInfo, &batch.commandBuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to allocate upload command buffer!");
+        }
+        if (vkCreateFence(device, &fenceInfo, nullptr, &batch.fence) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create upload fence!");
+        }
+    }
+
+    currentBatch = 0;
+    submittedBatches = 0;
+}
+
+StagingAllocation UploadBatcher::stageData(const void *data, VkDeviceSize size)
+{
+    StagingAllocation allocation{};
+    // Se asegura que el lote actual está grabando, ya que las regiones se asocian a él
+    beginBatch(batches[currentBatch]);
+
+    // Si los datos no caben en un segmento, se usa un staging buffer dedicado que se libera al terminar el lote
+    if (size > segmentSize)
+    {
+        VkDeviceMemory dedicatedMemory;
+        BufferCreator::createBuffer(device, physicalDevice, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, allocation.buffer, dedicatedMemory);
+        void *mapped;
+        vkMapMemory(device, dedicatedMemory, 0, size, 0, &mapped);
+        memcpy(mapped, data, static_cast<size_t>(size));
+        vkUnmapMemory(device, dedicatedMemory);
+        allocation.offset = 0;
+        releaseAfterCompletion(allocation.buffer, dedicatedMemory);
+        return allocation;
+    }
+
+    VkDeviceSize alignedHead = (segmentHead + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+    // Si el segmento está lleno, se envía el lote y se pasa al siguiente segmento del anillo
+    if (alignedHead + size > segmentSize)
+    {
+        nextBatch();
+        alignedHead = 0;
+    }
+
+    allocation.buffer = stagingRingBuffer;
+    allocation.offset = currentBatch * segmentSize + alignedHead;
+    memcpy(stagingRingMapped + allocation.offset, data, static_cast<size_t>(size));
+    segmentHead = alignedHead + size;
+
+    return allocation;
+}
+
+VkCommandBuffer UploadBatcher::getCommandBuffer()
+{
+    UploadBatch &batch = batches[currentBatch];
+    beginBatch(batch);
+    return batch.commandBuffer;
+}
+
+void UploadBatcher::copyToBuffer(const void *data, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset)
+{
+    StagingAllocation allocation = stageData(data, size);
+
+    VkBufferCopy copyRegion{};
+    copyRegion.srcOffset = allocation.offset;
+    copyRegion.dstOffset = dstOffset;
+    copyRegion.size = size;
+    vkCmdCopyBuffer(getCommandBuffer(), allocation.buffer, dstBuffer, 1, &copyRegion);
+}
+
+void UploadBatcher::releaseAfterCompletion(VkBuffer buffer, VkDeviceMemory bufferMemory)
+{
+    UploadBatch &batch = batches[currentBatch];
+    batch.releaseBuffers.push_back(buffer);
+    batch.releaseBuffersMemory.push_back(bufferMemory);
+}
+
+void UploadBatcher::submit()
+{
+    UploadBatch &batch = batches[currentBatch];
+    if (!batch.recording)
+    {
+        return;
+    }
+
+    vkEndCommandBuffer(batch.commandBuffer);
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &batch.commandBuffer;
+
+    if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, batch.fence) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to submit upload batch!");
+    }
+
+    batch.recording = false;
+    batch.inFlight = true;
+    submittedBatches++;
+}
+
+void UploadBatcher::flush()
+{
+    submit();
+    for (auto &batch : batches)
+    {
+        waitBatch(batch);
+    }
+    // Con todos los lotes terminados, se puede volver a escribir desde el principio del anillo
+    currentBatch = 0;
+    segmentHead = 0;
+}
+
+void UploadBatcher::cleanup()
+{
+    flush();
+
+    for (auto &batch : batches)
+    {
+        vkFreeCommandBuffers(device, commandPool, 1, &batch.commandBuffer);
+        vkDestroyFence(device, batch.fence, nullptr);
+    }
+
+    vkUnmapMemory(device, stagingRingBufferMemory);
+    vkDestroyBuffer(device, stagingRingBuffer, nullptr);
+    vkFreeMemory(device, stagingRingBufferMemory, nullptr);
+    stagingRingMapped = nullptr;
+}
+
+uint32_t UploadBatcher::getSubmittedBatches()
+{
+    return submittedBatches;
+}
+
+void UploadBatcher::beginBatch(UploadBatch &batch)
+{
+    if (batch.recording)
+    {
+        return;
+    }
+
+    // El segmento y los recursos del lote sólo se reutilizan cuando su envío anterior ha terminado
+    waitBatch(batch);
+    vkResetCommandBuffer(batch.commandBuffer, 0);
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    if (vkBeginCommandBuffer(batch.commandBuffer, &beginInfo) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to begin upload command buffer!");
+    }
+    batch.recording = true;
+}
+
+void UploadBatcher::waitBatch(UploadBatch &batch)
+{
+    if (!batch.inFlight)
+    {
+        return;
+    }
+
+    vkWaitForFences(device, 1, &batch.fence, VK_TRUE, UINT64_MAX);
+    vkResetFences(device, 1, &batch.fence);
+    batch.inFlight = false;
+
+    for (size_t i = 0; i < batch.releaseBuffers.size(); i++)
+    {
+        vkDestroyBuffer(device, batch.releaseBuffers[i], nullptr);
+        vkFreeMemory(device, batch.releaseBuffersMemory[i], nullptr);
+    }
+    batch.releaseBuffers.clear();
+    batch.releaseBuffersMemory.clear();
+}
+
+void UploadBatcher::nextBatch()
+{
+    submit();
+    currentBatch = (currentBatch + 1) % UPLOAD_BATCHES;
+    segmentHead = 0;
+    // Antes de escribir en el segmento del nuevo lote, se espera a que la GPU haya terminado de leerlo
+    beginBatch(batches[currentBatch]);
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <GLFW/glfw3.h>
+#include <GLFW/glfw3native.h>
+#include <glm/glm.hpp>
+#include <vma/vk_mem_alloc.h>
+
+#include <vector>
+#include <array>
+
+#define VK_USE_PLATFORM_WIN32_KHR
+#define GLFW_INCLUDE_VULKAN
+#define GLFW_EXPOSE_NATIVE_WIN32
+
+// Región del anillo de staging en la que se han escrito unos datos
+struct StagingAllocation
+{
+	VkBuffer buffer;
+	VkDeviceSize offset;
+};
+
+// Agrupa las subidas de datos a la GPU (copias, transiciones de layout, mip maps, construcción de estructuras de aceleración...)
+// en un único command buffer por lote, que se envía una sola vez y cuya finalización se controla con un fence.
+// Los datos se escriben en un anillo de staging mapeado de forma persistente, dividido en un segmento por lote en vuelo
+class UploadBatcher
+{
+public:
+	// Tamaño total del anillo de staging
+	static const VkDeviceSize STAGING_RING_SIZE = 128 * 1024 * 1024;
+	// Número de lotes que pueden estar en vuelo a la vez
+	static const uint32_t UPLOAD_BATCHES = 2;
+	// Alineamiento de cada región, válido para cualquier formato de texel utilizado
+	static const VkDeviceSize STAGING_ALIGNMENT = 16;
+
+	void init(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue);
+	// Copia los datos al anillo y devuelve dónde se han escrito, para usarlos como origen de una copia del lote actual
+	StagingAllocation stageData(const void *data, VkDeviceSize size);
+	// Command buffer del lote actual, en el que se graban los comandos de subida
+	VkCommandBuffer getCommandBuffer();
+	// Graba la copia de unos datos de CPU a un buffer de GPU
+	void copyToBuffer(const void *data, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset);
+	// Libera un buffer temporal cuando termine el lote actual
+	void releaseAfterCompletion(VkBuffer buffer, VkDeviceMemory bufferMemory);
+	// Envía el lote actual sin esperar a que termine
+	void submit();
+	// Envía el lote actual y espera a que terminen todos los lotes
+	void flush();
+	void cleanup();
+
+	uint32_t getSubmittedBatches();
+
+private:
+	struct UploadBatch
+	{
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		VkFence fence = VK_NULL_HANDLE;
+		bool recording = false;
+		bool inFlight = false;
+		// Buffers que se liberan cuando el fence del lote se señaliza
+		std::vector<VkBuffer> releaseBuffers;
+		std::vector<VkDeviceMemory> releaseBuffersMemory;
+	};
+
+	VkDevice device = VK_NULL_HANDLE;
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	VkCommandPool commandPool = VK_NULL_HANDLE;
+	VkQueue graphicsQueue = VK_NULL_HANDLE;
+
+	// Anillo de staging
+	VkBuffer stagingRingBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory stagingRingBufferMemory = VK_NULL_HANDLE;
+	uint8_t *stagingRingMapped = nullptr;
+	VkDeviceSize segmentSize = 0;
+	// Posición de escritura dentro del segmento del lote actual
+	VkDeviceSize segmentHead = 0;
+
+	std::array<UploadBatch, UPLOAD_BATCHES> batches;
+	uint32_t currentBatch = 0;
+	uint32_t submittedBatches = 0;
+
+	void beginBatch(UploadBatch &batch);
+	void waitBatch(UploadBatch &batch);
+	void nextBatch();
+};
\ No newline at end of file
@@ -25,7 +25,7 @@
 
 void UniformBuffersManager::createUniformBuffers(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t MAX_FRAMES_IN_FLIGHT, MainDirectionalLight light,
                                                  uint32_t width, uint32_t height, Camera *camera, LightsData sceneLights, VkCommandPool commandPool, VkQueue graphicsQueue,
-                                                 std::vector<MeshContainer> sceneMeshes)
+                                                 UploadBatcher &uploadBatcher, uint32_t sceneDrawCount, uint64_t sceneHash)
 {
     if (renderConfig == RenderMode::SHADOW_MAPPING || renderConfig == RenderMode::SHADOW_MAPPING_PCF)
     {
@@ -54,7 +54,8 @@ void UniformBuffersManager::createUniformBuffers(VkDevice device, VkPhysicalDevi
         gUniformBuffer.createUniformBuffers(device, physicalDevice, MAX_FRAMES_IN_FLIGHT, width, height, camera);
         ssaoUniformBuffer.createUniformBuffers(device, physicalDevice, MAX_FRAMES_IN_FLIGHT, width, height);
         shadowSSAOUniformBuffer.createUniformBuffers(device, physicalDevice, MAX_FRAMES_IN_FLIGHT, width, height, camera, sceneLights);
-        surfelsResourcesManager.createSurfelsResources(device, physicalDevice, width, height, camera, commandPool, graphicsQueue, sceneMeshes);
+        surfelsResourcesManager.createSurfelsResources(device, physicalDevice, MAX_FRAMES_IN_FLIGHT, width, height, camera, commandPool, graphicsQueue, uploadBatcher, sceneHash);
+        sceneCullingResourcesManager.createCullingResources(device, physicalDevice, MAX_FRAMES_IN_FLIGHT, width, height, sceneDrawCount, camera, commandPool, graphicsQueue);
     }
 }
 
@@ -87,7 +88,26 @@ void UniformBuffersManager::updateUniformBuffers(uint32_t currentImage, MainDire
         gUniformBuffer.updateUniformBuffers(currentImage, width, height, camera);
         ssaoUniformBuffer.updateUniformBuffers(currentImage, width, height);
         shadowSSAOUniformBuffer.updateUniformBuffers(currentImage, width, height, camera, sceneLights);
-        surfelsResourcesManager.updateUniformBuffers(width, height, camera);
+        surfelsResourcesManager.updateUniformBuffers(currentImage, width, height, camera);
+        sceneCullingResourcesManager.updateUniformBuffers(currentImage, width, height, camera);
+    }
+}
+
+void UniformBuffersManager::recreateSizeDependentResources(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t width, uint32_t height, VkCommandPool commandPool, VkQueue graphicsQueue)
+{
+    if (renderConfig == RenderMode::SURFELS_GLOBAL_ILLUMINATION || renderConfig == RenderMode::SURFELS_VISUALIZATION || renderConfig == RenderMode::SURFELS_RADIANCE_VISUALIZATION)
+    {
+        // La pirámide de profundidad tiene que coincidir con el nuevo G-Buffer
+        sceneCullingResourcesManager.cleanupHiZPyramid(device);
+        sceneCullingResourcesManager.createHiZPyramid(device, physicalDevice, width, height, commandPool, graphicsQueue);
+    }
+}
+
+void UniformBuffersManager::saveSurfelCache(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue)
+{
+    if (renderConfig == RenderMode::SURFELS_GLOBAL_ILLUMINATION || renderConfig == RenderMode::SURFELS_VISUALIZATION || renderConfig == RenderMode::SURFELS_RADIANCE_VISUALIZATION)
+    {
+        surfelsResourcesManager.saveSurfelCache(device, physicalDevice, commandPool, graphicsQueue);
     }
 }
 
@@ -121,6 +141,7 @@ void UniformBuffersManager::cleanupUniformBuffers(VkDevice device)
         ssaoUniformBuffer.cleanup(device);
         shadowSSAOUniformBuffer.cleanup(device);
         surfelsResourcesManager.cleanup(device);
+        sceneCullingResourcesManager.cleanup(device);
     }
 }
 
@@ -209,9 +230,19 @@ VkBuffer UniformBuffersManager::getSurfelCellBuffer()
     return surfelsResourcesManager.getSurfelCellBuffer();
 }
 
-VkBuffer UniformBuffersManager::getCameraSurfelBuffer()
+VkBuffer UniformBuffersManager::getSurfelFreeListBuffer()
 {
-    return surfelsResourcesManager.getCameraSurfelBuffer();
+    return surfelsResourcesManager.getSurfelFreeListBuffer();
+}
+
+VkBuffer UniformBuffersManager::getSurfelRayQueueBuffer()
+{
+    return surfelsResourcesManager.getSurfelRayQueueBuffer();
+}
+
+std::vector<VkBuffer> UniformBuffersManager::getCameraSurfelBuffers()
+{
+    return surfelsResourcesManager.getCameraSurfelBuffers();
 }
 
 VkBuffer UniformBuffersManager::getTranslucentMaterialsBuffer()
@@ -219,32 +250,40 @@ VkBuffer UniformBuffersManager::getTranslucentMaterialsBuffer()
     return surfelsResourcesManager.getTranslucentMaterialsBuffer();
 }
 
-std::vector<VkBuffer> UniformBuffersManager::getIndexBufferList()
+ImageCreator UniformBuffersManager::getRaysNoiseImage()
 {
-    return surfelsResourcesManager.getIndexBufferList();
+    return surfelsResourcesManager.getRaysNoiseImage();
 }
 
-std::vector<VkBuffer> UniformBuffersManager::getVertexBufferList()
+ImageCreator UniformBuffersManager::getBlueNoiseImage()
 {
-    return surfelsResourcesManager.getVertexBufferList();
+    return surfelsResourcesManager.getBlueNoiseImage();
 }
 
-std::vector<size_t> UniformBuffersManager::getIndexBufferSizeList()
+std::vector<VkImageView> UniformBuffersManager::getIrradianceVolumeViews()
 {
-    return surfelsResourcesManager.getIndexBufferSizeList();
+    return surfelsResourcesManager.getIrradianceVolumeViews();
 }
 
-std::vector<size_t> UniformBuffersManager::getVertexBufferSizeList()
+std::vector<VkImageView> UniformBuffersManager::getDirectionVolumeViews()
 {
-    return surfelsResourcesManager.getVertexBufferSizeList();
+    return surfelsResourcesManager.getDirectionVolumeViews();
 }
 
-ImageCreator UniformBuffersManager::getRaysNoiseImage()
+const SceneCullingBufferManager &UniformBuffersManager::getSceneCullingResources()
 {
-    return surfelsResourcesManager.getRaysNoiseImage();
+    return sceneCullingResourcesManager;
 }
 
-ImageCreator UniformBuffersManager::getBlueNoiseImage()
+void UniformBuffersManager::readSceneCullingStats(uint32_t currentImage)
 {
-    return surfelsResourcesManager.getBlueNoiseImage();
+    if (renderConfig == RenderMode::SURFELS_GLOBAL_ILLUMINATION || renderConfig == RenderMode::SURFELS_VISUALIZATION || renderConfig == RenderMode::SURFELS_RADIANCE_VISUALIZATION)
+    {
+        sceneCullingResourcesManager.readStats(currentImage);
+    }
+}
+
+SceneCullingStats UniformBuffersManager::getSceneCullingStats()
+{
+    return sceneCullingResourcesManager.getStats();
 }
\ No newline at end of file
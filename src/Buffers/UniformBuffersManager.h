@@ -10,6 +10,7 @@
 #include "ShadowSSAOCompositionUniformBuffer.h"
 #include "RaytracingUniformBuffer.h"
 #include "SurfelsBufferManager.h"
+#include "SceneCullingBufferManager.h"
 #include "Raytracing/RaytracingManager.h"
 
 #define VK_USE_PLATFORM_WIN32_KHR
@@ -41,12 +42,17 @@ private:
     RaytracingUniformBuffer raytracingUniformBuffer;
 
     SurfelsBufferManager surfelsResourcesManager;
+    SceneCullingBufferManager sceneCullingResourcesManager;
 
 public:
     void createUniformBuffers(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t MAX_FRAMES_IN_FLIGHT, MainDirectionalLight light,
-                              uint32_t width, uint32_t height, Camera* camera, LightsData sceneLights, VkCommandPool commandPool, VkQueue graphicsQueue,
-                              std::vector<MeshContainer> sceneMeshes);
+                              uint32_t width, uint32_t height, Camera* camera, LightsData sceneLights, VkCommandPool commandPool, VkQueue graphicsQueue, UploadBatcher &uploadBatcher,
+                              uint32_t sceneDrawCount, uint64_t sceneHash);
     void updateUniformBuffers(uint32_t currentImage, MainDirectionalLight light, uint32_t width, uint32_t height, Camera* camera, LightsData sceneLights);
+    // Recursos que dependen del tamaño de la ventana
+    void recreateSizeDependentResources(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t width, uint32_t height, VkCommandPool commandPool, VkQueue graphicsQueue);
+    // Guarda los surfels en la caché de la escena antes de liberar los buffers
+    void saveSurfelCache(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue);
     void cleanupUniformBuffers(VkDevice device);
 
     std::vector<VkBuffer> getGeometryMVPBuffers();
@@ -67,14 +73,17 @@ public:
     VkBuffer getSurfelStatsBuffer();
     VkBuffer getSurfelGridBuffer();
     VkBuffer getSurfelCellBuffer();
-    VkBuffer getCameraSurfelBuffer();
+    VkBuffer getSurfelFreeListBuffer();
+    VkBuffer getSurfelRayQueueBuffer();
+    std::vector<VkBuffer> getCameraSurfelBuffers();
     VkBuffer getTranslucentMaterialsBuffer();
 
-    std::vector<VkBuffer> getIndexBufferList();
-    std::vector<VkBuffer> getVertexBufferList();
-    std::vector<size_t> getIndexBufferSizeList();
-    std::vector<size_t> getVertexBufferSizeList();
-
     ImageCreator getRaysNoiseImage();
     ImageCreator getBlueNoiseImage();
+    std::vector<VkImageView> getIrradianceVolumeViews();
+    std::vector<VkImageView> getDirectionVolumeViews();
+
+    const SceneCullingBufferManager &getSceneCullingResources();
+    void readSceneCullingStats(uint32_t currentImage);
+    SceneCullingStats getSceneCullingStats();
 };
\ No newline at end of file
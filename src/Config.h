@@ -1,5 +1,7 @@
 #pragma once
 
+#include "Tools/SamplingSequences.h"
+
 enum RenderMode : short {
     SHADOW_MAPPING,
     SHADOW_MAPPING_PCF,
@@ -10,4 +12,37 @@ enum RenderMode : short {
     SURFELS_RADIANCE_VISUALIZATION,
     SURFELS_GLOBAL_ILLUMINATION
 };
-const RenderMode renderConfig = RenderMode::SURFELS_GLOBAL_ILLUMINATION;
\ No newline at end of file
+const RenderMode renderConfig = RenderMode::SURFELS_GLOBAL_ILLUMINATION;
+
+// Número de frames que pueden estar en vuelo a la vez: la CPU graba el siguiente mientras la GPU ejecuta los anteriores
+const unsigned int FRAMES_IN_FLIGHT = 2;
+
+// Iluminación difusa indirecta de cada píxel: una consulta filtrada al volumen de irradiancia que se construye con los
+// surfels de cada celda, o el gather gaussiano de los surfels de las celdas vecinas, más caro pero más preciso. El gather
+// se hace en un compute shader por teselas de 16x16 píxeles, que comparten la lista de surfels que les afectan
+enum IndirectDiffuseMode : short {
+    IRRADIANCE_VOLUME,
+    SURFEL_GATHER
+};
+const IndirectDiffuseMode indirectDiffuseMode = IndirectDiffuseMode::IRRADIANCE_VOLUME;
+
+// Rayos que se reparten en cada frame entre los surfels, por orden de prioridad, en el cálculo de su radiancia
+const unsigned int SURFEL_RAY_BUDGET = 250000;
+
+// Secuencia con la que se generan las direcciones de los rayos de los surfels
+const SamplingSequence raySamplingSequence = SamplingSequence::SOBOL;
+// Semilla del scrambling de la secuencia, compartida con el baker de surfels para que los rayos sean los mismos
+const unsigned int raySamplingSeed = 1337;
+
+// Guardar los surfels al salir y cargarlos al arrancar, para que la iluminación global de una escena estática no tenga
+// que converger de nuevo en cada ejecución
+const bool persistSurfelCache = true;
+
+// Construir al arrancar una BVH de CPU con los triángulos de la escena y medir su velocidad de trazado
+const bool runCpuBvhBenchmark = false;
+
+// Mostrar por consola una vez por segundo cuántos objetos de la escena descartan el frustum y la oclusión
+const bool reportSceneCullingStats = false;
+
+// Comparar al arrancar la discrepancia de las secuencias de muestreo con el número de rayos de la textura de direcciones
+const bool runSamplingDiscrepancyReport = false;
\ No newline at end of file
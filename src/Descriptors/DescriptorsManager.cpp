@@ -77,28 +77,36 @@ void DescriptorsManager::createDescriptors(VkDevice device, uint32_t MAX_FRAMES_
                                            VkImageView albedoImageView, VkImageView colorSSAOImageView, VkImageView colorSSAOBlurImageView, ImageCreator noiseTexture, std::vector<VkBuffer> uniformShadowBuffers,
                                            VkImageView depthImageView, VkSampler depthSampler, std::vector<VkBuffer> lightBuffers, std::vector<VkBuffer> mainLightDataBuffer,
                                            std::vector<VkBuffer> uniformMVPBuffers, VkImageView specularImageView, VkBuffer surfelBuffer, VkBuffer surfelStatsBuffer, VkBuffer surfelGridBuffer,
-                                           VkBuffer surfelCellBuffer, VkBuffer cameraUniformBuffer, AccelerationStructure &topLevelAccelerationStructure,
-                                           std::vector<VkBuffer> indexBufferList, std::vector<VkBuffer> vertexBufferList, std::vector<size_t> indexBufferSizeList, std::vector<size_t> vertexBufferSizeList, 
-                                           ImageCreator raysNoiseImage, VkImageView indirectDiffuseImageView, ImageCreator blueNoiseImage, VkImageView surfelsVisualizationImageView)
+                                           VkBuffer surfelCellBuffer, VkBuffer surfelFreeListBuffer, std::vector<VkBuffer> cameraUniformBuffers, AccelerationStructure &topLevelAccelerationStructure,
+                                           const SceneGeometryBuffer &sceneGeometry,
+                                           ImageCreator raysNoiseImage, VkImageView indirectDiffuseImageView, ImageCreator blueNoiseImage, VkImageView surfelsVisualizationImageView,
+                                           const SceneDrawList &sceneDrawList, const SceneCullingBufferManager &cullingResources, VkImageView gBufferDepthImageView,
+                                           VkBuffer surfelRayQueueBuffer, std::vector<VkImageView> irradianceVolumeViews, std::vector<VkImageView> directionVolumeViews)
 {
     shadowMappingDescriptors.createDescriptors(device, MAX_FRAMES_IN_FLIGHT, uniformShadowBuffers);
 
     colorSampler = getSSAOColorSampler(device);
 
     gBufferDescriptors.createDescriptors(device, numTextures, numMaterials, MAX_FRAMES_IN_FLIGHT, gUniformBuffers, diffuseImageCreators, alphaImageCreators, specularImageCreators);
-    surfelsGenerationDescriptors.createDescriptors(device, MAX_FRAMES_IN_FLIGHT, surfelBuffer, surfelStatsBuffer, surfelGridBuffer, surfelCellBuffer, cameraUniformBuffer,
-                                                   normalImageView, positionImageView, albedoImageView, blueNoiseImage);
-    surfelsVisualizationDescriptors.createDescriptors(device, MAX_FRAMES_IN_FLIGHT, surfelBuffer, surfelGridBuffer, surfelCellBuffer, cameraUniformBuffer, positionImageView);
-    surfelsRadianceCalculationDescriptors.createDescriptors(device, MAX_FRAMES_IN_FLIGHT, surfelBuffer, lightBuffers, topLevelAccelerationStructure, indexBufferList, vertexBufferList,
-                                                            indexBufferSizeList, vertexBufferSizeList, numTextures, numMaterials, diffuseImageCreators, alphaImageCreators, specularImageCreators,
-                                                            raysNoiseImage);
-    surfelsIndirectShadingDescriptors.createDescriptors(device, topLevelAccelerationStructure, MAX_FRAMES_IN_FLIGHT, surfelBuffer, surfelGridBuffer, surfelCellBuffer, cameraUniformBuffer,
-                                                        positionImageView, normalImageView);
+    surfelsGridDescriptors.createDescriptors(device, MAX_FRAMES_IN_FLIGHT, surfelBuffer, surfelStatsBuffer, surfelGridBuffer, surfelCellBuffer, surfelFreeListBuffer,
+                                             cameraUniformBuffers, surfelRayQueueBuffer);
+    surfelsGenerationDescriptors.createDescriptors(device, MAX_FRAMES_IN_FLIGHT, surfelBuffer, surfelStatsBuffer, surfelGridBuffer, surfelCellBuffer, cameraUniformBuffers,
+                                                   normalImageView, positionImageView, albedoImageView, blueNoiseImage, surfelFreeListBuffer);
+    surfelsVisualizationDescriptors.createDescriptors(device, MAX_FRAMES_IN_FLIGHT, surfelBuffer, surfelGridBuffer, surfelCellBuffer, cameraUniformBuffers, positionImageView);
+    surfelsRadianceCalculationDescriptors.createDescriptors(device, MAX_FRAMES_IN_FLIGHT, surfelBuffer, lightBuffers, topLevelAccelerationStructure, sceneGeometry,
+                                                            numTextures, numMaterials, diffuseImageCreators, alphaImageCreators, specularImageCreators,
+                                                            raysNoiseImage, surfelRayQueueBuffer, surfelGridBuffer, surfelCellBuffer, cameraUniformBuffers);
+    surfelsIrradianceVolumeDescriptors.createDescriptors(device, MAX_FRAMES_IN_FLIGHT, surfelBuffer, surfelGridBuffer, surfelCellBuffer, cameraUniformBuffers,
+                                                         irradianceVolumeViews, directionVolumeViews);
+    surfelsIndirectShadingDescriptors.createDescriptors(device, topLevelAccelerationStructure, MAX_FRAMES_IN_FLIGHT, surfelBuffer, surfelGridBuffer, surfelCellBuffer, cameraUniformBuffers,
+                                                        positionImageView, normalImageView, irradianceVolumeViews, directionVolumeViews, indirectDiffuseImageView);
     ssaoDescriptors.createDescriptors(device, MAX_FRAMES_IN_FLIGHT, ssaoProjUniformBuffers, ssaoParamsUniformBuffers, colorSampler, positionImageView, normalImageView, noiseTexture);
     ssaoBlurDescriptors.createDescriptors(device, MAX_FRAMES_IN_FLIGHT, colorSampler, colorSSAOImageView);
     surfelsCompositionDescriptors.createDescriptors(device, MAX_FRAMES_IN_FLIGHT, ssaoParamsUniformBuffers, colorSampler, positionImageView, normalImageView, albedoImageView,
                                                     colorSSAOBlurImageView, depthImageView, depthSampler, lightBuffers, mainLightDataBuffer, uniformMVPBuffers, specularImageView,
                                                     indirectDiffuseImageView, surfelsVisualizationImageView);
+    sceneCullingDescriptors.createDescriptors(device, MAX_FRAMES_IN_FLIGHT, sceneDrawList, cullingResources);
+    hiZDescriptors.createDescriptors(device, gBufferDepthImageView, cullingResources);
 }
 
 VkSampler DescriptorsManager::getSSAOColorSampler(VkDevice device)
@@ -154,13 +162,17 @@ void DescriptorsManager::cleanupDescriptors(VkDevice device)
     {
         shadowMappingDescriptors.cleanupDescriptors(device);
         gBufferDescriptors.cleanupDescriptors(device);
+        surfelsGridDescriptors.cleanupDescriptors(device);
         surfelsGenerationDescriptors.cleanupDescriptors(device);
         surfelsVisualizationDescriptors.cleanupDescriptors(device);
         surfelsRadianceCalculationDescriptors.cleanupDescriptors(device);
+        surfelsIrradianceVolumeDescriptors.cleanupDescriptors(device);
         surfelsIndirectShadingDescriptors.cleanupDescriptors(device);
         ssaoDescriptors.cleanupDescriptors(device);
         ssaoBlurDescriptors.cleanupDescriptors(device);
         surfelsCompositionDescriptors.cleanupDescriptors(device);
+        sceneCullingDescriptors.cleanupDescriptors(device);
+        hiZDescriptors.cleanupDescriptors(device);
         vkDestroySampler(device, colorSampler, nullptr);
     }
 }
@@ -210,6 +222,11 @@ VkDescriptorSetLayout DescriptorsManager::getSurfelsGenerationDescriptorSetLayou
     return surfelsGenerationDescriptors.getDescriptorSetLayout();
 }
 
+VkDescriptorSetLayout DescriptorsManager::getSurfelsGridDescriptorSetLayout()
+{
+    return surfelsGridDescriptors.getDescriptorSetLayout();
+}
+
 VkDescriptorSetLayout DescriptorsManager::getSurfelsVisualizationDescriptorSetLayout()
 {
     return surfelsVisualizationDescriptors.getDescriptorSetLayout();
@@ -220,6 +237,11 @@ VkDescriptorSetLayout DescriptorsManager::getSurfelsRadianceCalculationDescripto
     return surfelsRadianceCalculationDescriptors.getDescriptorSetLayout();
 }
 
+VkDescriptorSetLayout DescriptorsManager::getSurfelsIrradianceVolumeDescriptorSetLayout()
+{
+    return surfelsIrradianceVolumeDescriptors.getDescriptorSetLayout();
+}
+
 VkDescriptorSetLayout DescriptorsManager::getSurfelsIndirectLightingDescriptorSetLayout()
 {
     return surfelsIndirectShadingDescriptors.getDescriptorSetLayout();
@@ -230,6 +252,16 @@ VkDescriptorSetLayout DescriptorsManager::getSurfelsCompositionDescriptorSetLayo
     return surfelsCompositionDescriptors.getDescriptorSetLayout();
 }
 
+VkDescriptorSetLayout DescriptorsManager::getSceneCullingDescriptorSetLayout()
+{
+    return sceneCullingDescriptors.getDescriptorSetLayout();
+}
+
+VkDescriptorSetLayout DescriptorsManager::getHiZDescriptorSetLayout()
+{
+    return hiZDescriptors.getDescriptorSetLayout();
+}
+
 VkDescriptorSet DescriptorsManager::getGeometryDescriptor(int index)
 {
     return geometryDescriptors.getDescriptorSet(index);
@@ -275,6 +307,11 @@ VkDescriptorSet DescriptorsManager::getSurfelsGenerationDescriptor(int index)
     return surfelsGenerationDescriptors.getDescriptorSet(index);
 }
 
+VkDescriptorSet DescriptorsManager::getSurfelsGridDescriptor(int index)
+{
+    return surfelsGridDescriptors.getDescriptorSet(index);
+}
+
 VkDescriptorSet DescriptorsManager::getSurfelsVisualizationDescriptor(int index)
 {
     return surfelsVisualizationDescriptors.getDescriptorSet(index);
@@ -285,6 +322,11 @@ VkDescriptorSet DescriptorsManager::getSurfelsRadianceCalculationDescriptor(int
     return surfelsRadianceCalculationDescriptors.getDescriptorSet(index);
 }
 
+VkDescriptorSet DescriptorsManager::getSurfelsIrradianceVolumeDescriptor(int index)
+{
+    return surfelsIrradianceVolumeDescriptors.getDescriptorSet(index);
+}
+
 VkDescriptorSet DescriptorsManager::getSurfelsIndirectLightingDescriptor(int index)
 {
     return surfelsIndirectShadingDescriptors.getDescriptorSet(index);
@@ -294,3 +336,13 @@ VkDescriptorSet DescriptorsManager::getSurfelsCompositionDescriptor(int index)
 {
     return surfelsCompositionDescriptors.getDescriptorSet(index);
 }
+
+VkDescriptorSet DescriptorsManager::getSceneCullingDescriptor(int index)
+{
+    return sceneCullingDescriptors.getDescriptorSet(index);
+}
+
+std::vector<VkDescriptorSet> DescriptorsManager::getHiZDescriptors()
+{
+    return hiZDescriptors.getDescriptorSets();
+}
@@ -12,10 +12,14 @@
 #include "ShadowsSSAOCompositionDescriptors.h"
 #include "RaytracingDescriptors.h"
 #include "SurfelsGenerationDescriptors.h"
+#include "SurfelsGridDescriptors.h"
 #include "SurfelsVisualizationDescriptors.h"
 #include "SurfelsRadianceCalculationDescriptors.h"
+#include "SurfelsIrradianceVolumeDescriptors.h"
 #include "IndirectDiffuseShadingDescriptors.h"
 #include "SurfelsCompositionDescriptors.h"
+#include "SceneCullingDescriptors.h"
+#include "HiZDescriptors.h"
 
 #define VK_USE_PLATFORM_WIN32_KHR
 #define GLFW_INCLUDE_VULKAN
@@ -46,11 +50,16 @@ private:
     RaytracingDescriptors raytracingDescriptors;
 
     SurfelsGenerationDescriptors surfelsGenerationDescriptors;
+    SurfelsGridDescriptors surfelsGridDescriptors;
     SurfelsVisualizationDescriptors surfelsVisualizationDescriptors;
     SurfelsRadianceCalculationDescriptors surfelsRadianceCalculationDescriptors;
+    SurfelsIrradianceVolumeDescriptors surfelsIrradianceVolumeDescriptors;
     IndirectDiffuseShadingDescriptors surfelsIndirectShadingDescriptors;
     SurfelsCompositionDescriptors surfelsCompositionDescriptors;
 
+    SceneCullingDescriptors sceneCullingDescriptors;
+    HiZDescriptors hiZDescriptors;
+
     VkSampler colorSampler;
     VkSampler getSSAOColorSampler(VkDevice device);
 
@@ -79,9 +88,11 @@ public:
                            VkImageView albedoImageView, VkImageView colorSSAOImageView, VkImageView colorSSAOBlurImageView, ImageCreator noiseTexture, std::vector<VkBuffer> uniformShadowBuffers,
                            VkImageView depthImageView, VkSampler depthSampler, std::vector<VkBuffer> lightBuffers, std::vector<VkBuffer> mainLightDataBuffer,
                            std::vector<VkBuffer> uniformMVPBuffers, VkImageView specularImageView, VkBuffer surfelBuffer, VkBuffer surfelStatsBuffer, VkBuffer surfelGridBuffer,
-                           VkBuffer surfelCellBuffer, VkBuffer cameraUniformBuffer, AccelerationStructure &topLevelAccelerationStructure,
-                           std::vector<VkBuffer> indexBufferList, std::vector<VkBuffer> vertexBufferList, std::vector<size_t> indexBufferSizeList, std::vector<size_t> vertexBufferSizeList, 
-                           ImageCreator raysNoiseImage, VkImageView indirectDiffuseImageView, ImageCreator blueNoiseImage, VkImageView surfelsVisualizationImageView);
+                           VkBuffer surfelCellBuffer, VkBuffer surfelFreeListBuffer, std::vector<VkBuffer> cameraUniformBuffers, AccelerationStructure &topLevelAccelerationStructure,
+                           const SceneGeometryBuffer &sceneGeometry,
+                           ImageCreator raysNoiseImage, VkImageView indirectDiffuseImageView, ImageCreator blueNoiseImage, VkImageView surfelsVisualizationImageView,
+                           const SceneDrawList &sceneDrawList, const SceneCullingBufferManager &cullingResources, VkImageView gBufferDepthImageView,
+                           VkBuffer surfelRayQueueBuffer, std::vector<VkImageView> irradianceVolumeViews, std::vector<VkImageView> directionVolumeViews);
     void cleanupDescriptors(VkDevice device);
 
     VkDescriptorSetLayout getGeometryDescriptorSetLayout();
@@ -93,10 +104,14 @@ public:
     VkDescriptorSetLayout getShadowsSSAOCompositionDescriptorSetLayout();
     VkDescriptorSetLayout getRaytracingDescriptorSetLayout();
     VkDescriptorSetLayout getSurfelsGenerationDescriptorSetLayout();
+    VkDescriptorSetLayout getSurfelsGridDescriptorSetLayout();
     VkDescriptorSetLayout getSurfelsVisualizationDescriptorSetLayout();
     VkDescriptorSetLayout getSurfelsRadianceCalculationDescriptorSetLayout();
+    VkDescriptorSetLayout getSurfelsIrradianceVolumeDescriptorSetLayout();
     VkDescriptorSetLayout getSurfelsIndirectLightingDescriptorSetLayout();
     VkDescriptorSetLayout getSurfelsCompositionDescriptorSetLayout();
+    VkDescriptorSetLayout getSceneCullingDescriptorSetLayout();
+    VkDescriptorSetLayout getHiZDescriptorSetLayout();
 
     VkDescriptorSet getGeometryDescriptor(int index);
     VkDescriptorSet getShadowMappingDescriptor(int index);
@@ -107,8 +122,12 @@ public:
     VkDescriptorSet getShadowsSSAOCompositionDescriptor(int index);
     VkDescriptorSet getRaytracingDescriptor(int index);
     VkDescriptorSet getSurfelsGenerationDescriptor(int index);
+    VkDescriptorSet getSurfelsGridDescriptor(int index);
     VkDescriptorSet getSurfelsVisualizationDescriptor(int index);
     VkDescriptorSet getSurfelsRadianceCalculationDescriptor(int index);
+    VkDescriptorSet getSurfelsIrradianceVolumeDescriptor(int index);
     VkDescriptorSet getSurfelsIndirectLightingDescriptor(int index);
     VkDescriptorSet getSurfelsCompositionDescriptor(int index);
+    VkDescriptorSet getSceneCullingDescriptor(int index);
+    std::vector<VkDescriptorSet> getHiZDescriptors();
 };
\ No newline at end of file
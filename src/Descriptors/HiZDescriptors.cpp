@@ -0,0 +1,133 @@
+#include "HiZDescriptors.h"
+
+#include "Buffers/SceneCullingBufferManager.h"
+
+#define VK_USE_PLATFORM_WIN32_KHR
+#define GLFW_INCLUDE_VULKAN
+#define GLFW_EXPOSE_NATIVE_WIN32
+#define GLM_FORCE_RADIANS
+
+#include <GLFW/glfw3.h>
+#include <GLFW/glfw3native.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <vma/vk_mem_alloc.h>
+
+#include <vector>
+
+void HiZDescriptors::createDescriptors(VkDevice device, VkImageView gBufferDepthImageView, const SceneCullingBufferManager &cullingResources)
+{
+    uint32_t numLevels = cullingResources.getHiZLevels();
+    std::vector<VkImageView> levelViews = cullingResources.getHiZLevelViews();
+
+    // Descriptor pool
+    std::vector<VkDescriptorPoolSize> poolSize = {
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, numLevels},
+        {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, numLevels}};
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSize.size());
+    poolInfo.pPoolSizes = poolSize.data();
+    poolInfo.maxSets = numLevels;
+
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create descriptor pool!");
+    }
+
+    // Descriptor set layout
+    std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings(2);
+
+    setLayoutBindings[0].binding = 0;
+    setLayoutBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    setLayoutBindings[0].descriptorCount = 1;
+    setLayoutBindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    setLayoutBindings[1].binding = 1;
+    setLayoutBindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    setLayoutBindings[1].descriptorCount = 1;
+    setLayoutBindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
+    layoutInfo.pBindings = setLayoutBindings.data();
+
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create descriptor set layout!");
+    }
+
+    // Descriptor sets
+    std::vector<VkDescriptorSetLayout> layouts(numLevels, descriptorSetLayout);
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = descriptorPool;
+    allocInfo.pSetLayouts = layouts.data();
+    allocInfo.descriptorSetCount = numLevels;
+
+    descriptorSets.resize(numLevels);
+
+    if (vkAllocateDescriptorSets(device, &allocInfo, descriptorSets.data()) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create descriptor set!");
+    }
+
+    for (uint32_t level = 0; level < numLevels; level++)
+    {
+        std::vector<VkWriteDescriptorSet> descriptorWrites(2);
+
+        // Binding 0 -> Nivel de origen: el depth buffer del G-Buffer para el nivel 0, o el nivel anterior de la pirámide
+        VkDescriptorImageInfo sourceImageDescriptor{};
+        sourceImageDescriptor.imageLayout = level == 0 ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+        sourceImageDescriptor.imageView = level == 0 ? gBufferDepthImageView : levelViews[level - 1];
+        sourceImageDescriptor.sampler = cullingResources.getHiZSampler();
+
+        descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[0].dstSet = descriptorSets[level];
+        descriptorWrites[0].dstBinding = 0;
+        descriptorWrites[0].dstArrayElement = 0;
+        descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        descriptorWrites[0].descriptorCount = 1;
+        descriptorWrites[0].pImageInfo = &sourceImageDescriptor;
+
+        // Binding 1 -> Nivel de destino
+        VkDescriptorImageInfo targetImageDescriptor{};
+        targetImageDescriptor.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+        targetImageDescriptor.imageView = levelViews[level];
+
+        descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[1].dstSet = descriptorSets[level];
+        descriptorWrites[1].dstBinding = 1;
+        descriptorWrites[1].dstArrayElement = 0;
+        descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        descriptorWrites[1].descriptorCount = 1;
+        descriptorWrites[1].pImageInfo = &targetImageDescriptor;
+
+        // Actualización del descriptor
+        vkUpdateDescriptorSets(device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+    }
+}
+
+void HiZDescriptors::cleanupDescriptors(VkDevice device)
+{
+    vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+}
+
+VkDescriptorSetLayout HiZDescriptors::getDescriptorSetLayout()
+{
+    return descriptorSetLayout;
+}
+
+VkDescriptorSet HiZDescriptors::getDescriptorSet(int index)
+{
+    return descriptorSets[index];
+}
+
+std::vector<VkDescriptorSet> HiZDescriptors::getDescriptorSets()
+{
+    return descriptorSets;
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+
+#define VK_USE_PLATFORM_WIN32_KHR
+#define GLFW_INCLUDE_VULKAN
+#define GLFW_EXPOSE_NATIVE_WIN32
+#define GLM_FORCE_RADIANS
+
+#include "PipelineDescriptors.h"
+#include "Buffers/SceneCullingBufferManager.h"
+
+#include <GLFW/glfw3.h>
+#include <GLFW/glfw3native.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <vma/vk_mem_alloc.h>
+
+#include <vector>
+
+class HiZDescriptors : public PipelineDescriptors
+{
+public:
+    // Un descriptor set por nivel de la pirámide (no por frame): el nivel 0 lee el depth buffer del G-Buffer y el resto, el nivel anterior
+    void createDescriptors(VkDevice device, VkImageView gBufferDepthImageView, const SceneCullingBufferManager &cullingResources);
+    void cleanupDescriptors(VkDevice device) override;
+
+    VkDescriptorSetLayout getDescriptorSetLayout() override;
+    VkDescriptorSet getDescriptorSet(int index) override;
+    std::vector<VkDescriptorSet> getDescriptorSets();
+};
\ No newline at end of file
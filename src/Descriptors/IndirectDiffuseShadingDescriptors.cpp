@@ -19,16 +19,17 @@
 #include <vector>
 
 void IndirectDiffuseShadingDescriptors::createDescriptors(VkDevice device, AccelerationStructure &topLevelAccelerationStructure, uint32_t MAX_FRAMES_IN_FLIGHT,
-                                                          VkBuffer surfelBuffer, VkBuffer surfelGridBuffer, VkBuffer surfelCellBuffer, VkBuffer cameraUniformBuffer,
-                                                          VkImageView positionImageView, VkImageView normalImageView)
+                                                          VkBuffer surfelBuffer, VkBuffer surfelGridBuffer, VkBuffer surfelCellBuffer, std::vector<VkBuffer> cameraUniformBuffers,
+                                                          VkImageView positionImageView, VkImageView normalImageView, std::vector<VkImageView> irradianceVolumeViews,
+                                                          std::vector<VkImageView> directionVolumeViews, VkImageView indirectDiffuseImageView)
 {
     // Descriptor pool
     std::vector<VkDescriptorPoolSize> poolSize = {
-        {VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR, 1},
+        {VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR, MAX_FRAMES_IN_FLIGHT},
         {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 100},
         {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 10},
         {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 100},
-        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 10},
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 10 + 2 * SURFEL_CLIPMAP_LEVELS * MAX_FRAMES_IN_FLIGHT},
         {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1}};
 
     VkDescriptorPoolCreateInfo poolInfo{};
@@ -43,7 +44,7 @@ void IndirectDiffuseShadingDescriptors::createDescriptors(VkDevice device, Accel
     }
 
     // Descriptor set layout
-    std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings(7);
+    std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings(10);
 
     setLayoutBindings[0].binding = 0;
     setLayoutBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
@@ -53,32 +54,47 @@ void IndirectDiffuseShadingDescriptors::createDescriptors(VkDevice device, Accel
     setLayoutBindings[1].binding = 1;
     setLayoutBindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
     setLayoutBindings[1].descriptorCount = 1;
-    setLayoutBindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    setLayoutBindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
 
     setLayoutBindings[2].binding = 2;
     setLayoutBindings[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
     setLayoutBindings[2].descriptorCount = 1;
-    setLayoutBindings[2].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    setLayoutBindings[2].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
 
     setLayoutBindings[3].binding = 3;
     setLayoutBindings[3].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
     setLayoutBindings[3].descriptorCount = 1;
-    setLayoutBindings[3].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    setLayoutBindings[3].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
 
     setLayoutBindings[4].binding = 4;
     setLayoutBindings[4].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
     setLayoutBindings[4].descriptorCount = 1;
-    setLayoutBindings[4].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    setLayoutBindings[4].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
 
     setLayoutBindings[5].binding = 5;
     setLayoutBindings[5].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
     setLayoutBindings[5].descriptorCount = 1;
-    setLayoutBindings[5].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    setLayoutBindings[5].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
 
     setLayoutBindings[6].binding = 6;
     setLayoutBindings[6].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
     setLayoutBindings[6].descriptorCount = 1;
-    setLayoutBindings[6].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    setLayoutBindings[6].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
+
+    setLayoutBindings[7].binding = 7;
+    setLayoutBindings[7].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    setLayoutBindings[7].descriptorCount = SURFEL_CLIPMAP_LEVELS;
+    setLayoutBindings[7].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    setLayoutBindings[8].binding = 8;
+    setLayoutBindings[8].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    setLayoutBindings[8].descriptorCount = SURFEL_CLIPMAP_LEVELS;
+    setLayoutBindings[8].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    setLayoutBindings[9].binding = 9;
+    setLayoutBindings[9].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    setLayoutBindings[9].descriptorCount = 1;
+    setLayoutBindings[9].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
 
     VkDescriptorSetLayoutCreateInfo layoutInfo{};
     layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
@@ -122,9 +138,29 @@ void IndirectDiffuseShadingDescriptors::createDescriptors(VkDevice device, Accel
     samplerCreateInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
     vkCreateSampler(device, &samplerCreateInfo, nullptr, &imageDescriptorSampler);
 
+    // El filtrado trilineal del volumen cruza el borde de la textura igual que las celdas del grid
+    samplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerCreateInfo.maxLod = 0.0f;
+    vkCreateSampler(device, &samplerCreateInfo, nullptr, &volumeSampler);
+
+    std::vector<VkDescriptorImageInfo> irradianceVolumeInfos(SURFEL_CLIPMAP_LEVELS);
+    std::vector<VkDescriptorImageInfo> directionVolumeInfos(SURFEL_CLIPMAP_LEVELS);
+    for (uint32_t level = 0; level < SURFEL_CLIPMAP_LEVELS; level++)
+    {
+        irradianceVolumeInfos[level].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+        irradianceVolumeInfos[level].imageView = irradianceVolumeViews[level];
+        irradianceVolumeInfos[level].sampler = volumeSampler;
+        directionVolumeInfos[level].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+        directionVolumeInfos[level].imageView = directionVolumeViews[level];
+        directionVolumeInfos[level].sampler = volumeSampler;
+    }
+
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
     {
-        std::vector<VkWriteDescriptorSet> descriptorWrites(7);
+        std::vector<VkWriteDescriptorSet> descriptorWrites(10);
 
         // Binding 0 -> Estructura de aceleración con la geometría de la escena
         VkWriteDescriptorSetAccelerationStructureKHR descriptorAccelerationStructureInfo{};
@@ -157,7 +193,7 @@ void IndirectDiffuseShadingDescriptors::createDescriptors(VkDevice device, Accel
         VkDescriptorBufferInfo surfelGridDescInfo{};
         surfelGridDescInfo.buffer = surfelGridBuffer;
         surfelGridDescInfo.offset = 0;
-        surfelGridDescInfo.range = sizeof(unsigned int) * SURFEL_TABLE_SIZE;
+        surfelGridDescInfo.range = sizeof(SurfelGridCell) * SURFEL_TABLE_SIZE;
 
         descriptorWrites[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
         descriptorWrites[2].dstSet = descriptorSets[i];
@@ -171,7 +207,7 @@ void IndirectDiffuseShadingDescriptors::createDescriptors(VkDevice device, Accel
         VkDescriptorBufferInfo surfelCellDescInfo{};
         surfelCellDescInfo.buffer = surfelCellBuffer;
         surfelCellDescInfo.offset = 0;
-        surfelCellDescInfo.range = sizeof(unsigned int) * SURFEL_TABLE_SIZE * SURFEL_CELL_LIMIT;
+        surfelCellDescInfo.range = sizeof(unsigned int) * SURFEL_CELL_BUFFER_SIZE;
 
         descriptorWrites[3].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
         descriptorWrites[3].dstSet = descriptorSets[i];
@@ -211,7 +247,7 @@ void IndirectDiffuseShadingDescriptors::createDescriptors(VkDevice device, Accel
 
         // Binding 6 -> Buffer para leer los datos de la cámara
         VkDescriptorBufferInfo cameraBufferInfo{};
-        cameraBufferInfo.buffer = cameraUniformBuffer;
+        cameraBufferInfo.buffer = cameraUniformBuffers[i];
         cameraBufferInfo.offset = 0;
         cameraBufferInfo.range = sizeof(CameraUniformBuffer);
 
@@ -223,6 +259,37 @@ void IndirectDiffuseShadingDescriptors::createDescriptors(VkDevice device, Accel
         descriptorWrites[6].descriptorCount = 1;
         descriptorWrites[6].pBufferInfo = &cameraBufferInfo;
 
+        // Binding 7 -> Irradiancia media y ocupación de cada celda, una imagen por nivel del clipmap
+        descriptorWrites[7].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[7].dstSet = descriptorSets[i];
+        descriptorWrites[7].dstBinding = 7;
+        descriptorWrites[7].dstArrayElement = 0;
+        descriptorWrites[7].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        descriptorWrites[7].descriptorCount = SURFEL_CLIPMAP_LEVELS;
+        descriptorWrites[7].pImageInfo = irradianceVolumeInfos.data();
+
+        // Binding 8 -> Variación de la irradiancia de cada celda con la normal
+        descriptorWrites[8].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[8].dstSet = descriptorSets[i];
+        descriptorWrites[8].dstBinding = 8;
+        descriptorWrites[8].dstArrayElement = 0;
+        descriptorWrites[8].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        descriptorWrites[8].descriptorCount = SURFEL_CLIPMAP_LEVELS;
+        descriptorWrites[8].pImageInfo = directionVolumeInfos.data();
+
+        // Binding 9 -> Imagen de salida del gather por teselas, que se escribe desde el compute shader
+        VkDescriptorImageInfo indirectDiffuseImageDescriptor{};
+        indirectDiffuseImageDescriptor.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+        indirectDiffuseImageDescriptor.imageView = indirectDiffuseImageView;
+
+        descriptorWrites[9].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[9].dstSet = descriptorSets[i];
+        descriptorWrites[9].dstBinding = 9;
+        descriptorWrites[9].dstArrayElement = 0;
+        descriptorWrites[9].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        descriptorWrites[9].descriptorCount = 1;
+        descriptorWrites[9].pImageInfo = &indirectDiffuseImageDescriptor;
+
         // Actualización del descriptor
         vkUpdateDescriptorSets(device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
     }
@@ -233,6 +300,7 @@ void IndirectDiffuseShadingDescriptors::cleanupDescriptors(VkDevice device)
     vkDestroyDescriptorPool(device, descriptorPool, nullptr);
     vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
     vkDestroySampler(device, imageDescriptorSampler, nullptr);
+    vkDestroySampler(device, volumeSampler, nullptr);
 }
 
 VkDescriptorSetLayout IndirectDiffuseShadingDescriptors::getDescriptorSetLayout()
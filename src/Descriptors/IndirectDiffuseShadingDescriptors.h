@@ -21,11 +21,14 @@ class IndirectDiffuseShadingDescriptors : public PipelineDescriptors
 {
 private:
     VkSampler imageDescriptorSampler;
+    // Sampler del volumen de irradiancia, que repite la textura para seguir el direccionamiento toroidal del grid
+    VkSampler volumeSampler;
 
 public:
     void createDescriptors(VkDevice device, AccelerationStructure &topLevelAccelerationStructure, uint32_t MAX_FRAMES_IN_FLIGHT,
-                           VkBuffer surfelBuffer, VkBuffer surfelGridBuffer, VkBuffer surfelCellBuffer, VkBuffer cameraUniformBuffer,
-                           VkImageView positionImageView, VkImageView normalImageView);
+                           VkBuffer surfelBuffer, VkBuffer surfelGridBuffer, VkBuffer surfelCellBuffer, std::vector<VkBuffer> cameraUniformBuffers,
+                           VkImageView positionImageView, VkImageView normalImageView, std::vector<VkImageView> irradianceVolumeViews,
+                           std::vector<VkImageView> directionVolumeViews, VkImageView indirectDiffuseImageView);
     void cleanupDescriptors(VkDevice device) override;
 
     VkDescriptorSetLayout getDescriptorSetLayout() override;
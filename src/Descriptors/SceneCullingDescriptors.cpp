@@ -0,0 +1,186 @@
+#include "SceneCullingDescriptors.h"
+
+#include "Scene/Models/SceneDrawList.h"
+#include "Buffers/SceneCullingBufferManager.h"
+
+#define VK_USE_PLATFORM_WIN32_KHR
+#define GLFW_INCLUDE_VULKAN
+#define GLFW_EXPOSE_NATIVE_WIN32
+#define GLM_FORCE_RADIANS
+
+#include <GLFW/glfw3.h>
+#include <GLFW/glfw3native.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <vma/vk_mem_alloc.h>
+
+#include <vector>
+
+void SceneCullingDescriptors::createDescriptors(VkDevice device, uint32_t MAX_FRAMES_IN_FLIGHT, const SceneDrawList &sceneDrawList, const SceneCullingBufferManager &cullingResources)
+{
+    // Descriptor pool
+    std::vector<VkDescriptorPoolSize> poolSize = {
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, MAX_FRAMES_IN_FLIGHT},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4 * MAX_FRAMES_IN_FLIGHT},
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MAX_FRAMES_IN_FLIGHT}};
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSize.size());
+    poolInfo.pPoolSizes = poolSize.data();
+    poolInfo.maxSets = MAX_FRAMES_IN_FLIGHT;
+
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create descriptor pool!");
+    }
+
+    // Descriptor set layout
+    std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings(6);
+
+    for (uint32_t i = 0; i < setLayoutBindings.size(); i++)
+    {
+        setLayoutBindings[i].binding = i;
+        setLayoutBindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        setLayoutBindings[i].descriptorCount = 1;
+        setLayoutBindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    setLayoutBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    setLayoutBindings[5].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
+    layoutInfo.pBindings = setLayoutBindings.data();
+
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create descriptor set layout!");
+    }
+
+    // Descriptor sets
+    std::vector<VkDescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT, descriptorSetLayout);
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = descriptorPool;
+    allocInfo.pSetLayouts = layouts.data();
+    allocInfo.descriptorSetCount = MAX_FRAMES_IN_FLIGHT;
+
+    descriptorSets.resize(MAX_FRAMES_IN_FLIGHT);
+
+    if (vkAllocateDescriptorSets(device, &allocInfo, descriptorSets.data()) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create descriptor set!");
+    }
+
+    std::vector<VkBuffer> uniformCullingBuffers = cullingResources.getUniformCullingBuffers();
+
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        std::vector<VkWriteDescriptorSet> descriptorWrites(6);
+
+        // Binding 0 -> Variables uniformes del culling (cámaras y planos del frustum)
+        VkDescriptorBufferInfo cullingUniformDescInfo{};
+        cullingUniformDescInfo.buffer = uniformCullingBuffers[i];
+        cullingUniformDescInfo.offset = 0;
+        cullingUniformDescInfo.range = sizeof(SceneCullingUniformBuffer);
+
+        descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[0].dstSet = descriptorSets[i];
+        descriptorWrites[0].dstBinding = 0;
+        descriptorWrites[0].dstArrayElement = 0;
+        descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        descriptorWrites[0].descriptorCount = 1;
+        descriptorWrites[0].pBufferInfo = &cullingUniformDescInfo;
+
+        // Binding 1 -> Comandos indirectos de todos los objetos de la escena
+        VkDescriptorBufferInfo sourceCommandsDescInfo{};
+        sourceCommandsDescInfo.buffer = sceneDrawList.getIndirectCommandBuffer();
+        sourceCommandsDescInfo.offset = 0;
+        sourceCommandsDescInfo.range = sceneDrawList.getIndirectCommandBufferSize();
+
+        descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[1].dstSet = descriptorSets[i];
+        descriptorWrites[1].dstBinding = 1;
+        descriptorWrites[1].dstArrayElement = 0;
+        descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrites[1].descriptorCount = 1;
+        descriptorWrites[1].pBufferInfo = &sourceCommandsDescInfo;
+
+        // Binding 2 -> Datos de dibujado, con la caja envolvente de cada objeto
+        VkDescriptorBufferInfo drawDataDescInfo{};
+        drawDataDescInfo.buffer = sceneDrawList.getDrawDataBuffer();
+        drawDataDescInfo.offset = 0;
+        drawDataDescInfo.range = sceneDrawList.getDrawDataBufferSize();
+
+        descriptorWrites[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[2].dstSet = descriptorSets[i];
+        descriptorWrites[2].dstBinding = 2;
+        descriptorWrites[2].dstArrayElement = 0;
+        descriptorWrites[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrites[2].descriptorCount = 1;
+        descriptorWrites[2].pBufferInfo = &drawDataDescInfo;
+
+        // Binding 3 -> Lista compactada de comandos visibles
+        VkDescriptorBufferInfo culledCommandsDescInfo{};
+        culledCommandsDescInfo.buffer = cullingResources.getCulledCommandBuffer();
+        culledCommandsDescInfo.offset = 0;
+        culledCommandsDescInfo.range = VK_WHOLE_SIZE;
+
+        descriptorWrites[3].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[3].dstSet = descriptorSets[i];
+        descriptorWrites[3].dstBinding = 3;
+        descriptorWrites[3].dstArrayElement = 0;
+        descriptorWrites[3].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrites[3].descriptorCount = 1;
+        descriptorWrites[3].pBufferInfo = &culledCommandsDescInfo;
+
+        // Binding 4 -> Contadores del culling. El primero es el número de comandos de la lista compactada
+        VkDescriptorBufferInfo cullingStatsDescInfo{};
+        cullingStatsDescInfo.buffer = cullingResources.getCullingStatsBuffer();
+        cullingStatsDescInfo.offset = 0;
+        cullingStatsDescInfo.range = sizeof(SceneCullingStats);
+
+        descriptorWrites[4].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[4].dstSet = descriptorSets[i];
+        descriptorWrites[4].dstBinding = 4;
+        descriptorWrites[4].dstArrayElement = 0;
+        descriptorWrites[4].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrites[4].descriptorCount = 1;
+        descriptorWrites[4].pBufferInfo = &cullingStatsDescInfo;
+
+        // Binding 5 -> Pirámide de profundidad del frame anterior, con todos sus niveles
+        VkDescriptorImageInfo depthPyramidDescriptor{};
+        depthPyramidDescriptor.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+        depthPyramidDescriptor.imageView = cullingResources.getHiZImageView();
+        depthPyramidDescriptor.sampler = cullingResources.getHiZSampler();
+
+        descriptorWrites[5].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[5].dstSet = descriptorSets[i];
+        descriptorWrites[5].dstBinding = 5;
+        descriptorWrites[5].dstArrayElement = 0;
+        descriptorWrites[5].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        descriptorWrites[5].descriptorCount = 1;
+        descriptorWrites[5].pImageInfo = &depthPyramidDescriptor;
+
+        // Actualización del descriptor
+        vkUpdateDescriptorSets(device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+    }
+}
+
+void SceneCullingDescriptors::cleanupDescriptors(VkDevice device)
+{
+    vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+}
+
+VkDescriptorSetLayout SceneCullingDescriptors::getDescriptorSetLayout()
+{
+    return descriptorSetLayout;
+}
+
+VkDescriptorSet SceneCullingDescriptors::getDescriptorSet(int index)
+{
+    return descriptorSets[index];
+}
\ No newline at end of file
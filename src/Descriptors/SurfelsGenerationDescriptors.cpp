@@ -18,8 +18,8 @@
 #include <vector>
 
 void SurfelsGenerationDescriptors::createDescriptors(VkDevice device, uint32_t MAX_FRAMES_IN_FLIGHT, VkBuffer surfelBuffer, VkBuffer surfelStatsBuffer, VkBuffer surfelGridBuffer,
-                                                     VkBuffer surfelCellBuffer, VkBuffer cameraUniformBuffer, VkImageView normalImageView, VkImageView positionImageView,
-                                                     VkImageView albedoImageView, ImageCreator blueNoiseImage)
+                                                     VkBuffer surfelCellBuffer, std::vector<VkBuffer> cameraUniformBuffers, VkImageView normalImageView, VkImageView positionImageView,
+                                                     VkImageView albedoImageView, ImageCreator blueNoiseImage, VkBuffer surfelFreeListBuffer)
 {
     // Descriptor pool
     std::vector<VkDescriptorPoolSize> poolSize = {
@@ -42,7 +42,7 @@ void SurfelsGenerationDescriptors::createDescriptors(VkDevice device, uint32_t M
     }
 
     // Descriptor set layout
-    std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings(9);
+    std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings(10);
 
     setLayoutBindings[0].binding = 0;
     setLayoutBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
@@ -89,6 +89,11 @@ void SurfelsGenerationDescriptors::createDescriptors(VkDevice device, uint32_t M
     setLayoutBindings[8].descriptorCount = 1;
     setLayoutBindings[8].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
 
+    setLayoutBindings[9].binding = 9;
+    setLayoutBindings[9].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    setLayoutBindings[9].descriptorCount = 1;
+    setLayoutBindings[9].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
     VkDescriptorSetLayoutCreateInfo layoutInfo{};
     layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
     layoutInfo.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
@@ -133,7 +138,7 @@ void SurfelsGenerationDescriptors::createDescriptors(VkDevice device, uint32_t M
 
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
     {
-        std::vector<VkWriteDescriptorSet> descriptorWrites(9);
+        std::vector<VkWriteDescriptorSet> descriptorWrites(10);
 
         // Binding 0 -> Buffer para guardar los surfels una vez se generen en el shader
         VkDescriptorBufferInfo surfelDescInfo{};
@@ -167,7 +172,7 @@ void SurfelsGenerationDescriptors::createDescriptors(VkDevice device, uint32_t M
         VkDescriptorBufferInfo surfelStatsDescInfo{};
         surfelStatsDescInfo.buffer = surfelStatsBuffer;
         surfelStatsDescInfo.offset = 0;
-        surfelStatsDescInfo.range = sizeof(unsigned int) * 8;
+        surfelStatsDescInfo.range = sizeof(unsigned int) * SURFEL_STATS_SIZE;
 
         descriptorWrites[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
         descriptorWrites[2].dstSet = descriptorSets[i];
@@ -195,7 +200,7 @@ void SurfelsGenerationDescriptors::createDescriptors(VkDevice device, uint32_t M
         VkDescriptorBufferInfo surfelGridDescInfo{};
         surfelGridDescInfo.buffer = surfelGridBuffer;
         surfelGridDescInfo.offset = 0;
-        surfelGridDescInfo.range = sizeof(unsigned int) * SURFEL_TABLE_SIZE;
+        surfelGridDescInfo.range = sizeof(SurfelGridCell) * SURFEL_TABLE_SIZE;
 
         descriptorWrites[4].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
         descriptorWrites[4].dstSet = descriptorSets[i];
@@ -209,7 +214,7 @@ void SurfelsGenerationDescriptors::createDescriptors(VkDevice device, uint32_t M
         VkDescriptorBufferInfo surfelCellDescInfo{};
         surfelCellDescInfo.buffer = surfelCellBuffer;
         surfelCellDescInfo.offset = 0;
-        surfelCellDescInfo.range = sizeof(unsigned int) * SURFEL_TABLE_SIZE * SURFEL_CELL_LIMIT;
+        surfelCellDescInfo.range = sizeof(unsigned int) * SURFEL_CELL_BUFFER_SIZE;
 
         descriptorWrites[5].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
         descriptorWrites[5].dstSet = descriptorSets[i];
@@ -221,7 +226,7 @@ void SurfelsGenerationDescriptors::createDescriptors(VkDevice device, uint32_t M
 
         // Binding 6 -> Buffer para leer los datos de la cámara
         VkDescriptorBufferInfo cameraBufferInfo{};
-        cameraBufferInfo.buffer = cameraUniformBuffer;
+        cameraBufferInfo.buffer = cameraUniformBuffers[i];
         cameraBufferInfo.offset = 0;
         cameraBufferInfo.range = sizeof(CameraUniformBuffer);
 
@@ -261,6 +266,20 @@ void SurfelsGenerationDescriptors::createDescriptors(VkDevice device, uint32_t M
         descriptorWrites[8].descriptorCount = 1;
         descriptorWrites[8].pImageInfo = &blueNoiseImageDescriptor;
 
+        // Binding 9 -> Pila de surfels reciclados, de la que se toman los índices de los nuevos surfels
+        VkDescriptorBufferInfo surfelFreeListDescInfo{};
+        surfelFreeListDescInfo.buffer = surfelFreeListBuffer;
+        surfelFreeListDescInfo.offset = 0;
+        surfelFreeListDescInfo.range = sizeof(unsigned int) * SURFEL_CAPACITY;
+
+        descriptorWrites[9].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[9].dstSet = descriptorSets[i];
+        descriptorWrites[9].dstBinding = 9;
+        descriptorWrites[9].dstArrayElement = 0;
+        descriptorWrites[9].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrites[9].descriptorCount = 1;
+        descriptorWrites[9].pBufferInfo = &surfelFreeListDescInfo;
+
         // Actualización del descriptor
         vkUpdateDescriptorSets(device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
     }
@@ -23,8 +23,8 @@ private:
 
 public:
     void createDescriptors(VkDevice device, uint32_t MAX_FRAMES_IN_FLIGHT, VkBuffer surfelBuffer, VkBuffer surfelStatsBuffer, VkBuffer surfelGridBuffer,
-                           VkBuffer surfelCellBuffer, VkBuffer cameraUniformBuffer, VkImageView normalImageView, VkImageView positionImageView,
-                           VkImageView albedoImageView, ImageCreator blueNoiseImage);
+                           VkBuffer surfelCellBuffer, std::vector<VkBuffer> cameraUniformBuffers, VkImageView normalImageView, VkImageView positionImageView,
+                           VkImageView albedoImageView, ImageCreator blueNoiseImage, VkBuffer surfelFreeListBuffer);
     void cleanupDescriptors(VkDevice device) override;
 
     VkDescriptorSetLayout getDescriptorSetLayout() override;
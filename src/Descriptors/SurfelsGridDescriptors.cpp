@@ -0,0 +1,199 @@
+#include "SurfelsGridDescriptors.h"
+
+#include "Buffers/SurfelsBufferManager.h"
+
+#define VK_USE_PLATFORM_WIN32_KHR
+#define GLFW_INCLUDE_VULKAN
+#define GLFW_EXPOSE_NATIVE_WIN32
+#define GLM_FORCE_RADIANS
+
+#include <GLFW/glfw3.h>
+#include <GLFW/glfw3native.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <vma/vk_mem_alloc.h>
+
+#include <vector>
+
+void SurfelsGridDescriptors::createDescriptors(VkDevice device, uint32_t MAX_FRAMES_IN_FLIGHT, VkBuffer surfelBuffer, VkBuffer surfelStatsBuffer, VkBuffer surfelGridBuffer,
+                                               VkBuffer surfelCellBuffer, VkBuffer surfelFreeListBuffer, std::vector<VkBuffer> cameraUniformBuffers,
+                                               VkBuffer surfelRayQueueBuffer)
+{
+    // Descriptor pool
+    std::vector<VkDescriptorPoolSize> poolSize = {
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 6 * MAX_FRAMES_IN_FLIGHT},
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, MAX_FRAMES_IN_FLIGHT}};
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSize.size());
+    poolInfo.pPoolSizes = poolSize.data();
+    poolInfo.maxSets = MAX_FRAMES_IN_FLIGHT;
+
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create descriptor pool!");
+    }
+
+    // Descriptor set layout
+    // El mismo layout lo comparten el ciclo de vida de los surfels, las tres pasadas de construcción del grid (conteo, offsets y distribución)
+    // y las tres de la planificación de rayos (prioridades, reparto del presupuesto y cola)
+    std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings(7);
+
+    for (uint32_t i = 0; i < setLayoutBindings.size(); i++)
+    {
+        setLayoutBindings[i].binding = i;
+        setLayoutBindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        setLayoutBindings[i].descriptorCount = 1;
+        setLayoutBindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    setLayoutBindings[5].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
+    layoutInfo.pBindings = setLayoutBindings.data();
+
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create descriptor set layout!");
+    }
+
+    // Descriptor sets
+    std::vector<VkDescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT, descriptorSetLayout);
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = descriptorPool;
+    allocInfo.pSetLayouts = layouts.data();
+    allocInfo.descriptorSetCount = MAX_FRAMES_IN_FLIGHT;
+
+    descriptorSets.resize(MAX_FRAMES_IN_FLIGHT);
+
+    if (vkAllocateDescriptorSets(device, &allocInfo, descriptorSets.data()) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create descriptor set!");
+    }
+
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        std::vector<VkWriteDescriptorSet> descriptorWrites(7);
+
+        // Binding 0 -> Buffer con la lista global de surfels
+        VkDescriptorBufferInfo surfelDescInfo{};
+        surfelDescInfo.buffer = surfelBuffer;
+        surfelDescInfo.offset = 0;
+        surfelDescInfo.range = sizeof(Surfel) * SURFEL_CAPACITY;
+
+        descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[0].dstSet = descriptorSets[i];
+        descriptorWrites[0].dstBinding = 0;
+        descriptorWrites[0].dstArrayElement = 0;
+        descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrites[0].descriptorCount = 1;
+        descriptorWrites[0].pBufferInfo = &surfelDescInfo;
+
+        // Binding 1 -> Buffer con el estado de los surfels (número de surfels y reserva de la lista compactada)
+        VkDescriptorBufferInfo surfelStatsDescInfo{};
+        surfelStatsDescInfo.buffer = surfelStatsBuffer;
+        surfelStatsDescInfo.offset = 0;
+        surfelStatsDescInfo.range = sizeof(unsigned int) * SURFEL_STATS_SIZE;
+
+        descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[1].dstSet = descriptorSets[i];
+        descriptorWrites[1].dstBinding = 1;
+        descriptorWrites[1].dstArrayElement = 0;
+        descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrites[1].descriptorCount = 1;
+        descriptorWrites[1].pBufferInfo = &surfelStatsDescInfo;
+
+        // Binding 2 -> Buffer con el número de surfels y el offset de cada celda
+        VkDescriptorBufferInfo surfelGridDescInfo{};
+        surfelGridDescInfo.buffer = surfelGridBuffer;
+        surfelGridDescInfo.offset = 0;
+        surfelGridDescInfo.range = sizeof(SurfelGridCell) * SURFEL_TABLE_SIZE;
+
+        descriptorWrites[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[2].dstSet = descriptorSets[i];
+        descriptorWrites[2].dstBinding = 2;
+        descriptorWrites[2].dstArrayElement = 0;
+        descriptorWrites[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrites[2].descriptorCount = 1;
+        descriptorWrites[2].pBufferInfo = &surfelGridDescInfo;
+
+        // Binding 3 -> Buffer con las listas compactadas de surfels de cada celda
+        VkDescriptorBufferInfo surfelCellDescInfo{};
+        surfelCellDescInfo.buffer = surfelCellBuffer;
+        surfelCellDescInfo.offset = 0;
+        surfelCellDescInfo.range = sizeof(unsigned int) * SURFEL_CELL_BUFFER_SIZE;
+
+        descriptorWrites[3].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[3].dstSet = descriptorSets[i];
+        descriptorWrites[3].dstBinding = 3;
+        descriptorWrites[3].dstArrayElement = 0;
+        descriptorWrites[3].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrites[3].descriptorCount = 1;
+        descriptorWrites[3].pBufferInfo = &surfelCellDescInfo;
+
+        // Binding 4 -> Pila con los índices de los surfels reciclados, que la generación reutiliza
+        VkDescriptorBufferInfo surfelFreeListDescInfo{};
+        surfelFreeListDescInfo.buffer = surfelFreeListBuffer;
+        surfelFreeListDescInfo.offset = 0;
+        surfelFreeListDescInfo.range = sizeof(unsigned int) * SURFEL_CAPACITY;
+
+        descriptorWrites[4].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[4].dstSet = descriptorSets[i];
+        descriptorWrites[4].dstBinding = 4;
+        descriptorWrites[4].dstArrayElement = 0;
+        descriptorWrites[4].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrites[4].descriptorCount = 1;
+        descriptorWrites[4].pBufferInfo = &surfelFreeListDescInfo;
+
+        // Binding 5 -> Variables uniformes de la cámara, con el número de frame
+        VkDescriptorBufferInfo cameraDescInfo{};
+        cameraDescInfo.buffer = cameraUniformBuffers[i];
+        cameraDescInfo.offset = 0;
+        cameraDescInfo.range = sizeof(CameraUniformBuffer);
+
+        descriptorWrites[5].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[5].dstSet = descriptorSets[i];
+        descriptorWrites[5].dstBinding = 5;
+        descriptorWrites[5].dstArrayElement = 0;
+        descriptorWrites[5].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        descriptorWrites[5].descriptorCount = 1;
+        descriptorWrites[5].pBufferInfo = &cameraDescInfo;
+
+        // Binding 6 -> Cola de surfels que lanzan rayos en el frame, con su cabecera y el histograma de prioridades
+        VkDescriptorBufferInfo rayQueueDescInfo{};
+        rayQueueDescInfo.buffer = surfelRayQueueBuffer;
+        rayQueueDescInfo.offset = 0;
+        rayQueueDescInfo.range = VK_WHOLE_SIZE;
+
+        descriptorWrites[6].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[6].dstSet = descriptorSets[i];
+        descriptorWrites[6].dstBinding = 6;
+        descriptorWrites[6].dstArrayElement = 0;
+        descriptorWrites[6].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrites[6].descriptorCount = 1;
+        descriptorWrites[6].pBufferInfo = &rayQueueDescInfo;
+
+        // Actualización del descriptor
+        vkUpdateDescriptorSets(device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+    }
+}
+
+void SurfelsGridDescriptors::cleanupDescriptors(VkDevice device)
+{
+    vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+}
+
+VkDescriptorSetLayout SurfelsGridDescriptors::getDescriptorSetLayout()
+{
+    return descriptorSetLayout;
+}
+
+VkDescriptorSet SurfelsGridDescriptors::getDescriptorSet(int index)
+{
+    return descriptorSets[index];
+}
\ No newline at end of file
@@ -19,14 +19,15 @@
 #include <vector>
 
 void SurfelsRadianceCalculationDescriptors::createDescriptors(VkDevice device, uint32_t MAX_FRAMES_IN_FLIGHT, VkBuffer surfelBuffer, std::vector<VkBuffer> lightsDataBuffer,
-                                                              AccelerationStructure &topLevelAccelerationStructure, std::vector<VkBuffer> indexBufferList, std::vector<VkBuffer> vertexBufferList,
-                                                              std::vector<size_t> indexBufferSizeList, std::vector<size_t> vertexBufferSizeList, uint32_t numTextures, uint32_t numMaterials,
+                                                              AccelerationStructure &topLevelAccelerationStructure, const SceneGeometryBuffer &sceneGeometry,
+                                                              uint32_t numTextures, uint32_t numMaterials,
                                                               std::vector<ImageCreator> &diffuseImageCreators, std::vector<ImageCreator> &alphaImageCreators,
-                                                              std::vector<ImageCreator> &specularImageCreators, ImageCreator raysNoiseImage)
+                                                              std::vector<ImageCreator> &specularImageCreators, ImageCreator raysNoiseImage, VkBuffer surfelRayQueueBuffer,
+                                                              VkBuffer surfelGridBuffer, VkBuffer surfelCellBuffer, std::vector<VkBuffer> cameraUniformBuffers)
 {
     // Descriptor pool
     std::vector<VkDescriptorPoolSize> poolSize = {
-        {VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR, 1},
+        {VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR, MAX_FRAMES_IN_FLIGHT},
         {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 100},
         {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 10},
         {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 100},
@@ -45,7 +46,7 @@ void SurfelsRadianceCalculationDescriptors::createDescriptors(VkDevice device, u
     }
 
     // Descriptor set layout
-    std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings(7);
+    std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings(12);
 
     setLayoutBindings[0].binding = 0;
     setLayoutBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
@@ -64,12 +65,12 @@ void SurfelsRadianceCalculationDescriptors::createDescriptors(VkDevice device, u
 
     setLayoutBindings[3].binding = 3;
     setLayoutBindings[3].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-    setLayoutBindings[3].descriptorCount = indexBufferList.size();
+    setLayoutBindings[3].descriptorCount = 1;
     setLayoutBindings[3].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
 
     setLayoutBindings[4].binding = 4;
     setLayoutBindings[4].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-    setLayoutBindings[4].descriptorCount = vertexBufferList.size();
+    setLayoutBindings[4].descriptorCount = 1;
     setLayoutBindings[4].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
 
     setLayoutBindings[5].binding = 5;
@@ -82,6 +83,31 @@ void SurfelsRadianceCalculationDescriptors::createDescriptors(VkDevice device, u
     setLayoutBindings[6].descriptorCount = 1;
     setLayoutBindings[6].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
 
+    setLayoutBindings[7].binding = 7;
+    setLayoutBindings[7].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    setLayoutBindings[7].descriptorCount = 1;
+    setLayoutBindings[7].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    setLayoutBindings[8].binding = 8;
+    setLayoutBindings[8].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    setLayoutBindings[8].descriptorCount = 1;
+    setLayoutBindings[8].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    setLayoutBindings[9].binding = 9;
+    setLayoutBindings[9].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    setLayoutBindings[9].descriptorCount = 1;
+    setLayoutBindings[9].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    setLayoutBindings[10].binding = 10;
+    setLayoutBindings[10].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    setLayoutBindings[10].descriptorCount = 1;
+    setLayoutBindings[10].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    setLayoutBindings[11].binding = 11;
+    setLayoutBindings[11].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    setLayoutBindings[11].descriptorCount = 1;
+    setLayoutBindings[11].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
     VkDescriptorSetLayoutCreateInfo layoutInfo{};
     layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
     layoutInfo.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
@@ -110,7 +136,7 @@ void SurfelsRadianceCalculationDescriptors::createDescriptors(VkDevice device, u
 
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
     {
-        std::vector<VkWriteDescriptorSet> descriptorWrites(7);
+        std::vector<VkWriteDescriptorSet> descriptorWrites(12);
 
         // Binding 0 -> Estructura de aceleración con la geometría de la escena
         VkWriteDescriptorSetAccelerationStructureKHR descriptorAccelerationStructureInfo{};
@@ -152,39 +178,33 @@ void SurfelsRadianceCalculationDescriptors::createDescriptors(VkDevice device, u
         descriptorWrites[2].descriptorCount = 1;
         descriptorWrites[2].pBufferInfo = &surfelDescInfo;
 
-        // Binding 3 -> Lista de buffers de índices
-        // Crear la lista con la información de cada buffer
-        std::vector<VkDescriptorBufferInfo> indexBufferInfoList(indexBufferList.size());
-        for(int i = 0; i < indexBufferList.size(); i++) {
-            indexBufferInfoList[i].buffer = indexBufferList[i];
-            indexBufferInfoList[i].offset = 0;
-            indexBufferInfoList[i].range = indexBufferSizeList[i];
-        }
+        // Binding 3 -> Buffer de índices de toda la escena
+        VkDescriptorBufferInfo indexBufferInfo{};
+        indexBufferInfo.buffer = sceneGeometry.getIndexBuffer();
+        indexBufferInfo.offset = 0;
+        indexBufferInfo.range = sceneGeometry.getIndexBufferSize();
 
         descriptorWrites[3].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
         descriptorWrites[3].dstSet = descriptorSets[i];
         descriptorWrites[3].dstBinding = 3;
         descriptorWrites[3].dstArrayElement = 0;
         descriptorWrites[3].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        descriptorWrites[3].descriptorCount = indexBufferInfoList.size();
-        descriptorWrites[3].pBufferInfo = indexBufferInfoList.data();
-
-        // Binding 4 -> Lista de buffers de vértices
-        // Crear la lista con la información de cada buffer
-        std::vector<VkDescriptorBufferInfo> vertexBufferInfoList(vertexBufferList.size());
-        for(int i = 0; i < vertexBufferList.size(); i++) {
-            vertexBufferInfoList[i].buffer = vertexBufferList[i];
-            vertexBufferInfoList[i].offset = 0;
-            vertexBufferInfoList[i].range = vertexBufferSizeList[i];
-        }
+        descriptorWrites[3].descriptorCount = 1;
+        descriptorWrites[3].pBufferInfo = &indexBufferInfo;
+
+        // Binding 4 -> Buffer de vértices de toda la escena
+        VkDescriptorBufferInfo vertexBufferInfo{};
+        vertexBufferInfo.buffer = sceneGeometry.getVertexBuffer();
+        vertexBufferInfo.offset = 0;
+        vertexBufferInfo.range = sceneGeometry.getVertexBufferSize();
 
         descriptorWrites[4].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
         descriptorWrites[4].dstSet = descriptorSets[i];
         descriptorWrites[4].dstBinding = 4;
         descriptorWrites[4].dstArrayElement = 0;
         descriptorWrites[4].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        descriptorWrites[4].descriptorCount = vertexBufferInfoList.size();
-        descriptorWrites[4].pBufferInfo = vertexBufferInfoList.data();
+        descriptorWrites[4].descriptorCount = 1;
+        descriptorWrites[4].pBufferInfo = &vertexBufferInfo;
 
         // Binding 5 -> Texturas de la geometría para obtener la información de color con el choque
         std::vector<VkDescriptorImageInfo> imageInfos(numTextures * numMaterials);
@@ -229,6 +249,76 @@ void SurfelsRadianceCalculationDescriptors::createDescriptors(VkDevice device, u
         descriptorWrites[6].descriptorCount = 1;
         descriptorWrites[6].pImageInfo = &noiseImageDescriptor;
 
+        // Binding 7 -> Rango de cada objeto dentro de los buffers de la escena, indexado por la instancia de la TLAS
+        VkDescriptorBufferInfo submeshBufferInfo{};
+        submeshBufferInfo.buffer = sceneGeometry.getSubmeshBuffer();
+        submeshBufferInfo.offset = 0;
+        submeshBufferInfo.range = sceneGeometry.getSubmeshBufferSize();
+
+        descriptorWrites[7].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[7].dstSet = descriptorSets[i];
+        descriptorWrites[7].dstBinding = 7;
+        descriptorWrites[7].dstArrayElement = 0;
+        descriptorWrites[7].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrites[7].descriptorCount = 1;
+        descriptorWrites[7].pBufferInfo = &submeshBufferInfo;
+
+        // Binding 8 -> Cola con los surfels a los que la planificación ha asignado rayos en este frame
+        VkDescriptorBufferInfo rayQueueBufferInfo{};
+        rayQueueBufferInfo.buffer = surfelRayQueueBuffer;
+        rayQueueBufferInfo.offset = 0;
+        rayQueueBufferInfo.range = VK_WHOLE_SIZE;
+
+        descriptorWrites[8].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[8].dstSet = descriptorSets[i];
+        descriptorWrites[8].dstBinding = 8;
+        descriptorWrites[8].dstArrayElement = 0;
+        descriptorWrites[8].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrites[8].descriptorCount = 1;
+        descriptorWrites[8].pBufferInfo = &rayQueueBufferInfo;
+
+        // Binding 9 -> Grid de surfels, para leer la radiancia de los surfels cercanos a cada punto de choque
+        VkDescriptorBufferInfo surfelGridDescInfo{};
+        surfelGridDescInfo.buffer = surfelGridBuffer;
+        surfelGridDescInfo.offset = 0;
+        surfelGridDescInfo.range = sizeof(SurfelGridCell) * SURFEL_TABLE_SIZE;
+
+        descriptorWrites[9].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[9].dstSet = descriptorSets[i];
+        descriptorWrites[9].dstBinding = 9;
+        descriptorWrites[9].dstArrayElement = 0;
+        descriptorWrites[9].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrites[9].descriptorCount = 1;
+        descriptorWrites[9].pBufferInfo = &surfelGridDescInfo;
+
+        // Binding 10 -> Lista compactada con los surfels de cada celda
+        VkDescriptorBufferInfo surfelCellDescInfo{};
+        surfelCellDescInfo.buffer = surfelCellBuffer;
+        surfelCellDescInfo.offset = 0;
+        surfelCellDescInfo.range = sizeof(unsigned int) * SURFEL_CELL_BUFFER_SIZE;
+
+        descriptorWrites[10].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[10].dstSet = descriptorSets[i];
+        descriptorWrites[10].dstBinding = 10;
+        descriptorWrites[10].dstArrayElement = 0;
+        descriptorWrites[10].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrites[10].descriptorCount = 1;
+        descriptorWrites[10].pBufferInfo = &surfelCellDescInfo;
+
+        // Binding 11 -> Variables uniformes de la cámara, en cuya posición se centra el clipmap del grid
+        VkDescriptorBufferInfo cameraDescInfo{};
+        cameraDescInfo.buffer = cameraUniformBuffers[i];
+        cameraDescInfo.offset = 0;
+        cameraDescInfo.range = sizeof(CameraUniformBuffer);
+
+        descriptorWrites[11].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[11].dstSet = descriptorSets[i];
+        descriptorWrites[11].dstBinding = 11;
+        descriptorWrites[11].dstArrayElement = 0;
+        descriptorWrites[11].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        descriptorWrites[11].descriptorCount = 1;
+        descriptorWrites[11].pBufferInfo = &cameraDescInfo;
+
         // Actualización del descriptor
         vkUpdateDescriptorSets(device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
     }
@@ -7,6 +7,7 @@
 
 #include "Images/ImageCreator.h"
 #include "Raytracing/RaytracingManager.h"
+#include "Scene/Models/SceneGeometryBuffer.h"
 #include "PipelineDescriptors.h"
 
 #include <GLFW/glfw3.h>
@@ -21,10 +22,11 @@ class SurfelsRadianceCalculationDescriptors : public PipelineDescriptors
 {
 public:
     void createDescriptors(VkDevice device, uint32_t MAX_FRAMES_IN_FLIGHT, VkBuffer surfelBuffer, std::vector<VkBuffer> lightsDataBuffer,
-                           AccelerationStructure &topLevelAccelerationStructure, std::vector<VkBuffer> indexBufferList, std::vector<VkBuffer> vertexBufferList, 
-                           std::vector<size_t> indexBufferSizeList, std::vector<size_t> vertexBufferSizeList, uint32_t numTextures, uint32_t numMaterials,
+                           AccelerationStructure &topLevelAccelerationStructure, const SceneGeometryBuffer &sceneGeometry,
+                           uint32_t numTextures, uint32_t numMaterials,
                            std::vector<ImageCreator> &diffuseImageCreators, std::vector<ImageCreator> &alphaImageCreators, 
-                           std::vector<ImageCreator> &specularImageCreators, ImageCreator raysNoiseImage);
+                           std::vector<ImageCreator> &specularImageCreators, ImageCreator raysNoiseImage, VkBuffer surfelRayQueueBuffer,
+                           VkBuffer surfelGridBuffer, VkBuffer surfelCellBuffer, std::vector<VkBuffer> cameraUniformBuffers);
     void cleanupDescriptors(VkDevice device) override;
 
     VkDescriptorSetLayout getDescriptorSetLayout() override;
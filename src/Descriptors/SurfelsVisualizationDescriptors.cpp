@@ -18,7 +18,7 @@
 #include <vector>
 
 void SurfelsVisualizationDescriptors::createDescriptors(VkDevice device, uint32_t MAX_FRAMES_IN_FLIGHT, VkBuffer surfelBuffer, VkBuffer surfelGridBuffer, VkBuffer surfelCellBuffer,
-                                                        VkBuffer cameraUniformBuffer, VkImageView positionImageView)
+                                                        std::vector<VkBuffer> cameraUniformBuffers, VkImageView positionImageView)
 {
     // Descriptor pool
     std::vector<VkDescriptorPoolSize> poolSize = {
@@ -41,13 +41,18 @@ void SurfelsVisualizationDescriptors::createDescriptors(VkDevice device, uint32_
     }
 
     // Descriptor set layout
-    std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings(1);
+    std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings(2);
 
     setLayoutBindings[0].binding = 0;
     setLayoutBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
     setLayoutBindings[0].descriptorCount = 1;
     setLayoutBindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_GEOMETRY_BIT;
 
+    setLayoutBindings[1].binding = 1;
+    setLayoutBindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    setLayoutBindings[1].descriptorCount = 1;
+    setLayoutBindings[1].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
     VkDescriptorSetLayoutCreateInfo layoutInfo{};
     layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
     layoutInfo.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
@@ -76,11 +81,11 @@ void SurfelsVisualizationDescriptors::createDescriptors(VkDevice device, uint32_
 
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
     {
-        std::vector<VkWriteDescriptorSet> descriptorWrites(1);
+        std::vector<VkWriteDescriptorSet> descriptorWrites(2);
 
         // Binding 0 -> Buffer para leer los datos de la cámara
         VkDescriptorBufferInfo cameraBufferInfo{};
-        cameraBufferInfo.buffer = cameraUniformBuffer;
+        cameraBufferInfo.buffer = cameraUniformBuffers[i];
         cameraBufferInfo.offset = 0;
         cameraBufferInfo.range = sizeof(CameraUniformBuffer);
 
@@ -92,6 +97,20 @@ void SurfelsVisualizationDescriptors::createDescriptors(VkDevice device, uint32_
         descriptorWrites[0].descriptorCount = 1;
         descriptorWrites[0].pBufferInfo = &cameraBufferInfo;
 
+        // Binding 1 -> Buffer de surfels, del que el vertex shader lee directamente cada surfel
+        VkDescriptorBufferInfo surfelBufferInfo{};
+        surfelBufferInfo.buffer = surfelBuffer;
+        surfelBufferInfo.offset = 0;
+        surfelBufferInfo.range = sizeof(Surfel) * SURFEL_CAPACITY;
+
+        descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[1].dstSet = descriptorSets[i];
+        descriptorWrites[1].dstBinding = 1;
+        descriptorWrites[1].dstArrayElement = 0;
+        descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrites[1].descriptorCount = 1;
+        descriptorWrites[1].pBufferInfo = &surfelBufferInfo;
+
         // Actualización del descriptor
         vkUpdateDescriptorSets(device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
     }
@@ -20,7 +20,7 @@ class SurfelsVisualizationDescriptors : public PipelineDescriptors
 {
 public:
     void createDescriptors(VkDevice device, uint32_t MAX_FRAMES_IN_FLIGHT, VkBuffer surfelBuffer, VkBuffer surfelGridBuffer, VkBuffer surfelCellBuffer,
-                           VkBuffer cameraUniformBuffer, VkImageView positionImageView);
+                           std::vector<VkBuffer> cameraUniformBuffers, VkImageView positionImageView);
     void cleanupDescriptors(VkDevice device) override;
 
     VkDescriptorSetLayout getDescriptorSetLayout() override;
@@ -3,6 +3,7 @@
 #include "RenderApplication.h"
 #include "Buffers/Tools/BufferCreator.h"
 #include "Buffers/Tools/CommandBufferManager.h"
+#include "Buffers/Tools/UploadBatcher.h"
 
 #define GLFW_INCLUDE_VULKAN
 #define GLFW_EXPOSE_NATIVE_WIN32
@@ -17,6 +18,43 @@
 #include <vector>
 #include <array>
 
+TextureData ImageCreator::loadTextureData(const char *texturePath)
+{
+    TextureData textureData;
+    int texChannels;
+    // Se utiliza la variable definida en CMake para referir donde se encuentran los recursos
+    textureData.pixels = stbi_load(texturePath, &textureData.width, &textureData.height, &texChannels, STBI_rgb_alpha);
+
+    if (!textureData.pixels)
+    {
+        throw std::runtime_error("failed to load texture image!");
+    }
+    return textureData;
+}
+
+void ImageCreator::createTextureImage(UploadBatcher &uploadBatcher, VkDevice device, VkPhysicalDevice physicalDevice, TextureData &textureData)
+{
+    int texWidth = textureData.width;
+    int texHeight = textureData.height;
+    VkDeviceSize imageSize = texWidth * texHeight * 4;
+
+    // Se copian los pixels al anillo de staging del lote actual, sin crear un buffer propio
+    StagingAllocation stagingAllocation = uploadBatcher.stageData(textureData.pixels, imageSize);
+    // Se libera el espacio
+    stbi_image_free(textureData.pixels);
+    textureData.pixels = nullptr;
+    // Creación del objeto imagen
+    createImage(device, physicalDevice, texWidth, texHeight,
+                VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory, "SceneTexture");
+
+    // La transición, la copia y los mip maps se graban en el command buffer del lote, que se envía una sola vez
+    VkCommandBuffer commandBuffer = uploadBatcher.getCommandBuffer();
+    transitionImageLayout(commandBuffer, textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    copyBufferToImage(commandBuffer, stagingAllocation.buffer, stagingAllocation.offset, textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
+    generateMipmaps(commandBuffer, VK_FORMAT_R8G8B8A8_SRGB, texWidth, texHeight);
+}
+
 void ImageCreator::createTextureImage(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue, const char *texturePath)
 {
     // Se carga la imagen y se almacenan sus pixels, junto con su tamaño
@@ -44,15 +82,16 @@ void ImageCreator::createTextureImage(VkDevice device, VkPhysicalDevice physical
                 VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory, "SceneTexture");
 
-    // Copia del buffer a la imagen creada
+    // Textura suelta: la transición, la copia y los mip maps se graban en un único command buffer
+    VkCommandBuffer commandBuffer = CommandBufferManager::beginSingleTimeCommands(commandPool, device);
     // Primero se indica la etiqueta de la imagen, como destino de copia de datos
-    transitionImageLayout(commandPool, device, graphicsQueue, textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    transitionImageLayout(commandBuffer, textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
     // Después se hace la copia como tal
-    copyBufferToImage(commandPool, device, graphicsQueue, stagingBuffer, textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
-
+    copyBufferToImage(commandBuffer, stagingBuffer, 0, textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
     // Se crean los mip maps
-    generateMipmaps(commandPool, device, graphicsQueue, VK_FORMAT_R8G8B8A8_SRGB, texWidth, texHeight);
-    
+    generateMipmaps(commandBuffer, VK_FORMAT_R8G8B8A8_SRGB, texWidth, texHeight);
+    CommandBufferManager::endSingleTimeCommands(commandBuffer, graphicsQueue, device, commandPool);
+
     // Se libera la memoria de los buffers auxiliares
     vkDestroyBuffer(device, stagingBuffer, nullptr);
     vkFreeMemory(device, stagingBufferMemory, nullptr);
@@ -75,11 +114,9 @@ void ImageCreator::createNoiseTextureImage(VkDevice device, VkPhysicalDevice phy
                 VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory, "NoiseTexture");
     // Copia del buffer a la imagen creada
-    transitionImageLayout(commandPool, device, graphicsQueue, textureImage, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    copyBufferToImage(commandPool, device, graphicsQueue, stagingBuffer, textureImage, texWidth, texHeight);
-    transitionImageLayout(commandPool, device, graphicsQueue, textureImage, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-    vkDestroyBuffer(device, stagingBuffer, nullptr);
-    vkFreeMemory(device, stagingBufferMemory, nullptr);
+    transitionImageLayout(commandBuffer, textureImage, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    copyBufferToImage(commandBuffer, stagingBuffer, 0, textureImage, texWidth, texHeight);
+    transitionImageLayout(commandBuffer, textureImage, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
     // Creación de la image view
     textureImageView = createImageView(device, textureImage, VK_FORMAT_R32G32B32A32_SFLOAT,
                                        VK_IMAGE_ASPECT_COLOR_BIT, false);
@@ -104,6 +141,9 @@ void ImageCreator::createNoiseTextureImage(VkDevice device, VkPhysicalDevice phy
     }
 
     CommandBufferManager::endSingleTimeCommands(commandBuffer, graphicsQueue, device, commandPool);
+    // El staging buffer se libera una vez terminada la copia
+    vkDestroyBuffer(device, stagingBuffer, nullptr);
+    vkFreeMemory(device, stagingBufferMemory, nullptr);
 }
 
 void ImageCreator::createRaysNoiseTextureImage(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue, std::vector<glm::vec2> *noiseValues, uint32_t texWidth, uint32_t texHeight)
@@ -123,11 +163,9 @@ void ImageCreator::createRaysNoiseTextureImage(VkDevice device, VkPhysicalDevice
                 VK_FORMAT_R32G32_SFLOAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory, "NoiseRaysTexture");
     // Copia del buffer a la imagen creada
-    transitionImageLayout(commandPool, device, graphicsQueue, textureImage, VK_FORMAT_R32G32_SFLOAT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    copyBufferToImage(commandPool, device, graphicsQueue, stagingBuffer, textureImage, texWidth, texHeight);
-    transitionImageLayout(commandPool, device, graphicsQueue, textureImage, VK_FORMAT_R32G32_SFLOAT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-    vkDestroyBuffer(device, stagingBuffer, nullptr);
-    vkFreeMemory(device, stagingBufferMemory, nullptr);
+    transitionImageLayout(commandBuffer, textureImage, VK_FORMAT_R32G32_SFLOAT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    copyBufferToImage(commandBuffer, stagingBuffer, 0, textureImage, texWidth, texHeight);
+    transitionImageLayout(commandBuffer, textureImage, VK_FORMAT_R32G32_SFLOAT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
     // Creación de la image view
     textureImageView = createImageView(device, textureImage, VK_FORMAT_R32G32_SFLOAT,
                                        VK_IMAGE_ASPECT_COLOR_BIT, false);
@@ -152,6 +190,9 @@ void ImageCreator::createRaysNoiseTextureImage(VkDevice device, VkPhysicalDevice
     }
 
     CommandBufferManager::endSingleTimeCommands(commandBuffer, graphicsQueue, device, commandPool);
+    // El staging buffer se libera una vez terminada la copia
+    vkDestroyBuffer(device, stagingBuffer, nullptr);
+    vkFreeMemory(device, stagingBufferMemory, nullptr);
 }
 
 void ImageCreator::createImage(VkDevice device, VkPhysicalDevice physicalDevice,
@@ -209,9 +250,13 @@ void ImageCreator::createImage(VkDevice device, VkPhysicalDevice physicalDevice,
 void ImageCreator::transitionImageLayout(VkCommandPool commandPool, VkDevice device, VkQueue graphicsQueue,
                                          VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout)
 {
-
     VkCommandBuffer commandBuffer = CommandBufferManager::beginSingleTimeCommands(commandPool, device);
+    transitionImageLayout(commandBuffer, image, format, oldLayout, newLayout);
+    CommandBufferManager::endSingleTimeCommands(commandBuffer, graphicsQueue, device, commandPool);
+}
 
+void ImageCreator::transitionImageLayout(VkCommandBuffer commandBuffer, VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout)
+{
     // Se utiliza esta barrera para cambiar entre layouts de la imagen
     // La imagen se utilizaba como transferencia (Destino de copia de datos) y lectura (Acceso al shader)
     VkImageMemoryBarrier barrier{};
@@ -292,18 +337,13 @@ void ImageCreator::transitionImageLayout(VkCommandPool commandPool, VkDevice dev
         0, nullptr,
         0, nullptr,
         1, &barrier);
-
-    CommandBufferManager::endSingleTimeCommands(commandBuffer, graphicsQueue, device, commandPool);
 }
 
-void ImageCreator::copyBufferToImage(VkCommandPool commandPool, VkDevice device, VkQueue graphicsQueue,
-                                     VkBuffer buffer, VkImage image, uint32_t width, uint32_t height)
+void ImageCreator::copyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize bufferOffset, VkImage image, uint32_t width, uint32_t height)
 {
-
-    VkCommandBuffer commandBuffer = CommandBufferManager::beginSingleTimeCommands(commandPool, device);
     // Correspondencia de la imagen al buffer en el que se copia
     VkBufferImageCopy region{};
-    region.bufferOffset = 0;
+    region.bufferOffset = bufferOffset;
     region.bufferRowLength = 0;
     region.bufferImageHeight = 0;
 
@@ -319,8 +359,6 @@ void ImageCreator::copyBufferToImage(VkCommandPool commandPool, VkDevice device,
         1};
     // Copia del buffer a la imagen
     vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-    CommandBufferManager::endSingleTimeCommands(commandBuffer, graphicsQueue, device, commandPool);
 }
 
 VkImageView ImageCreator::createImageView(VkDevice device, VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, bool mipMapEnabled)
@@ -393,15 +431,12 @@ void ImageCreator::createTextureSampler(VkDevice device, VkPhysicalDevice physic
     }
 }
 
-void ImageCreator::generateMipmaps(VkCommandPool commandPool, VkDevice device, VkQueue graphicsQueue,
-                                   VkFormat imageFormat, uint32_t texWidth, uint32_t texHeight)
+void ImageCreator::generateMipmaps(VkCommandBuffer commandBuffer, VkFormat imageFormat, uint32_t texWidth, uint32_t texHeight)
 {
-    VkCommandBuffer commandBuffer = CommandBufferManager::beginSingleTimeCommands(commandPool, device);
-
     int32_t mipWidth = texWidth;
     int32_t mipHeight = texHeight;
 
-    // Transición inicial del mip 0 a TRANSFER_DST_OPTIMAL
+    // El mip 0 ya está en TRANSFER_DST_OPTIMAL tras la copia, la primera iteración lo pasa a origen del blit
     VkImageMemoryBarrier barrier{};
     barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
     barrier.image = textureImage;
@@ -412,14 +447,6 @@ void ImageCreator::generateMipmaps(VkCommandPool commandPool, VkDevice device, V
     barrier.subresourceRange.levelCount = 1;
     barrier.subresourceRange.baseArrayLayer = 0;
     barrier.subresourceRange.layerCount = 1;
-    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-    barrier.srcAccessMask = 0;
-    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-    vkCmdPipelineBarrier(commandBuffer,
-                         VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
-                         0, nullptr, 0, nullptr, 1, &barrier);
 
     for (uint32_t i = 1; i < MIP_MAP_LEVELS; i++)
     {
@@ -494,8 +521,6 @@ void ImageCreator::generateMipmaps(VkCommandPool commandPool, VkDevice device, V
     vkCmdPipelineBarrier(commandBuffer,
                          VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
                          0, nullptr, 0, nullptr, 1, &barrier);
-
-    CommandBufferManager::endSingleTimeCommands(commandBuffer, graphicsQueue, device, commandPool);
 }
 
 bool ImageCreator::hasStencilComponent(VkFormat format)
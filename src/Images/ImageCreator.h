@@ -2,6 +2,7 @@
 
 #include "Buffers/Tools/BufferCreator.h"
 #include "Buffers/Tools/CommandBufferManager.h"
+#include "Buffers/Tools/UploadBatcher.h"
 
 #define GLFW_INCLUDE_VULKAN
 #define GLFW_EXPOSE_NATIVE_WIN32
@@ -14,6 +15,14 @@
 #include <vector>
 #include <array>
 
+// Pixels de una textura ya decodificada, pendiente de subir a la GPU
+struct TextureData
+{
+    unsigned char *pixels = nullptr;
+    int width = 0;
+    int height = 0;
+};
+
 class ImageCreator
 {
 
@@ -30,6 +39,11 @@ public:
     VkImageView textureImageView;
     VkSampler textureSampler = VK_NULL_HANDLE;
 
+    // Decodifica la textura en memoria de CPU. No toca ningún recurso de Vulkan, por lo que se puede ejecutar en paralelo
+    static TextureData loadTextureData(const char *texturePath);
+    // Graba la subida de la textura en el lote actual del UploadBatcher y libera sus pixels
+    void createTextureImage(UploadBatcher &uploadBatcher, VkDevice device, VkPhysicalDevice physicalDevice, TextureData &textureData);
+    // Sube la textura con un único envío propio, para texturas sueltas fuera de la carga de la escena
     void createTextureImage(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue, const char *texturePath);
     void createNoiseTextureImage(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue,
                                  std::vector<glm::vec4> *noiseValues, uint32_t width, uint32_t height);
@@ -40,8 +54,8 @@ public:
                             VkMemoryPropertyFlags properties, VkImage &image, VkDeviceMemory &imageMemory, char *name);
     static void transitionImageLayout(VkCommandPool commandPool, VkDevice device, VkQueue graphicsQueue,
                                       VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout);
-    void copyBufferToImage(VkCommandPool commandPool, VkDevice device, VkQueue graphicsQueue,
-                           VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
+    static void transitionImageLayout(VkCommandBuffer commandBuffer, VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout);
+    static void copyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize bufferOffset, VkImage image, uint32_t width, uint32_t height);
     static VkImageView createImageView(VkDevice device, VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, bool mipMapEnabled);
     void createTextureImageView(VkDevice device);
     void createTextureSampler(VkDevice device, VkPhysicalDevice physicalDevice);
@@ -49,6 +63,5 @@ public:
     void cleanup(VkDevice device);
 
 private:
-    void generateMipmaps(VkCommandPool commandPool, VkDevice device, VkQueue graphicsQueue,
-                         VkFormat imageFormat, uint32_t texWidth, uint32_t texHeight);
+    void generateMipmaps(VkCommandBuffer commandBuffer, VkFormat imageFormat, uint32_t texWidth, uint32_t texHeight);
 };
\ No newline at end of file
@@ -1,12 +1,14 @@
 #include "CommandManager.h"
 
 #include "Tools/VulkanUtils.h"
-#include "Scene/Models/MeshContainer.h"
+#include "Scene/Models/SceneDrawList.h"
 #include "Camera/Camera.h"
 #include "Camera/CameraController.h"
 #include "Pipelines/GeometryPipeline.h"
 #include "Pipelines/SSAOPipeline.h"
 #include "Buffers/SurfelsBufferManager.h"
+#include "Buffers/SceneCullingBufferManager.h"
+#include "Render_Passes/IndirectDiffusePass.h"
 #include "Config.h"
 
 #include <GLFW/glfw3.h>
@@ -15,6 +17,7 @@
 #include <stdexcept>
 #include <iostream>
 #include <vector>
+#include <algorithm>
 
 #define VK_USE_PLATFORM_WIN32_KHR
 #define GLFW_INCLUDE_VULKAN
@@ -63,12 +66,38 @@ void CommandManager::createCommandBuffers(VkDevice device, uint32_t MAX_FRAMES_I
     }
 }
 
+void CommandManager::drawSceneIndirect(VkCommandBuffer commandBuffer, const SceneDrawList &sceneDrawList)
+{
+    // Todos los objetos comparten los buffers de vértices e índices de la escena, así que se enlazan una sola vez
+    VkBuffer vertexBuffers[] = {sceneDrawList.getVertexBuffer()};
+    VkDeviceSize offsets[] = {0};
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+    // Los índices son de 32 bits y relativos al primer vértice de cada objeto, que se indica en su comando indirecto
+    vkCmdBindIndexBuffer(commandBuffer, sceneDrawList.getIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
+
+    // Los rangos de cada objeto se leen de la lista de comandos en GPU, por lo que el coste en CPU no depende del número de objetos
+    vkCmdDrawIndexedIndirect(commandBuffer, sceneDrawList.getIndirectCommandBuffer(), 0, sceneDrawList.getDrawCount(),
+                             sizeof(VkDrawIndexedIndirectCommand));
+}
+
+void CommandManager::drawSceneIndirectCount(VkCommandBuffer commandBuffer, const SceneDrawList &sceneDrawList, VkBuffer culledCommandBuffer, VkBuffer countBuffer)
+{
+    VkBuffer vertexBuffers[] = {sceneDrawList.getVertexBuffer()};
+    VkDeviceSize offsets[] = {0};
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+    vkCmdBindIndexBuffer(commandBuffer, sceneDrawList.getIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
+
+    // El número de objetos de la escena solo acota el número de comandos; el real lo escribe el culling en el buffer de contadores
+    vkCmdDrawIndexedIndirectCount(commandBuffer, culledCommandBuffer, 0, countBuffer, 0, sceneDrawList.getDrawCount(),
+                                  sizeof(VkDrawIndexedIndirectCommand));
+}
+
 void CommandManager::recordCommandBuffer(VkExtent2D extent, uint32_t currentFrame, uint32_t imageIndex,
                                          VkRenderPass shadowMappingRenderPass, VkFramebuffer shadowMappingFramebuffer, VkPipeline shadowMappingPipeline,
                                          VkPipelineLayout shadowMappingPipelineLayout, VkDescriptorSet *shadowMappingDescriptorSet,
                                          VkRenderPass geometryRenderPass, VkFramebuffer geometryFramebuffer, VkPipeline geometryPipeline,
                                          VkPipelineLayout geometryPipelineLayout, VkDescriptorSet *geometryDescriptorSet,
-                                         std::vector<MeshContainer> sceneMeshes, Camera camera)
+                                         const SceneDrawList &sceneDrawList, Camera camera)
 {
     VkCommandBufferBeginInfo beginInfo{};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -119,28 +148,13 @@ void CommandManager::recordCommandBuffer(VkExtent2D extent, uint32_t currentFram
 
     vkCmdBindPipeline(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_GRAPHICS, shadowMappingPipeline);
 
-    for (const auto &mesh : sceneMeshes)
-    {
-        // Dentro de cada contenedor de objetos con el mismo material, se procesa cada mesh por separado, con sus buffers individuales
-        for (int i = 0; i < mesh.vertexMeshesData.vertices.size(); i++)
-        {
-            // Se obtiene el Vertex Buffer del objeto actual de la escena
-            VkBuffer vertexBuffers[] = {mesh.vertexMeshesData.vertexBufferList[i]};
-            VkDeviceSize offsets[] = {0};
-            vkCmdBindVertexBuffers(commandBuffers[currentFrame], 0, 1, vertexBuffers, offsets);
-
-            // Se pasa también el buffer de índices
-            vkCmdBindIndexBuffer(commandBuffers[currentFrame], mesh.vertexMeshesData.indexBufferList[i], 0, VK_INDEX_TYPE_UINT16);
-
-            // Se pasa el conjunto de descriptores correcto, en función del número de frame
-            // No son exclusivos para cada pipeline, se pueden reutilizar
-            vkCmdBindDescriptorSets(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_GRAPHICS, shadowMappingPipelineLayout,
-                                    0, 1, shadowMappingDescriptorSet, 0, nullptr);
+    // Se pasa el conjunto de descriptores correcto, en función del número de frame
+    // No son exclusivos para cada pipeline, se pueden reutilizar
+    vkCmdBindDescriptorSets(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_GRAPHICS, shadowMappingPipelineLayout,
+                            0, 1, shadowMappingDescriptorSet, 0, nullptr);
 
-            // Dibujar
-            vkCmdDrawIndexed(commandBuffers[currentFrame], static_cast<uint32_t>(mesh.vertexMeshesData.indices[i].size()), 1, 0, 0, 0);
-        }
-    }
+    // Dibujar
+    drawSceneIndirect(commandBuffers[currentFrame], sceneDrawList);
 
     vkCmdEndRenderPass(commandBuffers[currentFrame]);
 
@@ -176,35 +190,20 @@ void CommandManager::recordCommandBuffer(VkExtent2D extent, uint32_t currentFram
 
     vkCmdBindPipeline(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_GRAPHICS, geometryPipeline);
 
-    for (const auto &mesh : sceneMeshes)
-    {
-        // Dentro de cada contenedor de objetos con el mismo material, se procesa cada mesh por separado, con sus buffers individuales
-        for (int i = 0; i < mesh.vertexMeshesData.vertices.size(); i++)
-        {
-            // Se obtiene el Vertex Buffer del objeto actual de la escena
-            VkBuffer vertexBuffers[] = {mesh.vertexMeshesData.vertexBufferList[i]};
-            VkDeviceSize offsets[] = {0};
-            vkCmdBindVertexBuffers(commandBuffers[currentFrame], 0, 1, vertexBuffers, offsets);
-
-            // Se pasa también el buffer de índices
-            vkCmdBindIndexBuffer(commandBuffers[currentFrame], mesh.vertexMeshesData.indexBufferList[i], 0, VK_INDEX_TYPE_UINT16);
-
-            // Se pasan las Push Constants a los shaders
-            // Se definen los datos
-            PushConstantsData pushConstants;
-            pushConstants.cameraPosition = camera.getPosition();
-            pushConstants.enablePCF = (renderConfig == RenderMode::SHADOW_MAPPING_PCF) ? 1 : 0;
-            // Asignación al shader
-            vkCmdPushConstants(commandBuffers[currentFrame], geometryPipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PushConstantsData), &pushConstants);
-
-            // Se pasa el conjunto de descriptores correcto, en función del número de frame
-            // No son exclusivos para cada pipeline, se pueden reutilizar
-            vkCmdBindDescriptorSets(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_GRAPHICS, geometryPipelineLayout, 0, 1, geometryDescriptorSet, 0, nullptr);
-
-            // Dibujar
-            vkCmdDrawIndexed(commandBuffers[currentFrame], static_cast<uint32_t>(mesh.vertexMeshesData.indices[i].size()), 1, 0, 0, 0);
-        }
-    }
+    // Se pasan las Push Constants a los shaders
+    // Se definen los datos
+    PushConstantsData pushConstants;
+    pushConstants.cameraPosition = camera.getPosition();
+    pushConstants.enablePCF = (renderConfig == RenderMode::SHADOW_MAPPING_PCF) ? 1 : 0;
+    // Asignación al shader
+    vkCmdPushConstants(commandBuffers[currentFrame], geometryPipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PushConstantsData), &pushConstants);
+
+    // Se pasa el conjunto de descriptores correcto, en función del número de frame
+    // No son exclusivos para cada pipeline, se pueden reutilizar
+    vkCmdBindDescriptorSets(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_GRAPHICS, geometryPipelineLayout, 0, 1, geometryDescriptorSet, 0, nullptr);
+
+    // Dibujar
+    drawSceneIndirect(commandBuffers[currentFrame], sceneDrawList);
 
     vkCmdEndRenderPass(commandBuffers[currentFrame]);
 
@@ -214,7 +213,7 @@ void CommandManager::recordCommandBuffer(VkExtent2D extent, uint32_t currentFram
     }
 }
 
-void CommandManager::recordCommandBuffer(VkExtent2D extent, uint32_t currentFrame, uint32_t imageIndex, std::vector<MeshContainer> sceneMeshes,
+void CommandManager::recordCommandBuffer(VkExtent2D extent, uint32_t currentFrame, uint32_t imageIndex, const SceneDrawList &sceneDrawList,
                                          VkRenderPass gBufferRenderPass, VkFramebuffer gBufferFramebuffer, VkPipeline gBufferPipeline, VkPipelineLayout gBufferPipelineLayout, VkDescriptorSet *gBufferDescriptorSet,
                                          VkRenderPass ssaoRenderPass, VkFramebuffer ssaoFramebuffer, VkPipeline ssaoPipeline, VkPipelineLayout ssaoPipelineLayout, VkDescriptorSet *ssaoDescriptorSet,
                                          VkRenderPass ssaoBlurRenderPass, VkFramebuffer ssaoBlurFramebuffer, VkPipeline ssaoBlurPipeline, VkPipelineLayout ssaoBlurPipelineLayout, VkDescriptorSet *ssaoBlurDescriptorSet,
@@ -266,22 +265,11 @@ void CommandManager::recordCommandBuffer(VkExtent2D extent, uint32_t currentFram
     vkCmdBindPipeline(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_GRAPHICS, gBufferPipeline);
 
     // En esta pasada se carga la geometría de la escena
-    for (const auto &mesh : sceneMeshes)
-    {
-        for (int i = 0; i < mesh.vertexMeshesData.vertices.size(); i++)
-        {
-            VkBuffer vertexBuffers[] = {mesh.vertexMeshesData.vertexBufferList[i]};
-            VkDeviceSize offsets[] = {0};
-            vkCmdBindVertexBuffers(commandBuffers[currentFrame], 0, 1, vertexBuffers, offsets);
-
-            vkCmdBindIndexBuffer(commandBuffers[currentFrame], mesh.vertexMeshesData.indexBufferList[i], 0, VK_INDEX_TYPE_UINT16);
-
-            vkCmdBindDescriptorSets(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_GRAPHICS, gBufferPipelineLayout,
-                                    0, 1, gBufferDescriptorSet, 0, nullptr);
+    vkCmdBindDescriptorSets(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_GRAPHICS, gBufferPipelineLayout,
+                            0, 1, gBufferDescriptorSet, 0, nullptr);
 
-            vkCmdDrawIndexed(commandBuffers[currentFrame], static_cast<uint32_t>(mesh.vertexMeshesData.indices[i].size()), 1, 0, 0, 0);
-        }
-    }
+    // Dibujar
+    drawSceneIndirect(commandBuffers[currentFrame], sceneDrawList);
 
     vkCmdEndRenderPass(commandBuffers[currentFrame]);
 
@@ -380,7 +368,7 @@ void CommandManager::recordCommandBuffer(VkExtent2D extent, uint32_t currentFram
     }
 }
 
-void CommandManager::recordCommandBuffer(VkExtent2D extent, uint32_t currentFrame, uint32_t imageIndex, std::vector<MeshContainer> sceneMeshes,
+void CommandManager::recordCommandBuffer(VkExtent2D extent, uint32_t currentFrame, uint32_t imageIndex, const SceneDrawList &sceneDrawList,
                                          VkRenderPass gBufferRenderPass, VkFramebuffer gBufferFramebuffer, VkPipeline gBufferPipeline, VkPipelineLayout gBufferPipelineLayout, VkDescriptorSet *gBufferDescriptorSet,
                                          VkRenderPass ssaoRenderPass, VkFramebuffer ssaoFramebuffer, VkPipeline ssaoPipeline, VkPipelineLayout ssaoPipelineLayout, VkDescriptorSet *ssaoDescriptorSet,
                                          VkRenderPass ssaoBlurRenderPass, VkFramebuffer ssaoBlurFramebuffer, VkPipeline ssaoBlurPipeline, VkPipelineLayout ssaoBlurPipelineLayout, VkDescriptorSet *ssaoBlurDescriptorSet,
@@ -437,22 +425,11 @@ void CommandManager::recordCommandBuffer(VkExtent2D extent, uint32_t currentFram
 
     vkCmdBindPipeline(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_GRAPHICS, shadowMappingPipeline);
 
-    for (const auto &mesh : sceneMeshes)
-    {
-        for (int i = 0; i < mesh.vertexMeshesData.vertices.size(); i++)
-        {
-            VkBuffer vertexBuffers[] = {mesh.vertexMeshesData.vertexBufferList[i]};
-            VkDeviceSize offsets[] = {0};
-            vkCmdBindVertexBuffers(commandBuffers[currentFrame], 0, 1, vertexBuffers, offsets);
-
-            vkCmdBindIndexBuffer(commandBuffers[currentFrame], mesh.vertexMeshesData.indexBufferList[i], 0, VK_INDEX_TYPE_UINT16);
+    vkCmdBindDescriptorSets(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_GRAPHICS, shadowMappingPipelineLayout,
+                            0, 1, shadowMappingDescriptorSet, 0, nullptr);
 
-            vkCmdBindDescriptorSets(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_GRAPHICS, shadowMappingPipelineLayout,
-                                    0, 1, shadowMappingDescriptorSet, 0, nullptr);
-
-            vkCmdDrawIndexed(commandBuffers[currentFrame], static_cast<uint32_t>(mesh.vertexMeshesData.indices[i].size()), 1, 0, 0, 0);
-        }
-    }
+    // Dibujar
+    drawSceneIndirect(commandBuffers[currentFrame], sceneDrawList);
 
     vkCmdEndRenderPass(commandBuffers[currentFrame]);
 
@@ -509,22 +486,11 @@ void CommandManager::recordCommandBuffer(VkExtent2D extent, uint32_t currentFram
 
     vkCmdBindPipeline(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_GRAPHICS, gBufferPipeline);
 
-    for (const auto &mesh : sceneMeshes)
-    {
-        for (int i = 0; i < mesh.vertexMeshesData.vertices.size(); i++)
-        {
-            VkBuffer vertexBuffers[] = {mesh.vertexMeshesData.vertexBufferList[i]};
-            VkDeviceSize offsets[] = {0};
-            vkCmdBindVertexBuffers(commandBuffers[currentFrame], 0, 1, vertexBuffers, offsets);
+    vkCmdBindDescriptorSets(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_GRAPHICS, gBufferPipelineLayout,
+                            0, 1, gBufferDescriptorSet, 0, nullptr);
 
-            vkCmdBindIndexBuffer(commandBuffers[currentFrame], mesh.vertexMeshesData.indexBufferList[i], 0, VK_INDEX_TYPE_UINT16);
-
-            vkCmdBindDescriptorSets(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_GRAPHICS, gBufferPipelineLayout,
-                                    0, 1, gBufferDescriptorSet, 0, nullptr);
-
-            vkCmdDrawIndexed(commandBuffers[currentFrame], static_cast<uint32_t>(mesh.vertexMeshesData.indices[i].size()), 1, 0, 0, 0);
-        }
-    }
+    // Dibujar
+    drawSceneIndirect(commandBuffers[currentFrame], sceneDrawList);
 
     vkCmdEndRenderPass(commandBuffers[currentFrame]);
 
@@ -623,7 +589,7 @@ void CommandManager::recordCommandBuffer(VkExtent2D extent, uint32_t currentFram
     }
 }
 
-void CommandManager::recordCommandBuffer(VkExtent2D extent, uint32_t currentFrame, uint32_t imageIndex, std::vector<MeshContainer> sceneMeshes, VkRenderPass raytracingRenderPass,
+void CommandManager::recordCommandBuffer(VkExtent2D extent, uint32_t currentFrame, uint32_t imageIndex, const SceneDrawList &sceneDrawList, VkRenderPass raytracingRenderPass,
                                          VkFramebuffer raytracingFramebuffer, VkPipeline raytracingPipeline, VkPipelineLayout raytracingPipelineLayout, VkDescriptorSet *raytracingDescriptorSet)
 {
     VkCommandBufferBeginInfo beginInfo{};
@@ -668,22 +634,11 @@ void CommandManager::recordCommandBuffer(VkExtent2D extent, uint32_t currentFram
     vkCmdBindPipeline(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_GRAPHICS, raytracingPipeline);
 
     // Se carga la geometría de la escena
-    for (const auto &mesh : sceneMeshes)
-    {
-        for (int i = 0; i < mesh.vertexMeshesData.vertices.size(); i++)
-        {
-            VkBuffer vertexBuffers[] = {mesh.vertexMeshesData.vertexBufferList[i]};
-            VkDeviceSize offsets[] = {0};
-            vkCmdBindVertexBuffers(commandBuffers[currentFrame], 0, 1, vertexBuffers, offsets);
+    vkCmdBindDescriptorSets(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_GRAPHICS, raytracingPipelineLayout,
+                            0, 1, raytracingDescriptorSet, 0, nullptr);
 
-            vkCmdBindIndexBuffer(commandBuffers[currentFrame], mesh.vertexMeshesData.indexBufferList[i], 0, VK_INDEX_TYPE_UINT16);
-
-            vkCmdBindDescriptorSets(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_GRAPHICS, raytracingPipelineLayout,
-                                    0, 1, raytracingDescriptorSet, 0, nullptr);
-
-            vkCmdDrawIndexed(commandBuffers[currentFrame], static_cast<uint32_t>(mesh.vertexMeshesData.indices[i].size()), 1, 0, 0, 0);
-        }
-    }
+    // Dibujar
+    drawSceneIndirect(commandBuffers[currentFrame], sceneDrawList);
 
     vkCmdEndRenderPass(commandBuffers[currentFrame]);
 
@@ -693,18 +648,25 @@ void CommandManager::recordCommandBuffer(VkExtent2D extent, uint32_t currentFram
     }
 }
 
-void CommandManager::recordCommandBuffer(VkExtent2D extent, uint32_t currentFrame, uint32_t imageIndex, std::vector<MeshContainer> sceneMeshes,
+void CommandManager::recordCommandBuffer(VkExtent2D extent, uint32_t currentFrame, uint32_t imageIndex, const SceneDrawList &sceneDrawList,
                                          VkRenderPass gBufferRenderPass, VkFramebuffer gBufferFramebuffer, VkPipeline gBufferPipeline, VkPipelineLayout gBufferPipelineLayout, VkDescriptorSet *gBufferDescriptorSet,
                                          VkRenderPass ssaoRenderPass, VkFramebuffer ssaoFramebuffer, VkPipeline ssaoPipeline, VkPipelineLayout ssaoPipelineLayout, VkDescriptorSet *ssaoDescriptorSet,
                                          VkRenderPass ssaoBlurRenderPass, VkFramebuffer ssaoBlurFramebuffer, VkPipeline ssaoBlurPipeline, VkPipelineLayout ssaoBlurPipelineLayout, VkDescriptorSet *ssaoBlurDescriptorSet,
                                          VkRenderPass surfelsCompositionRenderPass, VkFramebuffer surfelsCompositionFramebuffer, VkPipeline surfelsCompositionPipeline, VkPipelineLayout surfelsCompositionPipelineLayout, VkDescriptorSet *surfelsCompositionDescriptorSet,
                                          VkRenderPass shadowMappingRenderPass, VkFramebuffer shadowMappingFramebuffer, VkPipeline shadowMappingPipeline, VkPipelineLayout shadowMappingPipelineLayout, VkDescriptorSet *shadowMappingDescriptorSet,
                                          VkPipeline surfelsGenerationPipeline, VkPipelineLayout surfelsGenerationPipelineLayout, VkDescriptorSet *surfelsGenerationDescriptorSet, VkBuffer surfelStatsBuffer,
+                                         VkPipeline surfelsGridCountPipeline, VkPipeline surfelsGridOffsetPipeline, VkPipeline surfelsGridBinningPipeline, VkPipeline surfelsIndirectArgsPipeline, VkPipeline surfelsLifecyclePipeline, VkPipelineLayout surfelsGridPipelineLayout, VkDescriptorSet *surfelsGridDescriptorSet, VkBuffer surfelGridBuffer,
                                          VkPipeline surfelsVisualizationPipeline, VkPipelineLayout surfelsVisualizationPipelineLayout, VkDescriptorSet *surfelsVisualizationDescriptorSet,
                                          VkPipeline surfelsRadianceCalculationPipeline, VkPipelineLayout surfelsRadianceCalculationPipelineLayout, VkDescriptorSet *surfelsRadianceCalculationDescriptorSet, VkBuffer surfelBuffer,
                                          VkPipeline surfelsIndirectLightingPipeline, VkPipelineLayout surfelsIndirectLightingPipelineLayout, VkDescriptorSet *surfelsIndirectLightingDescriptorSet,
-                                         VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue, VkRenderPass surfelsVisualizationRenderPass, VkFramebuffer surfelsVisualizationFramebuffer,
-                                         VkRenderPass surfelsIndirectLightingRenderPass, VkFramebuffer surfelsIndirectLightingFramebuffer)
+                                         VkRenderPass surfelsVisualizationRenderPass, VkFramebuffer surfelsVisualizationFramebuffer,
+                                         VkRenderPass surfelsIndirectLightingRenderPass, VkFramebuffer surfelsIndirectLightingFramebuffer,
+                                         VkPipeline sceneCullingPipeline, VkPipelineLayout sceneCullingPipelineLayout, VkDescriptorSet *sceneCullingDescriptorSet,
+                                         VkPipeline hiZPipeline, VkPipelineLayout hiZPipelineLayout, const std::vector<VkDescriptorSet> &hiZDescriptorSets,
+                                         const SceneCullingBufferManager &sceneCullingResources, VkPipeline surfelsRayPriorityPipeline, VkPipeline surfelsRayBudgetPipeline,
+                                         VkPipelineLayout surfelsRayBudgetPipelineLayout, VkPipeline surfelsRayEnqueuePipeline, VkBuffer surfelRayQueueBuffer,
+                                         VkPipeline surfelsIrradianceVolumePipeline, VkPipelineLayout surfelsIrradianceVolumePipelineLayout, VkDescriptorSet *surfelsIrradianceVolumeDescriptorSet,
+                                         VkPipeline surfelsIndirectLightingTiledPipeline, VkPipelineLayout surfelsIndirectLightingTiledPipelineLayout, VkImage indirectDiffuseImage)
 {
     VkCommandBufferBeginInfo beginInfo{};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -755,24 +717,88 @@ void CommandManager::recordCommandBuffer(VkExtent2D extent, uint32_t currentFram
 
     vkCmdBindPipeline(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_GRAPHICS, shadowMappingPipeline);
 
-    for (const auto &mesh : sceneMeshes)
-    {
-        for (int i = 0; i < mesh.vertexMeshesData.vertices.size(); i++)
-        {
-            VkBuffer vertexBuffers[] = {mesh.vertexMeshesData.vertexBufferList[i]};
-            VkDeviceSize offsets[] = {0};
-            vkCmdBindVertexBuffers(commandBuffers[currentFrame], 0, 1, vertexBuffers, offsets);
+    vkCmdBindDescriptorSets(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_GRAPHICS, shadowMappingPipelineLayout,
+                            0, 1, shadowMappingDescriptorSet, 0, nullptr);
 
-            vkCmdBindIndexBuffer(commandBuffers[currentFrame], mesh.vertexMeshesData.indexBufferList[i], 0, VK_INDEX_TYPE_UINT16);
+    // Dibujar
+    drawSceneIndirect(commandBuffers[currentFrame], sceneDrawList);
 
-            vkCmdBindDescriptorSets(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_GRAPHICS, shadowMappingPipelineLayout,
-                                    0, 1, shadowMappingDescriptorSet, 0, nullptr);
+    vkCmdEndRenderPass(commandBuffers[currentFrame]);
 
-            vkCmdDrawIndexed(commandBuffers[currentFrame], static_cast<uint32_t>(mesh.vertexMeshesData.indices[i].size()), 1, 0, 0, 0);
-        }
-    }
+    // Los buffers de surfels, el grid y las imágenes del G-Buffer se comparten entre los frames en vuelo.
+    // Antes de volver a escribirlos, se espera a que terminen los accesos del frame anterior enviado a la misma cola
+    VkMemoryBarrier frameBarrier = {};
+    frameBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    frameBarrier.pNext = nullptr;
+    frameBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    frameBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
 
-    vkCmdEndRenderPass(commandBuffers[currentFrame]);
+    vkCmdPipelineBarrier(
+        commandBuffers[currentFrame],
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        0,
+        1, &frameBarrier,
+        0, nullptr,
+        0, nullptr);
+
+    // PASADA DE CÓMPUTO 0 - CULLING DE LA ESCENA
+    // Cada objeto se comprueba contra el frustum de la cámara y contra la pirámide de profundidad del frame anterior.
+    // Los visibles se copian a una lista compactada, que es la que dibuja el G-Buffer
+
+    VkBuffer cullingStatsBuffer = sceneCullingResources.getCullingStatsBuffer();
+
+    vkCmdFillBuffer(commandBuffers[currentFrame], cullingStatsBuffer, 0, sizeof(SceneCullingStats), 0);
+
+    VkMemoryBarrier cullingBarrier = {};
+    cullingBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    cullingBarrier.pNext = nullptr;
+    cullingBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    cullingBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+    vkCmdPipelineBarrier(
+        commandBuffers[currentFrame],
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        1, &cullingBarrier,
+        0, nullptr,
+        0, nullptr);
+
+    vkCmdBindPipeline(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_COMPUTE, sceneCullingPipeline);
+    vkCmdBindDescriptorSets(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_COMPUTE, sceneCullingPipelineLayout, 0, 1, sceneCullingDescriptorSet, 0, nullptr);
+    vkCmdDispatch(commandBuffers[currentFrame], (sceneCullingResources.getDrawCount() + SCENE_CULLING_GROUP_SIZE - 1) / SCENE_CULLING_GROUP_SIZE, 1, 1);
+
+    // La lista compactada y su contador se leen en el dibujado indirecto, y los contadores se copian para leerlos desde CPU
+    cullingBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    cullingBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+
+    vkCmdPipelineBarrier(
+        commandBuffers[currentFrame],
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        1, &cullingBarrier,
+        0, nullptr,
+        0, nullptr);
+
+    VkBufferCopy statsCopy{};
+    statsCopy.srcOffset = 0;
+    statsCopy.dstOffset = 0;
+    statsCopy.size = sizeof(SceneCullingStats);
+    vkCmdCopyBuffer(commandBuffers[currentFrame], cullingStatsBuffer, sceneCullingResources.getStatsReadbackBuffer(currentFrame), 1, &statsCopy);
+
+    cullingBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    cullingBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+    vkCmdPipelineBarrier(
+        commandBuffers[currentFrame],
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_HOST_BIT,
+        0,
+        1, &cullingBarrier,
+        0, nullptr,
+        0, nullptr);
 
     // SEGUNDA PASADA - GBUFFER
 
@@ -808,24 +834,77 @@ void CommandManager::recordCommandBuffer(VkExtent2D extent, uint32_t currentFram
 
     vkCmdBindPipeline(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_GRAPHICS, gBufferPipeline);
 
-    for (const auto &mesh : sceneMeshes)
+    vkCmdBindDescriptorSets(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_GRAPHICS, gBufferPipelineLayout,
+                            0, 1, gBufferDescriptorSet, 0, nullptr);
+
+    // Dibujar solo los objetos que han pasado el culling
+    drawSceneIndirectCount(commandBuffers[currentFrame], sceneDrawList, sceneCullingResources.getCulledCommandBuffer(), cullingStatsBuffer);
+
+    vkCmdEndRenderPass(commandBuffers[currentFrame]);
+
+    // CONSTRUCCIÓN DE LA PIRÁMIDE DE PROFUNDIDAD
+    // Se reduce el depth buffer del G-Buffer nivel a nivel, quedándose con la profundidad más lejana. La usará el culling del siguiente frame
+
+    VkMemoryBarrier hiZBarrier = {};
+    hiZBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    hiZBarrier.pNext = nullptr;
+    hiZBarrier.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    hiZBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+    // El culling de este frame ya ha leído la pirámide anterior, así que también se espera a que termine antes de sobrescribirla
+    vkCmdPipelineBarrier(
+        commandBuffers[currentFrame],
+        VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        1, &hiZBarrier,
+        0, nullptr,
+        0, nullptr);
+
+    vkCmdBindPipeline(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_COMPUTE, hiZPipeline);
+
+    VkExtent2D hiZExtent = sceneCullingResources.getHiZExtent();
+    HiZPushConstants hiZSizes{glm::ivec2(extent.width, extent.height), glm::ivec2(0)};
+
+    hiZBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    hiZBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+    for (uint32_t level = 0; level < sceneCullingResources.getHiZLevels(); level++)
     {
-        for (int i = 0; i < mesh.vertexMeshesData.vertices.size(); i++)
-        {
-            VkBuffer vertexBuffers[] = {mesh.vertexMeshesData.vertexBufferList[i]};
-            VkDeviceSize offsets[] = {0};
-            vkCmdBindVertexBuffers(commandBuffers[currentFrame], 0, 1, vertexBuffers, offsets);
+        hiZSizes.targetSize = glm::ivec2(std::max(1u, hiZExtent.width >> level), std::max(1u, hiZExtent.height >> level));
 
-            vkCmdBindIndexBuffer(commandBuffers[currentFrame], mesh.vertexMeshesData.indexBufferList[i], 0, VK_INDEX_TYPE_UINT16);
+        vkCmdBindDescriptorSets(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_COMPUTE, hiZPipelineLayout, 0, 1, &hiZDescriptorSets[level], 0, nullptr);
+        vkCmdPushConstants(commandBuffers[currentFrame], hiZPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(HiZPushConstants), &hiZSizes);
+        vkCmdDispatch(commandBuffers[currentFrame], (hiZSizes.targetSize.x + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, (hiZSizes.targetSize.y + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, 1);
 
-            vkCmdBindDescriptorSets(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_GRAPHICS, gBufferPipelineLayout,
-                                    0, 1, gBufferDescriptorSet, 0, nullptr);
+        // Cada nivel se genera a partir del anterior
+        vkCmdPipelineBarrier(commandBuffers[currentFrame], VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &hiZBarrier, 0, nullptr, 0, nullptr);
 
-            vkCmdDrawIndexed(commandBuffers[currentFrame], static_cast<uint32_t>(mesh.vertexMeshesData.indices[i].size()), 1, 0, 0, 0);
-        }
+        hiZSizes.sourceSize = hiZSizes.targetSize;
     }
 
-    vkCmdEndRenderPass(commandBuffers[currentFrame]);
+    // CICLO DE VIDA DE LOS SURFELS
+    // Antes de generar, se reciclan los surfels que llevan demasiado tiempo sin verse y los redundantes, usando el grid del
+    // frame anterior. Sus índices quedan en la lista de libres, de la que la generación los saca en lugar de crecer la lista global
+
+    vkCmdBindDescriptorSets(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_COMPUTE, surfelsGridPipelineLayout, 0, 1, surfelsGridDescriptorSet, 0, nullptr);
+    vkCmdBindPipeline(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_COMPUTE, surfelsLifecyclePipeline);
+    vkCmdDispatch(commandBuffers[currentFrame], (SURFEL_CAPACITY + 64 - 1) / 64, 1, 1);
+
+    VkMemoryBarrier lifecycleBarrier = {};
+    lifecycleBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    lifecycleBarrier.pNext = nullptr;
+    lifecycleBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    lifecycleBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+    vkCmdPipelineBarrier(
+        commandBuffers[currentFrame],
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        1, &lifecycleBarrier,
+        0, nullptr,
+        0, nullptr);
 
     // -------------------------------------------------------------------------------------------------------------------------------------- //
     // PASADA DE CÓMPUTO 1 - GENERACIÓN DE SURFELS
@@ -852,7 +931,7 @@ void CommandManager::recordCommandBuffer(VkExtent2D extent, uint32_t currentFram
     bufferbarrierdesc.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
     bufferbarrierdesc.pNext = nullptr;
     bufferbarrierdesc.buffer = surfelStatsBuffer;
-    bufferbarrierdesc.size = sizeof(unsigned int) * 8;
+    bufferbarrierdesc.size = sizeof(unsigned int) * SURFEL_STATS_SIZE;
     bufferbarrierdesc.offset = 0;
     bufferbarrierdesc.srcAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
 
@@ -886,14 +965,82 @@ void CommandManager::recordCommandBuffer(VkExtent2D extent, uint32_t currentFram
         0, nullptr,
         0, nullptr);
 
+    // PASADA DE CÓMPUTO 2 - RECONSTRUCCIÓN DEL GRID COMPACTADO DE SURFELS
+    // Se rehace el grid con todos los surfels vivos en tres pasos: conteo por celda, suma prefija de los
+    // contadores para obtener el offset de cada celda, y distribución de los índices en la lista compactada.
+    // La generación del siguiente frame y la iluminación indirecta de este leen el grid resultante
+
+    VkMemoryBarrier gridBarrier = {};
+    gridBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    gridBarrier.pNext = nullptr;
+    gridBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    gridBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    vkCmdPipelineBarrier(
+        commandBuffers[currentFrame],
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        1, &gridBarrier,
+        0, nullptr,
+        0, nullptr);
+
+    // Se reinician los contadores de las celdas y el reservador de la lista compactada
+    vkCmdFillBuffer(commandBuffers[currentFrame], surfelGridBuffer, 0, VK_WHOLE_SIZE, 0);
+    vkCmdFillBuffer(commandBuffers[currentFrame], surfelStatsBuffer, sizeof(unsigned int) * SURFEL_STATS_CELL_ALLOCATOR, sizeof(unsigned int), 0);
+
+    gridBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    gridBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+    vkCmdPipelineBarrier(
+        commandBuffers[currentFrame],
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        1, &gridBarrier,
+        0, nullptr,
+        0, nullptr);
+
+    uint32_t surfelGroupCount = (SURFEL_CAPACITY + 64 - 1) / 64;
+    uint32_t scanGroupCount = (SURFEL_TABLE_SIZE + SURFEL_GRID_SCAN_BLOCK_SIZE - 1) / SURFEL_GRID_SCAN_BLOCK_SIZE;
+
+    gridBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    gridBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+    vkCmdBindDescriptorSets(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_COMPUTE, surfelsGridPipelineLayout, 0, 1, surfelsGridDescriptorSet, 0, nullptr);
+
+    vkCmdBindPipeline(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_COMPUTE, surfelsGridCountPipeline);
+    vkCmdDispatch(commandBuffers[currentFrame], surfelGroupCount, 1, 1);
+    vkCmdPipelineBarrier(commandBuffers[currentFrame], VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &gridBarrier, 0, nullptr, 0, nullptr);
+
+    vkCmdBindPipeline(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_COMPUTE, surfelsGridOffsetPipeline);
+    vkCmdDispatch(commandBuffers[currentFrame], scanGroupCount, 1, 1);
+    vkCmdPipelineBarrier(commandBuffers[currentFrame], VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &gridBarrier, 0, nullptr, 0, nullptr);
+
+    vkCmdBindPipeline(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_COMPUTE, surfelsGridBinningPipeline);
+    vkCmdDispatch(commandBuffers[currentFrame], surfelGroupCount, 1, 1);
+
+    // Se escriben los argumentos de las llamadas indirectas a partir del número de surfels vivos
+    vkCmdBindPipeline(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_COMPUTE, surfelsIndirectArgsPipeline);
+    vkCmdDispatch(commandBuffers[currentFrame], 1, 1, 1);
+
+    // El grid se lee tanto en cómputo como en el fragment shader de la iluminación indirecta, y los argumentos en el dibujado y el dispatch indirectos
+    gridBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    vkCmdPipelineBarrier(
+        commandBuffers[currentFrame],
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+        0,
+        1, &gridBarrier,
+        0, nullptr,
+        0, nullptr);
+
     // TERCERA PASADA - VISUALIZACIÓN DE LA COBERTURA OBTENIDA POR LA GENERACIÓN DE SURFELS
-    // Una vez terminada la pasada de cómputo para generar los surfels, se mapea el buffer a otro con la información indispensable para poder
-    // visualizar los surfels proyectados
+    // Los surfels se leen directamente del buffer de surfels en el vertex shader, y el número de puntos a pintar
+    // se toma del buffer de estadísticas, de modo que no hace falta leer nada desde CPU
 
     if (renderConfig == RenderMode::SURFELS_VISUALIZATION)
     {
-        SurfelsBufferManager::mapSurfelsVisualizationData(device, physicalDevice, commandPool, graphicsQueue, surfelBuffer, surfelsVBO, surfelsVBOAlloc, false);
-
         VkClearValue clearValuesSurfels[2];
         clearValuesSurfels[0].color = {{0.0f, 0.0f, 0.0f, 1.0f}};
         clearValuesSurfels[1].depthStencil = {1.0f, 0};
@@ -943,28 +1090,72 @@ void CommandManager::recordCommandBuffer(VkExtent2D extent, uint32_t currentFram
             surfelsVisualizationDescriptorSet,
             0, nullptr);
 
-        VkDeviceSize offsets[] = {0};
-        vkCmdBindVertexBuffers(
-            commandBuffers[currentFrame],
-            0, 1,
-            &surfelsVBO,
-            offsets);
-
-        vkCmdDraw(
+        vkCmdDrawIndirect(
             commandBuffers[currentFrame],
-            SURFEL_CAPACITY,
+            surfelStatsBuffer,
+            sizeof(unsigned int) * SURFEL_STATS_DRAW_ARGS,
             1,
-            0,
-            0);
+            sizeof(VkDrawIndirectCommand));
 
         vkCmdEndRenderPass(commandBuffers[currentFrame]);
     }
 
-    // PASADA DE CÓMPUTO 2 - CÁLCULO DE LA RADIANCIA ALMACENADA POR CADA SURFEL
+    // PASADA DE CÓMPUTO 3 - CÁLCULO DE LA RADIANCIA ALMACENADA POR CADA SURFEL
 
     if (renderConfig == RenderMode::SURFELS_GLOBAL_ILLUMINATION || renderConfig == RenderMode::SURFELS_RADIANCE_VISUALIZATION)
     {
-        uint32_t groupCount = (SURFEL_CAPACITY + 64 - 1) / 64;
+        // PLANIFICACIÓN DE RAYOS
+        // El presupuesto de rayos del frame se reparte entre los surfels que aún necesitan rayos según su prioridad: se
+        // construye un histograma de prioridades, se busca el cubo en el que se agota el presupuesto y se compactan en una
+        // cola los surfels elegidos. El cálculo de radiancia se lanza con un hilo por surfel de la cola
+
+        vkCmdFillBuffer(commandBuffers[currentFrame], surfelRayQueueBuffer, 0, sizeof(unsigned int) * (SURFEL_RAY_QUEUE_HEADER_SIZE + SURFEL_PRIORITY_BUCKETS), 0);
+
+        VkMemoryBarrier schedulingBarrier = {};
+        schedulingBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        schedulingBarrier.pNext = nullptr;
+        schedulingBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        schedulingBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+        vkCmdPipelineBarrier(
+            commandBuffers[currentFrame],
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            1, &schedulingBarrier,
+            0, nullptr,
+            0, nullptr);
+
+        schedulingBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+
+        vkCmdBindDescriptorSets(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_COMPUTE, surfelsGridPipelineLayout, 0, 1, surfelsGridDescriptorSet, 0, nullptr);
+        vkCmdBindPipeline(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_COMPUTE, surfelsRayPriorityPipeline);
+        vkCmdDispatchIndirect(commandBuffers[currentFrame], surfelStatsBuffer, sizeof(unsigned int) * SURFEL_STATS_DISPATCH_ARGS);
+        vkCmdPipelineBarrier(commandBuffers[currentFrame], VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &schedulingBarrier, 0, nullptr, 0, nullptr);
+
+        // El reparto del presupuesto tiene push constants, así que su layout no es compatible con el del grid y se vuelve a enlazar el descriptor
+        SurfelRayBudgetPushConstants rayBudget{SURFEL_RAY_BUDGET};
+
+        vkCmdBindDescriptorSets(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_COMPUTE, surfelsRayBudgetPipelineLayout, 0, 1, surfelsGridDescriptorSet, 0, nullptr);
+        vkCmdBindPipeline(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_COMPUTE, surfelsRayBudgetPipeline);
+        vkCmdPushConstants(commandBuffers[currentFrame], surfelsRayBudgetPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(SurfelRayBudgetPushConstants), &rayBudget);
+        vkCmdDispatch(commandBuffers[currentFrame], 1, 1, 1);
+        vkCmdPipelineBarrier(commandBuffers[currentFrame], VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &schedulingBarrier, 0, nullptr, 0, nullptr);
+
+        vkCmdBindDescriptorSets(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_COMPUTE, surfelsGridPipelineLayout, 0, 1, surfelsGridDescriptorSet, 0, nullptr);
+        vkCmdBindPipeline(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_COMPUTE, surfelsRayEnqueuePipeline);
+        vkCmdDispatchIndirect(commandBuffers[currentFrame], surfelStatsBuffer, sizeof(unsigned int) * SURFEL_STATS_DISPATCH_ARGS);
+
+        // La cola se lee en el cálculo de radiancia, y sus argumentos en el dispatch indirecto
+        schedulingBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+        vkCmdPipelineBarrier(
+            commandBuffers[currentFrame],
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+            0,
+            1, &schedulingBarrier,
+            0, nullptr,
+            0, nullptr);
 
         vkCmdBindPipeline(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_COMPUTE, surfelsRadianceCalculationPipeline);
         vkCmdPushConstants(
@@ -978,7 +1169,9 @@ void CommandManager::recordCommandBuffer(VkExtent2D extent, uint32_t currentFram
             sizeof(PushConstants),
             &windowSize);
         vkCmdBindDescriptorSets(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_COMPUTE, surfelsRadianceCalculationPipelineLayout, 0, 1, surfelsRadianceCalculationDescriptorSet, 0, nullptr);
-        vkCmdDispatch(commandBuffers[currentFrame], groupCount, 1, 1);
+
+        // El número de grupos lo escribe en la GPU el reparto del presupuesto, a partir de los surfels que han entrado en la cola
+        vkCmdDispatchIndirect(commandBuffers[currentFrame], surfelRayQueueBuffer, sizeof(unsigned int) * SURFEL_RAY_QUEUE_DISPATCH_ARGS);
 
         // Barrera para asegurar que se termina de escribir la radiancia en todos los surfels del buffer
         VkBufferMemoryBarrier barrier = {};
@@ -1003,7 +1196,6 @@ void CommandManager::recordCommandBuffer(VkExtent2D extent, uint32_t currentFram
         if (renderConfig == RenderMode::SURFELS_RADIANCE_VISUALIZATION)
         {
             // CUARTA PASADA - VISUALIZACIÓN DE LA RADIANCIA DE LOS SURFELS
-            SurfelsBufferManager::mapSurfelsVisualizationData(device, physicalDevice, commandPool, graphicsQueue, surfelBuffer, surfelsVBO, surfelsVBOAlloc, true);
 
             VkClearValue clearValuesSurfels[2];
             clearValuesSurfels[0].color = {{0.0f, 0.0f, 0.0f, 1.0f}};
@@ -1054,32 +1246,52 @@ void CommandManager::recordCommandBuffer(VkExtent2D extent, uint32_t currentFram
                 surfelsVisualizationDescriptorSet,
                 0, nullptr);
 
-            VkDeviceSize offsets[] = {0};
-            vkCmdBindVertexBuffers(
+            vkCmdDrawIndirect(
                 commandBuffers[currentFrame],
-                0, 1,
-                &surfelsVBO,
-                offsets);
-
-            vkCmdDraw(
-                commandBuffers[currentFrame],
-                SURFEL_CAPACITY,
+                surfelStatsBuffer,
+                sizeof(unsigned int) * SURFEL_STATS_DRAW_ARGS,
                 1,
-                0,
-                0);
+                sizeof(VkDrawIndirectCommand));
 
             vkCmdEndRenderPass(commandBuffers[currentFrame]);
         }
-        else
+        else if (indirectDiffuseMode == IndirectDiffuseMode::IRRADIANCE_VOLUME)
         {
+            // VOLUMEN DE IRRADIANCIA
+            // Cada celda del clipmap resume los surfels que la solapan, para que la iluminación indirecta sólo tenga
+            // que muestrear una textura por píxel. Los niveles van seguidos en z dentro del dispatch
+
+            vkCmdBindPipeline(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_COMPUTE, surfelsIrradianceVolumePipeline);
+            vkCmdBindDescriptorSets(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_COMPUTE, surfelsIrradianceVolumePipelineLayout, 0, 1, surfelsIrradianceVolumeDescriptorSet, 0, nullptr);
+
+            vkCmdDispatch(commandBuffers[currentFrame], SURFEL_GRID_DIMENSIONS.x / 4, SURFEL_GRID_DIMENSIONS.y / 4, SURFEL_GRID_DIMENSIONS.z * SURFEL_CLIPMAP_LEVELS / 4);
+
+            // Barrera para que la iluminación indirecta lea el volumen completo
+            VkMemoryBarrier volumeBarrier = {};
+            volumeBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            volumeBarrier.pNext = nullptr;
+            volumeBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            volumeBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+            vkCmdPipelineBarrier(
+                commandBuffers[currentFrame],
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                0,
+                1, &volumeBarrier,
+                0, nullptr,
+                0, nullptr);
+
             // CUARTA PASADA - CÁLCULO DE LA ILUMINACIÓN DIFUSA INDIRECTA
+            // Se calcula a resolución reducida y la composición la reescala
+            VkExtent2D indirectDiffuseExtent = IndirectDiffusePass::getImageExtent(extent);
 
             clearValues[0].color = {{0.0f, 0.0f, 0.0f, 1.0f}};
             clearValues[1].depthStencil = {1.0f, 0};
 
             renderPassBeginInfo.renderPass = surfelsIndirectLightingRenderPass;
             renderPassBeginInfo.framebuffer = surfelsIndirectLightingFramebuffer;
-            renderPassBeginInfo.renderArea.extent = extent;
+            renderPassBeginInfo.renderArea.extent = indirectDiffuseExtent;
             renderPassBeginInfo.clearValueCount = 1;
             renderPassBeginInfo.pClearValues = clearValues.data();
 
@@ -1087,14 +1299,14 @@ void CommandManager::recordCommandBuffer(VkExtent2D extent, uint32_t currentFram
 
             viewport.x = 0.0f;
             viewport.y = 0.0f;
-            viewport.width = static_cast<float>(extent.width);
-            viewport.height = static_cast<float>(extent.height);
+            viewport.width = static_cast<float>(indirectDiffuseExtent.width);
+            viewport.height = static_cast<float>(indirectDiffuseExtent.height);
             viewport.minDepth = 0.0f;
             viewport.maxDepth = 1.0f;
             vkCmdSetViewport(commandBuffers[currentFrame], 0, 1, &viewport);
 
             scissor.offset = {0, 0};
-            scissor.extent = extent;
+            scissor.extent = indirectDiffuseExtent;
             vkCmdSetScissor(commandBuffers[currentFrame], 0, 1, &scissor);
 
             vkCmdBindPipeline(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_GRAPHICS, surfelsIndirectLightingPipeline);
@@ -1116,6 +1328,57 @@ void CommandManager::recordCommandBuffer(VkExtent2D extent, uint32_t currentFram
 
             vkCmdEndRenderPass(commandBuffers[currentFrame]);
         }
+        else
+        {
+            // CUARTA PASADA - CÁLCULO DE LA ILUMINACIÓN DIFUSA INDIRECTA POR TESELAS
+            // Cada grupo reúne en memoria compartida los surfels que afectan a su tesela de 16x16 píxeles y sus píxeles
+            // sólo recorren esa lista. La imagen se escribe desde el compute shader, así que pasa a layout general
+            VkExtent2D indirectDiffuseExtent = IndirectDiffusePass::getImageExtent(extent);
+
+            VkImageMemoryBarrier indirectDiffuseBarrier{};
+            indirectDiffuseBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            indirectDiffuseBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            indirectDiffuseBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+            indirectDiffuseBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            indirectDiffuseBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            indirectDiffuseBarrier.image = indirectDiffuseImage;
+            indirectDiffuseBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            indirectDiffuseBarrier.subresourceRange.baseMipLevel = 0;
+            indirectDiffuseBarrier.subresourceRange.levelCount = 1;
+            indirectDiffuseBarrier.subresourceRange.baseArrayLayer = 0;
+            indirectDiffuseBarrier.subresourceRange.layerCount = 1;
+            indirectDiffuseBarrier.srcAccessMask = 0;
+            indirectDiffuseBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+
+            vkCmdPipelineBarrier(
+                commandBuffers[currentFrame],
+                VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                0,
+                0, nullptr,
+                0, nullptr,
+                1, &indirectDiffuseBarrier);
+
+            vkCmdBindPipeline(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_COMPUTE, surfelsIndirectLightingTiledPipeline);
+            vkCmdBindDescriptorSets(commandBuffers[currentFrame], VK_PIPELINE_BIND_POINT_COMPUTE, surfelsIndirectLightingTiledPipelineLayout, 0, 1, surfelsIndirectLightingDescriptorSet, 0, nullptr);
+
+            vkCmdDispatch(commandBuffers[currentFrame], (indirectDiffuseExtent.width + 15) / 16, (indirectDiffuseExtent.height + 15) / 16, 1);
+
+            // La composición muestrea la imagen como la deja la pasada de render del otro modo
+            indirectDiffuseBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+            indirectDiffuseBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            indirectDiffuseBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            indirectDiffuseBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+            vkCmdPipelineBarrier(
+                commandBuffers[currentFrame],
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                0,
+                0, nullptr,
+                0, nullptr,
+                1, &indirectDiffuseBarrier);
+        }
     }
 
     // -----------------------------------------------------------------------------------------
@@ -1217,15 +1480,6 @@ void CommandManager::recordCommandBuffer(VkExtent2D extent, uint32_t currentFram
 void CommandManager::cleanup(VkDevice device)
 {
     vkDestroyCommandPool(device, commandPool, nullptr);
-    cleanupAuxiliarBuffers(device);
-}
-
-void CommandManager::cleanupAuxiliarBuffers(VkDevice)
-{
-    if (surfelsVBO != VK_NULL_HANDLE)
-    {
-        vmaDestroyBuffer(BufferCreator::allocator, surfelsVBO, surfelsVBOAlloc);
-    }
 }
 
 VkCommandPool CommandManager::getCommandPool() const { return this->commandPool; }
@@ -1,8 +1,9 @@
 #pragma once
 
-#include "Scene/Models/MeshContainer.h"
+#include "Scene/Models/SceneDrawList.h"
 #include "Camera/Camera.h"
 #include "Buffers/SurfelsBufferManager.h"
+#include "Buffers/SceneCullingBufferManager.h"
 
 #include <GLFW/glfw3.h>
 #include <GLFW/glfw3native.h>
@@ -21,15 +22,16 @@ private:
 	VkCommandPool commandPool; // Maneja la memoria utilizada para guardar los buffers
 	std::vector<VkCommandBuffer> commandBuffers;
 
-	VkBuffer surfelsVBO = VK_NULL_HANDLE;
-    VmaAllocation surfelsVBOAlloc;
-
 	// Parámetros para Depth Bias
 	float depthBiasConstant;
 	float depthBiasSlope;
 
 	void createCommandPool(VkDevice device, VkPhysicalDevice physicalDevice, VkSurfaceKHR surface);
 	void createCommandBuffers(VkDevice device, uint32_t MAX_FRAMES_IN_FLIGHT);
+	// Enlaza los buffers compartidos por toda la escena y la dibuja con su lista de comandos indirectos
+	void drawSceneIndirect(VkCommandBuffer commandBuffer, const SceneDrawList &sceneDrawList);
+	// Igual que la anterior, pero con la lista compactada por el culling, cuyo número de comandos se lee de GPU
+	void drawSceneIndirectCount(VkCommandBuffer commandBuffer, const SceneDrawList &sceneDrawList, VkBuffer culledCommandBuffer, VkBuffer countBuffer);
 
 public:
 	CommandManager();
@@ -40,36 +42,41 @@ public:
 							 VkPipelineLayout shadowMappingPipelineLayout, VkDescriptorSet *shadowMappingDescriptorSet,
 							 VkRenderPass geometryRenderPass, VkFramebuffer geometryFramebuffer, VkPipeline geometryPipeline,
 							 VkPipelineLayout geometryPipelineLayout, VkDescriptorSet *geometryDescriptorSet,
-							 std::vector<MeshContainer> sceneMeshes, Camera camera);
-	void recordCommandBuffer(VkExtent2D extent, uint32_t currentFrame, uint32_t imageIndex, std::vector<MeshContainer> sceneMeshes,
+							 const SceneDrawList &sceneDrawList, Camera camera);
+	void recordCommandBuffer(VkExtent2D extent, uint32_t currentFrame, uint32_t imageIndex, const SceneDrawList &sceneDrawList,
 							 VkRenderPass gBufferRenderPass, VkFramebuffer gBufferFramebuffer, VkPipeline gBufferPipeline, VkPipelineLayout gBufferPipelineLayout, VkDescriptorSet *gBufferDescriptorSet,
 							 VkRenderPass ssaoRenderPass, VkFramebuffer ssaoFramebuffer, VkPipeline ssaoPipeline, VkPipelineLayout ssaoPipelineLayout, VkDescriptorSet *ssaoDescriptorSet,
 							 VkRenderPass ssaoBlurRenderPass, VkFramebuffer ssaoBlurFramebuffer, VkPipeline ssaoBlurPipeline, VkPipelineLayout ssaoBlurPipelineLayout, VkDescriptorSet *ssoBlurDescriptorSet,
 							 VkRenderPass ssaoCompositionRenderPass, VkFramebuffer ssaoCompositionFramebuffer, VkPipeline ssaoCompositionPipeline, VkPipelineLayout ssaoCompositionPipelineLayout, VkDescriptorSet *ssaoCompositionDescriptorSet);
-	void recordCommandBuffer(VkExtent2D extent, uint32_t currentFrame, uint32_t imageIndex, std::vector<MeshContainer> sceneMeshes,
+	void recordCommandBuffer(VkExtent2D extent, uint32_t currentFrame, uint32_t imageIndex, const SceneDrawList &sceneDrawList,
 							 VkRenderPass gBufferRenderPass, VkFramebuffer gBufferFramebuffer, VkPipeline gBufferPipeline, VkPipelineLayout gBufferPipelineLayout, VkDescriptorSet *gBufferDescriptorSet,
 							 VkRenderPass ssaoRenderPass, VkFramebuffer ssaoFramebuffer, VkPipeline ssaoPipeline, VkPipelineLayout ssaoPipelineLayout, VkDescriptorSet *ssaoDescriptorSet,
 							 VkRenderPass ssaoBlurRenderPass, VkFramebuffer ssaoBlurFramebuffer, VkPipeline ssaoBlurPipeline, VkPipelineLayout ssaoBlurPipelineLayout, VkDescriptorSet *ssaoBlurDescriptorSet,
 							 VkRenderPass ssaoCompositionRenderPass, VkFramebuffer ssaoCompositionFramebuffer, VkPipeline ssaoCompositionPipeline, VkPipelineLayout ssaoCompositionPipelineLayout, VkDescriptorSet *ssaoCompositionDescriptorSet,
 							 VkRenderPass shadowMappingRenderPass, VkFramebuffer shadowMappingFramebuffer, VkPipeline shadowMappingPipeline, VkPipelineLayout shadowMappingPipelineLayout, VkDescriptorSet *shadowMappingDescriptorSet);
-	void recordCommandBuffer(VkExtent2D extent, uint32_t currentFrame, uint32_t imageIndex, std::vector<MeshContainer> sceneMeshes, VkRenderPass raytracingRenderPass,
+	void recordCommandBuffer(VkExtent2D extent, uint32_t currentFrame, uint32_t imageIndex, const SceneDrawList &sceneDrawList, VkRenderPass raytracingRenderPass,
 							 VkFramebuffer raytracingFramebuffer, VkPipeline raytracingPipeline, VkPipelineLayout raytracingPipelineLayout, VkDescriptorSet *raytracingDescriptorSet);
-	void recordCommandBuffer(VkExtent2D extent, uint32_t currentFrame, uint32_t imageIndex, std::vector<MeshContainer> sceneMeshes,
+	void recordCommandBuffer(VkExtent2D extent, uint32_t currentFrame, uint32_t imageIndex, const SceneDrawList &sceneDrawList,
 							 VkRenderPass gBufferRenderPass, VkFramebuffer gBufferFramebuffer, VkPipeline gBufferPipeline, VkPipelineLayout gBufferPipelineLayout, VkDescriptorSet *gBufferDescriptorSet,
 							 VkRenderPass ssaoRenderPass, VkFramebuffer ssaoFramebuffer, VkPipeline ssaoPipeline, VkPipelineLayout ssaoPipelineLayout, VkDescriptorSet *ssaoDescriptorSet,
 							 VkRenderPass ssaoBlurRenderPass, VkFramebuffer ssaoBlurFramebuffer, VkPipeline ssaoBlurPipeline, VkPipelineLayout ssaoBlurPipelineLayout, VkDescriptorSet *ssaoBlurDescriptorSet,
 							 VkRenderPass surfelsCompositionRenderPass, VkFramebuffer surfelsCompositionFramebuffer, VkPipeline surfelsCompositionPipeline, VkPipelineLayout surfelsCompositionPipelineLayout, VkDescriptorSet *surfelsCompositionDescriptorSet,
 							 VkRenderPass shadowMappingRenderPass, VkFramebuffer shadowMappingFramebuffer, VkPipeline shadowMappingPipeline, VkPipelineLayout shadowMappingPipelineLayout, VkDescriptorSet *shadowMappingDescriptorSet,
 							 VkPipeline surfelsGenerationPipeline, VkPipelineLayout surfelsGenerationPipelineLayout, VkDescriptorSet *surfelsGenerationDescriptorSet, VkBuffer surfelStatsBuffer,
+							 VkPipeline surfelsGridCountPipeline, VkPipeline surfelsGridOffsetPipeline, VkPipeline surfelsGridBinningPipeline, VkPipeline surfelsIndirectArgsPipeline, VkPipeline surfelsLifecyclePipeline, VkPipelineLayout surfelsGridPipelineLayout, VkDescriptorSet *surfelsGridDescriptorSet, VkBuffer surfelGridBuffer,
 							 VkPipeline surfelsVisualizationPipeline, VkPipelineLayout surfelsVisualizationPipelineLayout, VkDescriptorSet *surfelsVisualizationDescriptorSet,
 							 VkPipeline surfelsRadianceCalculationPipeline, VkPipelineLayout surfelsRadianceCalculationPipelineLayout, VkDescriptorSet *surfelsRadianceCalculationDescriptorSet, VkBuffer surfelBuffer,
 							 VkPipeline surfelsIndirectLightingPipeline, VkPipelineLayout surfelsIndirectLightingPipelineLayout, VkDescriptorSet *surfelsIndirectLightingDescriptorSet,
-							 VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue, VkRenderPass surfelsVisualizationRenderPass, VkFramebuffer surfelsVisualizationFramebuffer,
-							 VkRenderPass surfelsIndirectLightingRenderPass, VkFramebuffer surfelsIndirectLightingFramebuffer);
+							 VkRenderPass surfelsVisualizationRenderPass, VkFramebuffer surfelsVisualizationFramebuffer,
+							 VkRenderPass surfelsIndirectLightingRenderPass, VkFramebuffer surfelsIndirectLightingFramebuffer,
+							 VkPipeline sceneCullingPipeline, VkPipelineLayout sceneCullingPipelineLayout, VkDescriptorSet *sceneCullingDescriptorSet,
+							 VkPipeline hiZPipeline, VkPipelineLayout hiZPipelineLayout, const std::vector<VkDescriptorSet> &hiZDescriptorSets,
+							 const SceneCullingBufferManager &sceneCullingResources, VkPipeline surfelsRayPriorityPipeline, VkPipeline surfelsRayBudgetPipeline,
+							 VkPipelineLayout surfelsRayBudgetPipelineLayout, VkPipeline surfelsRayEnqueuePipeline, VkBuffer surfelRayQueueBuffer,
+							 VkPipeline surfelsIrradianceVolumePipeline, VkPipelineLayout surfelsIrradianceVolumePipelineLayout, VkDescriptorSet *surfelsIrradianceVolumeDescriptorSet,
+							 VkPipeline surfelsIndirectLightingTiledPipeline, VkPipelineLayout surfelsIndirectLightingTiledPipelineLayout, VkImage indirectDiffuseImage);
 	void cleanup(VkDevice device);
 
-	void cleanupAuxiliarBuffers(VkDevice device);
-
 	VkCommandPool getCommandPool() const;
 	VkCommandBuffer *getCommandBuffer(uint32_t id);
 };
\ No newline at end of file
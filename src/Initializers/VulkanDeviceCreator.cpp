@@ -151,6 +151,7 @@ void VulkanDeviceCreator::createLogicalDevice(bool enableValidationLayers, const
     features12.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
     features12.descriptorIndexing = VK_TRUE;
     features12.bufferDeviceAddress = VK_TRUE;
+    features12.drawIndirectCount = VK_TRUE; // El G-Buffer lee de GPU el número de objetos que pasan el culling
 
     // Ray tracing
     VkPhysicalDeviceRayTracingPipelineFeaturesKHR enabledRayTracingPipelineFeatures{};
@@ -184,6 +185,11 @@ void VulkanDeviceCreator::createLogicalDevice(bool enableValidationLayers, const
     deviceFeatures.samplerAnisotropy = VK_TRUE;
     deviceFeatures.geometryShader = VK_TRUE;
     deviceFeatures.shaderInt16 = VK_TRUE;
+    // Dibujado indirecto de toda la escena con un solo comando, usando firstInstance como índice de los datos de dibujado
+    deviceFeatures.multiDrawIndirect = VK_TRUE;
+    deviceFeatures.drawIndirectFirstInstance = VK_TRUE;
+    // El volumen de irradiancia de los surfels escribe en la imagen de cada nivel del clipmap con un índice uniforme
+    deviceFeatures.shaderStorageImageArrayDynamicIndexing = VK_TRUE;
 
     VkPhysicalDeviceFeatures2 features2{};
     features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
@@ -12,10 +12,11 @@
 #include "CommandManager.h"
 #include "SynchronizationObjects.h"
 #include "RenderApplication.h"
+#include "Config.h"
 
 VulkanInitializer::VulkanInitializer()
 {
-    MAX_FRAMES_IN_FLIGHT = 1;
+    MAX_FRAMES_IN_FLIGHT = FRAMES_IN_FLIGHT;
 
     windowManager = WindowManager();
     swapChainManager = SwapChainManager();
@@ -44,34 +45,34 @@ void VulkanInitializer::recordCommandBuffer(VkExtent2D extent, uint32_t currentF
                                             VkPipelineLayout shadowMappingPipelineLayout, VkDescriptorSet shadowMappingDescriptorSet,
                                             VkRenderPass geometryRenderPass, VkFramebuffer geometryFramebuffer, VkPipeline geometryPipeline,
                                             VkPipelineLayout geometryPipelineLayout, VkDescriptorSet geometryDescriptorSet,
-                                            std::vector<MeshContainer> sceneMeshes, Camera camera)
+                                            const SceneDrawList &sceneDrawList, Camera camera)
 {
     commandManager.recordCommandBuffer(extent, currentFrame, imageIndex, shadowMappingRenderPass, shadowMappingFramebuffer, shadowMappingPipeline,
                                        shadowMappingPipelineLayout, &shadowMappingDescriptorSet, geometryRenderPass, geometryFramebuffer, geometryPipeline, geometryPipelineLayout,
-                                       &geometryDescriptorSet, sceneMeshes, camera);
+                                       &geometryDescriptorSet, sceneDrawList, camera);
 }
 
-void VulkanInitializer::recordCommandBuffer(VkExtent2D extent, uint32_t currentFrame, uint32_t imageIndex, std::vector<MeshContainer> sceneMeshes,
+void VulkanInitializer::recordCommandBuffer(VkExtent2D extent, uint32_t currentFrame, uint32_t imageIndex, const SceneDrawList &sceneDrawList,
                                             VkRenderPass gBufferRenderPass, VkFramebuffer gBufferFramebuffer, VkPipeline gBufferPipeline, VkPipelineLayout gBufferPipelineLayout, VkDescriptorSet gBufferDescriptorSet,
                                             VkRenderPass ssaoRenderPass, VkFramebuffer ssaoFramebuffer, VkPipeline ssaoPipeline, VkPipelineLayout ssaoPipelineLayout, VkDescriptorSet ssaoDescriptorSet,
                                             VkRenderPass ssaoBlurRenderPass, VkFramebuffer ssaoBlurFramebuffer, VkPipeline ssaoBlurPipeline, VkPipelineLayout ssaoBlurPipelineLayout, VkDescriptorSet ssaoBlurDescriptorSet,
                                             VkRenderPass ssaoCompositionRenderPass, VkFramebuffer ssaoCompositionFramebuffer, VkPipeline ssaoCompositionPipeline, VkPipelineLayout ssaoCompositionPipelineLayout, VkDescriptorSet ssaoCompositionDescriptorSet)
 {
-    commandManager.recordCommandBuffer(extent, currentFrame, imageIndex, sceneMeshes,
+    commandManager.recordCommandBuffer(extent, currentFrame, imageIndex, sceneDrawList,
                                        gBufferRenderPass, gBufferFramebuffer, gBufferPipeline, gBufferPipelineLayout, &gBufferDescriptorSet,
                                        ssaoRenderPass, ssaoFramebuffer, ssaoPipeline, ssaoPipelineLayout, &ssaoDescriptorSet,
                                        ssaoBlurRenderPass, ssaoBlurFramebuffer, ssaoBlurPipeline, ssaoBlurPipelineLayout, &ssaoBlurDescriptorSet,
                                        ssaoCompositionRenderPass, ssaoCompositionFramebuffer, ssaoCompositionPipeline, ssaoCompositionPipelineLayout, &ssaoCompositionDescriptorSet);
 }
 
-void VulkanInitializer::recordCommandBuffer(VkExtent2D extent, uint32_t currentFrame, uint32_t imageIndex, std::vector<MeshContainer> sceneMeshes,
+void VulkanInitializer::recordCommandBuffer(VkExtent2D extent, uint32_t currentFrame, uint32_t imageIndex, const SceneDrawList &sceneDrawList,
                                             VkRenderPass gBufferRenderPass, VkFramebuffer gBufferFramebuffer, VkPipeline gBufferPipeline, VkPipelineLayout gBufferPipelineLayout, VkDescriptorSet gBufferDescriptorSet,
                                             VkRenderPass ssaoRenderPass, VkFramebuffer ssaoFramebuffer, VkPipeline ssaoPipeline, VkPipelineLayout ssaoPipelineLayout, VkDescriptorSet ssaoDescriptorSet,
                                             VkRenderPass ssaoBlurRenderPass, VkFramebuffer ssaoBlurFramebuffer, VkPipeline ssaoBlurPipeline, VkPipelineLayout ssaoBlurPipelineLayout, VkDescriptorSet ssaoBlurDescriptorSet,
                                             VkRenderPass ssaoCompositionRenderPass, VkFramebuffer ssaoCompositionFramebuffer, VkPipeline ssaoCompositionPipeline, VkPipelineLayout ssaoCompositionPipelineLayout, VkDescriptorSet ssaoCompositionDescriptorSet,
                                             VkRenderPass shadowMappingRenderPass, VkFramebuffer shadowMappingFramebuffer, VkPipeline shadowMappingPipeline, VkPipelineLayout shadowMappingPipelineLayout, VkDescriptorSet shadowMappingDescriptorSet)
 {
-    commandManager.recordCommandBuffer(extent, currentFrame, imageIndex, sceneMeshes,
+    commandManager.recordCommandBuffer(extent, currentFrame, imageIndex, sceneDrawList,
                                        gBufferRenderPass, gBufferFramebuffer, gBufferPipeline, gBufferPipelineLayout, &gBufferDescriptorSet,
                                        ssaoRenderPass, ssaoFramebuffer, ssaoPipeline, ssaoPipelineLayout, &ssaoDescriptorSet,
                                        ssaoBlurRenderPass, ssaoBlurFramebuffer, ssaoBlurPipeline, ssaoBlurPipelineLayout, &ssaoBlurDescriptorSet,
@@ -79,37 +80,49 @@ void VulkanInitializer::recordCommandBuffer(VkExtent2D extent, uint32_t currentF
                                        shadowMappingRenderPass, shadowMappingFramebuffer, shadowMappingPipeline, shadowMappingPipelineLayout, &shadowMappingDescriptorSet);
 }
 
-void VulkanInitializer::recordCommandBuffer(VkExtent2D extent, uint32_t currentFrame, uint32_t imageIndex, std::vector<MeshContainer> sceneMeshes, VkRenderPass raytracingRenderPass,
+void VulkanInitializer::recordCommandBuffer(VkExtent2D extent, uint32_t currentFrame, uint32_t imageIndex, const SceneDrawList &sceneDrawList, VkRenderPass raytracingRenderPass,
                                             VkFramebuffer raytracingFramebuffer, VkPipeline raytracingPipeline, VkPipelineLayout raytracingPipelineLayout, VkDescriptorSet raytracingDescriptorSet)
 {
-    commandManager.recordCommandBuffer(extent, currentFrame, imageIndex, sceneMeshes, raytracingRenderPass,
+    commandManager.recordCommandBuffer(extent, currentFrame, imageIndex, sceneDrawList, raytracingRenderPass,
                                        raytracingFramebuffer, raytracingPipeline, raytracingPipelineLayout, &raytracingDescriptorSet);
 }
 
-void VulkanInitializer::recordCommandBuffer(VkExtent2D extent, uint32_t currentFrame, uint32_t imageIndex, std::vector<MeshContainer> sceneMeshes,
+void VulkanInitializer::recordCommandBuffer(VkExtent2D extent, uint32_t currentFrame, uint32_t imageIndex, const SceneDrawList &sceneDrawList,
                                             VkRenderPass gBufferRenderPass, VkFramebuffer gBufferFramebuffer, VkPipeline gBufferPipeline, VkPipelineLayout gBufferPipelineLayout, VkDescriptorSet gBufferDescriptorSet,
                                             VkRenderPass ssaoRenderPass, VkFramebuffer ssaoFramebuffer, VkPipeline ssaoPipeline, VkPipelineLayout ssaoPipelineLayout, VkDescriptorSet ssaoDescriptorSet,
                                             VkRenderPass ssaoBlurRenderPass, VkFramebuffer ssaoBlurFramebuffer, VkPipeline ssaoBlurPipeline, VkPipelineLayout ssaoBlurPipelineLayout, VkDescriptorSet ssaoBlurDescriptorSet,
                                             VkRenderPass surfelsCompositionRenderPass, VkFramebuffer surfelsCompositionFramebuffer, VkPipeline surfelsCompositionPipeline, VkPipelineLayout surfelsCompositionPipelineLayout, VkDescriptorSet surfelsCompositionDescriptorSet,
                                             VkRenderPass shadowMappingRenderPass, VkFramebuffer shadowMappingFramebuffer, VkPipeline shadowMappingPipeline, VkPipelineLayout shadowMappingPipelineLayout, VkDescriptorSet shadowMappingDescriptorSet,
                                             VkPipeline surfelsGenerationPipeline, VkPipelineLayout surfelsGenerationPipelineLayout, VkDescriptorSet surfelsGenerationDescriptorSet, VkBuffer surfelStatsBuffer,
+                                            VkPipeline surfelsGridCountPipeline, VkPipeline surfelsGridOffsetPipeline, VkPipeline surfelsGridBinningPipeline, VkPipeline surfelsIndirectArgsPipeline, VkPipeline surfelsLifecyclePipeline, VkPipelineLayout surfelsGridPipelineLayout, VkDescriptorSet surfelsGridDescriptorSet, VkBuffer surfelGridBuffer,
                                             VkPipeline surfelsVisualizationPipeline, VkPipelineLayout surfelsVisualizationPipelineLayout, VkDescriptorSet surfelsVisualizationDescriptorSet,
                                             VkPipeline surfelsRadianceCalculationPipeline, VkPipelineLayout surfelsRadianceCalculationPipelineLayout, VkDescriptorSet surfelsRadianceCalculationDescriptorSet, VkBuffer surfelBuffer,
                                             VkPipeline surfelsIndirectLightingPipeline, VkPipelineLayout surfelsIndirectLightingPipelineLayout, VkDescriptorSet surfelsIndirectLightingDescriptorSet,
-                                            VkRenderPass surfelsVisualizationRenderPass, VkFramebuffer surfelsVisualizationFramebuffer, VkRenderPass surfelsIndirectLightingRenderPass, VkFramebuffer surfelsIndirectLightingFramebuffer)
-{
-    commandManager.recordCommandBuffer(extent, currentFrame, imageIndex, sceneMeshes,
+                                            VkRenderPass surfelsVisualizationRenderPass, VkFramebuffer surfelsVisualizationFramebuffer, VkRenderPass surfelsIndirectLightingRenderPass, VkFramebuffer surfelsIndirectLightingFramebuffer,
+                                            VkPipeline sceneCullingPipeline, VkPipelineLayout sceneCullingPipelineLayout, VkDescriptorSet sceneCullingDescriptorSet,
+                                            VkPipeline hiZPipeline, VkPipelineLayout hiZPipelineLayout, const std::vector<VkDescriptorSet> &hiZDescriptorSets,
+                                            const SceneCullingBufferManager &sceneCullingResources, VkPipeline surfelsRayPriorityPipeline, VkPipeline surfelsRayBudgetPipeline,
+                                            VkPipelineLayout surfelsRayBudgetPipelineLayout, VkPipeline surfelsRayEnqueuePipeline, VkBuffer surfelRayQueueBuffer,
+                                            VkPipeline surfelsIrradianceVolumePipeline, VkPipelineLayout surfelsIrradianceVolumePipelineLayout, VkDescriptorSet surfelsIrradianceVolumeDescriptorSet,
+                                            VkPipeline surfelsIndirectLightingTiledPipeline, VkPipelineLayout surfelsIndirectLightingTiledPipelineLayout, VkImage indirectDiffuseImage)
+{
+    commandManager.recordCommandBuffer(extent, currentFrame, imageIndex, sceneDrawList,
                                        gBufferRenderPass, gBufferFramebuffer, gBufferPipeline, gBufferPipelineLayout, &gBufferDescriptorSet,
                                        ssaoRenderPass, ssaoFramebuffer, ssaoPipeline, ssaoPipelineLayout, &ssaoDescriptorSet,
                                        ssaoBlurRenderPass, ssaoBlurFramebuffer, ssaoBlurPipeline, ssaoBlurPipelineLayout, &ssaoBlurDescriptorSet,
                                        surfelsCompositionRenderPass, surfelsCompositionFramebuffer, surfelsCompositionPipeline, surfelsCompositionPipelineLayout, &surfelsCompositionDescriptorSet,
                                        shadowMappingRenderPass, shadowMappingFramebuffer, shadowMappingPipeline, shadowMappingPipelineLayout, &shadowMappingDescriptorSet,
                                        surfelsGenerationPipeline, surfelsGenerationPipelineLayout, &surfelsGenerationDescriptorSet, surfelStatsBuffer,
+                                       surfelsGridCountPipeline, surfelsGridOffsetPipeline, surfelsGridBinningPipeline, surfelsIndirectArgsPipeline, surfelsLifecyclePipeline, surfelsGridPipelineLayout, &surfelsGridDescriptorSet, surfelGridBuffer,
                                        surfelsVisualizationPipeline, surfelsVisualizationPipelineLayout, &surfelsVisualizationDescriptorSet,
                                        surfelsRadianceCalculationPipeline, surfelsRadianceCalculationPipelineLayout, &surfelsRadianceCalculationDescriptorSet, surfelBuffer,
                                        surfelsIndirectLightingPipeline, surfelsIndirectLightingPipelineLayout, &surfelsIndirectLightingDescriptorSet,
-                                       vkDeviceCreator.getVkDevice(), vkDeviceCreator.getVkPhysicalDevice(), commandManager.getCommandPool(), vkDeviceCreator.getVkGraphicsQueue(),
-                                       surfelsVisualizationRenderPass, surfelsVisualizationFramebuffer, surfelsIndirectLightingRenderPass, surfelsIndirectLightingFramebuffer);
+                                       surfelsVisualizationRenderPass, surfelsVisualizationFramebuffer, surfelsIndirectLightingRenderPass, surfelsIndirectLightingFramebuffer,
+                                       sceneCullingPipeline, sceneCullingPipelineLayout, &sceneCullingDescriptorSet,
+                                       hiZPipeline, hiZPipelineLayout, hiZDescriptorSets, sceneCullingResources,
+                                       surfelsRayPriorityPipeline, surfelsRayBudgetPipeline, surfelsRayBudgetPipelineLayout, surfelsRayEnqueuePipeline, surfelRayQueueBuffer,
+                                       surfelsIrradianceVolumePipeline, surfelsIrradianceVolumePipelineLayout, &surfelsIrradianceVolumeDescriptorSet,
+                                       surfelsIndirectLightingTiledPipeline, surfelsIndirectLightingTiledPipelineLayout, indirectDiffuseImage);
 }
 
 void VulkanInitializer::resetFramebufferResized()
@@ -117,11 +130,6 @@ void VulkanInitializer::resetFramebufferResized()
     windowManager.resetFramebufferResized();
 }
 
-void VulkanInitializer::cleanSurfelsAuxiliarBuffer()
-{
-    commandManager.cleanupAuxiliarBuffers(vkDeviceCreator.getVkDevice());
-}
-
 VkDevice VulkanInitializer::getVkDevice()
 {
     return vkDeviceCreator.getVkDevice();
@@ -238,8 +246,3 @@ void VulkanInitializer::cleanupSynchronizacionCommandObjects()
     syncObjects.cleanup(vkDeviceCreator.getVkDevice());
     commandManager.cleanup(vkDeviceCreator.getVkDevice());
 }
-
-void VulkanInitializer::cleanupAuxiliarBuffers()
-{
-    commandManager.cleanupAuxiliarBuffers(vkDeviceCreator.getVkDevice());
-}
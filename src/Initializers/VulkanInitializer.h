@@ -47,36 +47,41 @@ public:
                              VkPipelineLayout shadowMappingPipelineLayout, VkDescriptorSet shadowMappingDescriptorSet,
                              VkRenderPass geometryRenderPass, VkFramebuffer geometryFramebuffer, VkPipeline geometryPipeline,
                              VkPipelineLayout geometryPipelineLayout, VkDescriptorSet geometryDescriptorSet,
-                             std::vector<MeshContainer> sceneMeshes, Camera camera);
-    void recordCommandBuffer(VkExtent2D extent, uint32_t currentFrame, uint32_t imageIndex, std::vector<MeshContainer> sceneMeshes,
+                             const SceneDrawList &sceneDrawList, Camera camera);
+    void recordCommandBuffer(VkExtent2D extent, uint32_t currentFrame, uint32_t imageIndex, const SceneDrawList &sceneDrawList,
                              VkRenderPass gBufferRenderPass, VkFramebuffer gBufferFramebuffer, VkPipeline gBufferPipeline, VkPipelineLayout gBufferPipelineLayout, VkDescriptorSet gBufferDescriptorSet,
                              VkRenderPass ssaoRenderPass, VkFramebuffer ssaoFramebuffer, VkPipeline ssaoPipeline, VkPipelineLayout ssaoPipelineLayout, VkDescriptorSet ssaoDescriptorSet,
                              VkRenderPass ssaoBlurRenderPass, VkFramebuffer ssaoBlurFramebuffer, VkPipeline ssaoBlurPipeline, VkPipelineLayout ssaoBlurPipelineLayout, VkDescriptorSet ssoBlurDescriptorSet,
                              VkRenderPass ssaoCompositionRenderPass, VkFramebuffer ssaoCompositionFramebuffer, VkPipeline ssaoCompositionPipeline, VkPipelineLayout ssaoCompositionPipelineLayout, VkDescriptorSet ssaoCompositionDescriptorSet);
-    void recordCommandBuffer(VkExtent2D extent, uint32_t currentFrame, uint32_t imageIndex, std::vector<MeshContainer> sceneMeshes,
+    void recordCommandBuffer(VkExtent2D extent, uint32_t currentFrame, uint32_t imageIndex, const SceneDrawList &sceneDrawList,
                              VkRenderPass gBufferRenderPass, VkFramebuffer gBufferFramebuffer, VkPipeline gBufferPipeline, VkPipelineLayout gBufferPipelineLayout, VkDescriptorSet gBufferDescriptorSet,
                              VkRenderPass ssaoRenderPass, VkFramebuffer ssaoFramebuffer, VkPipeline ssaoPipeline, VkPipelineLayout ssaoPipelineLayout, VkDescriptorSet ssaoDescriptorSet,
                              VkRenderPass ssaoBlurRenderPass, VkFramebuffer ssaoBlurFramebuffer, VkPipeline ssaoBlurPipeline, VkPipelineLayout ssaoBlurPipelineLayout, VkDescriptorSet ssaoBlurDescriptorSet,
                              VkRenderPass ssaoCompositionRenderPass, VkFramebuffer ssaoCompositionFramebuffer, VkPipeline ssaoCompositionPipeline, VkPipelineLayout ssaoCompositionPipelineLayout, VkDescriptorSet ssaoCompositionDescriptorSet,
                              VkRenderPass shadowMappingRenderPass, VkFramebuffer shadowMappingFramebuffer, VkPipeline shadowMappingPipeline, VkPipelineLayout shadowMappingPipelineLayout, VkDescriptorSet shadowMappingDescriptorSet);
-    void recordCommandBuffer(VkExtent2D extent, uint32_t currentFrame, uint32_t imageIndex, std::vector<MeshContainer> sceneMeshes, VkRenderPass raytracingRenderPass,
+    void recordCommandBuffer(VkExtent2D extent, uint32_t currentFrame, uint32_t imageIndex, const SceneDrawList &sceneDrawList, VkRenderPass raytracingRenderPass,
                              VkFramebuffer raytracingFramebuffer, VkPipeline raytracingPipeline, VkPipelineLayout raytracingPipelineLayout, VkDescriptorSet raytracingDescriptorSet);
-    void recordCommandBuffer(VkExtent2D extent, uint32_t currentFrame, uint32_t imageIndex, std::vector<MeshContainer> sceneMeshes,
+    void recordCommandBuffer(VkExtent2D extent, uint32_t currentFrame, uint32_t imageIndex, const SceneDrawList &sceneDrawList,
                              VkRenderPass gBufferRenderPass, VkFramebuffer gBufferFramebuffer, VkPipeline gBufferPipeline, VkPipelineLayout gBufferPipelineLayout, VkDescriptorSet gBufferDescriptorSet,
                              VkRenderPass ssaoRenderPass, VkFramebuffer ssaoFramebuffer, VkPipeline ssaoPipeline, VkPipelineLayout ssaoPipelineLayout, VkDescriptorSet ssaoDescriptorSet,
                              VkRenderPass ssaoBlurRenderPass, VkFramebuffer ssaoBlurFramebuffer, VkPipeline ssaoBlurPipeline, VkPipelineLayout ssaoBlurPipelineLayout, VkDescriptorSet ssaoBlurDescriptorSet,
                              VkRenderPass surfelsCompositionRenderPass, VkFramebuffer surfelsCompositionFramebuffer, VkPipeline surfelsCompositionPipeline, VkPipelineLayout surfelsCompositionPipelineLayout, VkDescriptorSet surfelsCompositionDescriptorSet,
                              VkRenderPass shadowMappingRenderPass, VkFramebuffer shadowMappingFramebuffer, VkPipeline shadowMappingPipeline, VkPipelineLayout shadowMappingPipelineLayout, VkDescriptorSet shadowMappingDescriptorSet,
                              VkPipeline surfelsGenerationPipeline, VkPipelineLayout surfelsGenerationPipelineLayout, VkDescriptorSet surfelsGenerationDescriptorSet, VkBuffer surfelStatsBuffer,
+                             VkPipeline surfelsGridCountPipeline, VkPipeline surfelsGridOffsetPipeline, VkPipeline surfelsGridBinningPipeline, VkPipeline surfelsIndirectArgsPipeline, VkPipeline surfelsLifecyclePipeline, VkPipelineLayout surfelsGridPipelineLayout, VkDescriptorSet surfelsGridDescriptorSet, VkBuffer surfelGridBuffer,
                              VkPipeline surfelsVisualizationPipeline, VkPipelineLayout surfelsVisualizationPipelineLayout, VkDescriptorSet surfelsVisualizationDescriptorSet,
                              VkPipeline surfelsRadianceCalculationPipeline, VkPipelineLayout surfelsRadianceCalculationPipelineLayout, VkDescriptorSet surfelsRadianceCalculationDescriptorSet, VkBuffer surfelBuffer,
                              VkPipeline surfelsIndirectLightingPipeline, VkPipelineLayout surfelsIndirectLightingPipelineLayout, VkDescriptorSet surfelsIndirectLightingDescriptorSet,
-                             VkRenderPass surfelsVisualizationRenderPass, VkFramebuffer surfelsVisualizationFramebuffer, VkRenderPass surfelsIndirectLightingRenderPass, VkFramebuffer surfelsIndirectLightingFramebuffer);
+                             VkRenderPass surfelsVisualizationRenderPass, VkFramebuffer surfelsVisualizationFramebuffer, VkRenderPass surfelsIndirectLightingRenderPass, VkFramebuffer surfelsIndirectLightingFramebuffer,
+                             VkPipeline sceneCullingPipeline, VkPipelineLayout sceneCullingPipelineLayout, VkDescriptorSet sceneCullingDescriptorSet,
+                             VkPipeline hiZPipeline, VkPipelineLayout hiZPipelineLayout, const std::vector<VkDescriptorSet> &hiZDescriptorSets,
+                             const SceneCullingBufferManager &sceneCullingResources, VkPipeline surfelsRayPriorityPipeline, VkPipeline surfelsRayBudgetPipeline,
+                             VkPipelineLayout surfelsRayBudgetPipelineLayout, VkPipeline surfelsRayEnqueuePipeline, VkBuffer surfelRayQueueBuffer,
+                             VkPipeline surfelsIrradianceVolumePipeline, VkPipelineLayout surfelsIrradianceVolumePipelineLayout, VkDescriptorSet surfelsIrradianceVolumeDescriptorSet,
+                             VkPipeline surfelsIndirectLightingTiledPipeline, VkPipelineLayout surfelsIndirectLightingTiledPipelineLayout, VkImage indirectDiffuseImage);
 
     void resetFramebufferResized();
 
-    void cleanSurfelsAuxiliarBuffer();
-
     VkDevice getVkDevice();
     VkPhysicalDevice getVkPhysicalDevice();
     VkSurfaceKHR getVkSurface();
@@ -106,5 +111,4 @@ public:
     void cleanupSwapChain(DepthBuffer depthBufferCreator, std::vector<VkFramebuffer> swapChainFramebuffers);
     void cleanupSwapChain();
     void cleanupSynchronizacionCommandObjects();
-    void cleanupAuxiliarBuffers();
 };
\ No newline at end of file
@@ -115,7 +115,7 @@ void IndirectDiffuseShadingPipeline::createGraphicsPipeline(VkDevice device, VkE
     vertShaderStageInfo.module = vertShaderModule;
     vertShaderStageInfo.pName = "main";
 
-    auto fragmentShaderCode = ShaderStagesCreator::readFile(RESOURCES_PATH "shaders/indirect_diffuse_shading.spv");
+    auto fragmentShaderCode = ShaderStagesCreator::readFile(RESOURCES_PATH "shaders/indirect_diffuse_volume.spv");
     VkShaderModule fragmentShaderModule = ShaderStagesCreator::createShaderModule(fragmentShaderCode, device);
     VkPipelineShaderStageCreateInfo fragmentShaderStageInfo{};
     fragmentShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -50,7 +50,8 @@ void PipelineManager::createPipelines(VkDevice device, VkExtent2D swapChainExten
                                       VkRenderPass ssaoBlurRenderPass, VkDescriptorSetLayout surfelsCompositionDescriptorSetLayout, VkRenderPass surfelsCompositionRenderPass,
                                       VkDescriptorSetLayout shadowMappingDescriptorSetLayout, VkRenderPass shadowMappingRenderPass, VkDescriptorSetLayout surfelsGenerationDescriptorSetLayout,
                                       VkRenderPass surfelsVisualizationRenderPass, VkDescriptorSetLayout surfelsVisualizationDescriptorSetLayout, VkDescriptorSetLayout surfelsRadianceCalculationDescriptorSetLayout,
-                                      VkRenderPass surfelsIndirectLightingRenderPass, VkDescriptorSetLayout surfelsIndirectLightingDescriptorSetLayout)
+                                      VkRenderPass surfelsIndirectLightingRenderPass, VkDescriptorSetLayout surfelsIndirectLightingDescriptorSetLayout, VkDescriptorSetLayout surfelsGridDescriptorSetLayout,
+                                      VkDescriptorSetLayout sceneCullingDescriptorSetLayout, VkDescriptorSetLayout hiZDescriptorSetLayout, VkDescriptorSetLayout surfelsIrradianceVolumeDescriptorSetLayout)
 {
     shadowMappingPipeline.createGraphicsPipeline(device, swapChainExtent, shadowMappingDescriptorSetLayout, shadowMappingRenderPass);
     gBufferPipeline.createGraphicsPipeline(device, swapChainExtent, gBufferDescriptorSetLayout, gBufferRenderPass);
@@ -58,10 +59,23 @@ void PipelineManager::createPipelines(VkDevice device, VkExtent2D swapChainExten
     ssaoBlurPipeline.createGraphicsPipeline(device, swapChainExtent, ssaoBlurDescriptorSetLayout, ssaoBlurRenderPass);
     surfelsCompositionPipeline.createGraphicsPipeline(device, swapChainExtent, surfelsCompositionDescriptorSetLayout, surfelsCompositionRenderPass);
 
+    surfelsGridCountPipeline.createGraphicsPipeline(device, surfelsGridDescriptorSetLayout);
+    surfelsGridOffsetPipeline.createGraphicsPipeline(device, surfelsGridDescriptorSetLayout);
+    surfelsGridBinningPipeline.createGraphicsPipeline(device, surfelsGridDescriptorSetLayout);
+    surfelsIndirectArgsPipeline.createGraphicsPipeline(device, surfelsGridDescriptorSetLayout);
+    surfelsLifecyclePipeline.createGraphicsPipeline(device, surfelsGridDescriptorSetLayout);
+    surfelsRayPriorityPipeline.createGraphicsPipeline(device, surfelsGridDescriptorSetLayout);
+    surfelsRayBudgetPipeline.createGraphicsPipeline(device, surfelsGridDescriptorSetLayout);
+    surfelsRayEnqueuePipeline.createGraphicsPipeline(device, surfelsGridDescriptorSetLayout);
     surfelsGenerationPipeline.createGraphicsPipeline(device, surfelsGenerationDescriptorSetLayout);
     surfelsVisualizationPipeline.createGraphicsPipeline(device, swapChainExtent, surfelsVisualizationDescriptorSetLayout, surfelsVisualizationRenderPass);
     surfelsRadianceCalculationPipeline.createGraphicsPipeline(device, surfelsRadianceCalculationDescriptorSetLayout);
+    surfelsIrradianceVolumePipeline.createGraphicsPipeline(device, surfelsIrradianceVolumeDescriptorSetLayout);
     surfelsIndirectLightingPipeline.createGraphicsPipeline(device, swapChainExtent, surfelsIndirectLightingDescriptorSetLayout, surfelsIndirectLightingRenderPass);
+    surfelsIndirectLightingTiledPipeline.createGraphicsPipeline(device, surfelsIndirectLightingDescriptorSetLayout);
+
+    sceneCullingPipeline.createGraphicsPipeline(device, sceneCullingDescriptorSetLayout);
+    hiZPipeline.createGraphicsPipeline(device, hiZDescriptorSetLayout);
 }
 
 void PipelineManager::cleanup(VkDevice device)
@@ -97,10 +111,22 @@ void PipelineManager::cleanup(VkDevice device)
         ssaoPipeline.cleanup(device);
         ssaoBlurPipeline.cleanup(device);
         surfelsCompositionPipeline.cleanup(device);
+        surfelsGridCountPipeline.cleanup(device);
+        surfelsGridOffsetPipeline.cleanup(device);
+        surfelsGridBinningPipeline.cleanup(device);
+        surfelsIndirectArgsPipeline.cleanup(device);
+        surfelsLifecyclePipeline.cleanup(device);
+        surfelsRayPriorityPipeline.cleanup(device);
+        surfelsRayBudgetPipeline.cleanup(device);
+        surfelsRayEnqueuePipeline.cleanup(device);
         surfelsGenerationPipeline.cleanup(device);
         surfelsVisualizationPipeline.cleanup(device);
         surfelsRadianceCalculationPipeline.cleanup(device);
+        surfelsIrradianceVolumePipeline.cleanup(device);
         surfelsIndirectLightingPipeline.cleanup(device);
+        surfelsIndirectLightingTiledPipeline.cleanup(device);
+        sceneCullingPipeline.cleanup(device);
+        hiZPipeline.cleanup(device);
     }
 }
 
@@ -184,6 +210,57 @@ VkPipeline PipelineManager::getSurfelsGenerationPipeline()
     return surfelsGenerationPipeline.getGraphicsPipeline();
 }
 
+VkPipelineLayout PipelineManager::getSurfelsGridPipelineLayout()
+{
+    // Los tres pipelines del grid comparten el mismo layout de descriptores
+    return surfelsGridCountPipeline.getPipelineLayout();
+}
+
+VkPipeline PipelineManager::getSurfelsGridCountPipeline()
+{
+    return surfelsGridCountPipeline.getGraphicsPipeline();
+}
+
+VkPipeline PipelineManager::getSurfelsGridOffsetPipeline()
+{
+    return surfelsGridOffsetPipeline.getGraphicsPipeline();
+}
+
+VkPipeline PipelineManager::getSurfelsGridBinningPipeline()
+{
+    return surfelsGridBinningPipeline.getGraphicsPipeline();
+}
+
+VkPipeline PipelineManager::getSurfelsIndirectArgsPipeline()
+{
+    return surfelsIndirectArgsPipeline.getGraphicsPipeline();
+}
+
+VkPipeline PipelineManager::getSurfelsLifecyclePipeline()
+{
+    return surfelsLifecyclePipeline.getGraphicsPipeline();
+}
+
+VkPipeline PipelineManager::getSurfelsRayPriorityPipeline()
+{
+    return surfelsRayPriorityPipeline.getGraphicsPipeline();
+}
+
+VkPipelineLayout PipelineManager::getSurfelsRayBudgetPipelineLayout()
+{
+    return surfelsRayBudgetPipeline.getPipelineLayout();
+}
+
+VkPipeline PipelineManager::getSurfelsRayBudgetPipeline()
+{
+    return surfelsRayBudgetPipeline.getGraphicsPipeline();
+}
+
+VkPipeline PipelineManager::getSurfelsRayEnqueuePipeline()
+{
+    return surfelsRayEnqueuePipeline.getGraphicsPipeline();
+}
+
 VkPipelineLayout PipelineManager::getSurfelsVisualizationPipelineLayout()
 {
     return surfelsVisualizationPipeline.getPipelineLayout();
@@ -204,6 +281,16 @@ VkPipeline PipelineManager::getSurfelsRadianceCalculationPipeline()
     return surfelsRadianceCalculationPipeline.getGraphicsPipeline();
 }
 
+VkPipelineLayout PipelineManager::getSurfelsIrradianceVolumePipelineLayout()
+{
+    return surfelsIrradianceVolumePipeline.getPipelineLayout();
+}
+
+VkPipeline PipelineManager::getSurfelsIrradianceVolumePipeline()
+{
+    return surfelsIrradianceVolumePipeline.getGraphicsPipeline();
+}
+
 VkPipelineLayout PipelineManager::getSurfelsIndirectLightingPipelineLayout()
 {
     return surfelsIndirectLightingPipeline.getPipelineLayout();
@@ -214,6 +301,16 @@ VkPipeline PipelineManager::getSurfelsIndirectLightingPipeline()
     return surfelsIndirectLightingPipeline.getGraphicsPipeline();
 }
 
+VkPipelineLayout PipelineManager::getSurfelsIndirectLightingTiledPipelineLayout()
+{
+    return surfelsIndirectLightingTiledPipeline.getPipelineLayout();
+}
+
+VkPipeline PipelineManager::getSurfelsIndirectLightingTiledPipeline()
+{
+    return surfelsIndirectLightingTiledPipeline.getGraphicsPipeline();
+}
+
 VkPipelineLayout PipelineManager::getSurfelsCompositionPipelineLayout()
 {
     return surfelsCompositionPipeline.getPipelineLayout();
@@ -222,4 +319,24 @@ VkPipelineLayout PipelineManager::getSurfelsCompositionPipelineLayout()
 VkPipeline PipelineManager::getSurfelsCompositionPipeline()
 {
     return surfelsCompositionPipeline.getGraphicsPipeline();
+}
+
+VkPipelineLayout PipelineManager::getSceneCullingPipelineLayout()
+{
+    return sceneCullingPipeline.getPipelineLayout();
+}
+
+VkPipeline PipelineManager::getSceneCullingPipeline()
+{
+    return sceneCullingPipeline.getGraphicsPipeline();
+}
+
+VkPipelineLayout PipelineManager::getHiZPipelineLayout()
+{
+    return hiZPipeline.getPipelineLayout();
+}
+
+VkPipeline PipelineManager::getHiZPipeline()
+{
+    return hiZPipeline.getGraphicsPipeline();
 }
\ No newline at end of file
@@ -10,10 +10,22 @@
 #include "SSAOCompositionPipeline.h"
 #include "RaytracingPipeline.h"
 #include "SurfelsGenerationPipeline.h"
+#include "SurfelsGridCountPipeline.h"
+#include "SurfelsGridOffsetPipeline.h"
+#include "SurfelsGridBinningPipeline.h"
+#include "SurfelsIndirectArgsPipeline.h"
+#include "SurfelsLifecyclePipeline.h"
+#include "SurfelsRayPriorityPipeline.h"
+#include "SurfelsRayBudgetPipeline.h"
+#include "SurfelsRayEnqueuePipeline.h"
 #include "SurfelsVisualizationPipeline.h"
 #include "SurfelsRadianceCalculationPipeline.h"
+#include "SurfelsIrradianceVolumePipeline.h"
 #include "IndirectDiffuseShadingPipeline.h"
+#include "IndirectDiffuseTiledPipeline.h"
 #include "SurfelsCompositionPipeline.h"
+#include "SceneCullingPipeline.h"
+#include "HiZPipeline.h"
 
 #include <GLFW/glfw3.h>
 #include <GLFW/glfw3native.h>
@@ -36,11 +48,24 @@ private:
     RaytracingPipeline raytracingPipeline;
 
     SurfelsGenerationPipeline surfelsGenerationPipeline;
+    SurfelsGridCountPipeline surfelsGridCountPipeline;
+    SurfelsGridOffsetPipeline surfelsGridOffsetPipeline;
+    SurfelsGridBinningPipeline surfelsGridBinningPipeline;
+    SurfelsIndirectArgsPipeline surfelsIndirectArgsPipeline;
+    SurfelsLifecyclePipeline surfelsLifecyclePipeline;
+    SurfelsRayPriorityPipeline surfelsRayPriorityPipeline;
+    SurfelsRayBudgetPipeline surfelsRayBudgetPipeline;
+    SurfelsRayEnqueuePipeline surfelsRayEnqueuePipeline;
     SurfelsVisualizationPipeline surfelsVisualizationPipeline;
     SurfelsRadianceCalculationPipeline surfelsRadianceCalculationPipeline;
+    SurfelsIrradianceVolumePipeline surfelsIrradianceVolumePipeline;
     IndirectDiffuseShadingPipeline surfelsIndirectLightingPipeline;
+    IndirectDiffuseTiledPipeline surfelsIndirectLightingTiledPipeline;
     SurfelsCompositionPipeline surfelsCompositionPipeline;
 
+    SceneCullingPipeline sceneCullingPipeline;
+    HiZPipeline hiZPipeline;
+
 public:
     void createPipelines(VkDevice device, VkExtent2D swapChainExtent, VkDescriptorSetLayout geometryDescriptorSetLayout, VkRenderPass geometryRenderPass,
                          VkDescriptorSetLayout shadowMappingDescriptorSetLayout, VkRenderPass shadowMappingRenderPass);
@@ -57,7 +82,8 @@ public:
                          VkRenderPass ssaoBlurRenderPass, VkDescriptorSetLayout surfelsCompositionDescriptorSetLayout, VkRenderPass surfelsCompositionRenderPass,
                          VkDescriptorSetLayout shadowMappingDescriptorSetLayout, VkRenderPass shadowMappingRenderPass, VkDescriptorSetLayout surfelsGenerationDescriptorSetLayout,
                          VkRenderPass surfelsVisualizationRenderPass, VkDescriptorSetLayout surfelsVisualizationDescriptorSetLayout, VkDescriptorSetLayout surfelsRadianceCalculationDescriptorSetLayout,
-                         VkRenderPass surfelsIndirectLightingRenderPass, VkDescriptorSetLayout surfelsIndirectLightingDescriptorSetLayout);
+                         VkRenderPass surfelsIndirectLightingRenderPass, VkDescriptorSetLayout surfelsIndirectLightingDescriptorSetLayout, VkDescriptorSetLayout surfelsGridDescriptorSetLayout,
+                         VkDescriptorSetLayout sceneCullingDescriptorSetLayout, VkDescriptorSetLayout hiZDescriptorSetLayout, VkDescriptorSetLayout surfelsIrradianceVolumeDescriptorSetLayout);
 
     void cleanup(VkDevice device);
 
@@ -80,14 +106,32 @@ public:
 
     VkPipelineLayout getSurfelsGenerationPipelineLayout();
     VkPipeline getSurfelsGenerationPipeline();
+    VkPipelineLayout getSurfelsGridPipelineLayout();
+    VkPipeline getSurfelsGridCountPipeline();
+    VkPipeline getSurfelsGridOffsetPipeline();
+    VkPipeline getSurfelsGridBinningPipeline();
+    VkPipeline getSurfelsIndirectArgsPipeline();
+    VkPipeline getSurfelsLifecyclePipeline();
+    VkPipeline getSurfelsRayPriorityPipeline();
+    VkPipelineLayout getSurfelsRayBudgetPipelineLayout();
+    VkPipeline getSurfelsRayBudgetPipeline();
+    VkPipeline getSurfelsRayEnqueuePipeline();
     VkPipelineLayout getSurfelsVisualizationPipelineLayout();
     VkPipeline getSurfelsVisualizationPipeline();
     VkPipelineLayout getSurfelsRadianceCalculationPipelineLayout();
     VkPipeline getSurfelsRadianceCalculationPipeline();
+    VkPipelineLayout getSurfelsIrradianceVolumePipelineLayout();
+    VkPipeline getSurfelsIrradianceVolumePipeline();
     VkPipelineLayout getSurfelsIndirectLightingPipelineLayout();
     VkPipeline getSurfelsIndirectLightingPipeline();
+    VkPipelineLayout getSurfelsIndirectLightingTiledPipelineLayout();
+    VkPipeline getSurfelsIndirectLightingTiledPipeline();
     VkPipelineLayout getSurfelsCompositionPipelineLayout();
     VkPipeline getSurfelsCompositionPipeline();
+    VkPipelineLayout getSceneCullingPipelineLayout();
+    VkPipeline getSceneCullingPipeline();
+    VkPipelineLayout getHiZPipelineLayout();
+    VkPipeline getHiZPipeline();
     VkPipelineLayout getHorizontalBlurPipelineLayout();
     VkPipeline getHorizontalBlurPipeline();
     VkPipelineLayout getVerticalBlurPipelineLayout();
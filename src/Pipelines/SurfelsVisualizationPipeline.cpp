@@ -44,23 +44,12 @@ void SurfelsVisualizationPipeline::createGraphicsPipeline(VkDevice device, VkExt
     inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
     inputAssembly.primitiveRestartEnable = VK_FALSE;
 
-    // Se especifica el Input de Vértices (en este caso de los datos para cada punto)
-    VkVertexInputBindingDescription bindingDesc{};
-    bindingDesc.binding = 0;
-    bindingDesc.stride = sizeof(SimpleSurfel);
-    bindingDesc.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-
-    std::array<VkVertexInputAttributeDescription, 4> attribs{};
-    attribs[0] = {0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(SimpleSurfel, position)};
-    attribs[1] = {1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(SimpleSurfel, normal)};
-    attribs[2] = {2, 0, VK_FORMAT_R32_SFLOAT, offsetof(SimpleSurfel, radius)};
-    attribs[3] = {3, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(SimpleSurfel, color)};
-
+    // No hay Input de Vértices: el vertex shader lee cada surfel del buffer de surfels a partir de gl_VertexIndex
     VkPipelineVertexInputStateCreateInfo vertexInputInfo{VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO};
-    vertexInputInfo.vertexBindingDescriptionCount = 1;
-    vertexInputInfo.pVertexBindingDescriptions = &bindingDesc;
-    vertexInputInfo.vertexAttributeDescriptionCount = (uint32_t)attribs.size();
-    vertexInputInfo.pVertexAttributeDescriptions = attribs.data();
+    vertexInputInfo.vertexBindingDescriptionCount = 0;
+    vertexInputInfo.pVertexBindingDescriptions = nullptr;
+    vertexInputInfo.vertexAttributeDescriptionCount = 0;
+    vertexInputInfo.pVertexAttributeDescriptions = nullptr;
 
     VkPipelineRasterizationStateCreateInfo rasterizer{VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO};
     rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
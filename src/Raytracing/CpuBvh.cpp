@@ -0,0 +1,621 @@
+#include "CpuBvh.h"
+
+#include <xmmintrin.h>
+
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+	// Coste de recorrer un nodo relativo al de intersecar un triángulo, para comparar dividir con crear una hoja
+	const float SAH_TRAVERSAL_COST = 1.0f;
+	// Triángulos que procesa cada lote del binning en paralelo
+	const uint32_t PARALLEL_BINNING_BATCH = 16384;
+	const uint32_t TRIANGLE_BATCH_SIZE = 16384;
+	// Profundidad máxima de la pila del recorrido, suficiente para árboles de 4 hijos muy desequilibrados
+	const uint32_t TRAVERSAL_STACK_SIZE = 256;
+	// Las direcciones con alguna componente nula se desvían lo justo para que su inversa sea finita
+	const float MIN_DIRECTION_COMPONENT = 1e-20f;
+
+	struct Bin
+	{
+		glm::vec3 boundsMin = glm::vec3(std::numeric_limits<float>::max());
+		glm::vec3 boundsMax = glm::vec3(-std::numeric_limits<float>::max());
+		uint32_t count = 0;
+
+		void grow(const glm::vec3 &otherMin, const glm::vec3 &otherMax)
+		{
+			boundsMin = glm::min(boundsMin, otherMin);
+			boundsMax = glm::max(boundsMax, otherMax);
+		}
+	};
+
+	// Cubos de los tres ejes
+	struct BinSet
+	{
+		Bin bins[3][CpuBvh::SAH_BINS];
+	};
+
+	float surfaceArea(const glm::vec3 &boundsMin, const glm::vec3 &boundsMax)
+	{
+		glm::vec3 extent = glm::max(boundsMax - boundsMin, glm::vec3(0.0f));
+		return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+	}
+
+	uint32_t binIndex(float centroid, float centroidMin, float scale)
+	{
+		int bin = static_cast<int>((centroid - centroidMin) * scale);
+		return static_cast<uint32_t>(std::clamp(bin, 0, static_cast<int>(CpuBvh::SAH_BINS) - 1));
+	}
+}
+
+void CpuBvh::build(const std::vector<glm::vec3> &vertices, const std::vector<glm::uvec3> &triangles, ThreadPool &threadPool)
+{
+	nodes.clear();
+	bvhTriangles.clear();
+
+	const uint32_t numTriangles = static_cast<uint32_t>(triangles.size());
+	if (numTriangles == 0)
+	{
+		return;
+	}
+	if (numTriangles >= (LEAF_FLAG >> LEAF_COUNT_BITS))
+	{
+		throw std::runtime_error("failed to build CPU BVH: too many triangles!");
+	}
+
+	// Caja y centroide de cada triángulo
+	std::vector<BuildPrimitive> primitives(numTriangles);
+	threadPool.parallelFor(numTriangles, TRIANGLE_BATCH_SIZE, [&](uint32_t begin, uint32_t end)
+						   {
+		for (uint32_t i = begin; i < end; i++)
+		{
+			const glm::vec3 &v0 = vertices[triangles[i].x];
+			const glm::vec3 &v1 = vertices[triangles[i].y];
+			const glm::vec3 &v2 = vertices[triangles[i].z];
+			primitives[i].boundsMin = glm::min(v0, glm::min(v1, v2));
+			primitives[i].boundsMax = glm::max(v0, glm::max(v1, v2));
+			primitives[i].centroid = (primitives[i].boundsMin + primitives[i].boundsMax) * 0.5f;
+		} });
+
+	std::vector<uint32_t> primitiveIds(numTriangles);
+	std::iota(primitiveIds.begin(), primitiveIds.end(), 0);
+
+	// Primera fase: los nodos grandes se dividen desde este hilo, repartiendo entre los hilos el binning de cada uno,
+	// hasta que todos los rangos pendientes son lo bastante pequeños para construirse en una sola tarea
+	std::vector<BuildNode> buildNodes;
+	buildNodes.push_back(BuildNode{glm::vec3(0.0f), glm::vec3(0.0f), 0, numTriangles, 0});
+	std::vector<uint32_t> pendingNodes = {0};
+	std::vector<uint32_t> subtreeRoots;
+
+	while (!pendingNodes.empty())
+	{
+		uint32_t nodeIndex = pendingNodes.back();
+		pendingNodes.pop_back();
+
+		uint32_t first = buildNodes[nodeIndex].first;
+		uint32_t count = buildNodes[nodeIndex].count;
+		if (count <= PARALLEL_SUBTREE_TRIANGLES)
+		{
+			subtreeRoots.push_back(nodeIndex);
+			continue;
+		}
+
+		glm::vec3 centroidMin, centroidMax;
+		computeBounds(primitives, primitiveIds.data() + first, count, &buildNodes[nodeIndex].boundsMin, &buildNodes[nodeIndex].boundsMax,
+					  &centroidMin, &centroidMax);
+
+		Split split = findSplit(primitives, primitiveIds.data() + first, count, centroidMin, centroidMax, &threadPool);
+		uint32_t leftCount = partition(primitives, primitiveIds.data() + first, count, split, centroidMin, centroidMax);
+
+		uint32_t left = static_cast<uint32_t>(buildNodes.size());
+		buildNodes.push_back(BuildNode{glm::vec3(0.0f), glm::vec3(0.0f), first, leftCount, 0});
+		buildNodes.push_back(BuildNode{glm::vec3(0.0f), glm::vec3(0.0f), first + leftCount, count - leftCount, 0});
+		buildNodes[nodeIndex].first = left;
+		buildNodes[nodeIndex].count = 0;
+		buildNodes[nodeIndex].right = left + 1;
+
+		pendingNodes.push_back(left);
+		pendingNodes.push_back(left + 1);
+	}
+
+	// Segunda fase: cada subárbol se construye en su propio array de nodos, en paralelo. Los rangos de triángulos de los
+	// subárboles son disjuntos, así que pueden reordenar primitiveIds a la vez
+	std::vector<std::vector<BuildNode>> subtrees(subtreeRoots.size());
+	threadPool.parallelFor(static_cast<uint32_t>(subtreeRoots.size()), 1, [&](uint32_t begin, uint32_t end)
+						   {
+		for (uint32_t s = begin; s < end; s++)
+		{
+			subtrees[s].push_back(buildNodes[subtreeRoots[s]]);
+			buildSubtree(primitives, primitiveIds, subtrees[s], 0);
+		} });
+
+	// Los subárboles se añaden al árbol principal, desplazando los índices de sus hijos
+	for (size_t s = 0; s < subtrees.size(); s++)
+	{
+		const std::vector<BuildNode> &subtree = subtrees[s];
+		uint32_t offset = static_cast<uint32_t>(buildNodes.size()) - 1;
+		for (size_t k = 0; k < subtree.size(); k++)
+		{
+			BuildNode node = subtree[k];
+			if (node.count == 0)
+			{
+				node.first += offset;
+				node.right += offset;
+			}
+			if (k == 0)
+			{
+				buildNodes[subtreeRoots[s]] = node;
+			}
+			else
+			{
+				buildNodes.push_back(node);
+			}
+		}
+	}
+
+	// Se colapsa el árbol binario en nodos de 4 hijos. Si la raíz es una hoja, se guarda en un nodo con un único hijo
+	nodes.reserve(buildNodes.size() / 2 + 1);
+	if (buildNodes[0].count > 0)
+	{
+		nodes.emplace_back();
+		Node &root = nodes[0];
+		clearNode(&root);
+		root.minX[0] = buildNodes[0].boundsMin.x;
+		root.minY[0] = buildNodes[0].boundsMin.y;
+		root.minZ[0] = buildNodes[0].boundsMin.z;
+		root.maxX[0] = buildNodes[0].boundsMax.x;
+		root.maxY[0] = buildNodes[0].boundsMax.y;
+		root.maxZ[0] = buildNodes[0].boundsMax.z;
+		root.children[0] = LEAF_FLAG | (buildNodes[0].first << LEAF_COUNT_BITS) | buildNodes[0].count;
+		root.childCount = 1;
+	}
+	else
+	{
+		collapse(buildNodes, 0);
+	}
+	boundsMin = buildNodes[0].boundsMin;
+	boundsMax = buildNodes[0].boundsMax;
+
+	// Triángulos en el orden de las hojas, con las aristas precalculadas
+	bvhTriangles.resize(numTriangles);
+	threadPool.parallelFor(numTriangles, TRIANGLE_BATCH_SIZE, [&](uint32_t begin, uint32_t end)
+						   {
+		for (uint32_t i = begin; i < end; i++)
+		{
+			uint32_t id = primitiveIds[i];
+			const glm::vec3 &v0 = vertices[triangles[id].x];
+			bvhTriangles[i].v0 = v0;
+			bvhTriangles[i].edge1 = vertices[triangles[id].y] - v0;
+			bvhTriangles[i].edge2 = vertices[triangles[id].z] - v0;
+			bvhTriangles[i].id = id;
+		} });
+}
+
+bool CpuBvh::intersect(const glm::vec3 &origin, const glm::vec3 &direction, float tMin, float tMax, CpuBvhHit *hit) const
+{
+	return traverse<false>(origin, direction, tMin, tMax, hit);
+}
+
+bool CpuBvh::occluded(const glm::vec3 &origin, const glm::vec3 &direction, float tMin, float tMax) const
+{
+	return traverse<true>(origin, direction, tMin, tMax, nullptr);
+}
+
+uint32_t CpuBvh::getNodeCount() const
+{
+	return static_cast<uint32_t>(nodes.size());
+}
+
+uint32_t CpuBvh::getTriangleCount() const
+{
+	return static_cast<uint32_t>(bvhTriangles.size());
+}
+
+glm::vec3 CpuBvh::getBoundsMin() const
+{
+	return boundsMin;
+}
+
+glm::vec3 CpuBvh::getBoundsMax() const
+{
+	return boundsMax;
+}
+
+CpuBvh::Split CpuBvh::findSplit(const std::vector<BuildPrimitive> &primitives, const uint32_t *primitiveIds, uint32_t count,
+								const glm::vec3 &centroidMin, const glm::vec3 &centroidMax, ThreadPool *threadPool)
+{
+	glm::vec3 extent = centroidMax - centroidMin;
+	glm::vec3 scale;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		scale[axis] = extent[axis] > 0.0f ? static_cast<float>(SAH_BINS) / extent[axis] : 0.0f;
+	}
+
+	// Cada lote rellena sus propios cubos, que después se suman
+	auto fillBins = [&](uint32_t begin, uint32_t end, BinSet *binSet)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			const BuildPrimitive &primitive = primitives[primitiveIds[i]];
+			for (int axis = 0; axis < 3; axis++)
+			{
+				Bin &bin = binSet->bins[axis][binIndex(primitive.centroid[axis], centroidMin[axis], scale[axis])];
+				bin.grow(primitive.boundsMin, primitive.boundsMax);
+				bin.count++;
+			}
+		}
+	};
+
+	BinSet binSet;
+	if (threadPool != nullptr && count > PARALLEL_BINNING_BATCH)
+	{
+		uint32_t numBatches = (count + PARALLEL_BINNING_BATCH - 1) / PARALLEL_BINNING_BATCH;
+		std::vector<BinSet> batchBins(numBatches);
+		threadPool->parallelFor(count, PARALLEL_BINNING_BATCH, [&](uint32_t begin, uint32_t end)
+								{ fillBins(begin, end, &batchBins[begin / PARALLEL_BINNING_BATCH]); });
+
+		for (const BinSet &batch : batchBins)
+		{
+			for (int axis = 0; axis < 3; axis++)
+			{
+				for (uint32_t b = 0; b < SAH_BINS; b++)
+				{
+					binSet.bins[axis][b].grow(batch.bins[axis][b].boundsMin, batch.bins[axis][b].boundsMax);
+					binSet.bins[axis][b].count += batch.bins[axis][b].count;
+				}
+			}
+		}
+	}
+	else
+	{
+		fillBins(0, count, &binSet);
+	}
+
+	// Barrido de cada eje: coste de dejar a la izquierda los cubos hasta b y a la derecha el resto
+	Split best;
+	best.cost = std::numeric_limits<float>::max();
+	for (int axis = 0; axis < 3; axis++)
+	{
+		if (scale[axis] == 0.0f)
+		{
+			continue;
+		}
+
+		float rightCost[SAH_BINS];
+		Bin right;
+		for (uint32_t b = SAH_BINS - 1; b > 0; b--)
+		{
+			right.grow(binSet.bins[axis][b].boundsMin, binSet.bins[axis][b].boundsMax);
+			right.count += binSet.bins[axis][b].count;
+			rightCost[b] = right.count > 0 ? surfaceArea(right.boundsMin, right.boundsMax) * right.count : 0.0f;
+		}
+
+		Bin left;
+		for (uint32_t b = 0; b < SAH_BINS - 1; b++)
+		{
+			left.grow(binSet.bins[axis][b].boundsMin, binSet.bins[axis][b].boundsMax);
+			left.count += binSet.bins[axis][b].count;
+			if (left.count == 0 || left.count == count)
+			{
+				continue;
+			}
+
+			float cost = surfaceArea(left.boundsMin, left.boundsMax) * left.count + rightCost[b + 1];
+			if (cost < best.cost)
+			{
+				best.axis = axis;
+				best.bin = b;
+				best.cost = cost;
+			}
+		}
+	}
+	return best;
+}
+
+uint32_t CpuBvh::partition(const std::vector<BuildPrimitive> &primitives, uint32_t *primitiveIds, uint32_t count,
+						   const Split &split, const glm::vec3 &centroidMin, const glm::vec3 &centroidMax)
+{
+	// Sin una partición válida (todos los centroides coinciden) se divide por la mitad
+	if (split.axis < 0)
+	{
+		return count / 2;
+	}
+
+	int axis = split.axis;
+	float scale = static_cast<float>(SAH_BINS) / (centroidMax[axis] - centroidMin[axis]);
+	uint32_t *middle = std::partition(primitiveIds, primitiveIds + count, [&](uint32_t id)
+									  { return binIndex(primitives[id].centroid[axis], centroidMin[axis], scale) <= split.bin; });
+
+	uint32_t leftCount = static_cast<uint32_t>(middle - primitiveIds);
+	return leftCount == 0 || leftCount == count ? count / 2 : leftCount;
+}
+
+void CpuBvh::computeBounds(const std::vector<BuildPrimitive> &primitives, const uint32_t *primitiveIds, uint32_t count,
+						   glm::vec3 *boundsMin, glm::vec3 *boundsMax, glm::vec3 *centroidMin, glm::vec3 *centroidMax)
+{
+	*boundsMin = glm::vec3(std::numeric_limits<float>::max());
+	*boundsMax = glm::vec3(-std::numeric_limits<float>::max());
+	*centroidMin = *boundsMin;
+	*centroidMax = *boundsMax;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const BuildPrimitive &primitive = primitives[primitiveIds[i]];
+		*boundsMin = glm::min(*boundsMin, primitive.boundsMin);
+		*boundsMax = glm::max(*boundsMax, primitive.boundsMax);
+		*centroidMin = glm::min(*centroidMin, primitive.centroid);
+		*centroidMax = glm::max(*centroidMax, primitive.centroid);
+	}
+}
+
+void CpuBvh::buildSubtree(const std::vector<BuildPrimitive> &primitives, std::vector<uint32_t> &primitiveIds,
+						  std::vector<BuildNode> &buildNodes, uint32_t nodeIndex)
+{
+	std::vector<uint32_t> pendingNodes = {nodeIndex};
+	while (!pendingNodes.empty())
+	{
+		uint32_t current = pendingNodes.back();
+		pendingNodes.pop_back();
+
+		uint32_t first = buildNodes[current].first;
+		uint32_t count = buildNodes[current].count;
+
+		glm::vec3 centroidMin, centroidMax;
+		computeBounds(primitives, primitiveIds.data() + first, count, &buildNodes[current].boundsMin, &buildNodes[current].boundsMax,
+					  &centroidMin, &centroidMax);
+		if (count == 1)
+		{
+			continue;
+		}
+
+		Split split = findSplit(primitives, primitiveIds.data() + first, count, centroidMin, centroidMax, nullptr);
+		if (count <= MAX_LEAF_TRIANGLES)
+		{
+			// Se crea una hoja si dividir no sale más barato que intersecar todos sus triángulos
+			float nodeArea = surfaceArea(buildNodes[current].boundsMin, buildNodes[current].boundsMax);
+			if (split.axis < 0 || nodeArea <= 0.0f || SAH_TRAVERSAL_COST + split.cost / nodeArea >= static_cast<float>(count))
+			{
+				continue;
+			}
+		}
+
+		uint32_t leftCount = partition(primitives, primitiveIds.data() + first, count, split, centroidMin, centroidMax);
+
+		uint32_t left = static_cast<uint32_t>(buildNodes.size());
+		buildNodes.push_back(BuildNode{glm::vec3(0.0f), glm::vec3(0.0f), first, leftCount, 0});
+		buildNodes.push_back(BuildNode{glm::vec3(0.0f), glm::vec3(0.0f), first + leftCount, count - leftCount, 0});
+		buildNodes[current].first = left;
+		buildNodes[current].count = 0;
+		buildNodes[current].right = left + 1;
+
+		pendingNodes.push_back(left);
+		pendingNodes.push_back(left + 1);
+	}
+}
+
+uint32_t CpuBvh::collapse(const std::vector<BuildNode> &buildNodes, uint32_t buildNodeIndex)
+{
+	// Se parte de los dos hijos del nodo binario y se abre el hijo interno de mayor superficie hasta tener 4
+	uint32_t children[BVH_WIDTH] = {buildNodes[buildNodeIndex].first, buildNodes[buildNodeIndex].right};
+	uint32_t childCount = 2;
+	while (childCount < BVH_WIDTH)
+	{
+		int largest = -1;
+		float largestArea = -1.0f;
+		for (uint32_t c = 0; c < childCount; c++)
+		{
+			const BuildNode &child = buildNodes[children[c]];
+			float area = surfaceArea(child.boundsMin, child.boundsMax);
+			if (child.count == 0 && area > largestArea)
+			{
+				largest = static_cast<int>(c);
+				largestArea = area;
+			}
+		}
+		if (largest < 0)
+		{
+			break;
+		}
+
+		const BuildNode &opened = buildNodes[children[largest]];
+		children[largest] = opened.first;
+		children[childCount++] = opened.right;
+	}
+
+	uint32_t nodeIndex = static_cast<uint32_t>(nodes.size());
+	nodes.emplace_back();
+	{
+		Node &node = nodes[nodeIndex];
+		clearNode(&node);
+		node.childCount = childCount;
+		for (uint32_t c = 0; c < childCount; c++)
+		{
+			const BuildNode &child = buildNodes[children[c]];
+			node.minX[c] = child.boundsMin.x;
+			node.minY[c] = child.boundsMin.y;
+			node.minZ[c] = child.boundsMin.z;
+			node.maxX[c] = child.boundsMax.x;
+			node.maxY[c] = child.boundsMax.y;
+			node.maxZ[c] = child.boundsMax.z;
+		}
+	}
+
+	// Los hijos internos se colapsan después de rellenar el nodo, ya que nodes puede crecer y mover sus elementos
+	for (uint32_t c = 0; c < childCount; c++)
+	{
+		const BuildNode &child = buildNodes[children[c]];
+		uint32_t childReference = child.count > 0 ? LEAF_FLAG | (child.first << LEAF_COUNT_BITS) | child.count
+												  : collapse(buildNodes, children[c]);
+		nodes[nodeIndex].children[c] = childReference;
+	}
+	return nodeIndex;
+}
+
+void CpuBvh::clearNode(Node *node)
+{
+	// Los huecos de los nodos con menos de 4 hijos se descartan con childCount, pero se dejan a cero para que la prueba
+	// de las cajas no opere con valores sin inicializar
+	for (uint32_t c = 0; c < BVH_WIDTH; c++)
+	{
+		node->minX[c] = node->minY[c] = node->minZ[c] = 0.0f;
+		node->maxX[c] = node->maxY[c] = node->maxZ[c] = 0.0f;
+		node->children[c] = 0;
+	}
+	node->childCount = 0;
+}
+
+bool CpuBvh::intersectTriangle(const Triangle &triangle, const glm::vec3 &origin, const glm::vec3 &direction, float tMin, float tMax,
+							   float *t, float *u, float *v)
+{
+	// Möller-Trumbore, sin descartar caras traseras, igual que los rayos de la GPU
+	glm::vec3 p = glm::cross(direction, triangle.edge2);
+	float determinant = glm::dot(triangle.edge1, p);
+	if (std::abs(determinant) < 1e-12f)
+	{
+		return false;
+	}
+	float inverseDeterminant = 1.0f / determinant;
+
+	glm::vec3 s = origin - triangle.v0;
+	float hitU = glm::dot(s, p) * inverseDeterminant;
+	if (hitU < 0.0f || hitU > 1.0f)
+	{
+		return false;
+	}
+
+	glm::vec3 q = glm::cross(s, triangle.edge1);
+	float hitV = glm::dot(direction, q) * inverseDeterminant;
+	if (hitV < 0.0f || hitU + hitV > 1.0f)
+	{
+		return false;
+	}
+
+	float hitT = glm::dot(triangle.edge2, q) * inverseDeterminant;
+	if (hitT < tMin || hitT > tMax)
+	{
+		return false;
+	}
+
+	*t = hitT;
+	*u = hitU;
+	*v = hitV;
+	return true;
+}
+
+template <bool ANY_HIT>
+bool CpuBvh::traverse(const glm::vec3 &origin, const glm::vec3 &direction, float tMin, float tMax, CpuBvhHit *hit) const
+{
+	if (nodes.empty())
+	{
+		return false;
+	}
+
+	glm::vec3 inverseDirection;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float component = direction[axis];
+		if (std::abs(component) < MIN_DIRECTION_COMPONENT)
+		{
+			component = std::copysign(MIN_DIRECTION_COMPONENT, component);
+		}
+		inverseDirection[axis] = 1.0f / component;
+	}
+
+	const __m128 originX = _mm_set1_ps(origin.x);
+	const __m128 originY = _mm_set1_ps(origin.y);
+	const __m128 originZ = _mm_set1_ps(origin.z);
+	const __m128 inverseX = _mm_set1_ps(inverseDirection.x);
+	const __m128 inverseY = _mm_set1_ps(inverseDirection.y);
+	const __m128 inverseZ = _mm_set1_ps(inverseDirection.z);
+	const __m128 rayTMin = _mm_set1_ps(tMin);
+
+	uint32_t stack[TRAVERSAL_STACK_SIZE];
+	uint32_t stackSize = 0;
+	stack[stackSize++] = 0;
+
+	bool found = false;
+	float closest = tMax;
+
+	while (stackSize > 0)
+	{
+		uint32_t reference = stack[--stackSize];
+
+		if (reference & LEAF_FLAG)
+		{
+			uint32_t first = (reference & ~LEAF_FLAG) >> LEAF_COUNT_BITS;
+			uint32_t count = reference & LEAF_COUNT_MASK;
+			for (uint32_t i = first; i < first + count; i++)
+			{
+				float t, u, v;
+				if (intersectTriangle(bvhTriangles[i], origin, direction, tMin, closest, &t, &u, &v))
+				{
+					if (ANY_HIT)
+					{
+						return true;
+					}
+					found = true;
+					closest = t;
+					hit->t = t;
+					hit->triangle = bvhTriangles[i].id;
+					hit->u = u;
+					hit->v = v;
+				}
+			}
+			continue;
+		}
+
+		// Prueba de las 4 cajas hijas a la vez por el método de los slabs
+		const Node &node = nodes[reference];
+		__m128 t1X = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minX), originX), inverseX);
+		__m128 t2X = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxX), originX), inverseX);
+		__m128 t1Y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minY), originY), inverseY);
+		__m128 t2Y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxY), originY), inverseY);
+		__m128 t1Z = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minZ), originZ), inverseZ);
+		__m128 t2Z = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxZ), originZ), inverseZ);
+
+		__m128 tNear = _mm_max_ps(_mm_max_ps(_mm_min_ps(t1X, t2X), _mm_min_ps(t1Y, t2Y)), _mm_max_ps(_mm_min_ps(t1Z, t2Z), rayTMin));
+		__m128 tFar = _mm_min_ps(_mm_min_ps(_mm_max_ps(t1X, t2X), _mm_max_ps(t1Y, t2Y)), _mm_min_ps(_mm_max_ps(t1Z, t2Z), _mm_set1_ps(closest)));
+		int mask = _mm_movemask_ps(_mm_cmple_ps(tNear, tFar)) & ((1 << node.childCount) - 1);
+		if (mask == 0)
+		{
+			continue;
+		}
+
+		alignas(16) float nearDistances[BVH_WIDTH];
+		_mm_store_ps(nearDistances, tNear);
+
+		// Se apilan los hijos alcanzados del más lejano al más cercano, para visitar antes el más cercano
+		uint32_t hitChildren[BVH_WIDTH];
+		float hitDistances[BVH_WIDTH];
+		uint32_t hitCount = 0;
+		for (uint32_t c = 0; c < node.childCount; c++)
+		{
+			if ((mask & (1 << c)) == 0)
+			{
+				continue;
+			}
+			uint32_t position = hitCount++;
+			while (position > 0 && hitDistances[position - 1] < nearDistances[c])
+			{
+				hitChildren[position] = hitChildren[position - 1];
+				hitDistances[position] = hitDistances[position - 1];
+				position--;
+			}
+			hitChildren[position] = node.children[c];
+			hitDistances[position] = nearDistances[c];
+		}
+
+		if (stackSize + hitCount > TRAVERSAL_STACK_SIZE)
+		{
+			throw std::runtime_error("failed to traverse CPU BVH: stack overflow!");
+		}
+		for (uint32_t c = 0; c < hitCount; c++)
+		{
+			stack[stackSize++] = hitChildren[c];
+		}
+	}
+	return found;
+}
\ No newline at end of file
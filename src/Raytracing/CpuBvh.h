@@ -0,0 +1,121 @@
+#pragma once
+
+#include "Tools/ThreadPool.h"
+
+#define GLM_FORCE_RADIANS
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+
+// Choque de un rayo con un triángulo de la BVH: distancia y coordenadas baricéntricas respecto al segundo y tercer vértice
+struct CpuBvhHit
+{
+	float t;
+	uint32_t triangle; // Índice del triángulo en la lista con la que se construyó la BVH
+	float u;
+	float v;
+};
+
+// BVH de los triángulos de la escena para trazar rayos en CPU (bakes, picking y validación de los resultados de la GPU)
+// Se construye con SAH por cubos en paralelo como un árbol binario, que después se colapsa en nodos de 4 hijos con sus
+// cajas en estructura de arrays, de forma que el recorrido comprueba los 4 hijos de un nodo a la vez con SSE
+class CpuBvh
+{
+public:
+	static const uint32_t BVH_WIDTH = 4;
+	static const uint32_t SAH_BINS = 16;
+	// Las hojas se forman cuando el SAH no encuentra una partición mejor, con un máximo de triángulos por hoja
+	static const uint32_t MAX_LEAF_TRIANGLES = 8;
+	// Por debajo de este número de triángulos, cada subárbol se construye entero en una tarea del pool
+	static const uint32_t PARALLEL_SUBTREE_TRIANGLES = 16384;
+
+	// Construye la BVH. Los índices de los triángulos son globales a la lista de vértices
+	void build(const std::vector<glm::vec3> &vertices, const std::vector<glm::uvec3> &triangles, ThreadPool &threadPool);
+
+	// Choque más cercano con t en [tMin, tMax]
+	bool intersect(const glm::vec3 &origin, const glm::vec3 &direction, float tMin, float tMax, CpuBvhHit *hit) const;
+	// Si el rayo choca con algún triángulo en [tMin, tMax]. Termina en el primer choque
+	bool occluded(const glm::vec3 &origin, const glm::vec3 &direction, float tMin, float tMax) const;
+
+	uint32_t getNodeCount() const;
+	uint32_t getTriangleCount() const;
+	glm::vec3 getBoundsMin() const;
+	glm::vec3 getBoundsMax() const;
+
+private:
+	// Nodo de 4 hijos de 128 bytes (dos líneas de caché), con las cajas de los hijos en estructura de arrays. Cada hijo
+	// es otro nodo o una hoja, codificada con LEAF_FLAG, el primer triángulo y el número de triángulos
+	struct alignas(64) Node
+	{
+		float minX[BVH_WIDTH];
+		float minY[BVH_WIDTH];
+		float minZ[BVH_WIDTH];
+		float maxX[BVH_WIDTH];
+		float maxY[BVH_WIDTH];
+		float maxZ[BVH_WIDTH];
+		uint32_t children[BVH_WIDTH];
+		uint32_t childCount;
+	};
+
+	static const uint32_t LEAF_FLAG = 0x80000000u;
+	static const uint32_t LEAF_COUNT_BITS = 4;
+	static const uint32_t LEAF_COUNT_MASK = (1u << LEAF_COUNT_BITS) - 1;
+
+	// Triángulo preparado para Möller-Trumbore, en el orden de las hojas
+	struct Triangle
+	{
+		glm::vec3 v0;
+		glm::vec3 edge1;
+		glm::vec3 edge2;
+		uint32_t id;
+	};
+
+	// Nodo del árbol binario intermedio
+	struct BuildNode
+	{
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		uint32_t first; // Primer triángulo si es hoja, o hijo izquierdo si no
+		uint32_t count; // Triángulos de la hoja, 0 si es un nodo interno
+		uint32_t right;
+	};
+
+	// Caja y centroide de cada triángulo, que es lo único que usa la construcción
+	struct BuildPrimitive
+	{
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		glm::vec3 centroid;
+	};
+
+	struct Split
+	{
+		int axis = -1; // -1 si es mejor no dividir
+		uint32_t bin = 0;
+		float cost = 0.0f;
+	};
+
+	std::vector<Node> nodes;
+	std::vector<Triangle> bvhTriangles;
+	glm::vec3 boundsMin = glm::vec3(0.0f);
+	glm::vec3 boundsMax = glm::vec3(0.0f);
+
+	static Split findSplit(const std::vector<BuildPrimitive> &primitives, const uint32_t *primitiveIds, uint32_t count,
+						   const glm::vec3 &centroidMin, const glm::vec3 &centroidMax, ThreadPool *threadPool);
+	static uint32_t partition(const std::vector<BuildPrimitive> &primitives, uint32_t *primitiveIds, uint32_t count,
+							  const Split &split, const glm::vec3 &centroidMin, const glm::vec3 &centroidMax);
+	static void computeBounds(const std::vector<BuildPrimitive> &primitives, const uint32_t *primitiveIds, uint32_t count,
+							  glm::vec3 *boundsMin, glm::vec3 *boundsMax, glm::vec3 *centroidMin, glm::vec3 *centroidMax);
+	// Construye secuencialmente el subárbol de [first, first + count) a partir del nodo nodeIndex de buildNodes
+	static void buildSubtree(const std::vector<BuildPrimitive> &primitives, std::vector<uint32_t> &primitiveIds,
+							 std::vector<BuildNode> &buildNodes, uint32_t nodeIndex);
+	uint32_t collapse(const std::vector<BuildNode> &buildNodes, uint32_t buildNodeIndex);
+	static void clearNode(Node *node);
+
+	static bool intersectTriangle(const Triangle &triangle, const glm::vec3 &origin, const glm::vec3 &direction, float tMin, float tMax,
+								  float *t, float *u, float *v);
+	template <bool ANY_HIT>
+	bool traverse(const glm::vec3 &origin, const glm::vec3 &direction, float tMin, float tMax, CpuBvhHit *hit) const;
+};
\ No newline at end of file
@@ -0,0 +1,123 @@
+#include "CpuBvhBenchmark.h"
+
+#include "Surfels/SurfelData.h"
+#include "Tools/ThreadPool.h"
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	const float PI = 3.14159265358979323846f;
+	const float RAY_OFFSET = 0.001f;
+	const float RAY_T_MIN = 0.01f;
+
+	struct BenchmarkRay
+	{
+		glm::vec3 origin;
+		glm::vec3 direction;
+	};
+}
+
+void CpuBvhBenchmark::run(const std::vector<glm::vec3> &vertices, const std::vector<glm::uvec3> &triangles)
+{
+	if (triangles.empty())
+	{
+		return;
+	}
+
+	ThreadPool threadPool;
+	CpuBvh bvh;
+
+	auto buildStart = std::chrono::high_resolution_clock::now();
+	bvh.build(vertices, triangles, threadPool);
+	auto buildEnd = std::chrono::high_resolution_clock::now();
+
+	// Los rayos salen de un punto aleatorio de un triángulo aleatorio, con una dirección de coseno alrededor de su
+	// normal. Se generan antes de medir para que sólo cuente el recorrido
+	std::vector<BenchmarkRay> rays;
+	rays.reserve(BENCHMARK_RAYS);
+	std::mt19937 rng(BENCHMARK_SEED);
+	std::uniform_int_distribution<size_t> triangleDistribution(0, triangles.size() - 1);
+	std::uniform_real_distribution<float> unitDistribution(0.0f, 1.0f);
+	// Con escenas formadas sobre todo por triángulos degenerados se acaba con menos rayos en lugar de no terminar
+	for (uint32_t attempt = 0; rays.size() < BENCHMARK_RAYS && attempt < 16 * BENCHMARK_RAYS; attempt++)
+	{
+		const glm::uvec3 &triangle = triangles[triangleDistribution(rng)];
+		const glm::vec3 &v0 = vertices[triangle.x];
+		const glm::vec3 &v1 = vertices[triangle.y];
+		const glm::vec3 &v2 = vertices[triangle.z];
+		glm::vec3 normal = glm::cross(v1 - v0, v2 - v0);
+		if (glm::dot(normal, normal) < 1e-12f)
+		{
+			continue;
+		}
+		normal = glm::normalize(normal);
+
+		float b1 = unitDistribution(rng);
+		float b2 = unitDistribution(rng);
+		if (b1 + b2 > 1.0f)
+		{
+			b1 = 1.0f - b1;
+			b2 = 1.0f - b2;
+		}
+		glm::vec3 position = v0 + b1 * (v1 - v0) + b2 * (v2 - v0);
+
+		glm::vec3 tangent = std::abs(normal.z) < 0.999f ? glm::normalize(glm::cross(normal, glm::vec3(0.0f, 0.0f, 1.0f)))
+														: glm::normalize(glm::cross(normal, glm::vec3(0.0f, 1.0f, 0.0f)));
+		glm::vec3 bitangent = glm::cross(normal, tangent);
+		float r = std::sqrt(unitDistribution(rng));
+		float angle = 2.0f * PI * unitDistribution(rng);
+		float x = r * std::cos(angle);
+		float y = r * std::sin(angle);
+		float z = std::sqrt(std::max(0.0f, 1.0f - x * x - y * y));
+		glm::vec3 direction = glm::normalize(tangent * x + bitangent * y + normal * z);
+
+		rays.push_back(BenchmarkRay{position + normal * RAY_OFFSET, direction});
+	}
+
+	// Rayos de choque más cercano y rayos de sombra, repartidos entre todos los hilos
+	const uint32_t numRays = static_cast<uint32_t>(rays.size());
+	if (numRays == 0)
+	{
+		return;
+	}
+	const float rayLength = static_cast<float>(SurfelShader::RAYS_LENGTH);
+	std::atomic<uint32_t> closestHits{0};
+	std::atomic<uint32_t> occludedRays{0};
+
+	auto closestStart = std::chrono::high_resolution_clock::now();
+	threadPool.parallelFor(numRays, RAY_BATCH_SIZE, [&](uint32_t begin, uint32_t end)
+						   {
+		uint32_t batchHits = 0;
+		for (uint32_t i = begin; i < end; i++)
+		{
+			CpuBvhHit hit;
+			batchHits += bvh.intersect(rays[i].origin, rays[i].direction, RAY_T_MIN, rayLength, &hit) ? 1 : 0;
+		}
+		closestHits += batchHits; });
+	auto closestEnd = std::chrono::high_resolution_clock::now();
+
+	threadPool.parallelFor(numRays, RAY_BATCH_SIZE, [&](uint32_t begin, uint32_t end)
+						   {
+		uint32_t batchOccluded = 0;
+		for (uint32_t i = begin; i < end; i++)
+		{
+			batchOccluded += bvh.occluded(rays[i].origin, rays[i].direction, RAY_T_MIN, rayLength) ? 1 : 0;
+		}
+		occludedRays += batchOccluded; });
+	auto occludedEnd = std::chrono::high_resolution_clock::now();
+
+	float buildTime = std::chrono::duration<float, std::milli>(buildEnd - buildStart).count();
+	float closestTime = std::chrono::duration<float>(closestEnd - closestStart).count();
+	float occludedTime = std::chrono::duration<float>(occludedEnd - closestEnd).count();
+
+	std::cout << "BVH de CPU: " << bvh.getTriangleCount() << " triángulos, " << bvh.getNodeCount() << " nodos, construida en " << buildTime << " ms con "
+			  << threadPool.getNumThreads() << " hilos" << std::endl;
+	std::cout << "  Choque más cercano: " << (numRays / closestTime) * 1e-6f << " Mrayos/s (" << (100.0f * closestHits / numRays) << "% con choque)" << std::endl;
+	std::cout << "  Rayos de sombra: " << (numRays / occludedTime) * 1e-6f << " Mrayos/s (" << (100.0f * occludedRays / numRays) << "% ocluidos)" << std::endl;
+}
\ No newline at end of file
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "CpuBvh.h"
+
+#include <vector>
+#include <cstdint>
+
+// Medida del rendimiento de la BVH de CPU: tiempo de construcción y millones de rayos por segundo, trazando rayos
+// incoherentes como los de los surfels (desde puntos de la escena y en direcciones del hemisferio de su normal)
+class CpuBvhBenchmark
+{
+public:
+	static const uint32_t BENCHMARK_RAYS = 1u << 20;
+	static const uint32_t RAY_BATCH_SIZE = 4096;
+	static const uint32_t BENCHMARK_SEED = 1337;
+
+	// Construye la BVH con los triángulos e imprime los resultados por consola
+	static void run(const std::vector<glm::vec3> &vertices, const std::vector<glm::uvec3> &triangles);
+};
\ No newline at end of file
@@ -4,7 +4,7 @@
 #define GLFW_INCLUDE_VULKAN
 #define GLFW_EXPOSE_NATIVE_WIN32
 
-#include "Buffers/Tools/CommandBufferManager.h"
+#include "Buffers/Tools/UploadBatcher.h"
 #include "Scene/Models/MeshContainer.h"
 
 #include <GLFW/glfw3.h>
@@ -38,24 +38,41 @@ void RaytracingManager::enableFeatures(VkDevice device, VkPhysicalDevice physica
 	vkCreateRayTracingPipelinesKHR = reinterpret_cast<PFN_vkCreateRayTracingPipelinesKHR>(vkGetDeviceProcAddr(device, "vkCreateRayTracingPipelinesKHR"));
 }
 
-void RaytracingManager::createBottomLevelAccelerationStructures(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool,
-																VkQueue graphicsQueue, std::vector<MeshContainer> sceneMeshes)
+void RaytracingManager::createBottomLevelAccelerationStructures(UploadBatcher &uploadBatcher, VkDevice device, VkPhysicalDevice physicalDevice,
+																const std::vector<MeshContainer> &sceneMeshes, const SceneGeometryBuffer &sceneGeometry)
 {
 	int indexOffset = 0;
 	int vertexOffset = 0;
 
+	// Direcciones de los buffers compartidos, a las que se suma el rango de cada objeto
+	VkDeviceAddress sceneVertexAddress = getBufferDeviceAddress(device, sceneGeometry.getVertexBuffer());
+	VkDeviceAddress sceneIndexAddress = getBufferDeviceAddress(device, sceneGeometry.getIndexBuffer());
+	size_t submeshIndex = 0;
+
+	// Todas las construcciones se graban en el mismo lote, que se envía una sola vez
+	VkCommandBuffer commandBuffer = uploadBatcher.getCommandBuffer();
+	// Las copias de los buffers de vértices e índices tienen que haber terminado antes de leerlos en la construcción
+	VkMemoryBarrier uploadBarrier{};
+	uploadBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	uploadBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	uploadBarrier.dstAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, 0,
+						 1, &uploadBarrier, 0, nullptr, 0, nullptr);
+
 	for (const auto &mesh : sceneMeshes)
 	{
-		for (int i = 0; i < mesh.vertexMeshesData.vertexBufferList.size(); i++)
+		for (int i = 0; i < mesh.vertexMeshesData.vertices.size(); i++)
 		{
 			AccelerationStructure bottomLevelAccelerationStructure;
+			const GeometrySubmesh &submesh = sceneGeometry.getSubmeshes()[submeshIndex++];
 
 			// Primero se toma la geometría que se va a almacenar en la estructura de aceleración
+			// Los índices del objeto son relativos a su primer vértice, por lo que ambas direcciones apuntan al inicio de su rango
 			VkDeviceOrHostAddressConstKHR vertexBufferDeviceAddress{};
 			VkDeviceOrHostAddressConstKHR indexBufferDeviceAddress{};
 
-			vertexBufferDeviceAddress.deviceAddress = getBufferDeviceAddress(device, mesh.vertexMeshesData.vertexBufferList[i]);
-			indexBufferDeviceAddress.deviceAddress = getBufferDeviceAddress(device, mesh.vertexMeshesData.indexBufferList[i]);
+			vertexBufferDeviceAddress.deviceAddress = sceneVertexAddress + sizeof(Vertex) * static_cast<VkDeviceSize>(submesh.vertexOffset);
+			indexBufferDeviceAddress.deviceAddress = sceneIndexAddress + sizeof(uint32_t) * static_cast<VkDeviceSize>(submesh.firstIndex);
 
 			uint32_t numTriangles = static_cast<uint32_t>(mesh.vertexMeshesData.indices[i].size()) / 3;
 
@@ -68,7 +85,7 @@ void RaytracingManager::createBottomLevelAccelerationStructures(VkDevice device,
 			accelerationStructureGeometry.geometry.triangles.vertexData = vertexBufferDeviceAddress;
 			accelerationStructureGeometry.geometry.triangles.maxVertex = mesh.vertexMeshesData.vertices[i].size() - 1; // Índice del último vértice de la lista
 			accelerationStructureGeometry.geometry.triangles.vertexStride = sizeof(Vertex);							   // Tamaño de los vértices
-			accelerationStructureGeometry.geometry.triangles.indexType = VK_INDEX_TYPE_UINT16;
+			accelerationStructureGeometry.geometry.triangles.indexType = VK_INDEX_TYPE_UINT32;
 			accelerationStructureGeometry.geometry.triangles.indexData = indexBufferDeviceAddress;
 			accelerationStructureGeometry.geometry.triangles.transformData.deviceAddress = 0;
 			accelerationStructureGeometry.geometry.triangles.transformData.hostAddress = nullptr;
@@ -113,16 +130,14 @@ void RaytracingManager::createBottomLevelAccelerationStructures(VkDevice device,
 			accelerationStructureBuildRangeInfo.transformOffset = 0;
 			std::vector<VkAccelerationStructureBuildRangeInfoKHR *> accelerationBuildStructureRangeInfos = {&accelerationStructureBuildRangeInfo};
 
-			// Se crea un command buffer independiente para la creación de la estructura de aceleración
-			VkCommandBuffer commandBuffer = CommandBufferManager::beginSingleTimeCommands(commandPool, device);
+			// Cada estructura usa su propio scratch buffer, por lo que las construcciones del lote no necesitan barreras entre sí
 			vkCmdBuildAccelerationStructuresKHR(
 				commandBuffer,
 				1,
 				&accelerationBuildGeometryInfo,
 				accelerationBuildStructureRangeInfos.data());
-
-			CommandBufferManager::endSingleTimeCommands(commandBuffer, graphicsQueue, device, commandPool);
-			deleteScratchBuffer(device, scratchBuffer);
+			// El scratch buffer se libera cuando termine el lote
+			uploadBatcher.releaseAfterCompletion(scratchBuffer.handle, scratchBuffer.memory);
 
 			// Se añade la estructura de aceleración a la lista
 			bottomLevelAccelerationStructures.push_back(bottomLevelAccelerationStructure);
@@ -162,7 +177,7 @@ void RaytracingManager::createBottomLevelAccelerationStructures(VkDevice device,
 	}
 }
 
-void RaytracingManager::createTopLevelAccelerationStructure(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue)
+void RaytracingManager::createTopLevelAccelerationStructure(UploadBatcher &uploadBatcher, VkDevice device, VkPhysicalDevice physicalDevice)
 {
 	std::vector<VkAccelerationStructureInstanceKHR> instances;
 
@@ -245,14 +260,19 @@ void RaytracingManager::createTopLevelAccelerationStructure(VkDevice device, VkP
 	buildRangeInfo.transformOffset = 0;
 	std::vector<VkAccelerationStructureBuildRangeInfoKHR *> buildRangeInfos = {&buildRangeInfo};
 
-	VkCommandBuffer commandBuffer = CommandBufferManager::beginSingleTimeCommands(commandPool, device);
+	// La TLAS se graba en el mismo lote que las BLAS, esperando a que terminen de construirse
+	VkCommandBuffer commandBuffer = uploadBatcher.getCommandBuffer();
+	VkMemoryBarrier blasBarrier{};
+	blasBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	blasBarrier.srcAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR;
+	blasBarrier.dstAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, 0,
+						 1, &blasBarrier, 0, nullptr, 0, nullptr);
 	vkCmdBuildAccelerationStructuresKHR(commandBuffer, 1, &buildGeometryInfo, buildRangeInfos.data());
-	CommandBufferManager::endSingleTimeCommands(commandBuffer, graphicsQueue, device, commandPool);
-
-	deleteScratchBuffer(device, scratchBuffer);
 
-	vkDestroyBuffer(device, instancesBuffer, nullptr);
-	vkFreeMemory(device, instancesBufferMemory, nullptr);
+	// Los buffers temporales se liberan cuando termine el lote
+	uploadBatcher.releaseAfterCompletion(scratchBuffer.handle, scratchBuffer.memory);
+	uploadBatcher.releaseAfterCompletion(instancesBuffer, instancesBufferMemory);
 }
 
 uint64_t RaytracingManager::getBufferDeviceAddress(VkDevice device, VkBuffer buffer)
@@ -334,18 +354,6 @@ ScratchBuffer RaytracingManager::createScratchBuffer(VkDevice device, VkPhysical
 	return scratchBuffer;
 }
 
-void RaytracingManager::deleteScratchBuffer(VkDevice device, ScratchBuffer &scratchBuffer)
-{
-	if (scratchBuffer.handle != VK_NULL_HANDLE)
-	{
-		vkDestroyBuffer(device, scratchBuffer.handle, nullptr);
-	}
-	if (scratchBuffer.memory != VK_NULL_HANDLE)
-	{
-		vkFreeMemory(device, scratchBuffer.memory, nullptr);
-	}
-}
-
 AccelerationStructure RaytracingManager::getTLAS()
 {
 	return this->topLevelAccelerationStructure;
@@ -356,6 +364,28 @@ SceneOrganizationStructure RaytracingManager::getSceneStructure()
 	return this->sceneStructure;
 }
 
+void RaytracingManager::getSceneTriangles(std::vector<glm::vec3> *vertices, std::vector<glm::uvec3> *triangles) const
+{
+	vertices->resize(sceneStructure.sceneVertex.size());
+	for (size_t i = 0; i < sceneStructure.sceneVertex.size(); i++)
+	{
+		(*vertices)[i] = sceneStructure.sceneVertex[i].pos;
+	}
+
+	// Los índices de cada BLAS son relativos a su primer vértice
+	triangles->resize(sceneStructure.scenePrimitivesIndexes.size());
+	for (size_t blas = 0; blas < sceneStructure.blasIndexOffsets.size(); blas++)
+	{
+		size_t firstTriangle = sceneStructure.blasIndexOffsets[blas];
+		size_t lastTriangle = blas + 1 < sceneStructure.blasIndexOffsets.size() ? sceneStructure.blasIndexOffsets[blas + 1] : sceneStructure.scenePrimitivesIndexes.size();
+		glm::uvec3 vertexOffset = glm::uvec3(static_cast<uint32_t>(sceneStructure.blasVertexOffsets[blas]));
+		for (size_t t = firstTriangle; t < lastTriangle; t++)
+		{
+			(*triangles)[t] = glm::uvec3(sceneStructure.scenePrimitivesIndexes[t]) + vertexOffset;
+		}
+	}
+}
+
 void RaytracingManager::cleanup(VkDevice device)
 {
 	for (const auto &bottomLevelAccelerationStructure : bottomLevelAccelerationStructures)
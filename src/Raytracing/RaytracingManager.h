@@ -5,6 +5,8 @@
 #define GLFW_EXPOSE_NATIVE_WIN32
 
 #include "Scene/Models/MeshContainer.h"
+#include "Scene/Models/SceneGeometryBuffer.h"
+#include "Buffers/Tools/UploadBatcher.h"
 
 #include <GLFW/glfw3.h>
 #include <GLFW/glfw3native.h>
@@ -63,16 +65,19 @@ private:
 	void createAccelerationStructure(VkDevice device, VkPhysicalDevice physicalDevice, AccelerationStructure &accelerationStructure, VkAccelerationStructureTypeKHR type,
 									 VkAccelerationStructureBuildSizesInfoKHR buildSizeInfo);
 	ScratchBuffer createScratchBuffer(VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize deviceSize);
-	void deleteScratchBuffer(VkDevice device, ScratchBuffer &scratchBuffer);
 
 public:
 	void enableFeatures(VkDevice device, VkPhysicalDevice physicalDevice);
-	void createBottomLevelAccelerationStructures(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool,
-												VkQueue graphicsQueue, std::vector<MeshContainer> sceneMeshes);
-	void createTopLevelAccelerationStructure(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue);
+	// Las construcciones se graban en el lote actual del UploadBatcher, que hay que enviar antes de usar la TLAS
+	// Cada BLAS lee su rango de los buffers compartidos de la escena, en el mismo orden que sceneGeometry.getSubmeshes()
+	void createBottomLevelAccelerationStructures(UploadBatcher &uploadBatcher, VkDevice device, VkPhysicalDevice physicalDevice,
+												const std::vector<MeshContainer> &sceneMeshes, const SceneGeometryBuffer &sceneGeometry);
+	void createTopLevelAccelerationStructure(UploadBatcher &uploadBatcher, VkDevice device, VkPhysicalDevice physicalDevice);
 
 	AccelerationStructure getTLAS();
 	SceneOrganizationStructure getSceneStructure();
+	// Triángulos de todas las BLAS con índices globales a la lista de posiciones, para construir la BVH de CPU
+	void getSceneTriangles(std::vector<glm::vec3> *vertices, std::vector<glm::uvec3> *triangles) const;
 
 	void cleanup(VkDevice device);
 };
\ No newline at end of file
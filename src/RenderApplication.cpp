@@ -21,6 +21,8 @@
 #include "Descriptors/DescriptorsManager.h"
 #include "Buffers/UniformBuffersManager.h"
 #include "Raytracing/RaytracingManager.h"
+#include "Raytracing/CpuBvhBenchmark.h"
+#include "Tools/SamplingSequences.h"
 
 #include <GLFW/glfw3.h>
 #include <GLFW/glfw3native.h>
@@ -35,6 +37,7 @@
 #include <cstdint>
 #include <limits>
 #include <algorithm>
+#include <chrono>
 
 RenderApplication::RenderApplication() {}
 
@@ -47,6 +50,9 @@ void RenderApplication::run()
 
 void RenderApplication::initVulkan()
 {
+    // Se mide el tiempo de arranque, tanto total como el de la carga de la escena
+    auto startupStart = std::chrono::high_resolution_clock::now();
+
     /// ---------------------------- 1 -------------------------------------
     // Se inicializan los objetos esenciales para configurar Vulkan
     vulkanInitializer.prepareVulkan();
@@ -64,22 +70,47 @@ void RenderApplication::initVulkan()
                                            vulkanInitializer.getCommandPool(), vulkanInitializer.getVkGraphicsQueue(), vulkanInitializer.getSwapChainExtent());
 
     /// ---------------------------- 3 -------------------------------------
+    // Las subidas de la escena se agrupan en lotes que comparten un anillo de staging
+    uploadBatcher.init(vulkanInitializer.getVkDevice(), vulkanInitializer.getVkPhysicalDevice(), vulkanInitializer.getCommandPool(), vulkanInitializer.getVkGraphicsQueue());
     // Creación de la escena, carga de modelos, preparación de texturas e iluminación
-    sceneManager.loadSceneAssets(vulkanInitializer.getVkDevice(), vulkanInitializer.getVkPhysicalDevice(), vulkanInitializer.getCommandPool(), vulkanInitializer.getVkGraphicsQueue());
+    auto sceneLoadStart = std::chrono::high_resolution_clock::now();
+    sceneManager.loadSceneAssets(uploadBatcher, vulkanInitializer.getVkDevice(), vulkanInitializer.getVkPhysicalDevice());
+    auto sceneLoadEnd = std::chrono::high_resolution_clock::now();
 
     // Utilizando la información de la geometría cargada, se crean las estructuras de aceleración para raytracing
     if (renderConfig == RenderMode::RAYTRACING_BASE_SHADOWS || renderConfig == RenderMode::SURFELS_GLOBAL_ILLUMINATION || renderConfig == RenderMode::SURFELS_VISUALIZATION || renderConfig == RenderMode::SURFELS_RADIANCE_VISUALIZATION)
     {
-        raytracingManager.createBottomLevelAccelerationStructures(vulkanInitializer.getVkDevice(), vulkanInitializer.getVkPhysicalDevice(), vulkanInitializer.getCommandPool(), vulkanInitializer.getVkGraphicsQueue(),
-                                                                  sceneManager.sceneMeshes);
-        raytracingManager.createTopLevelAccelerationStructure(vulkanInitializer.getVkDevice(), vulkanInitializer.getVkPhysicalDevice(), vulkanInitializer.getCommandPool(), vulkanInitializer.getVkGraphicsQueue());
+        raytracingManager.createBottomLevelAccelerationStructures(uploadBatcher, vulkanInitializer.getVkDevice(), vulkanInitializer.getVkPhysicalDevice(), sceneManager.sceneMeshes, sceneManager.sceneGeometry);
+        raytracingManager.createTopLevelAccelerationStructure(uploadBatcher, vulkanInitializer.getVkDevice(), vulkanInitializer.getVkPhysicalDevice());
+        uploadBatcher.flush();
+
+        // Rendimiento de la BVH de CPU con los mismos triángulos que las BLAS
+        if (runCpuBvhBenchmark)
+        {
+            std::vector<glm::vec3> sceneVertices;
+            std::vector<glm::uvec3> sceneTriangles;
+            raytracingManager.getSceneTriangles(&sceneVertices, &sceneTriangles);
+            CpuBvhBenchmark::run(sceneVertices, sceneTriangles);
+        }
+
+        // Uniformidad de las secuencias con las que se pueden generar las direcciones de los rayos de los surfels
+        if (runSamplingDiscrepancyReport)
+        {
+            SamplingSequences::reportDiscrepancies(raySamplingSequence, NUM_RAYS * NUM_RAYS, raySamplingSeed);
+        }
     }
 
     /// ---------------------------- 4 -------------------------------------
-    // Creación de los buffers de variables uniformes, propios de cada pasada
+    // Creación de los buffers de variables uniformes, propios de cada pasada. La caché de surfels se sube con el mismo
+    // anillo de staging que la escena
     uniformBuffersManager.createUniformBuffers(vulkanInitializer.getVkDevice(), vulkanInitializer.getVkPhysicalDevice(), vulkanInitializer.getFramesInFlight(), sceneManager.sceneLights.mainLight,
                                                vulkanInitializer.getSwapChainExtent().width, vulkanInitializer.getSwapChainExtent().height, vulkanInitializer.getCamera(), sceneManager.sceneLights,
-                                               vulkanInitializer.getCommandPool(), vulkanInitializer.getVkGraphicsQueue(), sceneManager.sceneMeshes);
+                                               vulkanInitializer.getCommandPool(), vulkanInitializer.getVkGraphicsQueue(), uploadBatcher, sceneManager.sceneDrawList.getDrawCount(),
+                                               sceneManager.sceneHash);
+    uploadBatcher.flush();
+    std::cout << std::endl << "Lotes de subida enviados: " << uploadBatcher.getSubmittedBatches() << std::endl;
+    // Terminada la carga, se libera el anillo de staging
+    uploadBatcher.cleanup();
 
     /// ---------------------------- 5 -------------------------------------
     // Se crean los descriptores asociados a cada pasada de renderizado
@@ -125,10 +156,12 @@ void RenderApplication::initVulkan()
                                              uniformBuffersManager.getShadowMappingBuffers(), renderPassesManager.getDepthImageView(), renderPassesManager.getDepthSampler(),
                                              uniformBuffersManager.getShadowCompositionLightsBuffers(), uniformBuffersManager.getShadowCompositionMainLightBuffers(), uniformBuffersManager.getShadowCompositionMVPBuffers(),
                                              renderPassesManager.getGBufferSpecularImageView(), uniformBuffersManager.getSurfelBuffer(), uniformBuffersManager.getSurfelStatsBuffer(),
-                                             uniformBuffersManager.getSurfelGridBuffer(), uniformBuffersManager.getSurfelCellBuffer(), uniformBuffersManager.getCameraSurfelBuffer(),
-                                             raytracingManager.getTLAS(), uniformBuffersManager.getIndexBufferList(), uniformBuffersManager.getVertexBufferList(),
-                                             uniformBuffersManager.getIndexBufferSizeList(), uniformBuffersManager.getVertexBufferSizeList(), uniformBuffersManager.getRaysNoiseImage(),
-                                             renderPassesManager.getIndirectDiffuseImageView(), uniformBuffersManager.getBlueNoiseImage(), renderPassesManager.getSurfelsColorImageView());
+                                             uniformBuffersManager.getSurfelGridBuffer(), uniformBuffersManager.getSurfelCellBuffer(), uniformBuffersManager.getSurfelFreeListBuffer(),
+                                             uniformBuffersManager.getCameraSurfelBuffers(), raytracingManager.getTLAS(), sceneManager.sceneGeometry, uniformBuffersManager.getRaysNoiseImage(),
+                                             renderPassesManager.getIndirectDiffuseImageView(), uniformBuffersManager.getBlueNoiseImage(), renderPassesManager.getSurfelsColorImageView(),
+                                             sceneManager.sceneDrawList, uniformBuffersManager.getSceneCullingResources(), renderPassesManager.getGBufferDepthImageView(),
+                                             uniformBuffersManager.getSurfelRayQueueBuffer(), uniformBuffersManager.getIrradianceVolumeViews(),
+                                             uniformBuffersManager.getDirectionVolumeViews());
     }
 
     /// ---------------------------- 6 -------------------------------------
@@ -162,17 +195,37 @@ void RenderApplication::initVulkan()
                                         renderPassesManager.getSSAOBlurRenderPass(), descriptorsManager.getSurfelsCompositionDescriptorSetLayout(), renderPassesManager.getSSAOCompositionRenderPass(),
                                         descriptorsManager.getShadowMappingDescriptorSetLayout(), renderPassesManager.getShadowMappingRenderPass(), descriptorsManager.getSurfelsGenerationDescriptorSetLayout(),
                                         renderPassesManager.getSurfelsVisualizationRenderPass(), descriptorsManager.getSurfelsVisualizationDescriptorSetLayout(), descriptorsManager.getSurfelsRadianceCalculationDescriptorSetLayout(),
-                                        renderPassesManager.getIndirectDiffuseRenderPass(), descriptorsManager.getSurfelsIndirectLightingDescriptorSetLayout());
+                                        renderPassesManager.getIndirectDiffuseRenderPass(), descriptorsManager.getSurfelsIndirectLightingDescriptorSetLayout(),
+                                        descriptorsManager.getSurfelsGridDescriptorSetLayout(), descriptorsManager.getSceneCullingDescriptorSetLayout(), descriptorsManager.getHiZDescriptorSetLayout(),
+                                        descriptorsManager.getSurfelsIrradianceVolumeDescriptorSetLayout());
     }
+
+    auto startupEnd = std::chrono::high_resolution_clock::now();
+    std::cout << "Tiempo de carga de la escena: " << std::chrono::duration<float, std::milli>(sceneLoadEnd - sceneLoadStart).count() << " ms" << std::endl;
+    std::cout << "Tiempo total de arranque: " << std::chrono::duration<float, std::milli>(startupEnd - startupStart).count() << " ms" << std::endl;
 }
 
 void RenderApplication::mainLoop()
 {
+    // Las estadísticas del culling de la escena se muestran una vez por segundo si están activadas
+    auto lastStatsReport = std::chrono::high_resolution_clock::now();
+
     // Se hace que la función se ejecute hasta que se cierre la ventana
     while (!glfwWindowShouldClose(vulkanInitializer.getWindow()))
     {
         glfwPollEvents();
         drawFrame();
+
+        auto now = std::chrono::high_resolution_clock::now();
+        if (reportSceneCullingStats &&
+            (renderConfig == RenderMode::SURFELS_GLOBAL_ILLUMINATION || renderConfig == RenderMode::SURFELS_VISUALIZATION || renderConfig == RenderMode::SURFELS_RADIANCE_VISUALIZATION) &&
+            std::chrono::duration<float>(now - lastStatsReport).count() >= 1.0f)
+        {
+            SceneCullingStats cullingStats = uniformBuffersManager.getSceneCullingStats();
+            std::cout << "Culling: " << cullingStats.visibleDraws << " / " << cullingStats.testedDraws << " objetos visibles (frustum: " << cullingStats.frustumCulledDraws
+                      << ", oclusion: " << cullingStats.occlusionCulledDraws << ")" << std::endl;
+            lastStatsReport = now;
+        }
     }
     vkDeviceWaitIdle(vulkanInitializer.getVkDevice());
 }
@@ -183,8 +236,10 @@ void RenderApplication::drawFrame()
 
     // 1. Esperar que termine el frame anterior
     // (Esto es problemático la primera vez que se ejecute, porque no habrá una señal previa)
+    // Con varios frames en vuelo, sólo se espera al frame que usó por última vez los recursos de este índice
     vkWaitForFences(vulkanInitializer.getVkDevice(), 1, vulkanInitializer.getFence(currentFrame), VK_TRUE, UINT64_MAX); // Esta función toma un array de fences, al indicar Vk_TRUE hay que esperar a todos (no influye porque sólo tenemos uno)
-    vkResetFences(vulkanInitializer.getVkDevice(), 1, vulkanInitializer.getFence(currentFrame));
+    // Terminado ese frame, ya se pueden leer las estadísticas de su culling
+    uniformBuffersManager.readSceneCullingStats(currentFrame);
     // 2. Tomar una imagen del swap chain
     uint32_t imageIndex; // Índice de la imagen tomada, para escgoer el framebuffer asociado
     // Se referencia al dispositivo lógico y el swap chain, junto con la herramienta de sincronización
@@ -212,12 +267,12 @@ void RenderApplication::drawFrame()
                                               renderPassesManager.getShadowMappingFramebuffer(imageIndex), pipelineManager.getShadowMappingPipeline(),
                                               pipelineManager.getShadowMappingPipelineLayout(), descriptorsManager.getShadowMappingDescriptor(currentFrame),
                                               renderPassesManager.getGeometryRenderPass(), renderPassesManager.getGeometryFramebuffer(imageIndex), pipelineManager.getGeometryPipeline(),
-                                              pipelineManager.getGeometryPipelineLayout(), descriptorsManager.getGeometryDescriptor(currentFrame), sceneManager.sceneMeshes,
+                                              pipelineManager.getGeometryPipelineLayout(), descriptorsManager.getGeometryDescriptor(currentFrame), sceneManager.sceneDrawList,
                                               *vulkanInitializer.getCamera());
     }
     else if (renderConfig == RenderMode::SSAO)
     {
-        vulkanInitializer.recordCommandBuffer(vulkanInitializer.getSwapChainExtent(), currentFrame, imageIndex, sceneManager.sceneMeshes,
+        vulkanInitializer.recordCommandBuffer(vulkanInitializer.getSwapChainExtent(), currentFrame, imageIndex, sceneManager.sceneDrawList,
                                               renderPassesManager.getGBufferRenderPass(), renderPassesManager.getGBufferFramebuffer(imageIndex), pipelineManager.getGBufferPipeline(),
                                               pipelineManager.getGBufferPipelineLayout(), descriptorsManager.getGBufferDescriptor(currentFrame),
                                               renderPassesManager.getSSAORenderPass(), renderPassesManager.getSSAOFramebuffer(imageIndex), pipelineManager.getSSAOPipeline(),
@@ -229,7 +284,7 @@ void RenderApplication::drawFrame()
     }
     else if (renderConfig == RenderMode::SSAO_SHADOW_MAPPING_PCF)
     {
-        vulkanInitializer.recordCommandBuffer(vulkanInitializer.getSwapChainExtent(), currentFrame, imageIndex, sceneManager.sceneMeshes,
+        vulkanInitializer.recordCommandBuffer(vulkanInitializer.getSwapChainExtent(), currentFrame, imageIndex, sceneManager.sceneDrawList,
                                               renderPassesManager.getGBufferRenderPass(), renderPassesManager.getGBufferFramebuffer(imageIndex), pipelineManager.getGBufferPipeline(),
                                               pipelineManager.getGBufferPipelineLayout(), descriptorsManager.getGBufferDescriptor(currentFrame),
                                               renderPassesManager.getSSAORenderPass(), renderPassesManager.getSSAOFramebuffer(imageIndex), pipelineManager.getSSAOPipeline(),
@@ -243,14 +298,13 @@ void RenderApplication::drawFrame()
     }
     else if (renderConfig == RenderMode::RAYTRACING_BASE_SHADOWS)
     {
-        vulkanInitializer.recordCommandBuffer(vulkanInitializer.getSwapChainExtent(), currentFrame, imageIndex, sceneManager.sceneMeshes,
+        vulkanInitializer.recordCommandBuffer(vulkanInitializer.getSwapChainExtent(), currentFrame, imageIndex, sceneManager.sceneDrawList,
                                               renderPassesManager.getRaytracingRenderPass(), renderPassesManager.getRaytracingFramebuffer(imageIndex), pipelineManager.getRaytracingPipeline(),
                                               pipelineManager.getRaytracingPipelineLayout(), descriptorsManager.getRaytracingDescriptor(currentFrame));
     }
     else if (renderConfig == RenderMode::SURFELS_GLOBAL_ILLUMINATION || renderConfig == RenderMode::SURFELS_VISUALIZATION || renderConfig == RenderMode::SURFELS_RADIANCE_VISUALIZATION)
     {
-        vulkanInitializer.cleanSurfelsAuxiliarBuffer();
-        vulkanInitializer.recordCommandBuffer(vulkanInitializer.getSwapChainExtent(), currentFrame, imageIndex, sceneManager.sceneMeshes,
+        vulkanInitializer.recordCommandBuffer(vulkanInitializer.getSwapChainExtent(), currentFrame, imageIndex, sceneManager.sceneDrawList,
                                               renderPassesManager.getGBufferRenderPass(), renderPassesManager.getGBufferFramebuffer(imageIndex), pipelineManager.getGBufferPipeline(),
                                               pipelineManager.getGBufferPipelineLayout(), descriptorsManager.getGBufferDescriptor(currentFrame),
                                               renderPassesManager.getSSAORenderPass(), renderPassesManager.getSSAOFramebuffer(imageIndex), pipelineManager.getSSAOPipeline(),
@@ -262,12 +316,21 @@ void RenderApplication::drawFrame()
                                               renderPassesManager.getShadowMappingRenderPass(), renderPassesManager.getShadowMappingFramebuffer(imageIndex), pipelineManager.getShadowMappingPipeline(),
                                               pipelineManager.getShadowMappingPipelineLayout(), descriptorsManager.getShadowMappingDescriptor(currentFrame),
                                               pipelineManager.getSurfelsGenerationPipeline(), pipelineManager.getSurfelsGenerationPipelineLayout(), descriptorsManager.getSurfelsGenerationDescriptor(currentFrame),
-                                              uniformBuffersManager.getSurfelStatsBuffer(), pipelineManager.getSurfelsVisualizationPipeline(), pipelineManager.getSurfelsVisualizationPipelineLayout(),
+                                              uniformBuffersManager.getSurfelStatsBuffer(), pipelineManager.getSurfelsGridCountPipeline(), pipelineManager.getSurfelsGridOffsetPipeline(),
+                                              pipelineManager.getSurfelsGridBinningPipeline(), pipelineManager.getSurfelsIndirectArgsPipeline(), pipelineManager.getSurfelsLifecyclePipeline(), pipelineManager.getSurfelsGridPipelineLayout(), descriptorsManager.getSurfelsGridDescriptor(currentFrame),
+                                              uniformBuffersManager.getSurfelGridBuffer(), pipelineManager.getSurfelsVisualizationPipeline(), pipelineManager.getSurfelsVisualizationPipelineLayout(),
                                               descriptorsManager.getSurfelsVisualizationDescriptor(currentFrame), pipelineManager.getSurfelsRadianceCalculationPipeline(),
                                               pipelineManager.getSurfelsRadianceCalculationPipelineLayout(), descriptorsManager.getSurfelsRadianceCalculationDescriptor(currentFrame), uniformBuffersManager.getSurfelBuffer(),
                                               pipelineManager.getSurfelsIndirectLightingPipeline(), pipelineManager.getSurfelsIndirectLightingPipelineLayout(), descriptorsManager.getSurfelsIndirectLightingDescriptor(currentFrame),
                                               renderPassesManager.getSurfelsVisualizationRenderPass(), renderPassesManager.getSurfelsVisualizationFramebuffer(imageIndex), renderPassesManager.getIndirectDiffuseRenderPass(),
-                                              renderPassesManager.getIndirectDiffuseFramebuffer(imageIndex));
+                                              renderPassesManager.getIndirectDiffuseFramebuffer(imageIndex), pipelineManager.getSceneCullingPipeline(), pipelineManager.getSceneCullingPipelineLayout(),
+                                              descriptorsManager.getSceneCullingDescriptor(currentFrame), pipelineManager.getHiZPipeline(), pipelineManager.getHiZPipelineLayout(),
+                                              descriptorsManager.getHiZDescriptors(), uniformBuffersManager.getSceneCullingResources(), pipelineManager.getSurfelsRayPriorityPipeline(),
+                                              pipelineManager.getSurfelsRayBudgetPipeline(), pipelineManager.getSurfelsRayBudgetPipelineLayout(), pipelineManager.getSurfelsRayEnqueuePipeline(),
+                                              uniformBuffersManager.getSurfelRayQueueBuffer(), pipelineManager.getSurfelsIrradianceVolumePipeline(),
+                                              pipelineManager.getSurfelsIrradianceVolumePipelineLayout(), descriptorsManager.getSurfelsIrradianceVolumeDescriptor(currentFrame),
+                                              pipelineManager.getSurfelsIndirectLightingTiledPipeline(), pipelineManager.getSurfelsIndirectLightingTiledPipelineLayout(),
+                                              renderPassesManager.getIndirectDiffuseImage().textureImage);
     }
 
     // 4. Se actualiza el buffer de variables uniformes
@@ -319,6 +382,9 @@ void RenderApplication::drawFrame()
         renderPassesManager.cleanupFramebuffers(vulkanInitializer.getVkDevice());
         renderPassesManager.createFramebuffers(vulkanInitializer.getNumImageViews(), vulkanInitializer.getSwapChainManager(), vulkanInitializer.getVkDevice(), vulkanInitializer.getVkPhysicalDevice(),
                                                vulkanInitializer.getCommandPool(), vulkanInitializer.getVkGraphicsQueue(), vulkanInitializer.getSwapChainExtent());
+        // La pirámide de profundidad del culling depende del tamaño de la ventana
+        uniformBuffersManager.recreateSizeDependentResources(vulkanInitializer.getVkDevice(), vulkanInitializer.getVkPhysicalDevice(), vulkanInitializer.getSwapChainExtent().width,
+                                                             vulkanInitializer.getSwapChainExtent().height, vulkanInitializer.getCommandPool(), vulkanInitializer.getVkGraphicsQueue());
         descriptorsManager.cleanupDescriptors(vulkanInitializer.getVkDevice());
         if (renderConfig == RenderMode::SHADOW_MAPPING || renderConfig == RenderMode::SHADOW_MAPPING_PCF)
         {
@@ -362,10 +428,12 @@ void RenderApplication::drawFrame()
                                                  uniformBuffersManager.getShadowMappingBuffers(), renderPassesManager.getDepthImageView(), renderPassesManager.getDepthSampler(),
                                                  uniformBuffersManager.getShadowCompositionLightsBuffers(), uniformBuffersManager.getShadowCompositionMainLightBuffers(), uniformBuffersManager.getShadowCompositionMVPBuffers(),
                                                  renderPassesManager.getGBufferSpecularImageView(), uniformBuffersManager.getSurfelBuffer(), uniformBuffersManager.getSurfelStatsBuffer(),
-                                                 uniformBuffersManager.getSurfelGridBuffer(), uniformBuffersManager.getSurfelCellBuffer(), uniformBuffersManager.getCameraSurfelBuffer(),
-                                                 raytracingManager.getTLAS(), uniformBuffersManager.getIndexBufferList(), uniformBuffersManager.getVertexBufferList(),
-                                                 uniformBuffersManager.getIndexBufferSizeList(), uniformBuffersManager.getVertexBufferSizeList(), uniformBuffersManager.getRaysNoiseImage(),
-                                                 renderPassesManager.getIndirectDiffuseImageView(), uniformBuffersManager.getBlueNoiseImage(), renderPassesManager.getSurfelsColorImageView());
+                                                 uniformBuffersManager.getSurfelGridBuffer(), uniformBuffersManager.getSurfelCellBuffer(), uniformBuffersManager.getSurfelFreeListBuffer(),
+                                                 uniformBuffersManager.getCameraSurfelBuffers(), raytracingManager.getTLAS(), sceneManager.sceneGeometry, uniformBuffersManager.getRaysNoiseImage(),
+                                                 renderPassesManager.getIndirectDiffuseImageView(), uniformBuffersManager.getBlueNoiseImage(), renderPassesManager.getSurfelsColorImageView(),
+                                                 sceneManager.sceneDrawList, uniformBuffersManager.getSceneCullingResources(), renderPassesManager.getGBufferDepthImageView(),
+                                                 uniformBuffersManager.getSurfelRayQueueBuffer(), uniformBuffersManager.getIrradianceVolumeViews(),
+                                                 uniformBuffersManager.getDirectionVolumeViews());
         }
     }
     else if (result != VK_SUCCESS)
@@ -377,6 +445,8 @@ void RenderApplication::drawFrame()
 
 void RenderApplication::cleanup()
 {
+    // Antes de liberar nada, se guardan los surfels para el siguiente arranque
+    uniformBuffersManager.saveSurfelCache(vulkanInitializer.getVkDevice(), vulkanInitializer.getVkPhysicalDevice(), vulkanInitializer.getCommandPool(), vulkanInitializer.getVkGraphicsQueue());
     // Se limpian todos los recursos de la swap chain
     vulkanInitializer.cleanupSwapChain();
     // Se limpian las pasadas de renderizado y sus framebuffer asociados
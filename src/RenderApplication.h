@@ -13,6 +13,7 @@
 #include "Buffers/UniformBuffersManager.h"
 #include "Descriptors/DescriptorsManager.h"
 #include "Raytracing/RaytracingManager.h"
+#include "Buffers/Tools/UploadBatcher.h"
 
 #include <GLFW/glfw3.h>
 #include <GLFW/glfw3native.h>
@@ -52,6 +53,8 @@ private:
 	PipelineManager pipelineManager;
 	// Gestor del raytracing
 	RaytracingManager raytracingManager;
+	// Agrupador de las subidas de datos a la GPU durante la carga
+	UploadBatcher uploadBatcher;
 
 	uint32_t currentFrame = 0;
 
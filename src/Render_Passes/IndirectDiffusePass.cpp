@@ -6,6 +6,7 @@
 
 #include "Initializers/SwapChainManager.h"
 #include "Utils/DepthBuffer.h"
+#include "Surfels/SurfelData.h"
 
 #include <GLFW/glfw3.h>
 #include <GLFW/glfw3native.h>
@@ -69,8 +70,10 @@ void IndirectDiffusePass::createRenderPass(VkDevice device, VkFormat format, VkP
 
 void IndirectDiffusePass::createImageAttachments(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue, VkExtent2D swapChainExtent)
 {
-    // Attachment 0: Color
-    colorImage.createImage(device, physicalDevice, swapChainExtent.width, swapChainExtent.height, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+    // Attachment 0: Color. El gather por teselas la escribe desde un compute shader
+    VkExtent2D imageExtent = getImageExtent(swapChainExtent);
+    colorImage.createImage(device, physicalDevice, imageExtent.width, imageExtent.height, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL,
+                           VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT,
                            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, colorImage.textureImage, colorImage.textureImageMemory, "Surfels-Visualization");
     colorImage.textureImageView = colorImage.createImageView(device, colorImage.textureImage, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT, false);
 }
@@ -91,8 +94,8 @@ void IndirectDiffusePass::createFramebuffers(uint32_t numImageViews, SwapChainMa
         framebufferInfo.renderPass = renderPass;
         framebufferInfo.attachmentCount = attachments.size();
         framebufferInfo.pAttachments = attachments.data();
-        framebufferInfo.width = swapChainManager.getSwapChainExtent().width;
-        framebufferInfo.height = swapChainManager.getSwapChainExtent().height;
+        framebufferInfo.width = getImageExtent(swapChainManager.getSwapChainExtent()).width;
+        framebufferInfo.height = getImageExtent(swapChainManager.getSwapChainExtent()).height;
         framebufferInfo.layers = 1;
 
         if (vkCreateFramebuffer(device, &framebufferInfo, nullptr, &framebuffers[i]) != VK_SUCCESS)
@@ -129,4 +132,11 @@ VkImageView IndirectDiffusePass::getColorImageView()
 ImageCreator IndirectDiffusePass::getColorImage()
 {
     return this->colorImage;
+}
+
+VkExtent2D IndirectDiffusePass::getImageExtent(VkExtent2D swapChainExtent)
+{
+    // Se redondea hacia arriba para que cada píxel de la pantalla tenga un bloque en la imagen reducida
+    uint32_t downscale = SurfelShader::INDIRECT_DIFFUSE_DOWNSCALE;
+    return {(swapChainExtent.width + downscale - 1) / downscale, (swapChainExtent.height + downscale - 1) / downscale};
 }
\ No newline at end of file
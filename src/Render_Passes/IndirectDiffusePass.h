@@ -32,4 +32,7 @@ public:
 
     VkImageView getColorImageView();
     ImageCreator getColorImage();
+
+    // Resolución reducida a la que se calcula la iluminación indirecta
+    static VkExtent2D getImageExtent(VkExtent2D swapChainExtent);
 };
\ No newline at end of file
@@ -14,13 +14,34 @@
 
 MaterialsManager::MaterialsManager() {}
 
-void MaterialsManager::prepareTextureMaterials(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue)
+std::vector<std::future<TextureData>> MaterialsManager::decodeTextures(ThreadPool &threadPool)
 {
+    std::vector<std::future<TextureData>> decodedTextures;
+    decodedTextures.reserve(diffuseTexturesPath.size() + alphaTexturesPath.size() + specularTexturesPath.size());
+
+    for (const std::vector<char *> *texturesPath : {&diffuseTexturesPath, &alphaTexturesPath, &specularTexturesPath})
+    {
+        for (const char *texturePath : *texturesPath)
+        {
+            decodedTextures.push_back(threadPool.enqueue([texturePath]()
+                                                         { return ImageCreator::loadTextureData(texturePath); }));
+        }
+    }
+    return decodedTextures;
+}
+
+void MaterialsManager::prepareTextureMaterials(UploadBatcher &uploadBatcher, VkDevice device, VkPhysicalDevice physicalDevice,
+                                               std::vector<std::future<TextureData>> &decodedTextures)
+{
+    // Las texturas se recogen en el mismo orden en el que se encolaron, esperando sólo por la siguiente que se va a subir
+    uint32_t decodedIndex = 0;
+
     diffuseImageCreators.resize(diffuseTexturesPath.size());
 
     for (uint32_t i = 0; i < diffuseTexturesPath.size(); i++)
     {
-        diffuseImageCreators[i].createTextureImage(device, physicalDevice, commandPool, graphicsQueue, diffuseTexturesPath[i]);
+        TextureData textureData = decodedTextures[decodedIndex++].get();
+        diffuseImageCreators[i].createTextureImage(uploadBatcher, device, physicalDevice, textureData);
         diffuseImageCreators[i].createTextureImageView(device);
         diffuseImageCreators[i].createTextureSampler(device, physicalDevice);
     }
@@ -29,7 +50,8 @@ void MaterialsManager::prepareTextureMaterials(VkDevice device, VkPhysicalDevice
 
     for (uint32_t i = 0; i < alphaTexturesPath.size(); i++)
     {
-        alphaImageCreators[i].createTextureImage(device, physicalDevice, commandPool, graphicsQueue, alphaTexturesPath[i]);
+        TextureData textureData = decodedTextures[decodedIndex++].get();
+        alphaImageCreators[i].createTextureImage(uploadBatcher, device, physicalDevice, textureData);
         alphaImageCreators[i].createTextureImageView(device);
         alphaImageCreators[i].createTextureSampler(device, physicalDevice);
     }
@@ -38,7 +60,8 @@ void MaterialsManager::prepareTextureMaterials(VkDevice device, VkPhysicalDevice
 
     for (uint32_t i = 0; i < specularTexturesPath.size(); i++)
     {
-        specularImageCreators[i].createTextureImage(device, physicalDevice, commandPool, graphicsQueue, specularTexturesPath[i]);
+        TextureData textureData = decodedTextures[decodedIndex++].get();
+        specularImageCreators[i].createTextureImage(uploadBatcher, device, physicalDevice, textureData);
         specularImageCreators[i].createTextureImageView(device);
         specularImageCreators[i].createTextureSampler(device, physicalDevice);
     }
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "Images/ImageCreator.h"
+#include "Buffers/Tools/UploadBatcher.h"
+#include "Tools/ThreadPool.h"
 
 #define VK_USE_PLATFORM_WIN32_KHR
 #define GLFW_INCLUDE_VULKAN
@@ -10,6 +12,7 @@
 #include <GLFW/glfw3native.h>
 
 #include <vector>
+#include <future>
 
 class MaterialsManager
 {
@@ -26,7 +29,11 @@ public:
 
     MaterialsManager();
 
-    void prepareTextureMaterials(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue);
+    // Encola la decodificación de todas las texturas (difusas, transparencia y especulares, en ese orden)
+    std::vector<std::future<TextureData>> decodeTextures(ThreadPool &threadPool);
+    // Las subidas de todas las texturas se graban en los lotes del UploadBatcher, recogiendo las texturas decodificadas en orden
+    void prepareTextureMaterials(UploadBatcher &uploadBatcher, VkDevice device, VkPhysicalDevice physicalDevice,
+                                 std::vector<std::future<TextureData>> &decodedTextures);
     void cleanup(VkDevice device);
 
     std::vector<ImageCreator> getDiffuseImages();
@@ -13,7 +13,6 @@
 
 #include <vector>
 
-void MeshContainer::loadVertexData(VkDevice device, VkPhysicalDevice physicalDevice,
-    VkCommandPool commandPool, VkQueue graphicsQueue, const std::string& filePath, uint32_t* materialIndex) {
-        vertexMeshesData.createBufferData(device, physicalDevice, commandPool, graphicsQueue, filePath, materialIndex);
+void MeshContainer::loadVertexData(ImportedModel& model, uint32_t* materialIndex) {
+        vertexMeshesData.setModelData(model, materialIndex);
 }
\ No newline at end of file
@@ -21,7 +21,6 @@ public:
     // Información de todos los objetos dentro del fichero del modelo
     VertexBuffer vertexMeshesData;
 
-    // Función para cargar los datos de los vértices del modelo
-    void loadVertexData(VkDevice device, VkPhysicalDevice physicalDevice,
-		VkCommandPool commandPool, VkQueue graphicsQueue, const std::string& filePath, uint32_t* materialIndex);
+    // Función para cargar los datos de los vértices del modelo ya importado
+    void loadVertexData(ImportedModel& model, uint32_t* materialIndex);
 };
\ No newline at end of file
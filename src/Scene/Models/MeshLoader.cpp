@@ -1,5 +1,7 @@
 #include "MeshLoader.h"
 
+#include "Tools/MappedFile.h"
+
 #define VK_USE_PLATFORM_WIN32_KHR
 #define GLFW_INCLUDE_VULKAN
 #define GLFW_EXPOSE_NATIVE_WIN32
@@ -15,111 +17,274 @@
 #include <array>
 #include <string>
 #include <stdexcept>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <cstring>
+
+ImportedModel MeshLoader::importModel(const std::string& filePath) {
+    ImportedModel model;
+    // Con el tamaño y la fecha del fichero original se sabe si la versión cocinada sigue siendo válida sin leerlo. Sólo
+    // si han cambiado se compara el hash de su contenido
+    SourceFileStamp sourceStamp = getSourceStamp(filePath);
+    std::string cookedPath = getCookedPath(filePath);
+    // Si existe una versión cocinada del mismo fichero y con los mismos parámetros, se evita Assimp
+    bool stampOutdated = false;
+    if (loadCookedModel(cookedPath, filePath, sourceStamp, &model, &stampOutdated)) {
+        if (stampOutdated) {
+            updateCookedStamp(cookedPath, sourceStamp);
+        }
+        computeBounds(&model);
+        return model;
+    }
+    uint64_t sourceHash = hashSourceFile(filePath);
+    model.sourceHash = sourceHash;
 
-void MeshLoader::loadModel(const std::string& filePath, std::vector<std::vector<Vertex>>* vertices, std::vector<std::vector<uint16_t>>* indices, uint32_t* materialIndex) {
     // Se crea un importador de la librería assimp
     Assimp::Importer importer;
     // Se carga el modelo desde la ruta dada
-    const aiScene* scene = importer.ReadFile(filePath,
-        aiProcess_CalcTangentSpace |
-        aiProcess_Triangulate |
-        aiProcess_JoinIdenticalVertices |
-        aiProcess_SortByPType |
-        aiProcess_MakeLeftHanded |
-        aiProcess_FlipUVs |            
-        aiProcess_FlipWindingOrder |
-        aiProcess_PreTransformVertices);
+    const aiScene* scene = importer.ReadFile(filePath, MESH_IMPORT_FLAGS);
     // En caso de que no se cargue correctamente, se lanza una excepción
     if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
         throw std::runtime_error("Error al cargar el modelo: " + std::string(importer.GetErrorString()));
     }
     // Procesar las mallas de la escena, para obtener sus datos
-    processMeshes(scene, vertices, indices, materialIndex);
+    processMeshes(scene, &model);
+    // Se guarda la versión cocinada para los siguientes arranques
+    writeCookedModel(cookedPath, sourceHash, sourceStamp, model);
+    computeBounds(&model);
+    return model;
 }
 
-void MeshLoader::processMeshes(const aiScene* scene, std::vector<std::vector<Vertex>>* vertices, std::vector<std::vector<uint16_t>>* indices, uint32_t* materialIndex) {
+void MeshLoader::assignMaterials(ImportedModel* model, uint32_t* materialIndex) {
     // Variables auxiliares para detectar si un modelo tiene multi-material
     uint32_t lastMeshMaterialId = 0;
     uint32_t textureIndex = (*materialIndex);
+    for (size_t i = 0; i < model->meshMaterialIds.size(); i++) {
+        uint32_t meshMaterialId = model->meshMaterialIds[i];
+        // Índice del material
+        if (meshMaterialId > lastMeshMaterialId && (*materialIndex) < MULTI_OBJECT_LIMIT_INDEX) {
+            (*materialIndex)++; // Significa que el modelo tiene más de un material
+            lastMeshMaterialId = meshMaterialId;
+        }
+
+        // Se asigna el índice del material a cada vértice de la malla
+        for (auto& vertex : model->vertices[i]) {
+            vertex.idMaterial = textureIndex + meshMaterialId;
+        }
+    }
+    // Se incrementa el índice del material para el siguiente objeto
+    (*materialIndex)++;
+}
+
+void MeshLoader::processMeshes(const aiScene* scene, ImportedModel* model) {
+    model->vertices.resize(scene->mNumMeshes);
+    model->indices.resize(scene->mNumMeshes);
+    model->meshMaterialIds.resize(scene->mNumMeshes);
     // Se recorren todas las mallas de la escena
     for (unsigned int i = 0; i < scene->mNumMeshes; i++) {
-        // Se inicializa el vector de vértices y de índices
-        std::vector<Vertex> listaVertices;
-        std::vector<uint16_t> listaIndices;
-        (*vertices).push_back(listaVertices);
-        (*indices).push_back(listaIndices);
         // Se obtiene la malla actual
         aiMesh* mesh = scene->mMeshes[i];
-        // Índices para recorrer los distintos conjuntos de información de la malla
-        unsigned int faceIndex = 0; // Caras, para extraer los índices
-
-        // Vértices, posición
-        if (mesh->HasPositions()) {
-            // Se recorren los vértices de la malla
-            for (unsigned int j = 0; j < mesh->mNumVertices; j++) {
-                // Se crea un nuevo vértice
-                Vertex nVertex;
-                // Se lee la posición del vértice actual de la malla
-                const aiVector3D* vertexMeshPos = &mesh->mVertices[j];
-                // Se pasa esa información a un vec3 para poder asignarla al nuevo vértice
-                glm::vec3 vertexPosition = {vertexMeshPos->x, vertexMeshPos->y, vertexMeshPos->z};
-                nVertex.pos = vertexPosition;
-                // Se añade el vértice al vector global
-                (*vertices)[i].push_back(nVertex);
-            }
-        }
+        // Se reserva de una vez el espacio de los vértices, inicializados a cero
+        std::vector<Vertex>& meshVertices = model->vertices[i];
+        meshVertices.resize(mesh->HasPositions() ? mesh->mNumVertices : 0);
 
-        // Normales. Por el momento, se almacenan como color del modelo
-        if (mesh->HasNormals()) {
-            // De nuevo, se recorren todos los vértices de la malla
-            for (unsigned int k = 0; k < mesh->mNumVertices; k++) {
-                // Se lee la normal del vértice actual
-                const aiVector3D* normal = &mesh->mNormals[k];
-                // Se pasa esa información a un vec3 para poder asignarla al nuevo vértice
-                glm::vec3 vertexNormal = { normal->x, normal->y, normal->z };
-                // Se actualiza la información del vértice
-                (*vertices)[i].at(k).normal = vertexNormal;
+        // Se recorren los vértices de la malla, tomando posición, normal y coordenadas de textura
+        for (unsigned int j = 0; j < meshVertices.size(); j++) {
+            Vertex& vertex = meshVertices[j];
+            // Posición
+            const aiVector3D& vertexMeshPos = mesh->mVertices[j];
+            vertex.pos = glm::vec3(vertexMeshPos.x, vertexMeshPos.y, vertexMeshPos.z);
+            // Normal
+            if (mesh->HasNormals()) {
+                const aiVector3D& normal = mesh->mNormals[j];
+                vertex.normal = glm::vec3(normal.x, normal.y, normal.z);
+            }
+            // Coordenadas de textura
+            if (mesh->HasTextureCoords(0)) {
+                const aiVector3D& textCoord = mesh->mTextureCoords[0][j];
+                vertex.texCoord = glm::vec2(textCoord.x, textCoord.y);
             }
         }
 
-        // Coordenadas de textura
-        if (mesh->mTextureCoords != NULL) {
-            // Se recorren todos los vértice de la malla
-            for (unsigned int l = 0; l < mesh->mNumVertices; l++) {
-                // Se leen las coordenadas de textura del vértice actual
-                const aiVector3D* textCoord = &mesh->mTextureCoords[0][l];
-                // Se pasa la información a un vec2 para poder asignarla al nuevo vértice
-                glm::vec2 vertexTextCoord = { textCoord->x, textCoord->y };
-                // Se actualiza la información del vértice
-                (*vertices)[i].at(l).texCoord = vertexTextCoord;
+        // Se guarda el material de la malla, que se traduce al de la escena al asignar los materiales
+        model->meshMaterialIds[i] = mesh->mMaterialIndex;
+
+        // Índices de las caras. Al triangular, todas las caras tienen tres índices
+        std::vector<uint32_t>& meshIndices = model->indices[i];
+        meshIndices.reserve(static_cast<size_t>(mesh->mNumFaces) * 3);
+        for (unsigned int t = 0; t < mesh->mNumFaces; t++) {
+            const aiFace& face = mesh->mFaces[t];
+            for (unsigned int s = 0; s < face.mNumIndices; s++) {
+                meshIndices.push_back(static_cast<uint32_t>(face.mIndices[s]));
             }
         }
+    }
+}
 
-        // Índice del material
-        if (mesh->mMaterialIndex > lastMeshMaterialId && (*materialIndex) < MULTI_OBJECT_LIMIT_INDEX) {
-            (*materialIndex)++; // Significa que el modelo tiene más de un material
-            lastMeshMaterialId = mesh->mMaterialIndex;
+void MeshLoader::computeBounds(ImportedModel* model) {
+    // Se calcula la caja envolvente de cada malla a partir de sus vértices. Es barato comparado con la carga,
+    // por lo que no se guarda en el formato cocinado
+    model->bounds.resize(model->vertices.size());
+    for (size_t i = 0; i < model->vertices.size(); i++) {
+        MeshBounds& meshBounds = model->bounds[i];
+        if (model->vertices[i].empty()) {
+            meshBounds.min = glm::vec3(0.0f);
+            meshBounds.max = glm::vec3(0.0f);
+            continue;
         }
-
-        // Se asigna el índice del material a cada vértice de la malla
-        for(unsigned int m = 0; m < mesh->mNumVertices; m++) {
-            (*vertices)[i].at(m).idMaterial = textureIndex + mesh->mMaterialIndex;
+        meshBounds.min = model->vertices[i][0].pos;
+        meshBounds.max = model->vertices[i][0].pos;
+        for (const Vertex& vertex : model->vertices[i]) {
+            meshBounds.min = glm::min(meshBounds.min, vertex.pos);
+            meshBounds.max = glm::max(meshBounds.max, vertex.pos);
         }
+    }
+}
 
-        // Índices de las caras
-        if (mesh->HasFaces()) {
-            // Se recorren todas las caras de la malla
-            for (unsigned int t = 0; t < mesh->mNumFaces; t++) {
-                // Se obtiene la cara actual
-                const aiFace* face = &mesh->mFaces[t];
-                // Se copian los datos al vector de índices
-                for (unsigned int s = 0; s < face->mNumIndices; s++) {
-                    (*indices)[i].push_back(face->mIndices[s]);
-                }
-            }
+uint64_t MeshLoader::hashSourceFile(const std::string& filePath) {
+    MappedFile sourceFile;
+    if (!sourceFile.open(filePath)) {
+        throw std::runtime_error("Error al abrir el modelo: " + filePath);
+    }
+    // FNV-1a de 64 bits sobre el contenido del fichero
+    uint64_t hash = 14695981039346656037ull;
+    const uint8_t* data = sourceFile.getData();
+    for (size_t i = 0; i < sourceFile.getSize(); i++) {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+SourceFileStamp MeshLoader::getSourceStamp(const std::string& filePath) {
+    std::error_code sizeError;
+    std::error_code timeError;
+    SourceFileStamp stamp{};
+    stamp.size = std::filesystem::file_size(filePath, sizeError);
+    stamp.writeTime = static_cast<int64_t>(std::filesystem::last_write_time(filePath, timeError).time_since_epoch().count());
+    if (sizeError || timeError) {
+        throw std::runtime_error("Error al abrir el modelo: " + filePath);
+    }
+    return stamp;
+}
+
+std::string MeshLoader::getCookedPath(const std::string& filePath) {
+    std::filesystem::path sourcePath(filePath);
+    return (std::filesystem::path(MESH_CACHE_PATH) / sourcePath.stem()).string() + ".mesh";
+}
+
+bool MeshLoader::loadCookedModel(const std::string& cookedPath, const std::string& filePath, const SourceFileStamp& sourceStamp, ImportedModel* model,
+                                 bool* stampOutdated) {
+    // El fichero entero se proyecta en memoria, y los datos se copian directamente a los vectores
+    MappedFile cookedFile;
+    if (!cookedFile.open(cookedPath) || cookedFile.getSize() < sizeof(CookedMeshHeader)) {
+        return false;
+    }
+    const uint8_t* data = cookedFile.getData();
+    const CookedMeshHeader* header = reinterpret_cast<const CookedMeshHeader*>(data);
+    // Cualquier cambio en el formato, en el fichero original o en los parámetros de importación invalida la caché
+    if (memcmp(header->magic, COOKED_MESH_MAGIC, sizeof(header->magic)) != 0 || header->version != COOKED_MESH_VERSION ||
+        header->importFlags != MESH_IMPORT_FLAGS || header->vertexStride != sizeof(Vertex) || header->indexStride != sizeof(uint32_t)) {
+        return false;
+    }
+    // El contenido del fichero original sólo se lee si su tamaño o su fecha no coinciden con los de la caché
+    *stampOutdated = header->sourceSize != sourceStamp.size || header->sourceWriteTime != sourceStamp.writeTime;
+    if (*stampOutdated && hashSourceFile(filePath) != header->sourceHash) {
+        return false;
+    }
+    model->sourceHash = header->sourceHash;
+    size_t submeshesEnd = sizeof(CookedMeshHeader) + static_cast<size_t>(header->meshCount) * sizeof(CookedSubmesh);
+    if (cookedFile.getSize() < submeshesEnd) {
+        return false;
+    }
+    const CookedSubmesh* submeshes = reinterpret_cast<const CookedSubmesh*>(data + sizeof(CookedMeshHeader));
+
+    model->vertices.resize(header->meshCount);
+    model->indices.resize(header->meshCount);
+    model->meshMaterialIds.resize(header->meshCount);
+    for (uint32_t i = 0; i < header->meshCount; i++) {
+        const CookedSubmesh& submesh = submeshes[i];
+        size_t vertexBytes = static_cast<size_t>(submesh.vertexCount) * sizeof(Vertex);
+        size_t indexBytes = static_cast<size_t>(submesh.indexCount) * sizeof(uint32_t);
+        if (submesh.vertexOffset + vertexBytes > cookedFile.getSize() || submesh.indexOffset + indexBytes > cookedFile.getSize()) {
+            return false;
         }
+        model->meshMaterialIds[i] = submesh.materialId;
+        model->vertices[i].resize(submesh.vertexCount);
+        memcpy(model->vertices[i].data(), data + submesh.vertexOffset, vertexBytes);
+        model->indices[i].resize(submesh.indexCount);
+        memcpy(model->indices[i].data(), data + submesh.indexOffset, indexBytes);
+    }
+    return true;
+}
+
+void MeshLoader::writeCookedModel(const std::string& cookedPath, uint64_t sourceHash, const SourceFileStamp& sourceStamp, const ImportedModel& model) {
+    std::error_code errorCode;
+    std::filesystem::create_directories(std::filesystem::path(cookedPath).parent_path(), errorCode);
 
+    CookedMeshHeader header{};
+    memcpy(header.magic, COOKED_MESH_MAGIC, sizeof(header.magic));
+    header.version = COOKED_MESH_VERSION;
+    header.importFlags = MESH_IMPORT_FLAGS;
+    header.vertexStride = sizeof(Vertex);
+    header.indexStride = sizeof(uint32_t);
+    header.meshCount = static_cast<uint32_t>(model.vertices.size());
+    header.sourceHash = sourceHash;
+    header.sourceSize = sourceStamp.size;
+    header.sourceWriteTime = sourceStamp.writeTime;
+
+    // Los datos de cada malla empiezan alineados, para poder leerlos directamente desde el fichero proyectado
+    std::vector<CookedSubmesh> submeshes(header.meshCount);
+    uint64_t offset = alignCookedOffset(sizeof(CookedMeshHeader) + submeshes.size() * sizeof(CookedSubmesh));
+    for (uint32_t i = 0; i < header.meshCount; i++) {
+        submeshes[i].materialId = model.meshMaterialIds[i];
+        submeshes[i].vertexCount = static_cast<uint32_t>(model.vertices[i].size());
+        submeshes[i].indexCount = static_cast<uint32_t>(model.indices[i].size());
+        submeshes[i].vertexOffset = offset;
+        offset = alignCookedOffset(offset + model.vertices[i].size() * sizeof(Vertex));
+        submeshes[i].indexOffset = offset;
+        offset = alignCookedOffset(offset + model.indices[i].size() * sizeof(uint32_t));
     }
-    // Se incrementa el índice del material para el siguiente objeto
-    (*materialIndex)++;      
+
+    // Se escribe en un fichero temporal y se renombra al terminar, para no dejar nunca un fichero a medias
+    std::string temporaryPath = cookedPath + ".tmp";
+    std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "No se ha podido escribir la cache del modelo: " << cookedPath << std::endl;
+        return;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(submeshes.data()), submeshes.size() * sizeof(CookedSubmesh));
+    const char padding[COOKED_MESH_ALIGNMENT] = {};
+    for (uint32_t i = 0; i < header.meshCount; i++) {
+        file.write(padding, submeshes[i].vertexOffset - static_cast<uint64_t>(file.tellp()));
+        file.write(reinterpret_cast<const char*>(model.vertices[i].data()), model.vertices[i].size() * sizeof(Vertex));
+        file.write(padding, submeshes[i].indexOffset - static_cast<uint64_t>(file.tellp()));
+        file.write(reinterpret_cast<const char*>(model.indices[i].data()), model.indices[i].size() * sizeof(uint32_t));
+    }
+    file.close();
+
+    std::filesystem::rename(temporaryPath, cookedPath, errorCode);
+    if (errorCode) {
+        std::filesystem::remove(temporaryPath, errorCode);
+    }
+}
+
+void MeshLoader::updateCookedStamp(const std::string& cookedPath, const SourceFileStamp& sourceStamp) {
+    // Sólo se reescriben el tamaño y la fecha de la cabecera, para no volver a leer el fichero original en el siguiente
+    // arranque. Si falla, la caché sigue siendo válida y simplemente se vuelve a comprobar el hash
+    std::fstream file(cookedPath, std::ios::binary | std::ios::in | std::ios::out);
+    CookedMeshHeader header{};
+    if (!file || !file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+        return;
+    }
+    header.sourceSize = sourceStamp.size;
+    header.sourceWriteTime = sourceStamp.writeTime;
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+uint64_t MeshLoader::alignCookedOffset(uint64_t offset) {
+    return (offset + COOKED_MESH_ALIGNMENT - 1) & ~static_cast<uint64_t>(COOKED_MESH_ALIGNMENT - 1);
 }
\ No newline at end of file
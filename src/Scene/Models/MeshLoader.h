@@ -90,13 +90,95 @@ struct Vertex
     }
 };
 
+// Caja envolvente alineada con los ejes de una malla, en espacio de mundo (los modelos se importan ya transformados)
+struct MeshBounds
+{
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+// Datos de un fichero de modelo importado, antes de asignarle los materiales de la escena
+struct ImportedModel
+{
+    std::vector<std::vector<Vertex>> vertices;
+    std::vector<std::vector<uint32_t>> indices;
+    // Índice del material de cada malla dentro del fichero
+    std::vector<uint32_t> meshMaterialIds;
+    // Volumen envolvente de cada malla, para el culling de la escena
+    std::vector<MeshBounds> bounds;
+    // Hash del fichero original, que forma parte del hash de la escena
+    uint64_t sourceHash = 0;
+};
+
+// Formato cocinado de los modelos: cabecera, tabla de mallas y, a continuación, los vértices e índices de cada malla
+// tal y como están en memoria, para cargarlos sin pasar por Assimp
+struct CookedMeshHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t sourceHash;   // Hash del fichero original
+    uint32_t importFlags;  // Parámetros de importación de Assimp con los que se generó
+    uint32_t vertexStride; // Tamaño de Vertex y de los índices, por si cambian las estructuras
+    uint32_t indexStride;
+    uint32_t meshCount;
+    uint64_t sourceSize;     // Tamaño y fecha de modificación del fichero original cuando se comprobó su hash. Mientras no
+    int64_t sourceWriteTime; // cambien, no hace falta leer el fichero entero para validar la caché
+};
+
+// Tamaño y fecha de modificación de un fichero original
+struct SourceFileStamp
+{
+    uint64_t size;
+    int64_t writeTime;
+};
+
+struct CookedSubmesh
+{
+    uint32_t materialId;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t _pad;
+    uint64_t vertexOffset; // Offsets desde el principio del fichero
+    uint64_t indexOffset;
+};
+
 class MeshLoader
 {
 
 public:
     static const int MULTI_OBJECT_LIMIT_INDEX = 5;
-    static void loadModel(const std::string &filePath, std::vector<std::vector<Vertex>> *vertices, std::vector<std::vector<uint16_t>> *indices, uint32_t *materialIndex);
+    // Parámetros de importación de Assimp, que forman parte de la clave de la caché
+    static const unsigned int MESH_IMPORT_FLAGS = aiProcess_CalcTangentSpace |
+                                                  aiProcess_Triangulate |
+                                                  aiProcess_JoinIdenticalVertices |
+                                                  aiProcess_SortByPType |
+                                                  aiProcess_MakeLeftHanded |
+                                                  aiProcess_FlipUVs |
+                                                  aiProcess_FlipWindingOrder |
+                                                  aiProcess_PreTransformVertices;
+    static constexpr const char *COOKED_MESH_MAGIC = "SMSH";
+    static const uint32_t COOKED_MESH_VERSION = 3; // v2: índices de 32 bits, v3: tamaño y fecha del fichero original
+    static const uint32_t COOKED_MESH_ALIGNMENT = 16;
+    static constexpr const char *MESH_CACHE_PATH = RESOURCES_PATH "cache/meshes";
+    // Importa el fichero desde su versión cocinada o, si no existe o está desactualizada, con Assimp
+    // No depende de ningún estado compartido, por lo que se puede ejecutar en paralelo
+    static ImportedModel importModel(const std::string &filePath);
+    // Asigna a los vértices el material de la escena. Depende del índice acumulado de los modelos anteriores, por lo que se llama en orden
+    static void assignMaterials(ImportedModel *model, uint32_t *materialIndex);
 
 private:
-    static void processMeshes(const aiScene *scene, std::vector<std::vector<Vertex>> *vertices, std::vector<std::vector<uint16_t>> *indices, uint32_t *materialIndex);
+    static void processMeshes(const aiScene *scene, ImportedModel *model);
+    static void computeBounds(ImportedModel *model);
+
+    // Caché de modelos cocinados
+    static uint64_t hashSourceFile(const std::string &filePath);
+    static SourceFileStamp getSourceStamp(const std::string &filePath);
+    static std::string getCookedPath(const std::string &filePath);
+    // Carga la versión cocinada si sigue siendo válida, y deja en model->sourceHash el hash del fichero original. Si el
+    // tamaño o la fecha han cambiado pero el contenido no, lo indica en stampOutdated para actualizar la cabecera
+    static bool loadCookedModel(const std::string &cookedPath, const std::string &filePath, const SourceFileStamp &sourceStamp, ImportedModel *model,
+                                bool *stampOutdated);
+    static void writeCookedModel(const std::string &cookedPath, uint64_t sourceHash, const SourceFileStamp &sourceStamp, const ImportedModel &model);
+    static void updateCookedStamp(const std::string &cookedPath, const SourceFileStamp &sourceStamp);
+    static uint64_t alignCookedOffset(uint64_t offset);
 };
\ No newline at end of file
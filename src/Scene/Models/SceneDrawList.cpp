@@ -0,0 +1,111 @@
+#include "SceneDrawList.h"
+
+#include "Buffers/Tools/BufferCreator.h"
+#include "Buffers/Tools/UploadBatcher.h"
+
+#define VK_USE_PLATFORM_WIN32_KHR
+#define GLFW_INCLUDE_VULKAN
+#define GLFW_EXPOSE_NATIVE_WIN32
+
+#include <GLFW/glfw3.h>
+#include <GLFW/glfw3native.h>
+
+#include <vector>
+
+void SceneDrawList::build(UploadBatcher &uploadBatcher, VkDevice device, VkPhysicalDevice physicalDevice, const SceneGeometryBuffer &sceneGeometry)
+{
+    drawCommands.clear();
+
+    vertexBuffer = sceneGeometry.getVertexBuffer();
+    indexBuffer = sceneGeometry.getIndexBuffer();
+
+    for (const auto &submesh : sceneGeometry.getSubmeshes())
+    {
+        DrawCommand drawCommand{};
+        drawCommand.firstIndex = submesh.firstIndex;
+        drawCommand.indexCount = submesh.indexCount;
+        drawCommand.vertexOffset = submesh.vertexOffset;
+        drawCommand.materialId = submesh.materialId;
+
+        drawCommands.push_back(drawCommand);
+    }
+
+    // Se traducen los comandos al formato de Vulkan. Cada objeto es una única instancia, y su firstInstance
+    // indica a los shaders qué entrada de los datos de dibujado le corresponde
+    std::vector<VkDrawIndexedIndirectCommand> indirectCommands(drawCommands.size());
+    std::vector<DrawData> drawData(drawCommands.size());
+    const std::vector<MeshBounds> &submeshBounds = sceneGeometry.getSubmeshBounds();
+    for (size_t i = 0; i < drawCommands.size(); i++)
+    {
+        indirectCommands[i].indexCount = drawCommands[i].indexCount;
+        indirectCommands[i].instanceCount = 1;
+        indirectCommands[i].firstIndex = drawCommands[i].firstIndex;
+        indirectCommands[i].vertexOffset = drawCommands[i].vertexOffset;
+        indirectCommands[i].firstInstance = static_cast<uint32_t>(i);
+
+        drawData[i].submeshId = static_cast<uint32_t>(i);
+        drawData[i].materialId = drawCommands[i].materialId;
+        drawData[i].boundsMin = submeshBounds[i].min;
+        drawData[i].boundsMax = submeshBounds[i].max;
+    }
+
+    indirectCommandBufferSize = sizeof(VkDrawIndexedIndirectCommand) * indirectCommands.size();
+    drawDataBufferSize = sizeof(DrawData) * drawData.size();
+
+    // El buffer de comandos también es de almacenamiento, para que se pueda generar o compactar desde un compute shader
+    BufferCreator::createBuffer(device, physicalDevice, indirectCommandBufferSize, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indirectCommandBuffer, indirectCommandBufferMemory);
+    BufferCreator::createBuffer(device, physicalDevice, drawDataBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, drawDataBuffer, drawDataBufferMemory);
+
+    uploadBatcher.copyToBuffer(indirectCommands.data(), indirectCommandBufferSize, indirectCommandBuffer, 0);
+    uploadBatcher.copyToBuffer(drawData.data(), drawDataBufferSize, drawDataBuffer, 0);
+}
+
+const std::vector<DrawCommand> &SceneDrawList::getDrawCommands() const
+{
+    return drawCommands;
+}
+
+VkBuffer SceneDrawList::getVertexBuffer() const
+{
+    return vertexBuffer;
+}
+
+VkBuffer SceneDrawList::getIndexBuffer() const
+{
+    return indexBuffer;
+}
+
+VkBuffer SceneDrawList::getIndirectCommandBuffer() const
+{
+    return indirectCommandBuffer;
+}
+
+VkDeviceSize SceneDrawList::getIndirectCommandBufferSize() const
+{
+    return indirectCommandBufferSize;
+}
+
+VkBuffer SceneDrawList::getDrawDataBuffer() const
+{
+    return drawDataBuffer;
+}
+
+VkDeviceSize SceneDrawList::getDrawDataBufferSize() const
+{
+    return drawDataBufferSize;
+}
+
+uint32_t SceneDrawList::getDrawCount() const
+{
+    return static_cast<uint32_t>(drawCommands.size());
+}
+
+void SceneDrawList::cleanup(VkDevice device)
+{
+    vkDestroyBuffer(device, indirectCommandBuffer, nullptr);
+    vkFreeMemory(device, indirectCommandBufferMemory, nullptr);
+    vkDestroyBuffer(device, drawDataBuffer, nullptr);
+    vkFreeMemory(device, drawDataBufferMemory, nullptr);
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "SceneGeometryBuffer.h"
+#include "Buffers/Tools/UploadBatcher.h"
+
+#define VK_USE_PLATFORM_WIN32_KHR
+#define GLFW_INCLUDE_VULKAN
+#define GLFW_EXPOSE_NATIVE_WIN32
+
+#include <GLFW/glfw3.h>
+#include <GLFW/glfw3native.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+
+// ESTRUCTURAS //
+
+// Información mínima para dibujar un objeto de la escena, sin copiar su geometría en CPU
+// Todos los objetos comparten los buffers de la escena, así que basta con su rango dentro de ellos
+struct DrawCommand
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    int32_t vertexOffset;
+    uint32_t materialId;
+};
+
+// Datos por dibujado que pueden leer los shaders. El firstInstance de cada comando indirecto es su índice en este buffer,
+// por lo que se accede con gl_InstanceIndex. La caja envolvente la usa el culling de la escena
+struct DrawData
+{
+    glm::vec3 boundsMin;
+    uint32_t submeshId;  // Rango del objeto en la tabla de SceneGeometryBuffer
+    glm::vec3 boundsMax;
+    uint32_t materialId;
+};
+
+// Lista de dibujado de la escena. Se construye una sola vez tras cargar los modelos y después solo se consulta,
+// de modo que la grabación de los command buffers no depende del número de triángulos.
+// Los comandos se suben a la GPU como VkDrawIndexedIndirectCommand, para dibujar cada pase con una sola llamada
+class SceneDrawList
+{
+
+public:
+    // Se guarda un comando por cada objeto de la escena, con su rango en los buffers compartidos,
+    // y se graba la subida de los comandos indirectos y de los datos de dibujado en el lote actual
+    void build(UploadBatcher &uploadBatcher, VkDevice device, VkPhysicalDevice physicalDevice, const SceneGeometryBuffer &sceneGeometry);
+
+    const std::vector<DrawCommand> &getDrawCommands() const;
+    // Buffers de vértices e índices de toda la escena, que se enlazan una vez por pase
+    VkBuffer getVertexBuffer() const;
+    VkBuffer getIndexBuffer() const;
+    // Comandos indirectos y datos por dibujado en GPU
+    VkBuffer getIndirectCommandBuffer() const;
+    VkDeviceSize getIndirectCommandBufferSize() const;
+    VkBuffer getDrawDataBuffer() const;
+    VkDeviceSize getDrawDataBufferSize() const;
+    uint32_t getDrawCount() const;
+
+    void cleanup(VkDevice device);
+
+private:
+    std::vector<DrawCommand> drawCommands;
+    VkBuffer vertexBuffer = VK_NULL_HANDLE;
+    VkBuffer indexBuffer = VK_NULL_HANDLE;
+
+    VkBuffer indirectCommandBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory indirectCommandBufferMemory = VK_NULL_HANDLE;
+    VkDeviceSize indirectCommandBufferSize = 0;
+    VkBuffer drawDataBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory drawDataBufferMemory = VK_NULL_HANDLE;
+    VkDeviceSize drawDataBufferSize = 0;
+};
\ No newline at end of file
@@ -0,0 +1,124 @@
+#include "SceneGeometryBuffer.h"
+
+#include "Buffers/Tools/BufferCreator.h"
+#include "Buffers/Tools/UploadBatcher.h"
+
+#define VK_USE_PLATFORM_WIN32_KHR
+#define GLFW_INCLUDE_VULKAN
+#define GLFW_EXPOSE_NATIVE_WIN32
+
+#include <GLFW/glfw3.h>
+#include <GLFW/glfw3native.h>
+
+#include <vector>
+
+void SceneGeometryBuffer::build(UploadBatcher &uploadBatcher, VkDevice device, VkPhysicalDevice physicalDevice, const std::vector<MeshContainer> &sceneMeshes)
+{
+    submeshes.clear();
+    submeshBounds.clear();
+
+    // Primero se calcula el rango de cada objeto, para conocer el tamaño total de los buffers
+    uint32_t totalIndices = 0;
+    uint32_t totalVertices = 0;
+    for (const auto &mesh : sceneMeshes)
+    {
+        for (size_t i = 0; i < mesh.vertexMeshesData.vertices.size(); i++)
+        {
+            GeometrySubmesh submesh{};
+            submesh.firstIndex = totalIndices;
+            submesh.indexCount = static_cast<uint32_t>(mesh.vertexMeshesData.indices[i].size());
+            submesh.vertexOffset = static_cast<int32_t>(totalVertices);
+            submesh.vertexCount = static_cast<uint32_t>(mesh.vertexMeshesData.vertices[i].size());
+            // Todos los vértices de un mesh comparten material, así que basta con consultar el primero
+            submesh.materialId = mesh.vertexMeshesData.vertices[i].empty() ? 0 : static_cast<uint32_t>(mesh.vertexMeshesData.vertices[i][0].idMaterial);
+
+            totalIndices += submesh.indexCount;
+            totalVertices += submesh.vertexCount;
+            submeshes.push_back(submesh);
+            submeshBounds.push_back(mesh.vertexMeshesData.bounds[i]);
+        }
+    }
+
+    vertexBufferSize = sizeof(Vertex) * static_cast<VkDeviceSize>(totalVertices);
+    indexBufferSize = sizeof(uint32_t) * static_cast<VkDeviceSize>(totalIndices);
+    submeshBufferSize = sizeof(GeometrySubmesh) * static_cast<VkDeviceSize>(submeshes.size());
+
+    // Los mismos buffers se usan para dibujar, para construir las BLAS y para leer los triángulos desde los shaders
+    BufferCreator::createBuffer(device, physicalDevice, vertexBufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+        | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexBuffer, vertexBufferMemory);
+    BufferCreator::createBuffer(device, physicalDevice, indexBufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+        | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indexBuffer, indexBufferMemory);
+    BufferCreator::createBuffer(device, physicalDevice, submeshBufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, submeshBuffer, submeshBufferMemory);
+
+    // Cada objeto se copia en su rango desde el anillo de staging, todo dentro de los lotes del UploadBatcher
+    size_t submeshIndex = 0;
+    for (const auto &mesh : sceneMeshes)
+    {
+        for (size_t i = 0; i < mesh.vertexMeshesData.vertices.size(); i++)
+        {
+            const GeometrySubmesh &submesh = submeshes[submeshIndex++];
+            if (submesh.vertexCount > 0)
+            {
+                uploadBatcher.copyToBuffer(mesh.vertexMeshesData.vertices[i].data(), sizeof(Vertex) * submesh.vertexCount,
+                                           vertexBuffer, sizeof(Vertex) * static_cast<VkDeviceSize>(submesh.vertexOffset));
+            }
+            if (submesh.indexCount > 0)
+            {
+                uploadBatcher.copyToBuffer(mesh.vertexMeshesData.indices[i].data(), sizeof(uint32_t) * submesh.indexCount,
+                                           indexBuffer, sizeof(uint32_t) * static_cast<VkDeviceSize>(submesh.firstIndex));
+            }
+        }
+    }
+    uploadBatcher.copyToBuffer(submeshes.data(), submeshBufferSize, submeshBuffer, 0);
+}
+
+VkBuffer SceneGeometryBuffer::getVertexBuffer() const
+{
+    return vertexBuffer;
+}
+
+VkBuffer SceneGeometryBuffer::getIndexBuffer() const
+{
+    return indexBuffer;
+}
+
+VkBuffer SceneGeometryBuffer::getSubmeshBuffer() const
+{
+    return submeshBuffer;
+}
+
+VkDeviceSize SceneGeometryBuffer::getVertexBufferSize() const
+{
+    return vertexBufferSize;
+}
+
+VkDeviceSize SceneGeometryBuffer::getIndexBufferSize() const
+{
+    return indexBufferSize;
+}
+
+VkDeviceSize SceneGeometryBuffer::getSubmeshBufferSize() const
+{
+    return submeshBufferSize;
+}
+
+const std::vector<GeometrySubmesh> &SceneGeometryBuffer::getSubmeshes() const
+{
+    return submeshes;
+}
+
+const std::vector<MeshBounds> &SceneGeometryBuffer::getSubmeshBounds() const
+{
+    return submeshBounds;
+}
+
+void SceneGeometryBuffer::cleanup(VkDevice device)
+{
+    vkDestroyBuffer(device, vertexBuffer, nullptr);
+    vkFreeMemory(device, vertexBufferMemory, nullptr);
+    vkDestroyBuffer(device, indexBuffer, nullptr);
+    vkFreeMemory(device, indexBufferMemory, nullptr);
+    vkDestroyBuffer(device, submeshBuffer, nullptr);
+    vkFreeMemory(device, submeshBufferMemory, nullptr);
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "MeshContainer.h"
+#include "Buffers/Tools/UploadBatcher.h"
+
+#define VK_USE_PLATFORM_WIN32_KHR
+#define GLFW_INCLUDE_VULKAN
+#define GLFW_EXPOSE_NATIVE_WIN32
+
+#include <GLFW/glfw3.h>
+#include <GLFW/glfw3native.h>
+
+#include <vector>
+#include <cstdint>
+
+// ESTRUCTURAS //
+
+// Rango de un objeto de la escena dentro de los buffers compartidos
+// Se sube también a la GPU, para que los shaders puedan leer la geometría a partir del índice de la instancia
+struct GeometrySubmesh
+{
+    uint32_t firstIndex;   // Primer índice del objeto en el buffer de índices
+    uint32_t indexCount;
+    int32_t vertexOffset;  // Primer vértice del objeto en el buffer de vértices. Los índices son relativos a él
+    uint32_t vertexCount;
+    uint32_t materialId;
+    uint32_t padding[3];
+};
+
+// Geometría de toda la escena en un único buffer de vértices y un único buffer de índices de 32 bits
+// Cada objeto ocupa un rango de ambos buffers, de modo que se enlazan una sola vez por pase
+class SceneGeometryBuffer
+{
+
+public:
+    // Se reservan los buffers con el tamaño de toda la escena y se graba la copia de cada objeto en su rango
+    void build(UploadBatcher &uploadBatcher, VkDevice device, VkPhysicalDevice physicalDevice, const std::vector<MeshContainer> &sceneMeshes);
+
+    VkBuffer getVertexBuffer() const;
+    VkBuffer getIndexBuffer() const;
+    VkBuffer getSubmeshBuffer() const;
+    VkDeviceSize getVertexBufferSize() const;
+    VkDeviceSize getIndexBufferSize() const;
+    VkDeviceSize getSubmeshBufferSize() const;
+    const std::vector<GeometrySubmesh> &getSubmeshes() const;
+    // Caja envolvente de cada objeto, en el mismo orden que la tabla de rangos
+    const std::vector<MeshBounds> &getSubmeshBounds() const;
+
+    void cleanup(VkDevice device);
+
+private:
+    VkBuffer vertexBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory vertexBufferMemory = VK_NULL_HANDLE;
+    VkBuffer indexBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory indexBufferMemory = VK_NULL_HANDLE;
+    // Tabla de rangos de los objetos, en el mismo orden que las BLAS de la escena
+    VkBuffer submeshBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory submeshBufferMemory = VK_NULL_HANDLE;
+
+    VkDeviceSize vertexBufferSize = 0;
+    VkDeviceSize indexBufferSize = 0;
+    VkDeviceSize submeshBufferSize = 0;
+
+    std::vector<GeometrySubmesh> submeshes;
+    std::vector<MeshBounds> submeshBounds;
+};
\ No newline at end of file
@@ -1,7 +1,5 @@
 #pragma once
 
-#include "Buffers/Tools/BufferCreator.h"
-#include "Buffers/Tools/CommandBufferManager.h"
 #include "MeshLoader.h"
 
 #include <GLFW/glfw3.h>
@@ -21,33 +19,16 @@ class VertexBuffer {
 public:
 
 	// ATRIBUTOS //
-	// Vector de buffers para almacenar los vértices
-	std::vector<VkBuffer> vertexBufferList;
-	std::vector<VkDeviceMemory> vertexBufferMemoryList;
-	// Vector de buffers para almacenar los índices
-	std::vector<VkBuffer> indexBufferList;
-	std::vector<VkDeviceMemory> indexBufferMemoryList;
-
 	// Vector que almacena la lista de vértices de los objetos de cada fichero
 	std::vector<std::vector<Vertex>> vertices;
 	// Array que representa el conjunto de todos los índices de los vértices con los que se pintará la geometría
-	std::vector<std::vector<uint16_t>> indices;
+	std::vector<std::vector<uint32_t>> indices;
+	// Caja envolvente de cada objeto, calculada al importar el modelo
+	std::vector<MeshBounds> bounds;
 
 	// FUNCIONES //
-	// Función para realizar la creación de los buffer de vértices y de índices
-	void createBufferData(VkDevice device, VkPhysicalDevice physicalDevice,
-		VkCommandPool commandPool, VkQueue graphicsQueue, const std::string& filePath, uint32_t* materialIndex);
-	// Función para copiar de un buffer a otro
-	void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size,
-		VkDevice device, VkCommandPool commandPool, VkQueue graphicsQueue);
-	// Funciones para abstraer la lógica de creación del Vertex Buffer
-	void createVertexBuffer(VkDevice device, VkPhysicalDevice physicalDevice,
-		VkCommandPool commandPool, VkQueue graphicsQueue, int index);
-	// Función para crear el buffer de indexación de los vértices
-	// Se sigue el mismo procedimiento de lectura en CPU, copia a GPU...
-	void createIndexBuffer(VkDevice device, VkPhysicalDevice physicalDevice,
-		VkCommandPool commandPool, VkQueue graphicsQueue, int index);
-	// Destrucción de recursos
-	void cleanup(VkDevice device);
+	// Función para tomar los vértices e índices del modelo importado, una vez asignados sus materiales
+	// Los buffers de GPU no se crean aquí: toda la geometría de la escena se sube junta a SceneGeometryBuffer
+	void setModelData(ImportedModel& model, uint32_t* materialIndex);
 	
 };
\ No newline at end of file
@@ -0,0 +1,32 @@
+#include "SceneAssets.h"
+
+#include "SponzaResources.h"
+
+std::vector<std::future<ImportedModel>> SceneAssets::importModels(ThreadPool &threadPool)
+{
+    std::vector<std::future<ImportedModel>> importedModels;
+    importedModels.reserve(meshesPaths.size());
+    for (const char *meshPath : meshesPaths)
+    {
+        importedModels.push_back(threadPool.enqueue([meshPath]()
+                                                    { return MeshLoader::importModel(meshPath); }));
+    }
+    return importedModels;
+}
+
+void SceneAssets::hashSceneData(uint64_t *sceneHash, const void *data, size_t size)
+{
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < size; i++)
+    {
+        *sceneHash ^= bytes[i];
+        *sceneHash *= 1099511628211ull;
+    }
+}
+
+void SceneAssets::hashMainLight(uint64_t *sceneHash, const MainDirectionalLight &mainLight)
+{
+    hashSceneData(sceneHash, &mainLight.position, sizeof(mainLight.position));
+    hashSceneData(sceneHash, &mainLight.target, sizeof(mainLight.target));
+    hashSceneData(sceneHash, &mainLight.intensity, sizeof(mainLight.intensity));
+}
\ No newline at end of file
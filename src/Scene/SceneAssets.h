@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Models/MeshLoader.h"
+#include "Illumination/MainDirectionalLight.h"
+#include "Tools/ThreadPool.h"
+
+#include <vector>
+#include <future>
+#include <cstdint>
+#include <cstddef>
+
+// Parte de la carga de la escena que no depende de la GPU: la importación de los modelos y el hash que identifica la
+// escena. La comparten SceneManager y el baker de surfels, de modo que un bake se reconoce con el mismo hash al arrancar
+class SceneAssets
+{
+public:
+    static const uint64_t SCENE_HASH_SEED = 14695981039346656037ull;
+
+    // Encola la importación de los modelos de la escena. Los futures están en el orden de meshesPaths
+    static std::vector<std::future<ImportedModel>> importModels(ThreadPool &threadPool);
+    // Acumula datos en el hash de la escena (FNV-1a de 64 bits)
+    static void hashSceneData(uint64_t *sceneHash, const void *data, size_t size);
+    // La radiancia de los surfels depende de la luz principal, así que sus parámetros forman parte del hash
+    static void hashMainLight(uint64_t *sceneHash, const MainDirectionalLight &mainLight);
+};
\ No newline at end of file
@@ -1,8 +1,10 @@
 #include "SceneManager.h"
 
+#include "SceneAssets.h"
 #include "SponzaResources.h"
 #include "Models/MeshContainer.h"
 #include "Illumination/LightsData.h"
+#include "Tools/ThreadPool.h"
 
 #include <GLFW/glfw3.h>
 #include <GLFW/glfw3native.h>
@@ -15,45 +17,60 @@
 
 SceneManager::SceneManager() {}
 
-void SceneManager::loadSceneAssets(VkDevice device, VkPhysicalDevice physicalDevice,
-                                   VkCommandPool commandPool, VkQueue graphicsQueue)
+void SceneManager::loadSceneAssets(UploadBatcher &uploadBatcher, VkDevice device, VkPhysicalDevice physicalDevice)
 {
-    createScene(device, physicalDevice, commandPool, graphicsQueue);
+    // Hilos de trabajo para la importación de los modelos y la decodificación de las texturas
+    ThreadPool threadPool;
+    std::cout << "Hilos de carga: " << threadPool.getNumThreads() << std::endl;
+    // Se encolan todas las lecturas de disco antes de subir nada, para que se solapen entre sí y con las subidas a la GPU
+    std::vector<std::future<ImportedModel>> importedModels = SceneAssets::importModels(threadPool);
+    std::vector<std::future<TextureData>> decodedTextures = materialsManager.decodeTextures(threadPool);
+
+    createScene(uploadBatcher, device, physicalDevice, importedModels);
     addIllumination();
-    createMaterials(device, physicalDevice, commandPool, graphicsQueue);
+    createMaterials(uploadBatcher, device, physicalDevice, decodedTextures);
+    // Se envía el último lote y se espera a que todas las subidas de la escena hayan terminado
+    uploadBatcher.flush();
 }
 
-void SceneManager::createScene(VkDevice device, VkPhysicalDevice physicalDevice,
-                               VkCommandPool commandPool, VkQueue graphicsQueue)
+void SceneManager::createScene(UploadBatcher &uploadBatcher, VkDevice device, VkPhysicalDevice physicalDevice, std::vector<std::future<ImportedModel>> &importedModels)
 {
     // Se asigna el tamaño de la escena según el número de modelos
     sceneMeshes.resize(meshesPaths.size());
     // Se recorre el vector que contiene los directorios de los distintos modelos de la escena
     uint32_t materialIndex = 0;
     uint32_t *materialIndexPtr = &materialIndex;
+    sceneHash = SceneAssets::SCENE_HASH_SEED;
     for (uint32_t i = 0; i < meshesPaths.size(); i++)
     {
+        // Los modelos se recogen en el orden de meshesPaths, para que los índices de material no dependan de qué hilo termine antes
+        ImportedModel importedModel = importedModels[i].get();
+        SceneAssets::hashSceneData(&sceneHash, &importedModel.sourceHash, sizeof(importedModel.sourceHash));
         // Se cargan los datos del modelo y se almacenan
-        sceneMeshes[i].loadVertexData(device, physicalDevice, commandPool, graphicsQueue, meshesPaths[i], materialIndexPtr);
+        sceneMeshes[i].loadVertexData(importedModel, materialIndexPtr);
     }
+    // Con todos los modelos cargados se conoce el tamaño de la escena, y su geometría se sube a los buffers compartidos
+    sceneGeometry.build(uploadBatcher, device, physicalDevice, sceneMeshes);
+    // A partir de los rangos de cada objeto se construye la lista de dibujado
+    sceneDrawList.build(uploadBatcher, device, physicalDevice, sceneGeometry);
     std::cout << "Numero materiales total: " << (*materialIndexPtr);
 }
 
 void SceneManager::addIllumination()
 {
     sceneLights = LightsData(lightsPositions, lightsIntensities, lightsColors);
+
+    SceneAssets::hashMainLight(&sceneHash, sceneLights.mainLight);
 }
 
-void SceneManager::createMaterials(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue)
+void SceneManager::createMaterials(UploadBatcher &uploadBatcher, VkDevice device, VkPhysicalDevice physicalDevice, std::vector<std::future<TextureData>> &decodedTextures)
 {
-    materialsManager.prepareTextureMaterials(device, physicalDevice, commandPool, graphicsQueue);
+    materialsManager.prepareTextureMaterials(uploadBatcher, device, physicalDevice, decodedTextures);
 }
 
 void SceneManager::cleanup(VkDevice device)
 {
-    for (uint32_t i = 0; i < sceneMeshes.size(); i++)
-    {
-        sceneMeshes[i].vertexMeshesData.cleanup(device);
-    }
+    sceneDrawList.cleanup(device);
+    sceneGeometry.cleanup(device);
     materialsManager.cleanup(device);
-}
+}
\ No newline at end of file
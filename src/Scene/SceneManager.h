@@ -1,8 +1,12 @@
 #pragma once
 
 #include "Models/MeshContainer.h"
+#include "Models/SceneGeometryBuffer.h"
+#include "Models/SceneDrawList.h"
 #include "Illumination/LightsData.h"
 #include "MaterialsManager.h"
+#include "Buffers/Tools/UploadBatcher.h"
+#include "Tools/ThreadPool.h"
 
 #define VK_USE_PLATFORM_WIN32_KHR
 #define GLFW_INCLUDE_VULKAN
@@ -11,19 +15,28 @@
 #include <GLFW/glfw3.h>
 #include <GLFW/glfw3native.h>
 
+#include <vector>
+#include <future>
+
 class SceneManager
 {
 
 public:
     std::vector<MeshContainer> sceneMeshes;
+    // Vértices e índices de todos los modelos en un único par de buffers de GPU
+    SceneGeometryBuffer sceneGeometry;
+    // Lista inmutable con lo necesario para dibujar la escena, que se pasa por referencia al grabar cada frame
+    SceneDrawList sceneDrawList;
     LightsData sceneLights;
     MaterialsManager materialsManager;
+    // Hash de los modelos y de la iluminación, que identifica la escena en la caché de surfels
+    uint64_t sceneHash = 0;
 
     SceneManager();
 
-    void loadSceneAssets(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue);
-    void createScene(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue);
+    void loadSceneAssets(UploadBatcher &uploadBatcher, VkDevice device, VkPhysicalDevice physicalDevice);
+    void createScene(UploadBatcher &uploadBatcher, VkDevice device, VkPhysicalDevice physicalDevice, std::vector<std::future<ImportedModel>> &importedModels);
     void addIllumination();
-    void createMaterials(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue);
+    void createMaterials(UploadBatcher &uploadBatcher, VkDevice device, VkPhysicalDevice physicalDevice, std::vector<std::future<TextureData>> &decodedTextures);
     void cleanup(VkDevice device);
 };
\ No newline at end of file
@@ -0,0 +1,87 @@
+#include "SurfelBvhScene.h"
+
+#include <stdexcept>
+
+namespace
+{
+    const glm::vec3 DEFAULT_ALBEDO = glm::vec3(0.5f);
+}
+
+void SurfelBvhScene::addMesh(const std::vector<glm::vec3> &meshPositions, const std::vector<glm::vec3> &meshNormals, const std::vector<uint32_t> &meshIndices,
+                             uint32_t materialId)
+{
+    if (meshPositions.size() != meshNormals.size() || meshIndices.size() % 3 != 0)
+    {
+        throw std::runtime_error("failed to add mesh to the surfel BVH scene: inconsistent vertex data!");
+    }
+
+    uint32_t vertexOffset = static_cast<uint32_t>(positions.size());
+    positions.insert(positions.end(), meshPositions.begin(), meshPositions.end());
+    normals.insert(normals.end(), meshNormals.begin(), meshNormals.end());
+
+    for (size_t i = 0; i < meshIndices.size(); i += 3)
+    {
+        triangles.push_back(glm::uvec3(meshIndices[i], meshIndices[i + 1], meshIndices[i + 2]) + vertexOffset);
+        triangleMaterials.push_back(materialId);
+    }
+}
+
+void SurfelBvhScene::setMaterialAlbedos(const std::vector<glm::vec3> &albedos)
+{
+    materialAlbedos = albedos;
+}
+
+void SurfelBvhScene::build(ThreadPool &threadPool)
+{
+    bvh.build(positions, triangles, threadPool);
+}
+
+bool SurfelBvhScene::intersect(const glm::vec3 &origin, const glm::vec3 &direction, float tMin, float tMax, SurfelReferenceHit *hit) const
+{
+    CpuBvhHit bvhHit;
+    if (!bvh.intersect(origin, direction, tMin, tMax, &bvhHit))
+    {
+        return false;
+    }
+
+    // Normal interpolada con las coordenadas baricéntricas, igual que en el cálculo de radiancia de la GPU
+    const glm::uvec3 &triangle = triangles[bvhHit.triangle];
+    float a = 1.0f - bvhHit.u - bvhHit.v;
+    hit->t = bvhHit.t;
+    hit->normal = glm::normalize(a * glm::normalize(normals[triangle.x]) + bvhHit.u * glm::normalize(normals[triangle.y]) +
+                                 bvhHit.v * glm::normalize(normals[triangle.z]));
+
+    hit->albedo = getTriangleAlbedo(bvhHit.triangle);
+    return true;
+}
+
+bool SurfelBvhScene::occluded(const glm::vec3 &origin, const glm::vec3 &direction, float tMin, float tMax) const
+{
+    return bvh.occluded(origin, direction, tMin, tMax);
+}
+
+const CpuBvh &SurfelBvhScene::getBvh() const
+{
+    return bvh;
+}
+
+const std::vector<glm::vec3> &SurfelBvhScene::getPositions() const
+{
+    return positions;
+}
+
+const std::vector<glm::vec3> &SurfelBvhScene::getNormals() const
+{
+    return normals;
+}
+
+const std::vector<glm::uvec3> &SurfelBvhScene::getTriangles() const
+{
+    return triangles;
+}
+
+glm::vec3 SurfelBvhScene::getTriangleAlbedo(uint32_t triangle) const
+{
+    uint32_t materialId = triangleMaterials[triangle];
+    return materialId < materialAlbedos.size() ? materialAlbedos[materialId] : DEFAULT_ALBEDO;
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "SurfelReference.h"
+#include "Raytracing/CpuBvh.h"
+#include "Tools/ThreadPool.h"
+
+#define GLM_FORCE_RADIANS
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+
+// Escena de la implementación de referencia trazada con la BVH de CPU. En lugar de muestrear las texturas difusas como
+// el shader, cada material aporta un albedo constante (por ejemplo, el color medio de su textura)
+class SurfelBvhScene : public SurfelReferenceScene
+{
+public:
+    // Añade una malla con índices relativos a sus propios vértices y un único material
+    void addMesh(const std::vector<glm::vec3> &meshPositions, const std::vector<glm::vec3> &meshNormals, const std::vector<uint32_t> &meshIndices,
+                 uint32_t materialId);
+    // Albedo de cada material, indexado por su id. Los materiales sin albedo usan un gris medio
+    void setMaterialAlbedos(const std::vector<glm::vec3> &albedos);
+    // Construye la BVH con las mallas añadidas. Hay que llamarla antes de trazar rayos
+    void build(ThreadPool &threadPool);
+
+    bool intersect(const glm::vec3 &origin, const glm::vec3 &direction, float tMin, float tMax, SurfelReferenceHit *hit) const override;
+    bool occluded(const glm::vec3 &origin, const glm::vec3 &direction, float tMin, float tMax) const override;
+
+    const CpuBvh &getBvh() const;
+    // Geometría añadida, con los índices de los triángulos ya globales, para recorrer las superficies de la escena
+    const std::vector<glm::vec3> &getPositions() const;
+    const std::vector<glm::vec3> &getNormals() const;
+    const std::vector<glm::uvec3> &getTriangles() const;
+    glm::vec3 getTriangleAlbedo(uint32_t triangle) const;
+
+private:
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::uvec3> triangles;
+    std::vector<uint32_t> triangleMaterials;
+    std::vector<glm::vec3> materialAlbedos;
+    CpuBvh bvh;
+};
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <cstddef>
+
+// Constantes de los surfels, incluidas desde el mismo fichero que usan los shaders para que la aplicación y la
+// implementación de referencia en CPU no puedan desincronizarse. Se declaran en su propio espacio de nombres, con
+// alias para los tipos de GLSL que aparecen en el fichero
+namespace SurfelShader
+{
+    using uint = uint32_t;
+    using uvec3 = glm::uvec3;
+    using vec3 = glm::vec3;
+
+#include "../../resources/shaders/surfelsConstants.glsl"
+}
+
+// Mismo formato que el struct Surfel de surfelsData.glsl, para leer y escribir directamente el buffer de la GPU
+struct Surfel
+{
+    glm::vec3 position;
+    float radius;
+    glm::vec3 normal;
+    int generatedRays;
+    glm::vec3 color;
+    uint32_t lastSeenFrame; // Último frame en el que el surfel cubrió algún píxel visible
+    glm::vec3 direct_radiance;
+    uint32_t age;           // Frames que lleva vivo el surfel
+    glm::vec3 indirect_radiance;
+    float luminanceMoment2; // Media de la luminancia al cuadrado de las muestras, para estimar la varianza de la radiancia
+    float indirectTrend;    // Media móvil del cambio relativo de los rebotes, para saber si siguen necesitando rayos
+    uint32_t flags;         // SURFEL_FLAG_*
+    uint32_t padding[2];
+};
+
+// El buffer de la GPU, la caché de surfels y los parciales del bake dependen de que el struct coincida con el de
+// surfelsData.glsl (std430), así que se comprueban el tamaño y los offsets
+static_assert(sizeof(Surfel) == 96, "Surfel must match the std430 layout of surfelsData.glsl");
+static_assert(offsetof(Surfel, radius) == 12 && offsetof(Surfel, normal) == 16 && offsetof(Surfel, generatedRays) == 28,
+              "Surfel must match the std430 layout of surfelsData.glsl");
+static_assert(offsetof(Surfel, color) == 32 && offsetof(Surfel, lastSeenFrame) == 44 && offsetof(Surfel, direct_radiance) == 48 &&
+                  offsetof(Surfel, age) == 60,
+              "Surfel must match the std430 layout of surfelsData.glsl");
+static_assert(offsetof(Surfel, indirect_radiance) == 64 && offsetof(Surfel, luminanceMoment2) == 76 && offsetof(Surfel, indirectTrend) == 80 &&
+                  offsetof(Surfel, flags) == 84 && offsetof(Surfel, padding) == 88,
+              "Surfel must match the std430 layout of surfelsData.glsl");
+
+struct SurfelGridCell
+{
+    uint32_t count;
+    uint32_t offset;
+};
+
+static_assert(sizeof(SurfelGridCell) == 8, "SurfelGridCell must match the layout of surfelsData.glsl");
\ No newline at end of file
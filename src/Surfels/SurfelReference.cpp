@@ -0,0 +1,719 @@
+#include "SurfelReference.h"
+
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace SurfelShader;
+
+namespace
+{
+    // Constantes locales de surfel_radiance_calculation.comp
+    const float RADIANCE_EPSILON = 0.001f;
+    const float RAY_T_MIN = 0.01f;
+    const float SHADOW_RAY_LENGTH = 5000.0f;
+
+    // Constantes locales de indirect_diffuse_tiled.comp
+    const int SHADING_REGION_RADIUS = 2; // Región 5x5x5
+    const float SHADING_SIGMA_BASE = 5.0f;
+    const float SHADING_SIGMA_SCALE = 6.0f;
+    const float SHADING_MIN_WEIGHT_THRESHOLD = 1e-5f;
+    const float SHADING_MIN_ANGULAR_WEIGHT = 0.1f;
+
+    const float SQRT_PI = 1.772453851f;
+    const float PI = 3.14159265358979323846f;
+
+    // Campo de visión vertical con el que surfel_generation.comp calcula el radio de los surfels
+    const float SPAWN_FIELD_OF_VIEW = glm::radians(60.0f);
+
+    // Tamaño de los lotes en los que se reparte cada pasada entre los hilos
+    const uint32_t SURFEL_BATCH_SIZE = 1024;
+    const uint32_t TILE_BATCH_SIZE = 16;
+    const uint32_t ROW_BATCH_SIZE = 8;
+
+    // Un surfel solapa como mucho las 27 celdas vecinas de la suya
+    const uint32_t MAX_SURFEL_CELLS = 27;
+
+    glm::vec3 cosineSampleHemisphere(const glm::vec2 &xi)
+    {
+        float r = std::sqrt(xi.x);
+        float angle = 2.0f * PI * xi.y;
+        float x = r * std::cos(angle);
+        float y = r * std::sin(angle);
+        float z = std::sqrt(std::max(0.0f, 1.0f - x * x - y * y));
+        return glm::vec3(x, y, z);
+    }
+
+    void setOrthonormalBasis(const glm::vec3 &N, glm::vec3 *T, glm::vec3 *B)
+    {
+        if (std::abs(N.z) < 0.999f)
+        {
+            *T = glm::normalize(glm::cross(N, glm::vec3(0.0f, 0.0f, 1.0f)));
+        }
+        else
+        {
+            *T = glm::normalize(glm::cross(N, glm::vec3(0.0f, 1.0f, 0.0f)));
+        }
+        *B = glm::cross(N, *T);
+    }
+
+    float smoothstep01(float x)
+    {
+        float t = glm::clamp(x, 0.0f, 1.0f);
+        return t * t * (3.0f - 2.0f * t);
+    }
+}
+
+SurfelReference::SurfelReference(ThreadPool &threadPool) : threadPool(threadPool)
+{
+    surfels.resize(SURFEL_CAPACITY, Surfel{});
+    grid.resize(SURFEL_TABLE_SIZE, SurfelGridCell{0, 0});
+    freeList.reserve(SURFEL_CAPACITY);
+}
+
+void SurfelReference::buildGrid()
+{
+    // Celdas que solapa cada surfel vivo, calculadas en paralelo. Los surfels se envejecen aquí, como en el conteo
+    std::vector<uint32_t> overlappedCells(static_cast<size_t>(surfelCount) * MAX_SURFEL_CELLS);
+    std::vector<uint32_t> overlappedCount(surfelCount, 0);
+
+    threadPool.parallelFor(surfelCount, SURFEL_BATCH_SIZE, [&](uint32_t begin, uint32_t end)
+                {
+        for (uint32_t i = begin; i < end; i++)
+        {
+            Surfel &surfel = surfels[i];
+            if (!isAlive(surfel))
+            {
+                continue;
+            }
+            surfel.age++;
+
+            // Nivel más fino del clipmap que contiene al surfel. Fuera del clipmap no entra en el grid
+            uint32_t level = clipmapLevel(surfel.position, cameraPosition);
+            if (level >= SURFEL_CLIPMAP_LEVELS)
+            {
+                continue;
+            }
+
+            glm::ivec3 gridPosition = cell(surfel.position, level);
+            uint32_t count = 0;
+            for (int dx = -1; dx <= 1; dx++)
+            for (int dy = -1; dy <= 1; dy++)
+            for (int dz = -1; dz <= 1; dz++)
+            {
+                glm::ivec3 neighbour = gridPosition + glm::ivec3(dx, dy, dz);
+                if (cellIntersects(surfel, neighbour, level, cameraPosition))
+                {
+                    overlappedCells[static_cast<size_t>(i) * MAX_SURFEL_CELLS + count++] = cellIndex(neighbour, level);
+                }
+            }
+            overlappedCount[i] = count;
+        } });
+
+    for (SurfelGridCell &gridCell : grid)
+    {
+        gridCell.count = 0;
+    }
+    for (uint32_t i = 0; i < surfelCount; i++)
+    {
+        for (uint32_t k = 0; k < overlappedCount[i]; k++)
+        {
+            grid[overlappedCells[static_cast<size_t>(i) * MAX_SURFEL_CELLS + k]].count++;
+        }
+    }
+
+    // Suma prefija por bloques, como surfel_grid_offset: cada bloque calcula sus offsets locales en paralelo, luego se
+    // acumulan los totales de los bloques y por último se desplaza cada bloque a su base
+    const uint32_t numBlocks = (SURFEL_TABLE_SIZE + SURFEL_GRID_SCAN_BLOCK_SIZE - 1) / SURFEL_GRID_SCAN_BLOCK_SIZE;
+    std::vector<uint32_t> blockBase(numBlocks, 0);
+
+    threadPool.parallelFor(numBlocks, TILE_BATCH_SIZE, [&](uint32_t begin, uint32_t end)
+                {
+        for (uint32_t block = begin; block < end; block++)
+        {
+            uint32_t firstCell = block * SURFEL_GRID_SCAN_BLOCK_SIZE;
+            uint32_t lastCell = std::min(firstCell + SURFEL_GRID_SCAN_BLOCK_SIZE, SURFEL_TABLE_SIZE);
+            uint32_t offset = 0;
+            for (uint32_t c = firstCell; c < lastCell; c++)
+            {
+                grid[c].offset = offset;
+                offset += grid[c].count;
+            }
+            blockBase[block] = offset;
+        } });
+
+    uint32_t cellAllocator = 0;
+    for (uint32_t block = 0; block < numBlocks; block++)
+    {
+        uint32_t blockTotal = blockBase[block];
+        blockBase[block] = cellAllocator;
+        cellAllocator += blockTotal;
+    }
+
+    threadPool.parallelFor(numBlocks, TILE_BATCH_SIZE, [&](uint32_t begin, uint32_t end)
+                {
+        for (uint32_t block = begin; block < end; block++)
+        {
+            uint32_t firstCell = block * SURFEL_GRID_SCAN_BLOCK_SIZE;
+            uint32_t lastCell = std::min(firstCell + SURFEL_GRID_SCAN_BLOCK_SIZE, SURFEL_TABLE_SIZE);
+            for (uint32_t c = firstCell; c < lastCell; c++)
+            {
+                grid[c].offset += blockBase[block];
+                grid[c].count = 0;
+            }
+        } });
+
+    // Se distribuyen los surfels en orden de índice, de modo que el contenido de cada celda es determinista
+    cells.resize(cellAllocator);
+    for (uint32_t i = 0; i < surfelCount; i++)
+    {
+        for (uint32_t k = 0; k < overlappedCount[i]; k++)
+        {
+            SurfelGridCell &gridCell = grid[overlappedCells[static_cast<size_t>(i) * MAX_SURFEL_CELLS + k]];
+            cells[gridCell.offset + gridCell.count++] = i;
+        }
+    }
+
+    // Copia de la geometría de los surfels de cada referencia para el gather
+    binned.positionX.resize(cellAllocator);
+    binned.positionY.resize(cellAllocator);
+    binned.positionZ.resize(cellAllocator);
+    binned.normalX.resize(cellAllocator);
+    binned.normalY.resize(cellAllocator);
+    binned.normalZ.resize(cellAllocator);
+    binned.invTwoSigma2.resize(cellAllocator);
+    binned.homeCell.resize(cellAllocator);
+
+    threadPool.parallelFor(cellAllocator, SURFEL_BATCH_SIZE * 16, [&](uint32_t begin, uint32_t end)
+                {
+        for (uint32_t r = begin; r < end; r++)
+        {
+            const Surfel &surfel = surfels[cells[r]];
+            binned.positionX[r] = surfel.position.x;
+            binned.positionY[r] = surfel.position.y;
+            binned.positionZ[r] = surfel.position.z;
+            binned.normalX[r] = surfel.normal.x;
+            binned.normalY[r] = surfel.normal.y;
+            binned.normalZ[r] = surfel.normal.z;
+
+            float sigma = SHADING_SIGMA_BASE + SQRT_PI * surfel.radius * SHADING_SIGMA_SCALE;
+            binned.invTwoSigma2[r] = 1.0f / (2.0f * sigma * sigma + 1e-6f);
+
+            uint32_t level = clipmapLevel(surfel.position, cameraPosition);
+            binned.homeCell[r] = cellIndex(cell(surfel.position, level), level);
+        } });
+}
+
+uint32_t SurfelReference::spawnSurfels(const SurfelReferenceGBuffer &gBuffer, float farPlane, const std::vector<float> &blueNoise)
+{
+    const size_t numPixels = static_cast<size_t>(gBuffer.width) * gBuffer.height;
+    if (gBuffer.positions.size() != numPixels || gBuffer.normals.size() != numPixels || gBuffer.colors.size() != numPixels ||
+        gBuffer.depths.size() != numPixels)
+    {
+        throw std::runtime_error("failed to spawn reference surfels: incomplete G-buffer!");
+    }
+    if (!blueNoise.empty() && blueNoise.size() != BLUE_NOISE_SIZE * BLUE_NOISE_SIZE)
+    {
+        throw std::runtime_error("failed to spawn reference surfels: wrong blue noise size!");
+    }
+
+    const uint32_t tilesX = (gBuffer.width + SPAWN_TILE_SIZE - 1) / SPAWN_TILE_SIZE;
+    const uint32_t tilesY = (gBuffer.height + SPAWN_TILE_SIZE - 1) / SPAWN_TILE_SIZE;
+    const float focalLength = (gBuffer.height * 0.5f) / std::tan(SPAWN_FIELD_OF_VIEW * 0.5f);
+
+    // Resultado de cada región: el surfel que quiere generar, si lo hay, y los surfels que cubren alguno de sus píxeles
+    struct TileResult
+    {
+        bool spawn = false;
+        Surfel surfel{};
+        std::vector<uint32_t> seenSurfels;
+    };
+    std::vector<TileResult> tiles(static_cast<size_t>(tilesX) * tilesY);
+
+    threadPool.parallelFor(tilesX * tilesY, TILE_BATCH_SIZE, [&](uint32_t begin, uint32_t end)
+                {
+        for (uint32_t tile = begin; tile < end; tile++)
+        {
+            TileResult &result = tiles[tile];
+            uint32_t tileX = (tile % tilesX) * SPAWN_TILE_SIZE;
+            uint32_t tileY = (tile / tilesX) * SPAWN_TILE_SIZE;
+
+            // Se busca el píxel con menor cobertura con la misma clave que el atomicMin del shader: la cobertura
+            // truncada y, en caso de empate, las coordenadas locales del píxel
+            uint32_t minKey = UINT32_MAX;
+            size_t minPixel = 0;
+            float minCoverage = 0.0f;
+
+            for (uint32_t localY = 0; localY < SPAWN_TILE_SIZE; localY++)
+            for (uint32_t localX = 0; localX < SPAWN_TILE_SIZE; localX++)
+            {
+                uint32_t x = tileX + localX;
+                uint32_t y = tileY + localY;
+                if (x >= gBuffer.width || y >= gBuffer.height)
+                {
+                    continue;
+                }
+
+                size_t pixel = static_cast<size_t>(y) * gBuffer.width + x;
+                const glm::vec3 &worldPos = gBuffer.positions[pixel];
+                const glm::vec3 &normal = gBuffer.normals[pixel];
+
+                uint32_t level = clipmapLevel(worldPos, cameraPosition);
+                if (level >= SURFEL_CLIPMAP_LEVELS)
+                {
+                    continue;
+                }
+
+                float coverage = 0.0f;
+                const SurfelGridCell &gridCell = grid[cellIndex(cell(worldPos, level), level)];
+                for (uint32_t i = 0; i < gridCell.count; i++)
+                {
+                    uint32_t surfelIndex = cells[gridCell.offset + i];
+                    const Surfel &surfel = surfels[surfelIndex];
+
+                    float dist = glm::distance(surfel.position, worldPos);
+                    if (dist < surfel.radius)
+                    {
+                        float dotN = glm::dot(normal, surfel.normal);
+                        if (dotN > 0.0f)
+                        {
+                            float contribution = glm::clamp(dotN, 0.0f, 1.0f) * glm::clamp(1.0f - dist / surfel.radius, 0.0f, 1.0f);
+                            coverage += smoothstep01(contribution);
+                            result.seenSurfels.push_back(surfelIndex);
+                        }
+                    }
+                }
+
+                uint32_t key = ((static_cast<uint32_t>(coverage) & 0xFF) << 8) | ((localX & 0xF) << 4) | (localY & 0xF);
+                if (key < minKey)
+                {
+                    minKey = key;
+                    minPixel = pixel;
+                    minCoverage = coverage;
+                }
+            }
+
+            if (minKey == UINT32_MAX || minCoverage >= SURFEL_TARGET_COVERAGE)
+            {
+                continue;
+            }
+
+            // Generación probabilística según la profundidad
+            uint32_t x = static_cast<uint32_t>(minPixel % gBuffer.width);
+            uint32_t y = static_cast<uint32_t>(minPixel / gBuffer.width);
+            float depth = gBuffer.depths[minPixel];
+            float linearDepth = glm::clamp(depth / farPlane, 0.0f, 1.0f);
+            float chance = std::pow(1.0f - linearDepth, 16.0f);
+
+            float noise;
+            if (blueNoise.empty())
+            {
+                noise = static_cast<float>(hashUint(static_cast<uint32_t>(minPixel) ^ hashUint(frame))) / 4294967296.0f;
+            }
+            else
+            {
+                noise = blueNoise[(y % BLUE_NOISE_SIZE) * BLUE_NOISE_SIZE + (x % BLUE_NOISE_SIZE)];
+            }
+            if (noise < chance)
+            {
+                continue;
+            }
+
+            result.spawn = true;
+            result.surfel.position = gBuffer.positions[minPixel];
+            result.surfel.normal = gBuffer.normals[minPixel];
+            result.surfel.color = gBuffer.colors[minPixel];
+            result.surfel.generatedRays = 1;
+            result.surfel.lastSeenFrame = frame;
+            result.surfel.age = 0;
+            result.surfel.direct_radiance = glm::vec3(0.0f);
+            result.surfel.indirect_radiance = glm::vec3(0.0f);
+            result.surfel.luminanceMoment2 = 0.0f;
+            result.surfel.indirectTrend = 0.0f;
+            result.surfel.radius = std::min((SURFEL_MAX_RADIUS * depth) / focalLength, levelMaxRadius(clipmapLevel(result.surfel.position, cameraPosition)));
+        } });
+
+    // Los resultados se aplican en el orden de las regiones: primero se marcan los surfels vistos y después se reservan
+    // los nuevos, reutilizando antes los reciclados
+    uint32_t spawned = 0;
+    for (const TileResult &tile : tiles)
+    {
+        for (uint32_t surfelIndex : tile.seenSurfels)
+        {
+            surfels[surfelIndex].lastSeenFrame = frame;
+        }
+    }
+    for (const TileResult &tile : tiles)
+    {
+        if (!tile.spawn)
+        {
+            continue;
+        }
+
+        uint32_t surfelAlloc;
+        if (!freeList.empty())
+        {
+            surfelAlloc = freeList.back();
+            freeList.pop_back();
+        }
+        else if (surfelCount < SURFEL_CAPACITY)
+        {
+            surfelAlloc = surfelCount++;
+        }
+        else
+        {
+            break;
+        }
+
+        surfels[surfelAlloc] = tile.surfel;
+        spawned++;
+    }
+    return spawned;
+}
+
+uint64_t SurfelReference::integrateRadiance(const SurfelReferenceScene &scene, const glm::vec3 &lightPosition, float lightIntensity,
+                                            const std::vector<glm::vec2> &raySamples)
+{
+    const uint32_t side = static_cast<uint32_t>(std::sqrt(static_cast<double>(raySamples.size())));
+    if (side == 0 || side * side != raySamples.size())
+    {
+        throw std::runtime_error("failed to integrate reference surfel radiance: ray samples must fill a square texture!");
+    }
+
+    // Los resultados se escriben en una copia para que los rebotes de todos los surfels lean la caché del principio de
+    // la pasada, independientemente del orden en el que se procesen
+    std::vector<Surfel> updated(surfels.begin(), surfels.begin() + surfelCount);
+    std::atomic<uint64_t> tracedRays{0};
+
+    threadPool.parallelFor(surfelCount, SURFEL_BATCH_SIZE / 16, [&](uint32_t begin, uint32_t end)
+                {
+        uint64_t batchRays = 0;
+        for (uint32_t surfelIndex = begin; surfelIndex < end; surfelIndex++)
+        {
+            const Surfel &surfel = surfels[surfelIndex];
+            if (!needsRays(surfel))
+            {
+                continue;
+            }
+
+            // Mismo recorrido de la secuencia que el shader: desde la muestra en la que se quedó el surfel y rotada
+            // con un desplazamiento propio. Los lotes que sólo actualizan los rebotes avanzan con el número de frame
+            bool accumulateDirect = needsDirectRays(surfel);
+            uint32_t firstSample = sampleCount(surfel);
+            if (!accumulateDirect)
+            {
+                firstSample += frame * NUM_RAYS;
+            }
+            glm::vec2 rotation = glm::vec2(static_cast<float>(hashUint(surfelIndex)), static_cast<float>(hashUint(surfelIndex ^ 0x9e3779b9u))) / 4294967296.0f;
+
+            glm::vec3 T, B;
+            setOrthonormalBasis(surfel.normal, &T, &B);
+
+            glm::vec3 accumulatedRadiance(0.0f);
+            float accumulatedLuminance2 = 0.0f;
+            glm::vec3 accumulatedBounce(0.0f);
+            int numRays = 0;
+
+            for (uint32_t i = 0; i < NUM_RAYS; i++)
+            {
+                if (accumulateDirect && surfel.generatedRays + numRays >= static_cast<int>(MAX_RAYS_PER_SURFEL))
+                {
+                    break;
+                }
+                numRays++;
+
+                uint32_t sampleIndex = firstSample + i;
+                const glm::vec2 &texel = raySamples[((sampleIndex / side) % side) * side + sampleIndex % side];
+                glm::vec2 xi = glm::fract(texel + rotation);
+
+                glm::vec3 localDirection = cosineSampleHemisphere(xi);
+                glm::vec3 rayDirection = glm::normalize(T * localDirection.x + B * localDirection.y + surfel.normal * localDirection.z);
+                glm::vec3 rayOrigin = surfel.position + surfel.normal * RADIANCE_EPSILON;
+
+                SurfelReferenceHit hit;
+                if (!scene.intersect(rayOrigin, rayDirection, RAY_T_MIN, static_cast<float>(RAYS_LENGTH), &hit))
+                {
+                    continue;
+                }
+                glm::vec3 hitPos = rayOrigin + hit.t * rayDirection;
+
+                // Luz rebotada leída de la caché, con la normal orientada hacia el lado del que llega el rayo
+                glm::vec3 hitNormal = glm::dot(hit.normal, rayDirection) > 0.0f ? -hit.normal : hit.normal;
+                accumulatedBounce += SURFEL_BOUNCE_WEIGHT * hit.albedo * cachedRadiance(hitPos, hitNormal, surfelIndex ^ hashUint(sampleIndex));
+
+                glm::vec3 L = glm::normalize(lightPosition - hitPos);
+                if (scene.occluded(hitPos + surfel.normal * RADIANCE_EPSILON, L, RAY_T_MIN, SHADOW_RAY_LENGTH))
+                {
+                    continue;
+                }
+
+                glm::vec3 diffuse = lightIntensity * hit.albedo * std::max(glm::dot(L, hit.normal), 0.0f);
+                accumulatedRadiance += diffuse;
+                float luminance = glm::dot(diffuse, SURFEL_LUMINANCE_WEIGHTS);
+                accumulatedLuminance2 += luminance * luminance;
+            }
+
+            if (numRays == 0)
+            {
+                continue;
+            }
+            batchRays += numRays;
+
+            float previousSamples = static_cast<float>(sampleCount(surfel));
+            float totalSamples = previousSamples + static_cast<float>(numRays);
+
+            Surfel &result = updated[surfelIndex];
+            float bounceBlend = SURFEL_BOUNCE_MIN_BLEND;
+            if (accumulateDirect)
+            {
+                result.direct_radiance = (surfel.direct_radiance * previousSamples + accumulatedRadiance) / totalSamples;
+                result.luminanceMoment2 = (surfel.luminanceMoment2 * previousSamples + accumulatedLuminance2) / totalSamples;
+                result.generatedRays = surfel.generatedRays + numRays;
+                bounceBlend = std::max(static_cast<float>(numRays) / totalSamples, SURFEL_BOUNCE_MIN_BLEND);
+            }
+
+            glm::vec3 batchBounce = accumulatedBounce / static_cast<float>(numRays);
+            result.indirect_radiance = glm::mix(surfel.indirect_radiance, batchBounce, bounceBlend);
+            float bounceChange = glm::dot(batchBounce - surfel.indirect_radiance, SURFEL_LUMINANCE_WEIGHTS) /
+                                 std::max(glm::dot(result.direct_radiance + result.indirect_radiance, SURFEL_LUMINANCE_WEIGHTS), 1e-4f);
+            result.indirectTrend = glm::mix(surfel.indirectTrend, bounceChange, SURFEL_BOUNCE_TREND_BLEND);
+        }
+        tracedRays += batchRays; });
+
+    std::copy(updated.begin(), updated.end(), surfels.begin());
+    return tracedRays;
+}
+
+void SurfelReference::gatherIrradiance(const SurfelReferenceGBuffer &gBuffer, std::vector<glm::vec3> *irradiance) const
+{
+    const size_t numPixels = static_cast<size_t>(gBuffer.width) * gBuffer.height;
+    if (gBuffer.positions.size() != numPixels || gBuffer.normals.size() != numPixels)
+    {
+        throw std::runtime_error("failed to gather reference irradiance: incomplete G-buffer!");
+    }
+    irradiance->assign(numPixels, glm::vec3(0.0f));
+
+    threadPool.parallelFor(gBuffer.height, ROW_BATCH_SIZE, [&](uint32_t begin, uint32_t end)
+                {
+        // Pesos de los surfels de la celda que se está recorriendo
+        std::vector<float> weights;
+
+        for (uint32_t y = begin; y < end; y++)
+        for (uint32_t x = 0; x < gBuffer.width; x++)
+        {
+            size_t pixel = static_cast<size_t>(y) * gBuffer.width + x;
+            const glm::vec3 &position = gBuffer.positions[pixel];
+            const glm::vec3 &normal = gBuffer.normals[pixel];
+
+            uint32_t level = clipmapLevel(position, cameraPosition);
+            if (level >= SURFEL_CLIPMAP_LEVELS)
+            {
+                continue;
+            }
+            glm::ivec3 baseCell = cell(position, level);
+
+            glm::vec3 totalRadiance(0.0f);
+            float totalWeight = 0.0f;
+
+            for (int dx = -SHADING_REGION_RADIUS; dx <= SHADING_REGION_RADIUS; dx++)
+            for (int dy = -SHADING_REGION_RADIUS; dy <= SHADING_REGION_RADIUS; dy++)
+            for (int dz = -SHADING_REGION_RADIUS; dz <= SHADING_REGION_RADIUS; dz++)
+            {
+                glm::ivec3 c = baseCell + glm::ivec3(dx, dy, dz);
+                if (!cellValid(c, level, cameraPosition))
+                {
+                    continue;
+                }
+
+                uint32_t currentCell = cellIndex(c, level);
+                const SurfelGridCell &gridCell = grid[currentCell];
+                if (gridCell.count == 0)
+                {
+                    continue;
+                }
+
+                // Pesos de toda la celda sobre los arrays contiguos, sin saltos, para que se vectorice. Un surfel sólo
+                // cuenta desde su celda de origen para no sumarlo varias veces dentro de la región
+                weights.resize(gridCell.count);
+                const uint32_t first = gridCell.offset;
+                for (uint32_t k = 0; k < gridCell.count; k++)
+                {
+                    float ddx = position.x - binned.positionX[first + k];
+                    float ddy = position.y - binned.positionY[first + k];
+                    float ddz = position.z - binned.positionZ[first + k];
+                    float dist2 = ddx * ddx + ddy * ddy + ddz * ddz;
+                    float gauss = std::exp(-dist2 * binned.invTwoSigma2[first + k]);
+
+                    float nDot = normal.x * binned.normalX[first + k] + normal.y * binned.normalY[first + k] + normal.z * binned.normalZ[first + k];
+                    float angular = std::max(nDot, SHADING_MIN_ANGULAR_WEIGHT);
+
+                    weights[k] = binned.homeCell[first + k] == currentCell ? gauss * angular : 0.0f;
+                }
+
+                for (uint32_t k = 0; k < gridCell.count; k++)
+                {
+                    if (weights[k] < SHADING_MIN_WEIGHT_THRESHOLD)
+                    {
+                        continue;
+                    }
+                    totalRadiance += SurfelReference::irradiance(surfels[cells[first + k]]) * weights[k];
+                    totalWeight += weights[k];
+                }
+            }
+
+            if (totalWeight > 0.0f)
+            {
+                (*irradiance)[pixel] = totalRadiance / totalWeight;
+            }
+        } });
+}
+
+glm::vec3 SurfelReference::cachedRadiance(const glm::vec3 &hitPosition, const glm::vec3 &hitNormal, uint32_t seed) const
+{
+    uint32_t level = clipmapLevel(hitPosition, cameraPosition);
+    if (level >= SURFEL_CLIPMAP_LEVELS)
+    {
+        return glm::vec3(0.0f);
+    }
+
+    const SurfelGridCell &gridCell = grid[cellIndex(cell(hitPosition, level), level)];
+    uint32_t count = std::min(gridCell.count, SURFEL_BOUNCE_MAX_SURFELS);
+    // Mismo subconjunto que el shader: un surfel por tramo de la celda con el desplazamiento de la semilla
+    float stride = static_cast<float>(gridCell.count) / static_cast<float>(std::max(count, 1u));
+    float start = static_cast<float>(hashUint(seed)) / 4294967296.0f * stride;
+
+    glm::vec3 totalRadiance(0.0f);
+    float totalWeight = 0.0f;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t entry = std::min(static_cast<uint32_t>(start + static_cast<float>(i) * stride), gridCell.count - 1);
+        const Surfel &other = surfels[cells[gridCell.offset + entry]];
+        if (sampleCount(other) == 0)
+        {
+            continue;
+        }
+
+        float radius = std::max(other.radius, RADIANCE_EPSILON);
+        float falloff = std::max(1.0f - glm::distance(other.position, hitPosition) / (2.0f * radius), 0.0f);
+        float weight = falloff * std::max(glm::dot(other.normal, hitNormal), 0.0f);
+
+        totalRadiance += irradiance(other) * weight;
+        totalWeight += weight;
+    }
+    return totalWeight > 0.0f ? totalRadiance / totalWeight : glm::vec3(0.0f);
+}
+
+float SurfelReference::cellLength(uint32_t level)
+{
+    return CELL_LENGTH * static_cast<float>(1u << level);
+}
+
+float SurfelReference::levelMaxRadius(uint32_t level)
+{
+    return SURFEL_MAX_RADIUS * static_cast<float>(1u << level);
+}
+
+glm::ivec3 SurfelReference::cell(const glm::vec3 &position, uint32_t level)
+{
+    return glm::ivec3(glm::floor(position / cellLength(level)));
+}
+
+glm::ivec3 SurfelReference::levelOrigin(uint32_t level, const glm::vec3 &cameraPosition)
+{
+    return cell(cameraPosition, level) - glm::ivec3(SURFEL_GRID_DIMENSIONS / 2u);
+}
+
+bool SurfelReference::cellValid(const glm::ivec3 &cell, uint32_t level, const glm::vec3 &cameraPosition)
+{
+    glm::ivec3 local = cell - levelOrigin(level, cameraPosition);
+    return glm::all(glm::greaterThanEqual(local, glm::ivec3(0))) && glm::all(glm::lessThan(local, glm::ivec3(SURFEL_GRID_DIMENSIONS)));
+}
+
+uint32_t SurfelReference::clipmapLevel(const glm::vec3 &position, const glm::vec3 &cameraPosition)
+{
+    for (uint32_t level = 0; level < SURFEL_CLIPMAP_LEVELS; level++)
+    {
+        glm::ivec3 local = cell(position, level) - levelOrigin(level, cameraPosition);
+        if (glm::all(glm::greaterThanEqual(local, glm::ivec3(1))) && glm::all(glm::lessThan(local, glm::ivec3(SURFEL_GRID_DIMENSIONS) - 1)))
+        {
+            return level;
+        }
+    }
+    return SURFEL_CLIPMAP_LEVELS;
+}
+
+uint32_t SurfelReference::cellIndex(const glm::ivec3 &cell, uint32_t level)
+{
+    glm::uvec3 coord(cell & glm::ivec3(SURFEL_GRID_DIMENSIONS - 1u));
+    return level * SURFEL_LEVEL_TABLE_SIZE + coord.z * SURFEL_GRID_DIMENSIONS.x * SURFEL_GRID_DIMENSIONS.y + coord.y * SURFEL_GRID_DIMENSIONS.x + coord.x;
+}
+
+bool SurfelReference::cellIntersects(const Surfel &surfel, const glm::ivec3 &cell, uint32_t level, const glm::vec3 &cameraPosition)
+{
+    if (!cellValid(cell, level, cameraPosition))
+    {
+        return false;
+    }
+
+    // AABB de la celda en espacio de mundo y punto de la celda más cercano al surfel
+    glm::vec3 cellMin = glm::vec3(cell) * cellLength(level);
+    glm::vec3 cellMax = cellMin + glm::vec3(cellLength(level));
+    glm::vec3 closestPoint = glm::clamp(surfel.position, cellMin, cellMax);
+
+    glm::vec3 d = surfel.position - closestPoint;
+    float maxRadius = levelMaxRadius(level);
+    return glm::dot(d, d) < maxRadius * maxRadius;
+}
+
+bool SurfelReference::isAlive(const Surfel &surfel)
+{
+    return surfel.generatedRays > 0;
+}
+
+uint32_t SurfelReference::sampleCount(const Surfel &surfel)
+{
+    return static_cast<uint32_t>(std::max(surfel.generatedRays - 1, 0));
+}
+
+glm::vec3 SurfelReference::irradiance(const Surfel &surfel)
+{
+    return surfel.direct_radiance + surfel.indirect_radiance;
+}
+
+float SurfelReference::relativeError(const Surfel &surfel)
+{
+    uint32_t samples = sampleCount(surfel);
+    if (samples == 0)
+    {
+        return 1.0f;
+    }
+
+    float meanLuminance = glm::dot(surfel.direct_radiance, SURFEL_LUMINANCE_WEIGHTS);
+    float variance = std::max(surfel.luminanceMoment2 - meanLuminance * meanLuminance, 0.0f);
+    return std::sqrt(variance / static_cast<float>(samples)) / std::max(meanLuminance, 1e-4f);
+}
+
+bool SurfelReference::needsDirectRays(const Surfel &surfel)
+{
+    if (!isAlive(surfel) || surfel.generatedRays >= static_cast<int>(MAX_RAYS_PER_SURFEL))
+    {
+        return false;
+    }
+    return sampleCount(surfel) < SURFEL_MIN_SAMPLES || relativeError(surfel) >= SURFEL_CONVERGED_ERROR;
+}
+
+bool SurfelReference::needsRays(const Surfel &surfel)
+{
+    return needsDirectRays(surfel) || (isAlive(surfel) && std::abs(surfel.indirectTrend) >= SURFEL_BOUNCE_CONVERGED_CHANGE);
+}
+
+uint32_t SurfelReference::hashUint(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
\ No newline at end of file
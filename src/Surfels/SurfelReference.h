@@ -0,0 +1,118 @@
+#pragma once
+
+#include "SurfelData.h"
+#include "Tools/ThreadPool.h"
+
+#define GLM_FORCE_RADIANS
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+
+// G-buffer de la implementación de referencia, ya en espacio de mundo. Es lo que leen de sus texturas la generación de
+// surfels y el sombreado indirecto tras pasar la posición y la normal de espacio de cámara a espacio global
+struct SurfelReferenceGBuffer
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<glm::vec3> positions; // Posición en espacio de mundo de cada píxel
+    std::vector<glm::vec3> normals;   // Normal normalizada en espacio de mundo
+    std::vector<glm::vec3> colors;
+    std::vector<float> depths;        // Profundidad lineal: distancia al plano de la cámara (-z en espacio de cámara)
+};
+
+// Punto de choque de un rayo, con lo que necesita el cálculo de radiancia del material y la geometría alcanzados
+struct SurfelReferenceHit
+{
+    float t;
+    glm::vec3 normal; // Normal interpolada de los vértices
+    glm::vec3 albedo;
+};
+
+// Escena contra la que se trazan los rayos de los surfels en CPU, en lugar de la TLAS
+class SurfelReferenceScene
+{
+public:
+    virtual ~SurfelReferenceScene() = default;
+
+    // Choque más cercano del rayo con t en [tMin, tMax]
+    virtual bool intersect(const glm::vec3 &origin, const glm::vec3 &direction, float tMin, float tMax, SurfelReferenceHit *hit) const = 0;
+    // Si el rayo choca con algo en [tMin, tMax], para los rayos de sombra, que terminan en el primer choque
+    virtual bool occluded(const glm::vec3 &origin, const glm::vec3 &direction, float tMin, float tMax) const = 0;
+};
+
+// Implementación en CPU de los algoritmos de los surfels (construcción del grid, generación según la cobertura,
+// integración de la radiancia en el hemisferio y gather gaussiano del sombreado indirecto), para validar los shaders
+// sin una GPU con ray tracing y para hacer bakes offline. Sigue los mismos pasos y constantes que los shaders, pero
+// de forma determinista: donde la GPU usa atómicos, aquí cada hilo trabaja sobre su parte y los resultados se
+// combinan en orden
+class SurfelReference
+{
+public:
+    // Tamaño de la textura de blue noise de la generación (surfel_generation.comp la muestrea en píxel % 128)
+    static const uint32_t BLUE_NOISE_SIZE = 128;
+    // Tamaño de las regiones de píxeles en las que se genera como mucho un surfel, como los grupos del shader
+    static const uint32_t SPAWN_TILE_SIZE = 16;
+
+    // Mismo contenido que los buffers de la GPU: los surfels, el grid compactado y la pila de surfels reciclados
+    std::vector<Surfel> surfels;
+    uint32_t surfelCount = 0;
+    std::vector<SurfelGridCell> grid;
+    std::vector<uint32_t> cells;
+    std::vector<uint32_t> freeList;
+    // Número de frame con el que se marca cuándo se vio cada surfel
+    uint32_t frame = 0;
+    // Posición de la cámara, en la que se centra el clipmap del grid
+    glm::vec3 cameraPosition = glm::vec3(0.0f);
+
+    explicit SurfelReference(ThreadPool &threadPool);
+
+    // Equivalente a surfel_grid_count, surfel_grid_offset y surfel_grid_binning: envejece los surfels vivos y
+    // reconstruye el grid compactado. Dentro de cada celda los surfels quedan ordenados por índice
+    void buildGrid();
+    // Equivalente a surfel_generation: en cada región de 16x16 píxeles se busca el píxel menos cubierto y, si no llega
+    // a la cobertura objetivo, se genera un surfel en él. blueNoise tiene BLUE_NOISE_SIZE^2 valores (canal rojo de la
+    // textura); si está vacío se usa ruido blanco. Devuelve el número de surfels generados
+    uint32_t spawnSurfels(const SurfelReferenceGBuffer &gBuffer, float farPlane, const std::vector<float> &blueNoise);
+    // Equivalente a surfel_radiance_calculation para todos los surfels que necesitan rayos, sin presupuesto por frame.
+    // raySamples es la secuencia de la textura de direcciones (NUM_RAYS^2 puntos). Los rebotes se leen de la radiancia
+    // de los surfels al principio de la pasada. Devuelve el número de rayos trazados
+    uint64_t integrateRadiance(const SurfelReferenceScene &scene, const glm::vec3 &lightPosition, float lightIntensity,
+                               const std::vector<glm::vec2> &raySamples);
+    // Equivalente a indirect_diffuse_tiled: irradiancia indirecta de cada píxel del G-buffer
+    void gatherIrradiance(const SurfelReferenceGBuffer &gBuffer, std::vector<glm::vec3> *irradiance) const;
+
+    // Funciones de surfelsData.glsl
+    static float cellLength(uint32_t level);
+    static float levelMaxRadius(uint32_t level);
+    static glm::ivec3 cell(const glm::vec3 &position, uint32_t level);
+    static glm::ivec3 levelOrigin(uint32_t level, const glm::vec3 &cameraPosition);
+    static bool cellValid(const glm::ivec3 &cell, uint32_t level, const glm::vec3 &cameraPosition);
+    static uint32_t clipmapLevel(const glm::vec3 &position, const glm::vec3 &cameraPosition);
+    static uint32_t cellIndex(const glm::ivec3 &cell, uint32_t level);
+    static bool cellIntersects(const Surfel &surfel, const glm::ivec3 &cell, uint32_t level, const glm::vec3 &cameraPosition);
+    static bool isAlive(const Surfel &surfel);
+    static uint32_t sampleCount(const Surfel &surfel);
+    static glm::vec3 irradiance(const Surfel &surfel);
+    static float relativeError(const Surfel &surfel);
+    static bool needsDirectRays(const Surfel &surfel);
+    static bool needsRays(const Surfel &surfel);
+    static uint32_t hashUint(uint32_t x);
+
+private:
+    ThreadPool &threadPool;
+
+    // Copia en estructura de arrays de la geometría de los surfels de cada referencia del grid, en el mismo orden que
+    // cells, para que el bucle del gather recorra memoria contigua y el compilador pueda vectorizarlo
+    struct BinnedSurfels
+    {
+        std::vector<float> positionX, positionY, positionZ;
+        std::vector<float> normalX, normalY, normalZ;
+        std::vector<float> invTwoSigma2;
+        std::vector<uint32_t> homeCell; // Celda de origen del surfel en su nivel del clipmap
+    };
+    BinnedSurfels binned;
+
+    glm::vec3 cachedRadiance(const glm::vec3 &hitPosition, const glm::vec3 &hitNormal, uint32_t seed) const;
+};
\ No newline at end of file
@@ -0,0 +1,460 @@
+#include "Raytracing/CpuBvh.h"
+#include "Surfels/SurfelBvhScene.h"
+#include "Surfels/SurfelReference.h"
+#include "Tools/SamplingSequences.h"
+#include "Tools/ThreadPool.h"
+
+#define GLM_FORCE_RADIANS
+
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+using namespace SurfelShader;
+
+namespace
+{
+    const float PI = 3.14159265358979323846f;
+
+    // Escena de prueba: una habitación cerrada con una columna y una nube de triángulos pequeños, con más triángulos
+    // que CpuBvh::PARALLEL_SUBTREE_TRIANGLES para que la construcción reparta subárboles entre los hilos
+    const glm::vec3 ROOM_MIN = glm::vec3(-300.0f, 0.0f, -300.0f);
+    const glm::vec3 ROOM_MAX = glm::vec3(300.0f, 300.0f, 300.0f);
+    const uint32_t CLOUD_TRIANGLES = 20000;
+    const float CLOUD_TRIANGLE_SIZE = 8.0f;
+    const uint32_t SCENE_SEED = 1234;
+
+    // Rayos de la comparación con la fuerza bruta
+    const uint32_t BVH_TEST_RAYS = 4000;
+    const float BVH_T_TOLERANCE = 1e-4f;
+    // Margen de las coordenadas baricéntricas en el que un choque en el borde puede resolverse distinto por redondeo
+    const float BVH_EDGE_TOLERANCE = 1e-4f;
+
+    // G-buffer trazado desde la cámara y frames que se simulan con la implementación de referencia
+    const uint32_t GBUFFER_WIDTH = 320;
+    const uint32_t GBUFFER_HEIGHT = 180;
+    const float FIELD_OF_VIEW = glm::radians(60.0f);
+    const float FAR_PLANE = 1500.0f;
+    const glm::vec3 CAMERA_POSITION = glm::vec3(0.0f, 150.0f, 250.0f);
+    const glm::vec3 LIGHT_POSITION = glm::vec3(0.0f, 280.0f, 0.0f);
+    const float LIGHT_INTENSITY = 1.0f;
+    const uint32_t REFERENCE_FRAMES = 6;
+
+    // Como mucho se imprimen unos pocos fallos de cada comprobación, para que un error no inunde la salida
+    const uint32_t MAX_REPORTED_FAILURES = 8;
+
+    uint32_t failures = 0;
+
+    bool check(bool condition, const std::string &message)
+    {
+        if (!condition)
+        {
+            if (failures < MAX_REPORTED_FAILURES)
+            {
+                std::cerr << "FALLO: " << message << std::endl;
+            }
+            failures++;
+        }
+        return condition;
+    }
+
+    void addQuad(SurfelBvhScene &scene, const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c, const glm::vec3 &d, uint32_t materialId)
+    {
+        glm::vec3 normal = glm::normalize(glm::cross(b - a, c - a));
+        scene.addMesh({a, b, c, d}, {normal, normal, normal, normal}, {0, 1, 2, 0, 2, 3}, materialId);
+    }
+
+    // Caja con las caras hacia fuera, o hacia dentro si inward es true
+    void addBox(SurfelBvhScene &scene, const glm::vec3 &boxMin, const glm::vec3 &boxMax, bool inward, uint32_t materialId)
+    {
+        glm::vec3 corners[8];
+        for (int i = 0; i < 8; i++)
+        {
+            corners[i] = glm::vec3((i & 1) != 0 ? boxMax.x : boxMin.x, (i & 2) != 0 ? boxMax.y : boxMin.y, (i & 4) != 0 ? boxMax.z : boxMin.z);
+        }
+        // Esquinas de cada cara en sentido antihorario visto desde fuera
+        const int faces[6][4] = {{0, 4, 6, 2}, {1, 3, 7, 5}, {0, 1, 5, 4}, {2, 6, 7, 3}, {0, 2, 3, 1}, {4, 5, 7, 6}};
+        for (const auto &face : faces)
+        {
+            if (inward)
+            {
+                addQuad(scene, corners[face[0]], corners[face[3]], corners[face[2]], corners[face[1]], materialId);
+            }
+            else
+            {
+                addQuad(scene, corners[face[0]], corners[face[1]], corners[face[2]], corners[face[3]], materialId);
+            }
+        }
+    }
+
+    void buildScene(SurfelBvhScene &scene, ThreadPool &threadPool)
+    {
+        addBox(scene, ROOM_MIN, ROOM_MAX, true, 0);
+        addBox(scene, glm::vec3(-40.0f, 0.0f, -40.0f), glm::vec3(40.0f, 300.0f, 40.0f), false, 1);
+
+        std::mt19937 rng(SCENE_SEED);
+        std::uniform_real_distribution<float> unitDistribution(0.0f, 1.0f);
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec3> normals;
+        std::vector<uint32_t> indices;
+        for (uint32_t i = 0; i < CLOUD_TRIANGLES; i++)
+        {
+            // Nube en la mitad trasera de la habitación, para que la cámara vea también las paredes y la columna
+            glm::vec3 center = glm::vec3(-250.0f + 500.0f * unitDistribution(rng), 20.0f + 260.0f * unitDistribution(rng), -280.0f + 200.0f * unitDistribution(rng));
+            glm::vec3 v[3];
+            for (glm::vec3 &vertex : v)
+            {
+                vertex = center + CLOUD_TRIANGLE_SIZE * (glm::vec3(unitDistribution(rng), unitDistribution(rng), unitDistribution(rng)) - 0.5f);
+            }
+            glm::vec3 normal = glm::cross(v[1] - v[0], v[2] - v[0]);
+            normal = glm::dot(normal, normal) > 1e-12f ? glm::normalize(normal) : glm::vec3(0.0f, 1.0f, 0.0f);
+
+            for (const glm::vec3 &vertex : v)
+            {
+                indices.push_back(static_cast<uint32_t>(positions.size()));
+                positions.push_back(vertex);
+                normals.push_back(normal);
+            }
+        }
+        scene.addMesh(positions, normals, indices, 2);
+
+        scene.setMaterialAlbedos({glm::vec3(0.8f), glm::vec3(0.8f, 0.2f, 0.2f), glm::vec3(0.2f, 0.8f, 0.2f)});
+        scene.build(threadPool);
+    }
+
+    // Möller-Trumbore sin descartar caras traseras, sobre un triángulo sin preparar
+    bool intersectTriangle(const glm::vec3 &v0, const glm::vec3 &v1, const glm::vec3 &v2, const glm::vec3 &origin, const glm::vec3 &direction,
+                           float tMin, float tMax, CpuBvhHit *hit)
+    {
+        glm::vec3 edge1 = v1 - v0;
+        glm::vec3 edge2 = v2 - v0;
+        glm::vec3 p = glm::cross(direction, edge2);
+        float determinant = glm::dot(edge1, p);
+        if (std::abs(determinant) < 1e-12f)
+        {
+            return false;
+        }
+        float inverseDeterminant = 1.0f / determinant;
+
+        glm::vec3 s = origin - v0;
+        float u = glm::dot(s, p) * inverseDeterminant;
+        if (u < 0.0f || u > 1.0f)
+        {
+            return false;
+        }
+        glm::vec3 q = glm::cross(s, edge1);
+        float v = glm::dot(direction, q) * inverseDeterminant;
+        if (v < 0.0f || u + v > 1.0f)
+        {
+            return false;
+        }
+        float t = glm::dot(edge2, q) * inverseDeterminant;
+        if (t < tMin || t > tMax)
+        {
+            return false;
+        }
+
+        hit->t = t;
+        hit->u = u;
+        hit->v = v;
+        return true;
+    }
+
+    // Choque más cercano recorriendo todos los triángulos
+    bool bruteForceIntersect(const std::vector<glm::vec3> &positions, const std::vector<glm::uvec3> &triangles, const glm::vec3 &origin,
+                             const glm::vec3 &direction, float tMin, float tMax, CpuBvhHit *hit)
+    {
+        bool found = false;
+        float closest = tMax;
+        for (uint32_t i = 0; i < triangles.size(); i++)
+        {
+            const glm::uvec3 &triangle = triangles[i];
+            CpuBvhHit candidate;
+            if (intersectTriangle(positions[triangle.x], positions[triangle.y], positions[triangle.z], origin, direction, tMin, closest, &candidate))
+            {
+                found = true;
+                closest = candidate.t;
+                *hit = candidate;
+                hit->triangle = i;
+            }
+        }
+        return found;
+    }
+
+    // Si el choque cae tan cerca de un borde del triángulo que el redondeo puede darlo por dentro o por fuera
+    bool nearEdge(const CpuBvhHit &hit)
+    {
+        return std::min(std::min(hit.u, hit.v), 1.0f - hit.u - hit.v) < BVH_EDGE_TOLERANCE;
+    }
+
+    bool sameT(float a, float b)
+    {
+        return std::abs(a - b) <= BVH_T_TOLERANCE * std::max(1.0f, std::max(a, b));
+    }
+
+    // Compara los choques de la BVH con los de la fuerza bruta para rayos aleatorios desde dentro de la habitación
+    void testCpuBvh(const SurfelBvhScene &scene)
+    {
+        const CpuBvh &bvh = scene.getBvh();
+        const std::vector<glm::vec3> &positions = scene.getPositions();
+        const std::vector<glm::uvec3> &triangles = scene.getTriangles();
+        check(bvh.getTriangleCount() == triangles.size(), "la BVH no contiene todos los triángulos de la escena");
+
+        std::mt19937 rng(SCENE_SEED + 1);
+        std::uniform_real_distribution<float> unitDistribution(0.0f, 1.0f);
+        uint32_t hits = 0;
+        uint32_t occludedRays = 0;
+        for (uint32_t i = 0; i < BVH_TEST_RAYS; i++)
+        {
+            glm::vec3 origin = ROOM_MIN + (ROOM_MAX - ROOM_MIN) * glm::vec3(unitDistribution(rng), unitDistribution(rng), unitDistribution(rng));
+            float z = 1.0f - 2.0f * unitDistribution(rng);
+            float r = std::sqrt(std::max(0.0f, 1.0f - z * z));
+            float angle = 2.0f * PI * unitDistribution(rng);
+            glm::vec3 direction = glm::vec3(r * std::cos(angle), r * std::sin(angle), z);
+            // La mitad de los rayos son cortos, para comprobar también el corte por tMax
+            float tMax = (i & 1) != 0 ? 1000.0f * unitDistribution(rng) : static_cast<float>(RAYS_LENGTH);
+            const float tMin = 0.01f;
+
+            CpuBvhHit bvhHit;
+            CpuBvhHit bruteHit;
+            bool bvhFound = bvh.intersect(origin, direction, tMin, tMax, &bvhHit);
+            bool bruteFound = bruteForceIntersect(positions, triangles, origin, direction, tMin, tMax, &bruteHit);
+            std::string ray = "rayo " + std::to_string(i);
+
+            if (bvhFound != bruteFound)
+            {
+                const CpuBvhHit &found = bvhFound ? bvhHit : bruteHit;
+                check(nearEdge(found), ray + ": la BVH y la fuerza bruta no coinciden en si hay choque");
+            }
+            else if (bvhFound)
+            {
+                hits++;
+                // Un choque en el borde de un triángulo más cercano puede dejar el siguiente como el más cercano
+                check(sameT(bvhHit.t, bruteHit.t) || nearEdge(bvhHit) || nearEdge(bruteHit), ray + ": distancia " + std::to_string(bvhHit.t) + " en la BVH y " + std::to_string(bruteHit.t) +
+                                                       " en la fuerza bruta");
+                // Con dos triángulos a la misma distancia cualquiera de los dos es válido
+                if (bvhHit.triangle == bruteHit.triangle)
+                {
+                    check(std::abs(bvhHit.u - bruteHit.u) <= BVH_EDGE_TOLERANCE && std::abs(bvhHit.v - bruteHit.v) <= BVH_EDGE_TOLERANCE,
+                          ray + ": coordenadas baricéntricas distintas");
+                }
+            }
+
+            bool occluded = bvh.occluded(origin, direction, tMin, tMax);
+            occludedRays += occluded ? 1 : 0;
+            if (occluded != bruteFound)
+            {
+                check(bruteFound ? nearEdge(bruteHit) : bvhFound && nearEdge(bvhHit), ray + ": occluded no coincide con la fuerza bruta");
+            }
+        }
+
+        // Sin choques la comparación no comprobaría nada
+        check(hits > BVH_TEST_RAYS / 4, "casi ningún rayo choca con la escena de prueba");
+        std::cout << "BVH de CPU: " << BVH_TEST_RAYS << " rayos comparados con la fuerza bruta, " << hits << " choques, " << occludedRays
+                  << " ocluidos" << std::endl;
+    }
+
+    // G-buffer en espacio de mundo trazando un rayo por píxel desde la cámara, mirando hacia -z
+    SurfelReferenceGBuffer traceGBuffer(const SurfelBvhScene &scene)
+    {
+        SurfelReferenceGBuffer gBuffer;
+        gBuffer.width = GBUFFER_WIDTH;
+        gBuffer.height = GBUFFER_HEIGHT;
+        const size_t numPixels = static_cast<size_t>(GBUFFER_WIDTH) * GBUFFER_HEIGHT;
+        gBuffer.positions.resize(numPixels);
+        gBuffer.normals.resize(numPixels);
+        gBuffer.colors.resize(numPixels);
+        gBuffer.depths.resize(numPixels);
+
+        const glm::vec3 forward = glm::vec3(0.0f, 0.0f, -1.0f);
+        const float tanHalfFov = std::tan(FIELD_OF_VIEW * 0.5f);
+        const float aspect = static_cast<float>(GBUFFER_WIDTH) / GBUFFER_HEIGHT;
+        for (uint32_t y = 0; y < GBUFFER_HEIGHT; y++)
+        for (uint32_t x = 0; x < GBUFFER_WIDTH; x++)
+        {
+            float ndcX = (2.0f * (x + 0.5f) / GBUFFER_WIDTH - 1.0f) * tanHalfFov * aspect;
+            float ndcY = (1.0f - 2.0f * (y + 0.5f) / GBUFFER_HEIGHT) * tanHalfFov;
+            glm::vec3 direction = glm::normalize(forward + glm::vec3(ndcX, ndcY, 0.0f));
+
+            size_t pixel = static_cast<size_t>(y) * GBUFFER_WIDTH + x;
+            SurfelReferenceHit hit;
+            if (scene.intersect(CAMERA_POSITION, direction, 0.0f, FAR_PLANE, &hit))
+            {
+                gBuffer.positions[pixel] = CAMERA_POSITION + direction * hit.t;
+                // Como la nube no tiene un lado definido, la normal se orienta hacia la cámara
+                gBuffer.normals[pixel] = glm::dot(hit.normal, direction) > 0.0f ? -hit.normal : hit.normal;
+                gBuffer.colors[pixel] = hit.albedo;
+                gBuffer.depths[pixel] = hit.t * glm::dot(direction, forward);
+            }
+            else
+            {
+                gBuffer.positions[pixel] = CAMERA_POSITION + direction * FAR_PLANE;
+                gBuffer.normals[pixel] = -direction;
+                gBuffer.colors[pixel] = glm::vec3(0.0f);
+                gBuffer.depths[pixel] = FAR_PLANE;
+            }
+        }
+        return gBuffer;
+    }
+
+    // Invariantes del grid compactado y de la asignación de surfels tras buildGrid
+    void checkReferenceInvariants(const SurfelReference &reference, uint32_t frame)
+    {
+        std::string prefix = "frame " + std::to_string(frame) + ": ";
+
+        // Los offsets son la suma prefija exclusiva de los contadores, y el total es el tamaño de la lista de celdas
+        uint32_t offset = 0;
+        for (uint32_t c = 0; c < reference.grid.size(); c++)
+        {
+            if (!check(reference.grid[c].offset == offset, prefix + "el offset de la celda " + std::to_string(c) + " no es la suma prefija de los contadores"))
+            {
+                break;
+            }
+            offset += reference.grid[c].count;
+        }
+        check(offset == reference.cells.size(), prefix + "la suma de los contadores no coincide con el tamaño de la lista de celdas");
+
+        // Dentro de cada celda los surfels son vivos, distintos y están ordenados por índice
+        for (uint32_t c = 0; c < reference.grid.size(); c++)
+        {
+            const SurfelGridCell &gridCell = reference.grid[c];
+            for (uint32_t i = 0; i < gridCell.count && gridCell.offset + i < reference.cells.size(); i++)
+            {
+                uint32_t surfelIndex = reference.cells[gridCell.offset + i];
+                check(surfelIndex < reference.surfelCount && SurfelReference::isAlive(reference.surfels[surfelIndex]),
+                      prefix + "la celda " + std::to_string(c) + " contiene un surfel que no está vivo");
+                check(i == 0 || reference.cells[gridCell.offset + i - 1] < surfelIndex,
+                      prefix + "la celda " + std::to_string(c) + " no está ordenada por índice");
+            }
+        }
+
+        // Cada surfel vivo dentro del clipmap está en todas las celdas que solapa, y no hay más referencias que esas
+        uint64_t expectedReferences = 0;
+        uint32_t liveSurfels = 0;
+        for (uint32_t s = 0; s < reference.surfelCount; s++)
+        {
+            const Surfel &surfel = reference.surfels[s];
+            if (!SurfelReference::isAlive(surfel))
+            {
+                continue;
+            }
+            liveSurfels++;
+
+            uint32_t level = SurfelReference::clipmapLevel(surfel.position, reference.cameraPosition);
+            if (level >= SURFEL_CLIPMAP_LEVELS)
+            {
+                continue;
+            }
+            glm::ivec3 home = SurfelReference::cell(surfel.position, level);
+            for (int dx = -1; dx <= 1; dx++)
+            for (int dy = -1; dy <= 1; dy++)
+            for (int dz = -1; dz <= 1; dz++)
+            {
+                glm::ivec3 neighbour = home + glm::ivec3(dx, dy, dz);
+                if (!SurfelReference::cellIntersects(surfel, neighbour, level, reference.cameraPosition))
+                {
+                    continue;
+                }
+                expectedReferences++;
+
+                const SurfelGridCell &gridCell = reference.grid[SurfelReference::cellIndex(neighbour, level)];
+                auto first = reference.cells.begin() + std::min<size_t>(gridCell.offset, reference.cells.size());
+                auto last = reference.cells.begin() + std::min<size_t>(static_cast<size_t>(gridCell.offset) + gridCell.count, reference.cells.size());
+                check(std::find(first, last, s) != last, prefix + "el surfel " + std::to_string(s) + " no está en una celda que solapa");
+            }
+        }
+        check(expectedReferences == reference.cells.size(), prefix + "la lista de celdas tiene referencias de más");
+
+        // Los surfels reciclados y los que nunca se han usado son libres, y junto a los vivos suman la capacidad
+        std::vector<bool> freed(SURFEL_CAPACITY, false);
+        for (uint32_t surfelIndex : reference.freeList)
+        {
+            check(surfelIndex < reference.surfelCount && !freed[surfelIndex] && !SurfelReference::isAlive(reference.surfels[surfelIndex]),
+                  prefix + "la lista de libres contiene un surfel repetido, vivo o sin asignar");
+            if (surfelIndex < SURFEL_CAPACITY)
+            {
+                freed[surfelIndex] = true;
+            }
+        }
+        for (uint32_t s = reference.surfelCount; s < SURFEL_CAPACITY; s++)
+        {
+            if (!check(!SurfelReference::isAlive(reference.surfels[s]), prefix + "hay surfels vivos después de surfelCount"))
+            {
+                break;
+            }
+        }
+        check(liveSurfels + reference.freeList.size() + (SURFEL_CAPACITY - reference.surfelCount) == SURFEL_CAPACITY,
+              prefix + "los surfels libres y los vivos no suman la capacidad");
+    }
+
+    // Simula unos frames de la implementación de referencia con el mismo orden que la aplicación, comprobando los
+    // invariantes del grid tras cada reconstrucción
+    void testSurfelReference(const SurfelBvhScene &scene, ThreadPool &threadPool)
+    {
+        SurfelReferenceGBuffer gBuffer = traceGBuffer(scene);
+        std::vector<glm::vec2> raySamples = SamplingSequences::generate(SOBOL, NUM_RAYS * NUM_RAYS, SCENE_SEED);
+
+        SurfelReference reference(threadPool);
+        reference.cameraPosition = CAMERA_POSITION;
+        uint64_t tracedRays = 0;
+        for (uint32_t frame = 0; frame < REFERENCE_FRAMES; frame++)
+        {
+            reference.frame = frame;
+            reference.buildGrid();
+            checkReferenceInvariants(reference, frame);
+            reference.spawnSurfels(gBuffer, FAR_PLANE, {});
+            tracedRays += reference.integrateRadiance(scene, LIGHT_POSITION, LIGHT_INTENSITY, raySamples);
+        }
+        reference.buildGrid();
+        checkReferenceInvariants(reference, REFERENCE_FRAMES);
+
+        check(reference.surfelCount > 0, "la implementación de referencia no ha generado surfels");
+        check(tracedRays > 0, "la implementación de referencia no ha trazado rayos");
+        for (uint32_t s = 0; s < reference.surfelCount; s++)
+        {
+            glm::vec3 irradiance = SurfelReference::irradiance(reference.surfels[s]);
+            if (!check(std::isfinite(irradiance.x) && std::isfinite(irradiance.y) && std::isfinite(irradiance.z),
+                       "el surfel " + std::to_string(s) + " tiene una irradiancia no finita"))
+            {
+                break;
+            }
+        }
+        std::cout << "Referencia de surfels: " << REFERENCE_FRAMES << " frames, " << reference.surfelCount << " surfels, " << reference.cells.size()
+                  << " referencias en el grid, " << tracedRays << " rayos" << std::endl;
+    }
+}
+
+// Pruebas de la parte de CPU de los surfels, que se lanzan con ctest: la BVH de CPU frente a Möller-Trumbore por fuerza
+// bruta y los invariantes del grid de la implementación de referencia a lo largo de unos frames
+int main()
+{
+    try
+    {
+        ThreadPool threadPool;
+        SurfelBvhScene scene;
+        buildScene(scene, threadPool);
+
+        testCpuBvh(scene);
+        testSurfelReference(scene, threadPool);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (failures > 0)
+    {
+        std::cerr << failures << " comprobaciones fallidas" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "Todas las comprobaciones son correctas" << std::endl;
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
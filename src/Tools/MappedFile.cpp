@@ -0,0 +1,109 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <string>
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string &filePath)
+{
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr)
+    {
+        CloseHandle(file);
+        return false;
+    }
+    void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    fileHandle = file;
+    mappingHandle = mapping;
+    data = static_cast<const uint8_t *>(view);
+    size = static_cast<size_t>(fileSize.QuadPart);
+#else
+    int file = ::open(filePath.c_str(), O_RDONLY);
+    if (file < 0)
+    {
+        return false;
+    }
+    struct stat fileStat;
+    if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0)
+    {
+        ::close(file);
+        return false;
+    }
+    void *view = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    if (view == MAP_FAILED)
+    {
+        ::close(file);
+        return false;
+    }
+    fileDescriptor = file;
+    data = static_cast<const uint8_t *>(view);
+    size = static_cast<size_t>(fileStat.st_size);
+#endif
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (data == nullptr)
+    {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+    CloseHandle(static_cast<HANDLE>(mappingHandle));
+    CloseHandle(static_cast<HANDLE>(fileHandle));
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+#else
+    munmap(const_cast<uint8_t *>(data), size);
+    ::close(fileDescriptor);
+    fileDescriptor = -1;
+#endif
+    data = nullptr;
+    size = 0;
+}
+
+const uint8_t *MappedFile::getData() const
+{
+    return data;
+}
+
+size_t MappedFile::getSize() const
+{
+    return size;
+}
\ No newline at end of file
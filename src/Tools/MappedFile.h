@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Fichero de sólo lectura proyectado en memoria, para leer datos binarios sin copias intermedias
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	// Devuelve false si el fichero no existe o no se puede proyectar
+	bool open(const std::string &filePath);
+	void close();
+
+	const uint8_t *getData() const;
+	size_t getSize() const;
+
+private:
+	const uint8_t *data = nullptr;
+	size_t size = 0;
+#ifdef _WIN32
+	void *fileHandle = nullptr;
+	void *mappingHandle = nullptr;
+#else
+	int fileDescriptor = -1;
+#endif
+};
\ No newline at end of file
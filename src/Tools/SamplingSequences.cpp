@@ -0,0 +1,164 @@
+#include "SamplingSequences.h"
+
+#include <random>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+
+namespace
+{
+    // 1 / 2^32, para pasar los enteros de 32 bits de Sobol a [0,1)
+    const double UINT32_TO_UNIT = 1.0 / 4294967296.0;
+
+    // Razón plástica, raíz real de x^3 = x + 1. Sus inversas dan los incrementos de la secuencia R2
+    const double PLASTIC_NUMBER = 1.32471795724474602596;
+
+    // Valor justo por debajo de 1, para que ningún punto redondeado a float llegue a salirse del intervalo [0,1)
+    const float ONE_MINUS_EPSILON = 0.99999994f;
+}
+
+std::vector<glm::vec2> SamplingSequences::whiteNoise(uint32_t count, uint32_t seed)
+{
+    std::vector<glm::vec2> points(count);
+
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        float u1 = dist(rng);
+        float u2 = dist(rng);
+        points[i] = glm::vec2(u1, u2);
+    }
+    return points;
+}
+
+std::vector<glm::vec2> SamplingSequences::r2(uint32_t count, glm::vec2 offset)
+{
+    std::vector<glm::vec2> points(count);
+
+    const double alpha1 = 1.0 / PLASTIC_NUMBER;
+    const double alpha2 = 1.0 / (PLASTIC_NUMBER * PLASTIC_NUMBER);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        // Se calcula en doble precisión para no acumular error en los índices altos
+        double x = offset.x + alpha1 * (i + 1);
+        double y = offset.y + alpha2 * (i + 1);
+        points[i] = glm::vec2(static_cast<float>(x - std::floor(x)), static_cast<float>(y - std::floor(y)));
+        points[i] = glm::min(points[i], glm::vec2(ONE_MINUS_EPSILON));
+    }
+    return points;
+}
+
+std::vector<glm::vec2> SamplingSequences::sobol(uint32_t count, uint32_t seed)
+{
+    std::vector<glm::vec2> points(count);
+
+    // Números de dirección de las dos primeras dimensiones: la primera es la secuencia de van der Corput en base 2,
+    // y la segunda corresponde al polinomio primitivo x + 1
+    uint32_t directions0[32];
+    uint32_t directions1[32];
+    directions1[0] = 1u << 31;
+    for (uint32_t bit = 0; bit < 32; bit++)
+    {
+        directions0[bit] = 1u << (31 - bit);
+        if (bit > 0)
+        {
+            directions1[bit] = directions1[bit - 1] ^ (directions1[bit - 1] >> 1);
+        }
+    }
+
+    // El scrambling por XOR con una máscara aleatoria por dimensión conserva que cada bloque de 2^k puntos
+    // quede estratificado
+    std::mt19937 rng(seed);
+    uint32_t scramble0 = rng();
+    uint32_t scramble1 = rng();
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t x = scramble0;
+        uint32_t y = scramble1;
+        for (uint32_t bit = 0, index = i; index != 0; bit++, index >>= 1)
+        {
+            if (index & 1u)
+            {
+                x ^= directions0[bit];
+                y ^= directions1[bit];
+            }
+        }
+        points[i] = glm::vec2(static_cast<float>(x * UINT32_TO_UNIT), static_cast<float>(y * UINT32_TO_UNIT));
+        points[i] = glm::min(points[i], glm::vec2(ONE_MINUS_EPSILON));
+    }
+    return points;
+}
+
+std::vector<glm::vec2> SamplingSequences::generate(SamplingSequence sequence, uint32_t count, uint32_t seed)
+{
+    switch (sequence)
+    {
+    case SamplingSequence::R2:
+    {
+        // El offset se deriva de la semilla para que distintas semillas den secuencias distintas
+        std::vector<glm::vec2> offset = whiteNoise(1, seed);
+        return r2(count, offset[0]);
+    }
+    case SamplingSequence::SOBOL:
+        return sobol(count, seed);
+    default:
+        return whiteNoise(count, seed);
+    }
+}
+
+double SamplingSequences::l2StarDiscrepancy(const std::vector<glm::vec2> &points)
+{
+    if (points.empty())
+    {
+        return 0.0;
+    }
+
+    // Fórmula de Warnock para dos dimensiones:
+    // T^2 = 1/9 - (1/N) * sum_i prod_k (1 - x_ik^2) / 2 + (1/N^2) * sum_i sum_j prod_k (1 - max(x_ik, x_jk))
+    const double n = static_cast<double>(points.size());
+
+    double singleSum = 0.0;
+    for (const glm::vec2 &p : points)
+    {
+        singleSum += (1.0 - double(p.x) * p.x) * (1.0 - double(p.y) * p.y);
+    }
+
+    double pairSum = 0.0;
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        for (size_t j = 0; j < points.size(); j++)
+        {
+            pairSum += (1.0 - std::max(double(points[i].x), double(points[j].x))) * (1.0 - std::max(double(points[i].y), double(points[j].y)));
+        }
+    }
+
+    double squared = 1.0 / 9.0 - singleSum / (2.0 * n) + pairSum / (n * n);
+    return std::sqrt(std::max(squared, 0.0));
+}
+
+void SamplingSequences::reportDiscrepancies(SamplingSequence inUse, uint32_t count, uint32_t seed)
+{
+    std::cout << "Discrepancia L2* de las direcciones de los surfels (" << count << " muestras):" << std::endl;
+    for (SamplingSequence sequence : {SamplingSequence::WHITE_NOISE, SamplingSequence::R2, SamplingSequence::SOBOL})
+    {
+        double discrepancy = l2StarDiscrepancy(generate(sequence, count, seed));
+        std::cout << "  " << getName(sequence) << ": " << discrepancy << (sequence == inUse ? " (en uso)" : "") << std::endl;
+    }
+}
+
+const char *SamplingSequences::getName(SamplingSequence sequence)
+{
+    switch (sequence)
+    {
+    case SamplingSequence::R2:
+        return "R2";
+    case SamplingSequence::SOBOL:
+        return "Sobol";
+    default:
+        return "ruido blanco";
+    }
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+
+// Secuencias de puntos en [0,1)^2 para muestrear el hemisferio de los surfels. Las de baja discrepancia (Sobol y R2)
+// reparten los prefijos de la secuencia de forma mucho más uniforme que el ruido blanco, por lo que el error de la
+// irradiancia con el mismo número de rayos es menor
+enum SamplingSequence : short {
+	WHITE_NOISE,
+	R2,
+	SOBOL
+};
+
+class SamplingSequences
+{
+public:
+	static std::vector<glm::vec2> whiteNoise(uint32_t count, uint32_t seed);
+	// Secuencia aditiva R2 (Roberts), basada en la razón plástica, desplazada por un offset
+	static std::vector<glm::vec2> r2(uint32_t count, glm::vec2 offset);
+	// Dos primeras dimensiones de Sobol, con un scrambling de dígitos por XOR que mantiene la estratificación
+	// en potencias de dos
+	static std::vector<glm::vec2> sobol(uint32_t count, uint32_t seed);
+
+	static std::vector<glm::vec2> generate(SamplingSequence sequence, uint32_t count, uint32_t seed);
+
+	// Discrepancia L2-star (fórmula de Warnock). Cuanto menor, más uniforme es el conjunto de puntos
+	static double l2StarDiscrepancy(const std::vector<glm::vec2> &points);
+	// Imprime por consola la discrepancia de cada secuencia con el mismo número de muestras y semilla. El cálculo es
+	// cuadrático en el número de puntos, así que sólo se lanza a petición
+	static void reportDiscrepancies(SamplingSequence inUse, uint32_t count, uint32_t seed);
+
+	static const char *getName(SamplingSequence sequence);
+};
\ No newline at end of file
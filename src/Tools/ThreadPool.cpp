@@ -0,0 +1,60 @@
+#include "ThreadPool.h"
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <algorithm>
+
+ThreadPool::ThreadPool(uint32_t numThreads)
+{
+    if (numThreads == 0)
+    {
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    workers.reserve(numThreads);
+    for (uint32_t i = 0; i < numThreads; i++)
+    {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    condition.notify_all();
+    // Los hilos terminan las tareas pendientes antes de salir
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+uint32_t ThreadPool::getNumThreads() const
+{
+    return static_cast<uint32_t>(workers.size());
+}
+
+void ThreadPool::workerLoop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            condition.wait(lock, [this]()
+                           { return stopping || !tasks.empty(); });
+            if (stopping && tasks.empty())
+            {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop();
+        }
+        // Las excepciones quedan guardadas en el future de la tarea
+        task();
+    }
+}
\ No newline at end of file
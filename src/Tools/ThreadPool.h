@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <cstdint>
+
+// Conjunto fijo de hilos de trabajo que ejecutan tareas en orden de llegada
+// Cada tarea devuelve un future, de forma que quien la encola decide en qué orden recoge los resultados
+class ThreadPool
+{
+public:
+	// Con 0 hilos se usan todos los disponibles en la máquina
+	explicit ThreadPool(uint32_t numThreads = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+	template <typename F>
+	auto enqueue(F &&task) -> std::future<decltype(task())>
+	{
+		using ReturnType = decltype(task());
+		auto packagedTask = std::make_shared<std::packaged_task<ReturnType()>>(std::forward<F>(task));
+		std::future<ReturnType> result = packagedTask->get_future();
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			tasks.push([packagedTask]()
+					   { (*packagedTask)(); });
+		}
+		condition.notify_one();
+		return result;
+	}
+
+	// Reparte [0, count) en lotes de batchSize entre los hilos y espera a que terminen todos. No se puede llamar desde
+	// una tarea del propio pool, porque su hilo quedaría bloqueado esperando a lotes que quizá nadie ejecute
+	template <typename F>
+	void parallelFor(uint32_t count, uint32_t batchSize, F &&task)
+	{
+		std::vector<std::future<void>> batches;
+		for (uint32_t begin = 0; begin < count; begin += batchSize)
+		{
+			uint32_t end = count - begin > batchSize ? begin + batchSize : count;
+			batches.push_back(enqueue([&task, begin, end]()
+									  { task(begin, end); }));
+		}
+		// Se espera a todos los lotes antes de relanzar sus excepciones con get(), ya que usan la tarea por referencia
+		for (auto &batch : batches)
+		{
+			batch.wait();
+		}
+		for (auto &batch : batches)
+		{
+			batch.get();
+		}
+	}
+
+	uint32_t getNumThreads() const;
+
+private:
+	std::vector<std::thread> workers;
+	std::queue<std::function<void()>> tasks;
+	std::mutex queueMutex;
+	std::condition_variable condition;
+	bool stopping = false;
+
+	void workerLoop();
+};
\ No newline at end of file